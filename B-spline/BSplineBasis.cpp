@@ -0,0 +1,573 @@
+#include "BSplineBasis.h"
+#include "../Core/Constants.h"
+#include "../Core/TaskSchedulers.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+using namespace std;
+
+namespace cagd
+{
+    // special constructor
+    BSplineBasis::BSplineBasis(GLuint degree, GLuint function_count, GLdouble u_min, GLdouble u_max):
+        _degree(degree)
+    {
+        SetClampedUniformKnotVector(degree, function_count, u_min, u_max);
+    }
+
+    GLboolean BSplineBasis::SetClampedUniformKnotVector(GLuint degree, GLuint function_count, GLdouble u_min, GLdouble u_max)
+    {
+        if (function_count < degree + 1 || u_min >= u_max)
+            return GL_FALSE;
+
+        _degree = degree;
+        _knot.ResizeRows(function_count + degree + 1);
+
+        GLuint segment_count = function_count - degree;
+        GLdouble step = (u_max - u_min) / segment_count;
+
+        for (GLuint i = 0; i <= degree; ++i)
+        {
+            _knot[i]                  = u_min;
+            _knot[function_count + i] = u_max;
+        }
+
+        for (GLuint i = 1; i < segment_count; ++i)
+            _knot[degree + i] = u_min + i * step;
+
+        return GL_TRUE;
+    }
+
+    GLboolean BSplineBasis::SetKnotVector(GLuint degree, const ColumnMatrix<GLdouble> &knot_vector)
+    {
+        GLuint knot_count = knot_vector.GetRowCount();
+
+        if (knot_count < 2 * (degree + 1))
+            return GL_FALSE;
+
+        for (GLuint i = 1; i < knot_count; ++i)
+            if (knot_vector[i] < knot_vector[i - 1])
+                return GL_FALSE;
+
+        if (knot_vector[degree] >= knot_vector[knot_count - degree - 1])
+            return GL_FALSE;
+
+        _degree = degree;
+        _knot   = knot_vector;
+
+        return GL_TRUE;
+    }
+
+    // get properties
+    GLuint BSplineBasis::GetDegree() const
+    {
+        return _degree;
+    }
+
+    GLuint BSplineBasis::GetFunctionCount() const
+    {
+        return _knot.GetRowCount() - _degree - 1;
+    }
+
+    const ColumnMatrix<GLdouble>& BSplineBasis::GetKnotVector() const
+    {
+        return _knot;
+    }
+
+    GLvoid BSplineBasis::GetDefinitionDomain(GLdouble &u_min, GLdouble &u_max) const
+    {
+        u_min = _knot[_degree];
+        u_max = _knot[GetFunctionCount()];
+    }
+
+    GLuint BSplineBasis::FindSpan(GLdouble u) const
+    {
+        GLuint n = GetFunctionCount() - 1;
+
+        if (u <= _knot[_degree])
+        {
+            // skip the empty intervals at the beginning of the domain
+            GLuint span = _degree;
+            while (_knot[span + 1] <= _knot[_degree])
+                ++span;
+            return span;
+        }
+
+        if (u >= _knot[n + 1])
+        {
+            // the right end of the domain belongs to the last non-empty interval
+            GLuint span = n;
+            while (_knot[span] >= _knot[n + 1])
+                --span;
+            return span;
+        }
+
+        // invariant: _knot[low] <= u < _knot[high]
+        GLuint low = _degree, high = n + 1;
+
+        while (high - low > 1)
+        {
+            GLuint middle = (low + high) / 2;
+
+            if (u < _knot[middle])
+                high = middle;
+            else
+                low = middle;
+        }
+
+        return low;
+    }
+
+    GLvoid BSplineBasis::Values(GLuint span, GLdouble u, RowMatrix<GLdouble> &values) const
+    {
+        values.ResizeColumns(_degree + 1);
+
+        vector<GLdouble> left(_degree + 1), right(_degree + 1);
+
+        values[0] = 1.0;
+
+        for (GLuint j = 1; j <= _degree; ++j)
+        {
+            left[j]  = u - _knot[span + 1 - j];
+            right[j] = _knot[span + j] - u;
+
+            GLdouble saved = 0.0;
+
+            for (GLuint r = 0; r < j; ++r)
+            {
+                GLdouble temp = values[r] / (right[r + 1] + left[j - r]);
+                values[r] = saved + right[r + 1] * temp;
+                saved = left[j - r] * temp;
+            }
+
+            values[j] = saved;
+        }
+    }
+
+    GLvoid BSplineBasis::Derivatives(GLuint span, GLdouble u, GLuint max_order_of_derivatives, Matrix<GLdouble> &derivatives) const
+    {
+        GLint p = (GLint)_degree;
+        GLint n = (GLint)max_order_of_derivatives;
+
+        derivatives.ResizeRows(max_order_of_derivatives + 1);
+        derivatives.ResizeColumns(_degree + 1);
+
+        // this method is called several times by every surface evaluation, therefore all
+        // temporary arrays share a single allocation:
+        // ndu[j * (p + 1) + r] stores the basis functions of degree j (upper triangle, r >= j),
+        // ndu[(r + 1) * (p + 1) + j] the corresponding knot differences (lower triangle),
+        // a[s * (p + 1) + j] the coefficients of consecutive orders alternately in the rows s = 0, 1
+        vector<GLdouble> workspace((p + 1) * (p + 5));
+
+        GLdouble *ndu   = &workspace[0];
+        GLdouble *a     = ndu + (p + 1) * (p + 1);
+        GLdouble *left  = a + 2 * (p + 1);
+        GLdouble *right = left + (p + 1);
+
+        GLint stride = p + 1;
+
+        ndu[0] = 1.0;
+
+        for (GLint j = 1; j <= p; ++j)
+        {
+            left[j]  = u - _knot[span + 1 - j];
+            right[j] = _knot[span + j] - u;
+
+            GLdouble saved = 0.0;
+
+            for (GLint r = 0; r < j; ++r)
+            {
+                ndu[j * stride + r] = right[r + 1] + left[j - r];
+                GLdouble temp = ndu[r * stride + j - 1] / ndu[j * stride + r];
+
+                ndu[r * stride + j] = saved + right[r + 1] * temp;
+                saved = left[j - r] * temp;
+            }
+
+            ndu[j * stride + j] = saved;
+        }
+
+        for (GLint j = 0; j <= p; ++j)
+            derivatives(0, j) = ndu[j * stride + p];
+
+        for (GLint k = 1; k <= n; ++k)
+            for (GLint j = 0; j <= p; ++j)
+                derivatives(k, j) = 0.0;
+
+        // the derivatives are computed as linear combinations of lower degree basis functions
+        for (GLint r = 0; r <= p; ++r)
+        {
+            GLdouble *a1 = a, *a2 = a + stride;
+            a1[0] = 1.0;
+
+            for (GLint k = 1; k <= n && k <= p; ++k)
+            {
+                GLdouble d = 0.0;
+                GLint rk = r - k, pk = p - k;
+
+                if (r >= k)
+                {
+                    a2[0] = a1[0] / ndu[(pk + 1) * stride + rk];
+                    d = a2[0] * ndu[rk * stride + pk];
+                }
+
+                GLint j1 = (rk >= -1) ? 1 : -rk;
+                GLint j2 = (r - 1 <= pk) ? k - 1 : p - r;
+
+                for (GLint j = j1; j <= j2; ++j)
+                {
+                    a2[j] = (a1[j] - a1[j - 1]) / ndu[(pk + 1) * stride + rk + j];
+                    d += a2[j] * ndu[(rk + j) * stride + pk];
+                }
+
+                if (r <= pk)
+                {
+                    a2[k] = -a1[k - 1] / ndu[(pk + 1) * stride + r];
+                    d += a2[k] * ndu[r * stride + pk];
+                }
+
+                derivatives(k, r) = d;
+
+                swap(a1, a2);
+            }
+        }
+
+        // multiply by the factors p!/(p-k)!
+        GLdouble factor = p;
+
+        for (GLint k = 1; k <= n && k <= p; ++k)
+        {
+            for (GLint j = 0; j <= p; ++j)
+                derivatives(k, j) *= factor;
+
+            factor *= (p - k);
+        }
+    }
+
+    GLvoid BSplineBasis::BlossomCoefficients(GLuint span, const GLdouble *arguments, RowMatrix<GLdouble> &coefficients) const
+    {
+        // product of the B-spline matrices R_1(x_1) R_2(x_2) ... R_p(x_p), the entries
+        // coefficients[j] belong to the indices span - degree + j
+        coefficients.ResizeColumns(_degree + 1);
+
+        for (GLuint j = 0; j <= _degree; ++j)
+            coefficients[j] = 0.0;
+
+        coefficients[_degree] = 1.0;
+
+        for (GLuint k = 1; k <= _degree; ++k)
+        {
+            GLdouble x = arguments[k - 1];
+
+            // the nonzero entries are stored at positions degree - k + 1, ..., degree, and
+            // each of them is split between its own position and the preceding one
+            for (GLuint j = _degree - k; j < _degree; ++j)
+            {
+                GLuint   i     = span - _degree + j + 1;
+                GLdouble value = coefficients[j + 1];
+                GLdouble right = (x - _knot[i]) / (_knot[i + k] - _knot[i]);
+
+                coefficients[j]    += (1.0 - right) * value;
+                coefficients[j + 1] = right * value;
+            }
+        }
+    }
+
+    GLvoid BSplineBasis::_Transformation(const BSplineBasis &target,
+                                         ColumnMatrix<GLuint> &first_index, Matrix<GLdouble> &alpha) const
+    {
+        const ColumnMatrix<GLdouble> &tau = target._knot;
+
+        GLint  count      = (GLint)target.GetFunctionCount();
+        GLuint elevation  = target._degree - _degree;
+
+        GLdouble u_min, u_max;
+        GetDefinitionDomain(u_min, u_max);
+
+        first_index.ResizeRows(count);
+        alpha.ResizeRows(count);
+        alpha.ResizeColumns(_degree + 1);
+
+        TaskScheduler::Instance().ParallelFor(0, count, [&](GLint chunk_begin, GLint chunk_end)
+        {
+            for (GLint j = chunk_begin; j < chunk_end; ++j)
+            {
+                // the blossom identity holds for the polynomial piece of any non-empty knot interval
+                // within the support [tau_j, tau_{j + target degree + 1}] of the target function
+                GLdouble left = tau[j], right = tau[j + target._degree + 1];
+
+                for (GLuint l = j; l <= j + target._degree; ++l)
+                {
+                    if (tau[l] < tau[l + 1] && tau[l] >= u_min && tau[l + 1] <= u_max)
+                    {
+                        left  = tau[l];
+                        right = tau[l + 1];
+                        break;
+                    }
+                }
+
+                GLuint span = FindSpan(0.5 * (left + right));
+
+                first_index[j] = span - _degree;
+
+                RowMatrix<GLdouble> coefficients;
+                std::vector<GLdouble> arguments(_degree + 1);
+
+                if (!elevation)
+                {
+                    for (GLuint k = 0; k < _degree; ++k)
+                        arguments[k] = tau[j + 1 + k];
+
+                    BlossomCoefficients(span, arguments.data(), coefficients);
+
+                    for (GLuint k = 0; k <= _degree; ++k)
+                        alpha(j, k) = coefficients[k];
+                }
+                else
+                {
+                    // the coefficient of the elevated spline is the average of the blossom values
+                    // at the arguments tau_{j + 1}, ..., tau_{j + degree + 1} without one of them
+                    for (GLuint k = 0; k <= _degree; ++k)
+                        alpha(j, k) = 0.0;
+
+                    for (GLuint omitted = 0; omitted <= _degree; ++omitted)
+                    {
+                        for (GLuint k = 0, l = 0; k <= _degree; ++k)
+                            if (k != omitted)
+                                arguments[l++] = tau[j + 1 + k];
+
+                        BlossomCoefficients(span, arguments.data(), coefficients);
+
+                        for (GLuint k = 0; k <= _degree; ++k)
+                            alpha(j, k) += coefficients[k] / (_degree + 1);
+                    }
+                }
+            }
+        });
+    }
+
+    GLuint BSplineBasis::Multiplicity(GLdouble u) const
+    {
+        GLuint multiplicity = 0;
+
+        for (GLuint i = 0; i < _knot.GetRowCount(); ++i)
+            if (_knot[i] == u)
+                ++multiplicity;
+
+        return multiplicity;
+    }
+
+    GLboolean BSplineBasis::IsClamped() const
+    {
+        GLuint n = GetFunctionCount() - 1;
+
+        return _knot[0] == _knot[_degree] && _knot[n + 1] == _knot[n + _degree + 1];
+    }
+
+    GLboolean BSplineBasis::InsertKnot(GLdouble u, BSplineBasis &refined,
+                                       ColumnMatrix<GLuint> &first_index, Matrix<GLdouble> &alpha) const
+    {
+        GLdouble u_min, u_max;
+        GetDefinitionDomain(u_min, u_max);
+
+        if (u <= u_min || u >= u_max || Multiplicity(u) >= _degree)
+            return GL_FALSE;
+
+        GLuint knot_count = _knot.GetRowCount();
+        GLuint span       = FindSpan(u);
+
+        refined._degree = _degree;
+        refined._knot.ResizeRows(knot_count + 1);
+
+        for (GLuint i = 0; i <= span; ++i)
+            refined._knot[i] = _knot[i];
+
+        refined._knot[span + 1] = u;
+
+        for (GLuint i = span + 1; i < knot_count; ++i)
+            refined._knot[i + 1] = _knot[i];
+
+        // Q_i = P_i if i <= span - degree, Q_i = (1 - a_i) P_{i - 1} + a_i P_i if
+        // span - degree < i <= span, and Q_i = P_{i - 1} otherwise
+        GLuint count = GetFunctionCount() + 1;
+
+        first_index.ResizeRows(count);
+        alpha.ResizeRows(count);
+        alpha.ResizeColumns(_degree + 1);
+
+        for (GLuint i = 0; i < count; ++i)
+        {
+            for (GLuint k = 0; k <= _degree; ++k)
+                alpha(i, k) = 0.0;
+
+            if (i + _degree <= span)
+            {
+                first_index[i] = i;
+                alpha(i, 0) = 1.0;
+            }
+            else if (i <= span)
+            {
+                GLdouble a = (u - _knot[i]) / (_knot[i + _degree] - _knot[i]);
+
+                first_index[i] = i - 1;
+                alpha(i, 0) = 1.0 - a;
+                alpha(i, 1) = a;
+            }
+            else
+            {
+                first_index[i] = i - 1;
+                alpha(i, 0) = 1.0;
+            }
+        }
+
+        return GL_TRUE;
+    }
+
+    GLboolean BSplineBasis::RefineKnotVector(const ColumnMatrix<GLdouble> &inserted_knots, BSplineBasis &refined,
+                                             ColumnMatrix<GLuint> &first_index, Matrix<GLdouble> &alpha) const
+    {
+        GLdouble u_min, u_max;
+        GetDefinitionDomain(u_min, u_max);
+
+        GLuint inserted_count = inserted_knots.GetRowCount();
+
+        std::vector<GLdouble> inserted(inserted_count);
+
+        for (GLuint i = 0; i < inserted_count; ++i)
+        {
+            if (inserted_knots[i] <= u_min || inserted_knots[i] >= u_max)
+                return GL_FALSE;
+
+            inserted[i] = inserted_knots[i];
+        }
+
+        std::sort(inserted.begin(), inserted.end());
+
+        // merge the sorted sequences, the multiplicities are only checked at the inserted values,
+        // i.e., the original multiplicity plus the inserted count cannot exceed the degree
+        GLuint knot_count = _knot.GetRowCount();
+
+        ColumnMatrix<GLdouble> tau(knot_count + inserted_count);
+
+        for (GLuint i = 0, j = 0, l = 0; l < knot_count + inserted_count; ++l)
+        {
+            if (j < inserted_count && (i == knot_count || inserted[j] < _knot[i]))
+                tau[l] = inserted[j++];
+            else
+                tau[l] = _knot[i++];
+        }
+
+        for (GLuint l = 0, run = 1; l + 1 < tau.GetRowCount(); ++l)
+        {
+            run = (tau[l + 1] == tau[l]) ? run + 1 : 1;
+
+            if (run > _degree && std::binary_search(inserted.begin(), inserted.end(), tau[l + 1]))
+                return GL_FALSE;
+        }
+
+        refined._degree = _degree;
+        refined._knot   = tau;
+
+        _Transformation(refined, first_index, alpha);
+
+        return GL_TRUE;
+    }
+
+    GLboolean BSplineBasis::ElevateDegree(BSplineBasis &elevated,
+                                          ColumnMatrix<GLuint> &first_index, Matrix<GLdouble> &alpha) const
+    {
+        if (!IsClamped())
+            return GL_FALSE;
+
+        GLuint knot_count = _knot.GetRowCount();
+
+        std::vector<GLdouble> tau;
+        tau.reserve(knot_count + knot_count - 2 * _degree);
+
+        for (GLuint i = 0; i < knot_count; ++i)
+        {
+            tau.push_back(_knot[i]);
+
+            if (i + 1 == knot_count || _knot[i + 1] != _knot[i])
+                tau.push_back(_knot[i]);
+        }
+
+        elevated._degree = _degree + 1;
+        elevated._knot.ResizeRows((GLuint)tau.size());
+
+        for (GLuint i = 0; i < tau.size(); ++i)
+            elevated._knot[i] = tau[i];
+
+        _Transformation(elevated, first_index, alpha);
+
+        return GL_TRUE;
+    }
+
+    GLvoid BSplineBasis::GramMatrix(GLuint order, SymmetricBandedMatrix &gram) const
+    {
+        GLuint count = GetFunctionCount();
+
+        gram.Resize(count, _degree);
+
+        if (order > _degree)
+            return;
+
+        // the integrands are polynomials of degree at most 2 * degree on each span, thus
+        // degree + 1 Gauss-Legendre nodes are exact; the nodes are the roots of the Legendre
+        // polynomial P_{degree + 1}, located by Newton's method
+        GLuint node_count = _degree + 1;
+        vector<GLdouble> node(node_count), weight(node_count);
+
+        for (GLuint i = 0; i < node_count; ++i)
+        {
+            GLdouble x = cos(PI * (i + 0.75) / (node_count + 0.5)), derivative = 1.0;
+
+            for (GLuint iteration = 0; iteration < 100; ++iteration)
+            {
+                GLdouble p0 = 1.0, p1 = 0.0;
+
+                for (GLuint k = 1; k <= node_count; ++k)
+                {
+                    GLdouble p2 = p1;
+                    p1 = p0;
+                    p0 = ((2.0 * k - 1.0) * x * p1 - (k - 1.0) * p2) / k;
+                }
+
+                derivative = node_count * (x * p0 - p1) / (x * x - 1.0);
+
+                GLdouble step = p0 / derivative;
+                x -= step;
+
+                if (fabs(step) < 1.0e-15)
+                    break;
+            }
+
+            node[i]   = x;
+            weight[i] = 2.0 / ((1.0 - x * x) * derivative * derivative);
+        }
+
+        Matrix<GLdouble> derivatives;
+
+        for (GLuint span = _degree; span < count; ++span)
+        {
+            GLdouble a = _knot[span], b = _knot[span + 1];
+
+            if (a >= b)
+                continue;
+
+            for (GLuint l = 0; l < node_count; ++l)
+            {
+                GLdouble u = 0.5 * (a + b) + 0.5 * (b - a) * node[l];
+                GLdouble w = 0.5 * (b - a) * weight[l];
+
+                Derivatives(span, u, order, derivatives);
+
+                for (GLuint i = 0; i <= _degree; ++i)
+                    for (GLuint j = 0; j <= i; ++j)
+                        gram(span - _degree + i, span - _degree + j) += w * derivatives(order, i) * derivatives(order, j);
+            }
+        }
+    }
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include "../Core/Matrices.h"
+#include "../Core/SymmetricBandedMatrices.h"
+
+#include <GL/glew.h>
+
+namespace cagd
+{
+    //-------------------
+    // class BSplineBasis
+    //-------------------
+    // Normalized B-spline functions N_{i,p}, i = 0, ..., function_count - 1, of degree p over
+    // a non-decreasing knot vector u_0 <= u_1 <= ... <= u_{function_count + p}.
+    //
+    // The definition domain is [u_p, u_{function_count}]. At any parameter value at most p + 1
+    // functions are non-vanishing, namely N_{span - p}, ..., N_{span}, where span is the index of
+    // the knot interval [u_span, u_{span + 1}) containing the parameter. Values and derivatives
+    // are evaluated only for these functions by means of the Cox-de Boor recursion.
+    //
+    // Knot insertion, knot refinement and degree elevation are described by a sparse
+    // transformation: the j-th coefficient of a spline in the target basis is
+    //
+    // c'_j = sum_{k=0}^{p} alpha(j, k) c_{first_index[j] + k},
+    //
+    // where c denotes its coefficients in this basis, thus curves and surfaces can apply the
+    // same transformation to their control points (in homogeneous form, if they are rational).
+    class BSplineBasis
+    {
+    protected:
+        GLuint                  _degree;
+        ColumnMatrix<GLdouble>  _knot;
+
+        // expresses the coefficients in the target basis, which is either a refinement of this
+        // basis or its refinement of one degree higher, by means of blossoming
+        GLvoid                  _Transformation(const BSplineBasis &target,
+                                                ColumnMatrix<GLuint> &first_index, Matrix<GLdouble> &alpha) const;
+
+    public:
+        // special constructor, creates a clamped uniform knot vector over [u_min, u_max]
+        BSplineBasis(GLuint degree = 3, GLuint function_count = 4, GLdouble u_min = 0.0, GLdouble u_max = 1.0);
+
+        // the first and the last degree + 1 knots coincide with u_min and u_max, respectively,
+        // while the interior knots are uniformly distributed
+        GLboolean SetClampedUniformKnotVector(GLuint degree, GLuint function_count, GLdouble u_min = 0.0, GLdouble u_max = 1.0);
+
+        // fails if the knots are decreasing, if there are less than 2 * (degree + 1) knots, or
+        // if the definition domain would be empty
+        GLboolean SetKnotVector(GLuint degree, const ColumnMatrix<GLdouble> &knot_vector);
+
+        // get properties
+        GLuint                        GetDegree() const;
+        GLuint                        GetFunctionCount() const;
+        const ColumnMatrix<GLdouble>& GetKnotVector() const;
+        GLvoid                        GetDefinitionDomain(GLdouble &u_min, GLdouble &u_max) const;
+
+        // returns the index of the knot interval that contains u by means of binary search, the
+        // parameter is clamped to the definition domain, and the right end of the domain belongs
+        // to the last non-empty interval
+        GLuint FindSpan(GLdouble u) const;
+
+        // values[j] = N_{span - degree + j}(u), j = 0, ..., degree
+        GLvoid Values(GLuint span, GLdouble u, RowMatrix<GLdouble> &values) const;
+
+        // derivatives(k, j) = d^k/du^k N_{span - degree + j}(u), k = 0, ..., max_order_of_derivatives,
+        // j = 0, ..., degree; derivatives of order greater than the degree vanish
+        GLvoid Derivatives(GLuint span, GLdouble u, GLuint max_order_of_derivatives, Matrix<GLdouble> &derivatives) const;
+
+        // coefficients[j], j = 0, ..., degree, such that the blossom of the polynomial piece of the
+        // spline sum_i c_i N_i over the given span evaluated at arguments[0], ..., arguments[degree - 1]
+        // equals sum_j coefficients[j] c_{span - degree + j}
+        GLvoid BlossomCoefficients(GLuint span, const GLdouble *arguments, RowMatrix<GLdouble> &coefficients) const;
+
+        // Boehm's algorithm, inserts the knot u once; fails unless u lies in the interior of the
+        // definition domain and its multiplicity is less than the degree
+        GLboolean InsertKnot(GLdouble u, BSplineBasis &refined,
+                             ColumnMatrix<GLuint> &first_index, Matrix<GLdouble> &alpha) const;
+
+        // Oslo algorithm, inserts several knots at once, each new coefficient is obtained
+        // independently of the others in O(degree^2) operations; fails under the same
+        // conditions as InsertKnot
+        GLboolean RefineKnotVector(const ColumnMatrix<GLdouble> &inserted_knots, BSplineBasis &refined,
+                                   ColumnMatrix<GLuint> &first_index, Matrix<GLdouble> &alpha) const;
+
+        // raises the degree by one and the multiplicity of every distinct knot by one; requires a
+        // knot vector that is clamped at both ends of the definition domain
+        GLboolean ElevateDegree(BSplineBasis &elevated,
+                                ColumnMatrix<GLuint> &first_index, Matrix<GLdouble> &alpha) const;
+
+        GLboolean IsClamped() const;
+        GLuint    Multiplicity(GLdouble u) const;
+
+        // gram(i, j) = integral of N_i^{(order)} N_j^{(order)} over the definition domain, evaluated
+        // exactly by Gauss-Legendre quadrature on every non-empty knot span; the half bandwidth
+        // of the result equals the degree
+        GLvoid    GramMatrix(GLuint order, SymmetricBandedMatrix &gram) const;
+    };
+}
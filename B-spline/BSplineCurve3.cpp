@@ -0,0 +1,464 @@
+#include "BSplineCurve3.h"
+#include "../Core/Exceptions.h"
+#include "../Core/SymmetricBandedMatrices.h"
+#include "../Core/TaskSchedulers.h"
+
+#include <vector>
+
+using namespace std;
+
+namespace cagd
+{
+    // special constructor
+    BSplineCurve3::BSplineCurve3(GLuint degree, GLuint data_count, GLenum data_usage_flag):
+        LinearCombination3(0.0, 1.0, data_count, data_usage_flag),
+        _basis(degree, data_count, 0.0, 1.0),
+        _rational(GL_FALSE)
+    {
+        if (data_count < degree + 1)
+            throw Exception("BSplineCurve3::BSplineCurve3 - the number of control points has to exceed the degree!");
+
+        _weight.ResizeRows(data_count);
+        for (GLuint i = 0; i < data_count; ++i)
+            _weight[i] = 1.0;
+    }
+
+    // special constructor
+    BSplineCurve3::BSplineCurve3(GLuint degree, const ColumnMatrix<GLdouble> &knot_vector, GLenum data_usage_flag):
+        LinearCombination3(0.0, 1.0,
+                           knot_vector.GetRowCount() > degree + 1 ? knot_vector.GetRowCount() - degree - 1 : 0,
+                           data_usage_flag),
+        _rational(GL_FALSE)
+    {
+        if (!_basis.SetKnotVector(degree, knot_vector))
+            throw Exception("BSplineCurve3::BSplineCurve3 - invalid knot vector!");
+
+        _UpdateDefinitionDomain();
+
+        GLuint data_count = _data.GetRowCount();
+
+        _weight.ResizeRows(data_count);
+        for (GLuint i = 0; i < data_count; ++i)
+            _weight[i] = 1.0;
+    }
+
+    GLvoid BSplineCurve3::_UpdateDefinitionDomain()
+    {
+        _basis.GetDefinitionDomain(_u_min, _u_max);
+    }
+
+    GLboolean BSplineCurve3::SetKnotVector(const ColumnMatrix<GLdouble> &knot_vector)
+    {
+        if (knot_vector.GetRowCount() != _data.GetRowCount() + _basis.GetDegree() + 1)
+            return GL_FALSE;
+
+        if (!_basis.SetKnotVector(_basis.GetDegree(), knot_vector))
+            return GL_FALSE;
+
+        _UpdateDefinitionDomain();
+
+        return GL_TRUE;
+    }
+
+    GLvoid BSplineCurve3::_Transform(const BSplineBasis &basis,
+                                     const ColumnMatrix<GLuint> &first_index, const Matrix<GLdouble> &alpha)
+    {
+        GLint  count = (GLint)first_index.GetRowCount();
+        GLuint width = alpha.GetColumnCount();
+
+        ColumnMatrix<DCoordinate3> data(count);
+        ColumnMatrix<GLdouble>     weight(count);
+
+        TaskScheduler::Instance().ParallelFor(0, count, [&](GLint chunk_begin, GLint chunk_end)
+        {
+            for (GLint j = chunk_begin; j < chunk_end; ++j)
+            {
+                DCoordinate3 point;
+                GLdouble     w = 0.0;
+
+                for (GLuint k = 0; k < width; ++k)
+                {
+                    GLuint   i = first_index[j] + k;
+                    GLdouble a = alpha(j, k);
+
+                    if (a == 0.0)
+                        continue;
+
+                    if (_rational)
+                    {
+                        point += (a * _weight[i]) * _data[i];
+                        w     += a * _weight[i];
+                    }
+                    else
+                    {
+                        point += a * _data[i];
+                    }
+                }
+
+                // the weights of a non-rational curve remain exactly 1 (instead of a sum of the
+                // rounded transformation coefficients)
+                data[j]   = _rational ? point / w : point;
+                weight[j] = _rational ? w : 1.0;
+            }
+        });
+
+        _basis  = basis;
+        _data   = data;
+        _weight = weight;
+
+        _UpdateDefinitionDomain();
+
+        if (_vbo_data)
+            UpdateVertexBufferObjectsOfData(_data_usage_flag);
+    }
+
+    GLboolean BSplineCurve3::InsertKnot(GLdouble u, GLuint multiplicity)
+    {
+        if (_basis.Multiplicity(u) + multiplicity > _basis.GetDegree())
+            return GL_FALSE;
+
+        for (GLuint r = 0; r < multiplicity; ++r)
+        {
+            BSplineBasis         refined;
+            ColumnMatrix<GLuint> first_index;
+            Matrix<GLdouble>     alpha;
+
+            if (!_basis.InsertKnot(u, refined, first_index, alpha))
+                return GL_FALSE;
+
+            _Transform(refined, first_index, alpha);
+        }
+
+        return GL_TRUE;
+    }
+
+    GLboolean BSplineCurve3::RefineKnotVector(const ColumnMatrix<GLdouble> &inserted_knots)
+    {
+        BSplineBasis         refined;
+        ColumnMatrix<GLuint> first_index;
+        Matrix<GLdouble>     alpha;
+
+        if (!_basis.RefineKnotVector(inserted_knots, refined, first_index, alpha))
+            return GL_FALSE;
+
+        _Transform(refined, first_index, alpha);
+
+        return GL_TRUE;
+    }
+
+    GLboolean BSplineCurve3::ElevateDegree(GLuint times)
+    {
+        if (times && !_basis.IsClamped())
+            return GL_FALSE;
+
+        for (GLuint r = 0; r < times; ++r)
+        {
+            BSplineBasis         elevated;
+            ColumnMatrix<GLuint> first_index;
+            Matrix<GLdouble>     alpha;
+
+            if (!_basis.ElevateDegree(elevated, first_index, alpha))
+                return GL_FALSE;
+
+            _Transform(elevated, first_index, alpha);
+        }
+
+        return GL_TRUE;
+    }
+
+    GLboolean BSplineCurve3::UpdateDataForLeastSquaresFitting(const ColumnMatrix<GLdouble> &parameters,
+                                                              const ColumnMatrix<DCoordinate3> &points,
+                                                              GLdouble smoothing_weight)
+    {
+        GLint sample_count = (GLint)parameters.GetRowCount();
+
+        if (!sample_count || points.GetRowCount() != (GLuint)sample_count || smoothing_weight < 0.0)
+            return GL_FALSE;
+
+        for (GLint k = 0; k < sample_count; ++k)
+            if (parameters[k] < _u_min || parameters[k] > _u_max)
+                return GL_FALSE;
+
+        GLuint p     = _basis.GetDegree();
+        GLuint count = _data.GetRowCount();
+
+        // the samples are accumulated chunk by chunk into private normal equations, which are summed
+        // up in the order of the chunks
+        typedef pair<SymmetricBandedMatrix, ColumnMatrix<DCoordinate3> > NormalEquations;
+
+        auto accumulate = [&](GLint chunk_begin, GLint chunk_end, NormalEquations &partial)
+        {
+            RowMatrix<GLdouble> values;
+
+            for (GLint k = chunk_begin; k < chunk_end; ++k)
+            {
+                GLdouble u     = parameters[k];
+                GLuint   span  = _basis.FindSpan(u);
+                GLuint   first = span - p;
+
+                _basis.Values(span, u, values);
+
+                if (_rational)
+                {
+                    GLdouble denominator = 0.0;
+
+                    for (GLuint i = 0; i <= p; ++i)
+                    {
+                        values[i] *= _weight[first + i];
+                        denominator += values[i];
+                    }
+
+                    for (GLuint i = 0; i <= p; ++i)
+                        values[i] /= denominator;
+                }
+
+                for (GLuint i = 0; i <= p; ++i)
+                {
+                    partial.second[first + i] += values[i] * points[k];
+
+                    for (GLuint j = 0; j <= i; ++j)
+                        partial.first(first + i, first + j) += values[i] * values[j];
+                }
+            }
+        };
+
+        auto sum = [count](NormalEquations &result, const NormalEquations &partial)
+        {
+            result.first += partial.first;
+
+            for (GLuint i = 0; i < count; ++i)
+                result.second[i] += partial.second[i];
+        };
+
+        NormalEquations equations = TaskScheduler::Instance().ParallelReduce(
+                0, sample_count,
+                NormalEquations(SymmetricBandedMatrix(count, p), ColumnMatrix<DCoordinate3>(count)),
+                accumulate, sum);
+
+        SymmetricBandedMatrix      &normal = equations.first;
+        ColumnMatrix<DCoordinate3> &rhs    = equations.second;
+
+        // average the data term, thus the smoothing weight does not depend on the sample count
+        for (GLuint i = 0; i < count; ++i)
+        {
+            rhs[i] /= sample_count;
+
+            for (GLuint j = (i > p ? i - p : 0); j <= i; ++j)
+                normal(i, j) /= sample_count;
+        }
+
+        if (smoothing_weight > 0.0)
+        {
+            SymmetricBandedMatrix fairness;
+            _basis.GramMatrix(p >= 2 ? 2 : 1, fairness);
+
+            for (GLuint i = 0; i < count; ++i)
+                for (GLuint j = (i > p ? i - p : 0); j <= i; ++j)
+                    normal(i, j) += smoothing_weight * fairness(i, j);
+        }
+
+        ColumnMatrix<DCoordinate3> solution;
+
+        if (!normal.SolveLinearSystem(rhs, solution))
+            return GL_FALSE;
+
+        _data = solution;
+
+        return GL_TRUE;
+    }
+
+    GLboolean BSplineCurve3::ChordLengthParameters(const ColumnMatrix<DCoordinate3> &points,
+                                                   ColumnMatrix<GLdouble> &parameters) const
+    {
+        GLuint point_count = points.GetRowCount();
+
+        if (point_count < 2)
+            return GL_FALSE;
+
+        parameters.ResizeRows(point_count);
+        parameters[0] = 0.0;
+
+        for (GLuint k = 1; k < point_count; ++k)
+        {
+            DCoordinate3 chord = points[k];
+            chord -= points[k - 1];
+
+            parameters[k] = parameters[k - 1] + chord.length();
+        }
+
+        GLdouble length = parameters[point_count - 1];
+
+        if (length <= 0.0)
+            return GL_FALSE;
+
+        for (GLuint k = 0; k < point_count; ++k)
+            parameters[k] = _u_min + (_u_max - _u_min) * parameters[k] / length;
+
+        parameters[point_count - 1] = _u_max;
+
+        return GL_TRUE;
+    }
+
+    GLboolean BSplineCurve3::SetWeight(GLuint index, GLdouble weight)
+    {
+        if (index >= _weight.GetRowCount() || weight <= 0.0)
+            return GL_FALSE;
+
+        _weight[index] = weight;
+
+        _rational = GL_FALSE;
+        for (GLuint i = 0; i < _weight.GetRowCount() && !_rational; ++i)
+            _rational = (_weight[i] != 1.0);
+
+        return GL_TRUE;
+    }
+
+    GLboolean BSplineCurve3::SetWeights(const ColumnMatrix<GLdouble> &weights)
+    {
+        if (weights.GetRowCount() != _weight.GetRowCount())
+            return GL_FALSE;
+
+        for (GLuint i = 0; i < weights.GetRowCount(); ++i)
+            if (weights[i] <= 0.0)
+                return GL_FALSE;
+
+        _weight = weights;
+
+        _rational = GL_FALSE;
+        for (GLuint i = 0; i < _weight.GetRowCount() && !_rational; ++i)
+            _rational = (_weight[i] != 1.0);
+
+        return GL_TRUE;
+    }
+
+    // get properties
+    GLuint BSplineCurve3::GetDegree() const
+    {
+        return _basis.GetDegree();
+    }
+
+    const BSplineBasis& BSplineCurve3::GetBasis() const
+    {
+        return _basis;
+    }
+
+    const ColumnMatrix<GLdouble>& BSplineCurve3::GetKnotVector() const
+    {
+        return _basis.GetKnotVector();
+    }
+
+    GLdouble BSplineCurve3::GetWeight(GLuint index) const
+    {
+        return _weight[index];
+    }
+
+    GLboolean BSplineCurve3::IsRational() const
+    {
+        return _rational;
+    }
+
+    GLboolean BSplineCurve3::BlendingFunctionValues(GLdouble u, RowMatrix<GLdouble> &values) const
+    {
+        if (u < _u_min || u > _u_max)
+            return GL_FALSE;
+
+        GLuint p    = _basis.GetDegree();
+        GLuint span = _basis.FindSpan(u);
+
+        RowMatrix<GLdouble> local_values;
+        _basis.Values(span, u, local_values);
+
+        values.ResizeColumns(_data.GetRowCount());
+        for (GLuint i = 0; i < values.GetColumnCount(); ++i)
+            values[i] = 0.0;
+
+        GLuint first = span - p;
+
+        if (!_rational)
+        {
+            for (GLuint j = 0; j <= p; ++j)
+                values[first + j] = local_values[j];
+        }
+        else
+        {
+            GLdouble denominator = 0.0;
+
+            for (GLuint j = 0; j <= p; ++j)
+            {
+                values[first + j] = local_values[j] * _weight[first + j];
+                denominator += values[first + j];
+            }
+
+            for (GLuint j = 0; j <= p; ++j)
+                values[first + j] /= denominator;
+        }
+
+        return GL_TRUE;
+    }
+
+    GLboolean BSplineCurve3::CalculateDerivatives(GLuint max_order_of_derivatives, GLdouble u, Derivatives &d) const
+    {
+        if (u < _u_min || u > _u_max)
+            return GL_FALSE;
+
+        GLuint p     = _basis.GetDegree();
+        GLuint span  = _basis.FindSpan(u);
+        GLuint first = span - p;
+
+        Matrix<GLdouble> basis_derivatives(max_order_of_derivatives + 1, p + 1);
+        _basis.Derivatives(span, u, max_order_of_derivatives, basis_derivatives);
+
+        d.ResizeRows(max_order_of_derivatives + 1);
+        d.LoadNullVectors();
+
+        if (!_rational)
+        {
+            for (GLuint k = 0; k <= max_order_of_derivatives && k <= p; ++k)
+                for (GLuint j = 0; j <= p; ++j)
+                    d[k] += basis_derivatives(k, j) * _data[first + j];
+
+            return GL_TRUE;
+        }
+
+        // derivatives of the homogeneous numerator A and of the weight function w, then
+        // C^(k) = (A^(k) - sum_{i=1}^{k} binomial(k, i) w^(i) C^(k-i)) / w
+        ColumnMatrix<GLdouble> w(max_order_of_derivatives + 1);
+
+        for (GLuint k = 0; k <= max_order_of_derivatives; ++k)
+        {
+            w[k] = 0.0;
+
+            if (k <= p)
+            {
+                for (GLuint j = 0; j <= p; ++j)
+                {
+                    GLdouble weighted = basis_derivatives(k, j) * _weight[first + j];
+
+                    d[k] += weighted * _data[first + j];
+                    w[k] += weighted;
+                }
+            }
+        }
+
+        // row k of the Pascal triangle is updated in place
+        RowMatrix<GLdouble> binomial(max_order_of_derivatives + 1);
+        binomial[0] = 1.0;
+
+        for (GLuint k = 0; k <= max_order_of_derivatives; ++k)
+        {
+            if (k > 0)
+            {
+                binomial[k] = 1.0;
+                for (GLuint i = k - 1; i > 0; --i)
+                    binomial[i] += binomial[i - 1];
+            }
+
+            for (GLuint i = 1; i <= k; ++i)
+                d[k] -= (binomial[i] * w[i]) * d[k - i];
+
+            d[k] /= w[0];
+        }
+
+        return GL_TRUE;
+    }
+}
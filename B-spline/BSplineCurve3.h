@@ -0,0 +1,80 @@
+#pragma once
+
+#include "../Core/LinearCombination3.h"
+#include "../Core/Matrices.h"
+#include "BSplineBasis.h"
+
+namespace cagd
+{
+    //--------------------
+    // class BSplineCurve3
+    //--------------------
+    // B-spline curve of arbitrary degree over a non-uniform knot vector, with optional rational
+    // weights (NURBS). The inherited data points are the control points.
+    //
+    // Both the blending function values and the derivatives are evaluated by locating the knot
+    // span of the parameter and by using only the degree + 1 non-vanishing basis functions,
+    // thus the cost of a sample does not depend on the number of control points.
+    class BSplineCurve3: public LinearCombination3
+    {
+    protected:
+        BSplineBasis            _basis;
+        ColumnMatrix<GLdouble>  _weight;
+        GLboolean               _rational;     // GL_TRUE if at least one weight differs from 1
+
+        GLvoid                  _UpdateDefinitionDomain();
+
+        // replaces the basis, and maps the (homogeneous) control points onto the new basis
+        GLvoid                  _Transform(const BSplineBasis &basis,
+                                           const ColumnMatrix<GLuint> &first_index, const Matrix<GLdouble> &alpha);
+
+    public:
+        // special constructor, creates a clamped uniform knot vector over [0, 1]
+        BSplineCurve3(GLuint degree, GLuint data_count, GLenum data_usage_flag = GL_STATIC_DRAW);
+
+        // special constructor, the number of control points is knot_count - degree - 1
+        BSplineCurve3(GLuint degree, const ColumnMatrix<GLdouble> &knot_vector, GLenum data_usage_flag = GL_STATIC_DRAW);
+
+        // the degree and the number of control points are preserved, thus the knot vector has
+        // to consist of data_count + degree + 1 non-decreasing values
+        GLboolean SetKnotVector(const ColumnMatrix<GLdouble> &knot_vector);
+
+        // exact refinement operations, the shape of the curve does not change; the vertex
+        // buffer object of the control polygon is updated if it exists
+        GLboolean InsertKnot(GLdouble u, GLuint multiplicity = 1);
+        GLboolean RefineKnotVector(const ColumnMatrix<GLdouble> &inserted_knots);
+        GLboolean ElevateDegree(GLuint times = 1);
+
+        // least squares fitting with fairness, minimizes
+        //
+        // (1 / M) sum_{k=0}^{M-1} ||c(u_k) - d_k||^2 + smoothing_weight * integral ||c''(u)||^2 du
+        //
+        // over the control points, while the knot vector and the weights are preserved (for
+        // degree 1 the first derivative is used in the fairness term, and for rational curves the
+        // term is measured in the non-rational B-spline basis); the normal equations are banded,
+        // they are assembled in parallel and solved by Cholesky decomposition; a positive
+        // smoothing weight is required if the samples do not determine every control point
+        GLboolean UpdateDataForLeastSquaresFitting(const ColumnMatrix<GLdouble> &parameters,
+                                                   const ColumnMatrix<DCoordinate3> &points,
+                                                   GLdouble smoothing_weight = 0.0);
+
+        // chord length parametrization of a point sequence over the definition domain
+        GLboolean ChordLengthParameters(const ColumnMatrix<DCoordinate3> &points,
+                                        ColumnMatrix<GLdouble> &parameters) const;
+
+        // weights have to be positive
+        GLboolean SetWeight(GLuint index, GLdouble weight);
+        GLboolean SetWeights(const ColumnMatrix<GLdouble> &weights);
+
+        // get properties
+        GLuint                        GetDegree() const;
+        const BSplineBasis&           GetBasis() const;
+        const ColumnMatrix<GLdouble>& GetKnotVector() const;
+        GLdouble                      GetWeight(GLuint index) const;
+        GLboolean                     IsRational() const;
+
+        // redeclare and define inherited pure virtual methods
+        GLboolean BlendingFunctionValues(GLdouble u, RowMatrix<GLdouble> &values) const;
+        GLboolean CalculateDerivatives(GLuint max_order_of_derivatives, GLdouble u, Derivatives &d) const;
+    };
+}
@@ -0,0 +1,787 @@
+#include "BSplineSurface3.h"
+#include "../Core/Exceptions.h"
+#include "../Core/SymmetricBandedMatrices.h"
+#include "../Core/TaskSchedulers.h"
+
+#include <cmath>
+#include <vector>
+
+using namespace std;
+
+namespace cagd
+{
+    // special constructor
+    BSplineSurface3::BSplineSurface3(GLuint u_degree, GLuint v_degree, GLuint row_count, GLuint column_count):
+        TensorProductSurface3(0.0, 1.0, 0.0, 1.0, row_count, column_count),
+        _u_basis(u_degree, row_count, 0.0, 1.0),
+        _v_basis(v_degree, column_count, 0.0, 1.0),
+        _weight(row_count, column_count),
+        _rational(GL_FALSE)
+    {
+        if (row_count < u_degree + 1 || column_count < v_degree + 1)
+            throw Exception("BSplineSurface3::BSplineSurface3 - the size of the control net has to exceed the degrees!");
+
+        for (GLuint i = 0; i < row_count; ++i)
+            for (GLuint j = 0; j < column_count; ++j)
+                _weight(i, j) = 1.0;
+    }
+
+    // special constructor
+    BSplineSurface3::BSplineSurface3(GLuint u_degree, const ColumnMatrix<GLdouble> &u_knot_vector,
+                                     GLuint v_degree, const ColumnMatrix<GLdouble> &v_knot_vector):
+        TensorProductSurface3(0.0, 1.0, 0.0, 1.0,
+                              u_knot_vector.GetRowCount() > u_degree + 1 ? u_knot_vector.GetRowCount() - u_degree - 1 : 1,
+                              v_knot_vector.GetRowCount() > v_degree + 1 ? v_knot_vector.GetRowCount() - v_degree - 1 : 1),
+        _rational(GL_FALSE)
+    {
+        if (!_u_basis.SetKnotVector(u_degree, u_knot_vector) || !_v_basis.SetKnotVector(v_degree, v_knot_vector))
+            throw Exception("BSplineSurface3::BSplineSurface3 - invalid knot vector!");
+
+        _UpdateDefinitionDomain();
+
+        GLuint row_count = _data.GetRowCount(), column_count = _data.GetColumnCount();
+
+        _weight.ResizeRows(row_count);
+        _weight.ResizeColumns(column_count);
+
+        for (GLuint i = 0; i < row_count; ++i)
+            for (GLuint j = 0; j < column_count; ++j)
+                _weight(i, j) = 1.0;
+    }
+
+    GLvoid BSplineSurface3::_UpdateDefinitionDomain()
+    {
+        _u_basis.GetDefinitionDomain(_u_min, _u_max);
+        _v_basis.GetDefinitionDomain(_v_min, _v_max);
+    }
+
+    GLboolean BSplineSurface3::SetUKnotVector(const ColumnMatrix<GLdouble> &u_knot_vector)
+    {
+        if (u_knot_vector.GetRowCount() != _data.GetRowCount() + _u_basis.GetDegree() + 1)
+            return GL_FALSE;
+
+        if (!_u_basis.SetKnotVector(_u_basis.GetDegree(), u_knot_vector))
+            return GL_FALSE;
+
+        _UpdateDefinitionDomain();
+
+        return GL_TRUE;
+    }
+
+    GLboolean BSplineSurface3::SetVKnotVector(const ColumnMatrix<GLdouble> &v_knot_vector)
+    {
+        if (v_knot_vector.GetRowCount() != _data.GetColumnCount() + _v_basis.GetDegree() + 1)
+            return GL_FALSE;
+
+        if (!_v_basis.SetKnotVector(_v_basis.GetDegree(), v_knot_vector))
+            return GL_FALSE;
+
+        _UpdateDefinitionDomain();
+
+        return GL_TRUE;
+    }
+
+    GLvoid BSplineSurface3::_Transform(Direction direction, const BSplineBasis &basis,
+                                       const ColumnMatrix<GLuint> &first_index, const Matrix<GLdouble> &alpha)
+    {
+        GLuint count = first_index.GetRowCount();
+        GLuint width = alpha.GetColumnCount();
+
+        GLuint row_count    = (direction == U_DIRECTION) ? count : _data.GetRowCount();
+        GLuint column_count = (direction == V_DIRECTION) ? count : _data.GetColumnCount();
+
+        // lines are the columns in direction u and the rows in direction v
+        GLint  line_count   = (GLint)((direction == U_DIRECTION) ? column_count : row_count);
+
+        Matrix<DCoordinate3> data(row_count, column_count);
+        Matrix<GLdouble>     weight(row_count, column_count);
+
+        TaskScheduler::Instance().ParallelFor(0, line_count, [&](GLint chunk_begin, GLint chunk_end)
+        {
+            for (GLint line = chunk_begin; line < chunk_end; ++line)
+            {
+                for (GLuint j = 0; j < count; ++j)
+                {
+                    DCoordinate3 point;
+                    GLdouble     w = 0.0;
+
+                    for (GLuint k = 0; k < width; ++k)
+                    {
+                        GLdouble a = alpha(j, k);
+
+                        if (a == 0.0)
+                            continue;
+
+                        GLuint row    = (direction == U_DIRECTION) ? first_index[j] + k : line;
+                        GLuint column = (direction == U_DIRECTION) ? line : first_index[j] + k;
+
+                        if (_rational)
+                        {
+                            point += (a * _weight(row, column)) * _data(row, column);
+                            w     += a * _weight(row, column);
+                        }
+                        else
+                        {
+                            point += a * _data(row, column);
+                        }
+                    }
+
+                    GLuint row    = (direction == U_DIRECTION) ? j : line;
+                    GLuint column = (direction == U_DIRECTION) ? line : j;
+
+                    data(row, column)   = _rational ? point / w : point;
+                    weight(row, column) = _rational ? w : 1.0;
+                }
+            }
+        });
+
+        if (direction == U_DIRECTION)
+            _u_basis = basis;
+        else
+            _v_basis = basis;
+
+        _data   = data;
+        _weight = weight;
+
+        _UpdateDefinitionDomain();
+
+        if (_vbo_data)
+            UpdateVertexBufferObjectsOfData();
+    }
+
+    GLboolean BSplineSurface3::_InsertKnot(Direction direction, GLdouble value, GLuint multiplicity)
+    {
+        const BSplineBasis &current = (direction == U_DIRECTION) ? _u_basis : _v_basis;
+
+        if (current.Multiplicity(value) + multiplicity > current.GetDegree())
+            return GL_FALSE;
+
+        for (GLuint r = 0; r < multiplicity; ++r)
+        {
+            BSplineBasis         refined;
+            ColumnMatrix<GLuint> first_index;
+            Matrix<GLdouble>     alpha;
+
+            if (!current.InsertKnot(value, refined, first_index, alpha))
+                return GL_FALSE;
+
+            _Transform(direction, refined, first_index, alpha);
+        }
+
+        return GL_TRUE;
+    }
+
+    GLboolean BSplineSurface3::_RefineKnotVector(Direction direction, const ColumnMatrix<GLdouble> &inserted_knots)
+    {
+        const BSplineBasis &current = (direction == U_DIRECTION) ? _u_basis : _v_basis;
+
+        BSplineBasis         refined;
+        ColumnMatrix<GLuint> first_index;
+        Matrix<GLdouble>     alpha;
+
+        if (!current.RefineKnotVector(inserted_knots, refined, first_index, alpha))
+            return GL_FALSE;
+
+        _Transform(direction, refined, first_index, alpha);
+
+        return GL_TRUE;
+    }
+
+    GLboolean BSplineSurface3::_ElevateDegree(Direction direction, GLuint times)
+    {
+        const BSplineBasis &current = (direction == U_DIRECTION) ? _u_basis : _v_basis;
+
+        if (times && !current.IsClamped())
+            return GL_FALSE;
+
+        for (GLuint r = 0; r < times; ++r)
+        {
+            BSplineBasis         elevated;
+            ColumnMatrix<GLuint> first_index;
+            Matrix<GLdouble>     alpha;
+
+            if (!current.ElevateDegree(elevated, first_index, alpha))
+                return GL_FALSE;
+
+            _Transform(direction, elevated, first_index, alpha);
+        }
+
+        return GL_TRUE;
+    }
+
+    GLboolean BSplineSurface3::InsertUKnot(GLdouble u, GLuint multiplicity)
+    {
+        return _InsertKnot(U_DIRECTION, u, multiplicity);
+    }
+
+    GLboolean BSplineSurface3::InsertVKnot(GLdouble v, GLuint multiplicity)
+    {
+        return _InsertKnot(V_DIRECTION, v, multiplicity);
+    }
+
+    GLboolean BSplineSurface3::RefineUKnotVector(const ColumnMatrix<GLdouble> &inserted_knots)
+    {
+        return _RefineKnotVector(U_DIRECTION, inserted_knots);
+    }
+
+    GLboolean BSplineSurface3::RefineVKnotVector(const ColumnMatrix<GLdouble> &inserted_knots)
+    {
+        return _RefineKnotVector(V_DIRECTION, inserted_knots);
+    }
+
+    GLboolean BSplineSurface3::ElevateUDegree(GLuint times)
+    {
+        return _ElevateDegree(U_DIRECTION, times);
+    }
+
+    GLboolean BSplineSurface3::ElevateVDegree(GLuint times)
+    {
+        return _ElevateDegree(V_DIRECTION, times);
+    }
+
+    GLboolean BSplineSurface3::UpdateDataForLeastSquaresFitting(
+            const ColumnMatrix<GLdouble> &u, const ColumnMatrix<GLdouble> &v,
+            const ColumnMatrix<DCoordinate3> &points, GLdouble smoothing_weight)
+    {
+        GLuint sample_count = u.GetRowCount();
+
+        if (!sample_count || v.GetRowCount() != sample_count || points.GetRowCount() != sample_count ||
+            smoothing_weight < 0.0)
+            return GL_FALSE;
+
+        GLuint p = _u_basis.GetDegree(), q = _v_basis.GetDegree();
+        GLuint row_count = _data.GetRowCount(), column_count = _data.GetColumnCount();
+
+        // the control point (i, j) is the unknown i * column_count + j
+        GLuint size = row_count * column_count, half_bandwidth = p * column_count + q;
+
+        // bucket the samples by their span in direction u
+        std::vector<GLuint> bucket_start(row_count + 1, 0), order(sample_count), u_span(sample_count);
+
+        for (GLuint k = 0; k < sample_count; ++k)
+        {
+            if (u[k] < _u_min || u[k] > _u_max || v[k] < _v_min || v[k] > _v_max)
+                return GL_FALSE;
+
+            u_span[k] = _u_basis.FindSpan(u[k]);
+            ++bucket_start[u_span[k] + 1];
+        }
+
+        for (GLuint s = 0; s < row_count; ++s)
+            bucket_start[s + 1] += bucket_start[s];
+
+        {
+            std::vector<GLuint> position(bucket_start.begin(), bucket_start.end() - 1);
+
+            for (GLuint k = 0; k < sample_count; ++k)
+                order[position[u_span[k]]++] = k;
+        }
+
+        SymmetricBandedMatrix      normal(size, half_bandwidth);
+        ColumnMatrix<DCoordinate3> rhs(size);
+
+        // the samples of span s modify the rows of the normal equations that belong to the control
+        // points s - p, ..., s in direction u, thus spans that differ at least by p + 1 can be
+        // processed in parallel without synchronization
+        for (GLuint color = 0; color <= p; ++color)
+        {
+            GLint first_span = (GLint)(p + color);
+
+            GLint span_count = first_span < (GLint)row_count ?
+                               ((GLint)row_count - first_span + (GLint)p) / (GLint)(p + 1) : 0;
+
+            TaskScheduler::Instance().ParallelFor(0, span_count, [&](GLint chunk_begin, GLint chunk_end)
+            {
+                RowMatrix<GLdouble> u_values, v_values;
+                Matrix<GLdouble>    values(p + 1, q + 1);
+
+                for (GLint t = chunk_begin; t < chunk_end; ++t)
+                {
+                    GLint s = first_span + t * (GLint)(p + 1);
+
+                    for (GLuint b = bucket_start[s]; b < bucket_start[s + 1]; ++b)
+                    {
+                        GLuint   k            = order[b];
+                        GLuint   v_span       = _v_basis.FindSpan(v[k]);
+                        GLuint   first_row    = s - p;
+                        GLuint   first_column = v_span - q;
+                        GLdouble denominator  = 0.0;
+
+                        _u_basis.Values(s, u[k], u_values);
+                        _v_basis.Values(v_span, v[k], v_values);
+
+                        for (GLuint i = 0; i <= p; ++i)
+                        {
+                            for (GLuint j = 0; j <= q; ++j)
+                            {
+                                values(i, j) = u_values[i] * v_values[j];
+
+                                if (_rational)
+                                {
+                                    values(i, j) *= _weight(first_row + i, first_column + j);
+                                    denominator += values(i, j);
+                                }
+                            }
+                        }
+
+                        for (GLuint i = 0; i <= p; ++i)
+                        {
+                            for (GLuint j = 0; j <= q; ++j)
+                            {
+                                if (_rational)
+                                    values(i, j) /= denominator;
+
+                                GLuint I = (first_row + i) * column_count + first_column + j;
+
+                                rhs[I] += values(i, j) * points[k];
+
+                                for (GLuint a = 0; a <= i; ++a)
+                                {
+                                    for (GLuint c = 0; c <= q; ++c)
+                                    {
+                                        GLuint J = (first_row + a) * column_count + first_column + c;
+
+                                        if (J <= I)
+                                            normal(I, J) += values(i, j) * values(a, c);
+                                    }
+                                }
+                            }
+                        }
+                    }
+                }
+            }, 1);
+        }
+
+        // thin plate energy as a sum of Kronecker products of univariate Gram matrices
+        SymmetricBandedMatrix u_gram[3], v_gram[3];
+
+        if (smoothing_weight > 0.0)
+        {
+            for (GLuint order = 0; order <= 2; ++order)
+            {
+                _u_basis.GramMatrix(order, u_gram[order]);
+                _v_basis.GramMatrix(order, v_gram[order]);
+            }
+        }
+
+        TaskScheduler::Instance().ParallelFor(0, (GLint)row_count, [&](GLint chunk_begin, GLint chunk_end)
+        {
+            for (GLint i = chunk_begin; i < chunk_end; ++i)
+            {
+                for (GLuint j = 0; j < column_count; ++j)
+                {
+                    GLuint I = i * column_count + j;
+
+                    rhs[I] /= sample_count;
+
+                    for (GLuint k = (i > (GLint)p ? i - p : 0); k <= (GLuint)i; ++k)
+                    {
+                        GLuint l_first = (j > q) ? j - q : 0;
+                        GLuint l_last  = std::min(column_count - 1, j + q);
+
+                        for (GLuint l = l_first; l <= l_last; ++l)
+                        {
+                            GLuint J = k * column_count + l;
+
+                            if (J > I)
+                                continue;
+
+                            normal(I, J) /= sample_count;
+
+                            if (smoothing_weight > 0.0)
+                                normal(I, J) += smoothing_weight * (
+                                        u_gram[2](i, k) * v_gram[0](j, l) +
+                                        2.0 * u_gram[1](i, k) * v_gram[1](j, l) +
+                                        u_gram[0](i, k) * v_gram[2](j, l));
+                        }
+                    }
+                }
+            }
+        });
+
+        ColumnMatrix<DCoordinate3> solution;
+
+        if (!normal.SolveLinearSystem(rhs, solution))
+            return GL_FALSE;
+
+        for (GLuint i = 0; i < row_count; ++i)
+            for (GLuint j = 0; j < column_count; ++j)
+                _data(i, j) = solution[i * column_count + j];
+
+        if (_vbo_data)
+            UpdateVertexBufferObjectsOfData();
+
+        return GL_TRUE;
+    }
+
+    GLboolean BSplineSurface3::UpdateDataForLeastSquaresFitting(const TriangulatedMesh3 &mesh, GLdouble smoothing_weight)
+    {
+        GLint vertex_count = (GLint)mesh._vertex.size();
+
+        if (!vertex_count)
+            return GL_FALSE;
+
+        // centroid and covariance matrix of the vertices
+        GLdouble c[3] = {0.0, 0.0, 0.0}, m[3][3] = {{0.0, 0.0, 0.0}, {0.0, 0.0, 0.0}, {0.0, 0.0, 0.0}};
+
+        for (GLint k = 0; k < vertex_count; ++k)
+            for (GLuint r = 0; r < 3; ++r)
+                c[r] += mesh._vertex[k][r];
+
+        for (GLuint r = 0; r < 3; ++r)
+            c[r] /= vertex_count;
+
+        for (GLint k = 0; k < vertex_count; ++k)
+        {
+            GLdouble d[3] = {mesh._vertex[k][0] - c[0], mesh._vertex[k][1] - c[1], mesh._vertex[k][2] - c[2]};
+
+            for (GLuint r = 0; r < 3; ++r)
+                for (GLuint s = 0; s < 3; ++s)
+                    m[r][s] += d[r] * d[s];
+        }
+
+        // cyclic Jacobi rotations, the columns of e become the eigenvectors of the covariance matrix
+        GLdouble e[3][3] = {{1.0, 0.0, 0.0}, {0.0, 1.0, 0.0}, {0.0, 0.0, 1.0}};
+
+        for (GLuint sweep = 0; sweep < 50; ++sweep)
+        {
+            GLdouble off = fabs(m[0][1]) + fabs(m[0][2]) + fabs(m[1][2]);
+
+            if (off <= 1.0e-15 * (fabs(m[0][0]) + fabs(m[1][1]) + fabs(m[2][2])))
+                break;
+
+            for (GLuint r = 0; r < 2; ++r)
+            {
+                for (GLuint s = r + 1; s < 3; ++s)
+                {
+                    if (m[r][s] == 0.0)
+                        continue;
+
+                    GLdouble theta   = 0.5 * (m[s][s] - m[r][r]) / m[r][s];
+                    GLdouble t       = (theta >= 0.0 ? 1.0 : -1.0) / (fabs(theta) + sqrt(theta * theta + 1.0));
+                    GLdouble cosine  = 1.0 / sqrt(t * t + 1.0);
+                    GLdouble sine    = t * cosine;
+
+                    for (GLuint k = 0; k < 3; ++k)
+                    {
+                        GLdouble a = m[k][r], b = m[k][s];
+                        m[k][r] = cosine * a - sine * b;
+                        m[k][s] = sine * a + cosine * b;
+                    }
+
+                    for (GLuint k = 0; k < 3; ++k)
+                    {
+                        GLdouble a = m[r][k], b = m[s][k];
+                        m[r][k] = cosine * a - sine * b;
+                        m[s][k] = sine * a + cosine * b;
+                    }
+
+                    for (GLuint k = 0; k < 3; ++k)
+                    {
+                        GLdouble a = e[k][r], b = e[k][s];
+                        e[k][r] = cosine * a - sine * b;
+                        e[k][s] = sine * a + cosine * b;
+                    }
+                }
+            }
+        }
+
+        // the eigenvectors of the two largest eigenvalues span the least squares plane
+        GLuint axis[3] = {0, 1, 2};
+
+        for (GLuint r = 0; r < 3; ++r)
+            for (GLuint s = r + 1; s < 3; ++s)
+                if (m[axis[s]][axis[s]] > m[axis[r]][axis[r]])
+                    std::swap(axis[r], axis[s]);
+
+        ColumnMatrix<GLdouble> u(vertex_count), v(vertex_count);
+        ColumnMatrix<DCoordinate3> points(vertex_count);
+
+        TaskScheduler::Instance().ParallelFor(0, vertex_count, [&](GLint chunk_begin, GLint chunk_end)
+        {
+            for (GLint k = chunk_begin; k < chunk_end; ++k)
+            {
+                const DCoordinate3 &vertex = mesh._vertex[k];
+
+                u[k] = v[k] = 0.0;
+
+                for (GLuint r = 0; r < 3; ++r)
+                {
+                    u[k] += (vertex[r] - c[r]) * e[r][axis[0]];
+                    v[k] += (vertex[r] - c[r]) * e[r][axis[1]];
+                }
+
+                points[k] = vertex;
+            }
+        });
+
+        GLdouble u_low = u[0], u_high = u[0], v_low = v[0], v_high = v[0];
+
+        for (GLint k = 1; k < vertex_count; ++k)
+        {
+            u_low  = std::min(u_low, u[k]);
+            u_high = std::max(u_high, u[k]);
+            v_low  = std::min(v_low, v[k]);
+            v_high = std::max(v_high, v[k]);
+        }
+
+        if (u_low >= u_high || v_low >= v_high)
+            return GL_FALSE;
+
+        TaskScheduler::Instance().ParallelFor(0, vertex_count, [&](GLint chunk_begin, GLint chunk_end)
+        {
+            for (GLint k = chunk_begin; k < chunk_end; ++k)
+            {
+                u[k] = std::min(_u_max, _u_min + (_u_max - _u_min) * (u[k] - u_low) / (u_high - u_low));
+                v[k] = std::min(_v_max, _v_min + (_v_max - _v_min) * (v[k] - v_low) / (v_high - v_low));
+            }
+        });
+
+        return UpdateDataForLeastSquaresFitting(u, v, points, smoothing_weight);
+    }
+
+    GLboolean BSplineSurface3::SetWeight(GLuint row, GLuint column, GLdouble weight)
+    {
+        if (row >= _weight.GetRowCount() || column >= _weight.GetColumnCount() || weight <= 0.0)
+            return GL_FALSE;
+
+        _weight(row, column) = weight;
+
+        _rational = GL_FALSE;
+        for (GLuint i = 0; i < _weight.GetRowCount() && !_rational; ++i)
+            for (GLuint j = 0; j < _weight.GetColumnCount() && !_rational; ++j)
+                _rational = (_weight(i, j) != 1.0);
+
+        return GL_TRUE;
+    }
+
+    // get properties
+    GLuint BSplineSurface3::GetUDegree() const
+    {
+        return _u_basis.GetDegree();
+    }
+
+    GLuint BSplineSurface3::GetVDegree() const
+    {
+        return _v_basis.GetDegree();
+    }
+
+    const BSplineBasis& BSplineSurface3::GetUBasis() const
+    {
+        return _u_basis;
+    }
+
+    const BSplineBasis& BSplineSurface3::GetVBasis() const
+    {
+        return _v_basis;
+    }
+
+    GLdouble BSplineSurface3::GetWeight(GLuint row, GLuint column) const
+    {
+        return _weight(row, column);
+    }
+
+    GLboolean BSplineSurface3::IsRational() const
+    {
+        return _rational;
+    }
+
+    GLboolean BSplineSurface3::UBlendingFunctionValues(GLdouble u_knot, RowMatrix<GLdouble> &blending_values) const
+    {
+        if (u_knot < _u_min || u_knot > _u_max)
+            return GL_FALSE;
+
+        GLuint span = _u_basis.FindSpan(u_knot);
+
+        RowMatrix<GLdouble> local_values;
+        _u_basis.Values(span, u_knot, local_values);
+
+        blending_values.ResizeColumns(_data.GetRowCount());
+        for (GLuint i = 0; i < blending_values.GetColumnCount(); ++i)
+            blending_values[i] = 0.0;
+
+        for (GLuint j = 0; j < local_values.GetColumnCount(); ++j)
+            blending_values[span - _u_basis.GetDegree() + j] = local_values[j];
+
+        return GL_TRUE;
+    }
+
+    GLboolean BSplineSurface3::VBlendingFunctionValues(GLdouble v_knot, RowMatrix<GLdouble> &blending_values) const
+    {
+        if (v_knot < _v_min || v_knot > _v_max)
+            return GL_FALSE;
+
+        GLuint span = _v_basis.FindSpan(v_knot);
+
+        RowMatrix<GLdouble> local_values;
+        _v_basis.Values(span, v_knot, local_values);
+
+        blending_values.ResizeColumns(_data.GetColumnCount());
+        for (GLuint j = 0; j < blending_values.GetColumnCount(); ++j)
+            blending_values[j] = 0.0;
+
+        for (GLuint j = 0; j < local_values.GetColumnCount(); ++j)
+            blending_values[span - _v_basis.GetDegree() + j] = local_values[j];
+
+        return GL_TRUE;
+    }
+
+    GLboolean BSplineSurface3::UBlendingFunctionDerivatives(
+            GLuint maximum_order_of_derivatives, GLdouble u_knot, Matrix<GLdouble> &derivatives) const
+    {
+        if (_rational || u_knot < _u_min || u_knot > _u_max)
+            return GL_FALSE;
+
+        GLuint span = _u_basis.FindSpan(u_knot), p = _u_basis.GetDegree();
+
+        Matrix<GLdouble> local_derivatives(maximum_order_of_derivatives + 1, p + 1);
+        _u_basis.Derivatives(span, u_knot, maximum_order_of_derivatives, local_derivatives);
+
+        derivatives.ResizeRows(maximum_order_of_derivatives + 1);
+        derivatives.ResizeColumns(_data.GetRowCount());
+
+        for (GLuint k = 0; k <= maximum_order_of_derivatives; ++k)
+        {
+            for (GLuint i = 0; i < derivatives.GetColumnCount(); ++i)
+                derivatives(k, i) = 0.0;
+
+            for (GLuint j = 0; j <= p; ++j)
+                derivatives(k, span - p + j) = local_derivatives(k, j);
+        }
+
+        return GL_TRUE;
+    }
+
+    GLboolean BSplineSurface3::VBlendingFunctionDerivatives(
+            GLuint maximum_order_of_derivatives, GLdouble v_knot, Matrix<GLdouble> &derivatives) const
+    {
+        if (_rational || v_knot < _v_min || v_knot > _v_max)
+            return GL_FALSE;
+
+        GLuint span = _v_basis.FindSpan(v_knot), q = _v_basis.GetDegree();
+
+        Matrix<GLdouble> local_derivatives(maximum_order_of_derivatives + 1, q + 1);
+        _v_basis.Derivatives(span, v_knot, maximum_order_of_derivatives, local_derivatives);
+
+        derivatives.ResizeRows(maximum_order_of_derivatives + 1);
+        derivatives.ResizeColumns(_data.GetColumnCount());
+
+        for (GLuint k = 0; k <= maximum_order_of_derivatives; ++k)
+        {
+            for (GLuint j = 0; j < derivatives.GetColumnCount(); ++j)
+                derivatives(k, j) = 0.0;
+
+            for (GLuint j = 0; j <= q; ++j)
+                derivatives(k, span - q + j) = local_derivatives(k, j);
+        }
+
+        return GL_TRUE;
+    }
+
+    GLboolean BSplineSurface3::CalculatePartialDerivatives(
+            GLuint maximum_order_of_partial_derivatives,
+            GLdouble u, GLdouble v, PartialDerivatives &pd) const
+    {
+        if (u < _u_min || u > _u_max || v < _v_min || v > _v_max)
+            return GL_FALSE;
+
+        GLuint order = maximum_order_of_partial_derivatives;
+        GLuint p = _u_basis.GetDegree(), q = _v_basis.GetDegree();
+
+        GLuint u_span = _u_basis.FindSpan(u), v_span = _v_basis.FindSpan(v);
+        GLuint first_row = u_span - p, first_column = v_span - q;
+
+        Matrix<GLdouble> u_derivatives(order + 1, p + 1), v_derivatives(order + 1, q + 1);
+        _u_basis.Derivatives(u_span, u, order, u_derivatives);
+        _v_basis.Derivatives(v_span, v, order, v_derivatives);
+
+        // derivatives(k, l) = \partial^{k + l} / \partial u^k \partial v^l of the (homogeneous) surface,
+        // w(k, l) the corresponding derivatives of the weight function
+        Matrix<DCoordinate3> derivatives(order + 1, order + 1);
+        Matrix<GLdouble>     w(order + 1, order + 1);
+        vector<DCoordinate3> temp(q + 1);
+        vector<GLdouble>     temp_w(q + 1);
+
+        for (GLuint k = 0; k <= order; ++k)
+        {
+            for (GLuint l = 0; l <= order - k; ++l)
+            {
+                derivatives(k, l) = DCoordinate3();
+                w(k, l) = 0.0;
+            }
+
+            if (k > p)
+                continue;
+
+            // contract the active rows of the control net with the k-th derivatives in direction u
+            for (GLuint s = 0; s <= q; ++s)
+            {
+                temp[s] = DCoordinate3();
+                temp_w[s] = 0.0;
+
+                for (GLuint r = 0; r <= p; ++r)
+                {
+                    GLdouble coefficient = u_derivatives(k, r);
+
+                    if (_rational)
+                    {
+                        coefficient *= _weight(first_row + r, first_column + s);
+                        temp_w[s] += coefficient;
+                    }
+
+                    temp[s] += coefficient * _data(first_row + r, first_column + s);
+                }
+            }
+
+            for (GLuint l = 0; l <= order - k && l <= q; ++l)
+            {
+                for (GLuint s = 0; s <= q; ++s)
+                {
+                    derivatives(k, l) += v_derivatives(l, s) * temp[s];
+                    w(k, l) += v_derivatives(l, s) * temp_w[s];
+                }
+            }
+        }
+
+        if (_rational)
+        {
+            // S^{(k,l)} = (A^{(k,l)} - sum_{(i,j) != (0,0)} binomial(k, i) binomial(l, j) w^{(i,j)} S^{(k-i,l-j)}) / w
+            TriangularMatrix<GLdouble> binomial(order + 1);
+
+            for (GLuint r = 0; r <= order; ++r)
+            {
+                binomial(r, 0) = binomial(r, r) = 1.0;
+
+                for (GLuint i = 1; i < r; ++i)
+                    binomial(r, i) = binomial(r - 1, i - 1) + binomial(r - 1, i);
+            }
+
+            for (GLuint k = 0; k <= order; ++k)
+            {
+                for (GLuint l = 0; l <= order - k; ++l)
+                {
+                    for (GLuint i = 0; i <= k; ++i)
+                    {
+                        for (GLuint j = 0; j <= l; ++j)
+                        {
+                            if (i == 0 && j == 0)
+                                continue;
+
+                            derivatives(k, l) -= (binomial(k, i) * binomial(l, j) * w(i, j)) * derivatives(k - i, l - j);
+                        }
+                    }
+
+                    derivatives(k, l) /= w(0, 0);
+                }
+            }
+        }
+
+        pd.ResizeRows(order + 1);
+
+        for (GLuint r = 0; r <= order; ++r)
+            for (GLuint j = 0; j <= r; ++j)
+                pd(r, j) = derivatives(r - j, j);
+
+        return GL_TRUE;
+    }
+}
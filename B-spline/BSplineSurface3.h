@@ -0,0 +1,110 @@
+#pragma once
+
+#include "../Core/Matrices.h"
+#include "../Core/TensorProductSurfaces3.h"
+#include "../Core/TriangulatedMeshes3.h"
+#include "BSplineBasis.h"
+
+namespace cagd
+{
+    //----------------------
+    // class BSplineSurface3
+    //----------------------
+    // Tensor product B-spline surface of degrees (p, q) over non-uniform knot vectors in
+    // directions u and v, with optional rational weights. The control point _data(i, j) belongs
+    // to the basis functions N_{i,p}(u) and N_{j,q}(v), i.e., rows correspond to direction u.
+    //
+    // Partial derivatives of any order are evaluated from the (p + 1) x (q + 1) control points
+    // that are active over the knot span pair of the parameters.
+    class BSplineSurface3: public TensorProductSurface3
+    {
+    public:
+        enum Direction { U_DIRECTION = 0, V_DIRECTION };
+
+    protected:
+        BSplineBasis        _u_basis, _v_basis;
+        Matrix<GLdouble>    _weight;
+        GLboolean           _rational;     // GL_TRUE if at least one weight differs from 1
+
+        GLvoid              _UpdateDefinitionDomain();
+
+        // replaces the basis of the given direction, and maps the (homogeneous) control net onto
+        // the new basis; in direction u the columns, in direction v the rows of the control net
+        // are transformed in parallel
+        GLvoid              _Transform(Direction direction, const BSplineBasis &basis,
+                                       const ColumnMatrix<GLuint> &first_index, const Matrix<GLdouble> &alpha);
+
+        GLboolean           _InsertKnot(Direction direction, GLdouble value, GLuint multiplicity);
+        GLboolean           _RefineKnotVector(Direction direction, const ColumnMatrix<GLdouble> &inserted_knots);
+        GLboolean           _ElevateDegree(Direction direction, GLuint times);
+
+    public:
+        // special constructor, creates clamped uniform knot vectors over [0, 1] x [0, 1]
+        BSplineSurface3(GLuint u_degree, GLuint v_degree, GLuint row_count, GLuint column_count);
+
+        // special constructor, the row and column counts are determined by the knot vectors
+        BSplineSurface3(GLuint u_degree, const ColumnMatrix<GLdouble> &u_knot_vector,
+                        GLuint v_degree, const ColumnMatrix<GLdouble> &v_knot_vector);
+
+        // the degrees and the size of the control net are preserved
+        GLboolean SetUKnotVector(const ColumnMatrix<GLdouble> &u_knot_vector);
+        GLboolean SetVKnotVector(const ColumnMatrix<GLdouble> &v_knot_vector);
+
+        // exact refinement operations, the shape of the surface does not change; the vertex
+        // buffer object of the control net is updated if it exists
+        GLboolean InsertUKnot(GLdouble u, GLuint multiplicity = 1);
+        GLboolean InsertVKnot(GLdouble v, GLuint multiplicity = 1);
+
+        GLboolean RefineUKnotVector(const ColumnMatrix<GLdouble> &inserted_knots);
+        GLboolean RefineVKnotVector(const ColumnMatrix<GLdouble> &inserted_knots);
+
+        GLboolean ElevateUDegree(GLuint times = 1);
+        GLboolean ElevateVDegree(GLuint times = 1);
+
+        // least squares fitting with fairness, minimizes
+        //
+        // (1 / M) sum_{k=0}^{M-1} ||s(u_k, v_k) - d_k||^2 +
+        // smoothing_weight * integral ||s_uu||^2 + 2 ||s_uv||^2 + ||s_vv||^2 du dv
+        //
+        // over the control net, while the knot vectors and the weights are preserved (for rational
+        // surfaces the thin plate energy is measured in the non-rational B-spline basis); the
+        // normal equations are banded if the control points are ordered row by row, they are
+        // assembled in parallel and solved by Cholesky decomposition; a positive smoothing weight
+        // is required if the samples do not determine every control point
+        GLboolean UpdateDataForLeastSquaresFitting(const ColumnMatrix<GLdouble> &u, const ColumnMatrix<GLdouble> &v,
+                                                   const ColumnMatrix<DCoordinate3> &points,
+                                                   GLdouble smoothing_weight = 0.0);
+
+        // fits the surface to the vertices of the mesh (e.g., a scan loaded by LoadFromOFF), which
+        // are parametrized by their orthogonal projections onto the least squares plane of the
+        // vertices, such that the bounding rectangle of the projections fills the definition domain
+        GLboolean UpdateDataForLeastSquaresFitting(const TriangulatedMesh3 &mesh, GLdouble smoothing_weight = 0.0);
+
+        // weights have to be positive
+        GLboolean SetWeight(GLuint row, GLuint column, GLdouble weight);
+
+        // get properties
+        GLuint              GetUDegree() const;
+        GLuint              GetVDegree() const;
+        const BSplineBasis& GetUBasis() const;
+        const BSplineBasis& GetVBasis() const;
+        GLdouble            GetWeight(GLuint row, GLuint column) const;
+        GLboolean           IsRational() const;
+
+        // redeclare and define inherited pure virtual methods; the blending functions are the
+        // (non-rational) B-spline functions of the given direction, since the rational basis
+        // does not factor into univariate functions
+        GLboolean UBlendingFunctionValues(GLdouble u_knot, RowMatrix<GLdouble> &blending_values) const;
+        GLboolean VBlendingFunctionValues(GLdouble v_knot, RowMatrix<GLdouble> &blending_values) const;
+
+        // fail for rational surfaces, whose isoparametric lines are evaluated point by point
+        GLboolean UBlendingFunctionDerivatives(GLuint maximum_order_of_derivatives,
+                                               GLdouble u_knot, Matrix<GLdouble> &derivatives) const;
+        GLboolean VBlendingFunctionDerivatives(GLuint maximum_order_of_derivatives,
+                                               GLdouble v_knot, Matrix<GLdouble> &derivatives) const;
+
+        // pd(r, j) = \partial^r s / \partial u^{r - j} \partial v^j, r = 0, ..., maximum order
+        GLboolean CalculatePartialDerivatives(GLuint maximum_order_of_partial_derivatives,
+                                              GLdouble u, GLdouble v, PartialDerivatives &pd) const;
+    };
+}
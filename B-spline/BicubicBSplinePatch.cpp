@@ -3,6 +3,58 @@
 
 using namespace cagd;
 
+// derivatives(k, i) = d^k/dt^k of the i-th uniform cubic B-spline function over [0, 1]
+static GLboolean UniformCubicBSplineDerivatives(
+        GLuint maximum_order_of_derivatives, GLdouble t, Matrix<GLdouble> &derivatives)
+{
+    if (t < 0.0 || t > 1.0)
+        return GL_FALSE;
+
+    derivatives.ResizeRows(maximum_order_of_derivatives + 1);
+    derivatives.ResizeColumns(4);
+
+    GLdouble t2 = t*t, t3 = t2*t;
+    GLdouble w = 1.0 - t, w2 = w*w, w3 = w2*w;
+
+    derivatives(0, 0) = w3/6;
+    derivatives(0, 1) = ((3*t*w2) + (3*w) + 1)/6;
+    derivatives(0, 2) = (3*t2*w + 3*t + 1)/6;
+    derivatives(0, 3) = t3/6;
+
+    for (GLuint k = 1; k <= maximum_order_of_derivatives; ++k)
+    {
+        switch (k)
+        {
+        case 1:
+            derivatives(1, 0) = -0.5 * w2;
+            derivatives(1, 1) = 0.5 * t * (3*t - 4);
+            derivatives(1, 2) = (-3*t2)/2 + t + 0.5;
+            derivatives(1, 3) = 0.5 * t2;
+            break;
+
+        case 2:
+            derivatives(2, 0) = w;
+            derivatives(2, 1) = 3*t - 2;
+            derivatives(2, 2) = -3*t + 1;
+            derivatives(2, 3) = t;
+            break;
+
+        case 3:
+            derivatives(3, 0) = -1.0;
+            derivatives(3, 1) = 3.0;
+            derivatives(3, 2) = -3.0;
+            derivatives(3, 3) = 1.0;
+            break;
+
+        default:
+            for (GLuint i = 0; i < 4; ++i)
+                derivatives(k, i) = 0.0;
+        }
+    }
+
+    return GL_TRUE;
+}
+
 BicubicBSplinePatch::BicubicBSplinePatch(): TensorProductSurface3(0.0, 1.0, 0.0, 1.0, 4, 4)
 {
 }
@@ -43,15 +95,27 @@ GLboolean BicubicBSplinePatch::VBlendingFunctionValues(GLdouble v_knot, RowMatri
     return GL_TRUE;
 }
 
+GLboolean BicubicBSplinePatch::UBlendingFunctionDerivatives(
+        GLuint maximum_order_of_derivatives, GLdouble u_knot, Matrix<GLdouble> &derivatives) const
+{
+    return UniformCubicBSplineDerivatives(maximum_order_of_derivatives, u_knot, derivatives);
+}
+
+GLboolean BicubicBSplinePatch::VBlendingFunctionDerivatives(
+        GLuint maximum_order_of_derivatives, GLdouble v_knot, Matrix<GLdouble> &derivatives) const
+{
+    return UniformCubicBSplineDerivatives(maximum_order_of_derivatives, v_knot, derivatives);
+}
+
 GLboolean BicubicBSplinePatch::CalculatePartialDerivatives(
         GLuint maximum_order_of_partial_derivatives,
         GLdouble u, GLdouble v, PartialDerivatives &pd) const
 {
-    if (u < 0.0 || u > 1.0 || v < 0.0 || v > 1.0 || maximum_order_of_partial_derivatives > 1)
+    if (u < 0.0 || u > 1.0 || v < 0.0 || v > 1.0 || maximum_order_of_partial_derivatives > 2)
         return GL_FALSE;
 
     // blending function values and derivatives in u-direction
-    RowMatrix<GLdouble> u_blending_values(4), d1_u_blending_values(4);
+    RowMatrix<GLdouble> u_blending_values(4), d1_u_blending_values(4), d2_u_blending_values(4);
 
     GLdouble u2 = u*u, u3 = u2*u;
     GLdouble wu = 1.0 - u, wu2 = wu*wu, wu3 = wu2*wu;
@@ -66,8 +130,13 @@ GLboolean BicubicBSplinePatch::CalculatePartialDerivatives(
     d1_u_blending_values(2) = (-3*u2)/2 + u + 0.5;
     d1_u_blending_values(3) = 0.5 * u2;
 
+    d2_u_blending_values(0) = wu;
+    d2_u_blending_values(1) = 3*u - 2;
+    d2_u_blending_values(2) = -3*u + 1;
+    d2_u_blending_values(3) = u;
+
     // blending function values and derivatives in v-direction
-    RowMatrix<GLdouble> v_blending_values(4), d1_v_blending_values(4);
+    RowMatrix<GLdouble> v_blending_values(4), d1_v_blending_values(4), d2_v_blending_values(4);
 
     GLdouble v2 = v*v, v3 = v2*v;
     GLdouble wv = 1.0 - v, wv2 = wv*wv, wv3 = wv2*wv;
@@ -82,20 +151,37 @@ GLboolean BicubicBSplinePatch::CalculatePartialDerivatives(
     d1_v_blending_values(2) = (-3*v2)/2 + v + 0.5;
     d1_v_blending_values(3) =  0.5 * v2;
 
+    d2_v_blending_values(0) = wv;
+    d2_v_blending_values(1) = 3*v - 2;
+    d2_v_blending_values(2) = -3*v + 1;
+    d2_v_blending_values(3) = v;
+
     // calculate partial derivatives
-    pd.ResizeRows(2);
+    // the second order partial derivatives are required e.g. by curvature analyses
+    GLboolean second_order = (maximum_order_of_partial_derivatives == 2);
+
+    pd.ResizeRows(second_order ? 3 : 2);
     pd.LoadNullVectors();
     for (GLuint row = 0; row < 4; ++row)
     {
-        DCoordinate3 aux_d0_v, aux_d1_v;
+        DCoordinate3 aux_d0_v, aux_d1_v, aux_d2_v;
         for (GLuint column = 0; column<4; ++column)
         {
             aux_d0_v += _data(row,column) * v_blending_values(column);
             aux_d1_v += _data(row,column) * d1_v_blending_values(column);
+            if (second_order)
+                aux_d2_v += _data(row,column) * d2_v_blending_values(column);
         }
         pd(0,0) += aux_d0_v * u_blending_values(row);
         pd(1,0) += aux_d0_v * d1_u_blending_values(row);
         pd(1,1) += aux_d1_v * u_blending_values(row);
+
+        if (second_order)
+        {
+            pd(2,0) += aux_d0_v * d2_u_blending_values(row);
+            pd(2,1) += aux_d1_v * d1_u_blending_values(row);
+            pd(2,2) += aux_d2_v * u_blending_values(row);
+        }
     }
     return GL_TRUE;
 }
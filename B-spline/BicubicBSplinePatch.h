@@ -12,6 +12,10 @@ namespace cagd
 
             GLboolean UBlendingFunctionValues(GLdouble u_knot, RowMatrix<GLdouble>& blending_values) const;
             GLboolean VBlendingFunctionValues(GLdouble v_knot, RowMatrix<GLdouble>& blending_values) const;
+            GLboolean UBlendingFunctionDerivatives(GLuint maximum_order_of_derivatives,
+                                                   GLdouble u_knot, Matrix<GLdouble>& derivatives) const;
+            GLboolean VBlendingFunctionDerivatives(GLuint maximum_order_of_derivatives,
+                                                   GLdouble v_knot, Matrix<GLdouble>& derivatives) const;
             GLboolean CalculatePartialDerivatives(GLuint maximum_order_of_partial_derivatives,
                                                   GLdouble u, GLdouble v, PartialDerivatives& pd) const;
 
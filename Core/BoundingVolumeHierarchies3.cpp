@@ -0,0 +1,731 @@
+#include "BoundingVolumeHierarchies3.h"
+#include "TaskSchedulers.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace cagd;
+using namespace std;
+
+// number of centroid bins per axis evaluated by the surface area heuristic
+static const GLuint BIN_COUNT = 16;
+
+// the upper levels of the tree are split by the calling thread until the subtrees become
+// smaller than max(SUBTREE_SIZE, face_count / SUBTREE_COUNT), then the subtrees are built in parallel
+static const GLuint SUBTREE_SIZE  = 1024;
+static const GLuint SUBTREE_COUNT = 64;
+
+static GLdouble HalfSurfaceArea(const DCoordinate3 &low, const DCoordinate3 &high)
+{
+    GLdouble dx = high[0] - low[0], dy = high[1] - low[1], dz = high[2] - low[2];
+
+    return (dx < 0.0) ? 0.0 : dx * dy + dy * dz + dz * dx;
+}
+
+static GLvoid Enlarge(DCoordinate3 &low, DCoordinate3 &high, const DCoordinate3 &low_rhs, const DCoordinate3 &high_rhs)
+{
+    for (GLuint r = 0; r < 3; ++r)
+    {
+        low[r]  = min(low[r], low_rhs[r]);
+        high[r] = max(high[r], high_rhs[r]);
+    }
+}
+
+static GLvoid MakeEmpty(DCoordinate3 &low, DCoordinate3 &high)
+{
+    GLdouble infinity = numeric_limits<GLdouble>::max();
+
+    low  = DCoordinate3(infinity, infinity, infinity);
+    high = DCoordinate3(-infinity, -infinity, -infinity);
+}
+
+// squared distance of a point from an axis aligned box
+static GLdouble SquaredDistance(const DCoordinate3 &point, const DCoordinate3 &low, const DCoordinate3 &high)
+{
+    GLdouble result = 0.0;
+
+    for (GLuint r = 0; r < 3; ++r)
+    {
+        GLdouble d = max(max(low[r] - point[r], point[r] - high[r]), 0.0);
+        result += d * d;
+    }
+
+    return result;
+}
+
+// closest point of the triangle abc to p, expressed as a + u * (b - a) + v * (c - a)
+static GLvoid ClosestPointOnTriangle(const DCoordinate3 &p,
+                                     const DCoordinate3 &a, const DCoordinate3 &b, const DCoordinate3 &c,
+                                     GLdouble &u, GLdouble &v)
+{
+    DCoordinate3 ab = b - a, ac = c - a, ap = p - a;
+
+    GLdouble d1 = ab * ap, d2 = ac * ap;
+    if (d1 <= 0.0 && d2 <= 0.0) { u = 0.0; v = 0.0; return; }
+
+    DCoordinate3 bp = p - b;
+    GLdouble d3 = ab * bp, d4 = ac * bp;
+    if (d3 >= 0.0 && d4 <= d3) { u = 1.0; v = 0.0; return; }
+
+    GLdouble vc = d1 * d4 - d3 * d2;
+    if (vc <= 0.0 && d1 >= 0.0 && d3 <= 0.0) { u = d1 / (d1 - d3); v = 0.0; return; }
+
+    DCoordinate3 cp = p - c;
+    GLdouble d5 = ab * cp, d6 = ac * cp;
+    if (d6 >= 0.0 && d5 <= d6) { u = 0.0; v = 1.0; return; }
+
+    GLdouble vb = d5 * d2 - d1 * d6;
+    if (vb <= 0.0 && d2 >= 0.0 && d6 <= 0.0) { u = 0.0; v = d2 / (d2 - d6); return; }
+
+    GLdouble va = d3 * d6 - d5 * d4;
+    if (va <= 0.0 && d4 - d3 >= 0.0 && d5 - d6 >= 0.0)
+    {
+        v = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+        u = 1.0 - v;
+        return;
+    }
+
+    GLdouble denominator = 1.0 / (va + vb + vc);
+    u = vb * denominator;
+    v = vc * denominator;
+}
+
+// separating axis test of the triangle abc and the box [low, high]
+static GLboolean TriangleOverlapsBox(const DCoordinate3 &a, const DCoordinate3 &b, const DCoordinate3 &c,
+                                     const DCoordinate3 &low, const DCoordinate3 &high)
+{
+    DCoordinate3 center = 0.5 * (low + high), half = 0.5 * (high - low);
+    DCoordinate3 vertex[3] = {a - center, b - center, c - center};
+    DCoordinate3 edge[3]   = {vertex[1] - vertex[0], vertex[2] - vertex[1], vertex[0] - vertex[2]};
+
+    // candidate axes: the 9 cross products of edges and coordinate axes, the 3 coordinate axes
+    // and the normal of the triangle
+    DCoordinate3 axis[13];
+    GLuint       axis_count = 0;
+
+    for (GLuint i = 0; i < 3; ++i)
+    {
+        for (GLuint r = 0; r < 3; ++r)
+        {
+            DCoordinate3 unit;
+            unit[r] = 1.0;
+            axis[axis_count++] = edge[i] ^ unit;
+        }
+    }
+
+    for (GLuint r = 0; r < 3; ++r)
+    {
+        axis[axis_count] = DCoordinate3();
+        axis[axis_count++][r] = 1.0;
+    }
+
+    axis[axis_count++] = edge[0] ^ edge[1];
+
+    for (GLuint k = 0; k < axis_count; ++k)
+    {
+        const DCoordinate3 &n = axis[k];
+
+        GLdouble p0 = n * vertex[0], p1 = n * vertex[1], p2 = n * vertex[2];
+        GLdouble radius = half[0] * fabs(n[0]) + half[1] * fabs(n[1]) + half[2] * fabs(n[2]);
+
+        if (min(p0, min(p1, p2)) > radius || max(p0, max(p1, p2)) < -radius)
+            return GL_FALSE;
+    }
+
+    return GL_TRUE;
+}
+
+// default constructor
+BoundingVolumeHierarchy3::BoundingVolumeHierarchy3():
+        _node_count(0),
+        _maximum_leaf_size(4)
+{
+}
+
+GLboolean BoundingVolumeHierarchy3::Build(const TriangulatedMesh3 &mesh, GLuint maximum_leaf_size)
+{
+    return Build(vector<const TriangulatedMesh3*>(1, &mesh), maximum_leaf_size);
+}
+
+GLboolean BoundingVolumeHierarchy3::Build(const vector<const TriangulatedMesh3*> &meshes, GLuint maximum_leaf_size)
+{
+    _mesh = meshes;
+    _maximum_leaf_size = max(maximum_leaf_size, 1u);
+
+    GLuint mesh_count = (GLuint)_mesh.size();
+
+    _vertex_offset.assign(mesh_count + 1, 0);
+    _face_offset.assign(mesh_count + 1, 0);
+
+    for (GLuint i = 0; i < mesh_count; ++i)
+    {
+        _vertex_offset[i + 1] = _vertex_offset[i] + (_mesh[i] ? _mesh[i]->VertexCount() : 0);
+        _face_offset[i + 1]   = _face_offset[i] + (_mesh[i] ? _mesh[i]->FaceCount() : 0);
+    }
+
+    GLuint face_count = _face_offset[mesh_count];
+
+    _vertex.resize(_vertex_offset[mesh_count]);
+    _triangle.resize(3 * face_count);
+    _primitive.resize(face_count);
+    _node.clear();
+    _node_count = 0;
+
+    if (!face_count)
+        return GL_FALSE;
+
+    for (GLuint i = 0; i < mesh_count; ++i)
+    {
+        if (!_mesh[i])
+            continue;
+
+        for (GLuint v = 0; v < _mesh[i]->VertexCount(); ++v)
+            _vertex[_vertex_offset[i] + v] = _mesh[i]->Vertex(v);
+
+        for (GLuint f = 0; f < _mesh[i]->FaceCount(); ++f)
+            for (GLuint k = 0; k < 3; ++k)
+                _triangle[3 * (_face_offset[i] + f) + k] = _vertex_offset[i] + _mesh[i]->_face[f][k];
+    }
+
+    // bounding boxes and centroids of the faces
+    vector<DCoordinate3> low(face_count), high(face_count), centroid(face_count);
+
+    TaskScheduler::Instance().ParallelFor(0, (GLint)face_count, [&](GLint chunk_begin, GLint chunk_end)
+    {
+        for (GLint f = chunk_begin; f < chunk_end; ++f)
+        {
+            _primitive[f] = f;
+
+            const DCoordinate3 &a = _vertex[_triangle[3 * f]];
+            const DCoordinate3 &b = _vertex[_triangle[3 * f + 1]];
+            const DCoordinate3 &c = _vertex[_triangle[3 * f + 2]];
+
+            low[f] = high[f] = a;
+            Enlarge(low[f], high[f], b, b);
+            Enlarge(low[f], high[f], c, c);
+
+            centroid[f] = a;
+            centroid[f] += b;
+            centroid[f] += c;
+            centroid[f] /= 3.0;
+        }
+    });
+
+    // a binary tree with at most one face per leaf has 2 * face_count - 1 nodes, since the
+    // storage is never reallocated, concurrent threads may write disjoint nodes
+    _node.resize(2 * face_count - 1);
+
+    atomic<GLuint> allocated_node_count(1);
+    vector<BuildTask> subtrees;
+
+    _Build(0, 0, face_count, low, high, centroid, allocated_node_count,
+           max(SUBTREE_SIZE, face_count / SUBTREE_COUNT), &subtrees);
+
+    TaskScheduler::Instance().ParallelFor(0, (GLint)subtrees.size(), [&](GLint chunk_begin, GLint chunk_end)
+    {
+        for (GLint i = chunk_begin; i < chunk_end; ++i)
+            _Build(subtrees[i].node_index, subtrees[i].begin, subtrees[i].end, low, high, centroid,
+                   allocated_node_count, 0, 0);
+    }, 1);
+
+    _node_count = allocated_node_count;
+    _node.resize(_node_count);
+
+    return GL_TRUE;
+}
+
+GLvoid BoundingVolumeHierarchy3::_Build(GLuint node_index, GLuint begin, GLuint end,
+                                        const vector<DCoordinate3> &low, const vector<DCoordinate3> &high,
+                                        const vector<DCoordinate3> &centroid, atomic<GLuint> &allocated_node_count,
+                                        GLuint subtree_size, vector<BuildTask> *subtrees)
+{
+    if (subtrees && end - begin < subtree_size)
+    {
+        BuildTask task = {node_index, begin, end};
+        subtrees->push_back(task);
+        return;
+    }
+
+    Node &node = _node[node_index];
+
+    DCoordinate3 centroid_low, centroid_high;
+
+    MakeEmpty(node.low, node.high);
+    MakeEmpty(centroid_low, centroid_high);
+
+    for (GLuint i = begin; i < end; ++i)
+    {
+        GLuint f = _primitive[i];
+
+        Enlarge(node.low, node.high, low[f], high[f]);
+        Enlarge(centroid_low, centroid_high, centroid[f], centroid[f]);
+    }
+
+    GLuint count = end - begin;
+
+    node.first = begin;
+    node.count = count;
+
+    if (count == 1)
+        return;
+
+    // the split is evaluated between the bins of every axis, the expected cost of a subdivision
+    // is 1 + (area(left) * count(left) + area(right) * count(right)) / area(node), while that of
+    // a leaf is count
+    GLdouble best_cost  = numeric_limits<GLdouble>::max();
+    GLuint   best_axis  = 0, best_split = 0;
+    GLdouble node_area  = HalfSurfaceArea(node.low, node.high);
+
+    for (GLuint axis = 0; axis < 3; ++axis)
+    {
+        GLdouble extent = centroid_high[axis] - centroid_low[axis];
+
+        if (extent <= 0.0)
+            continue;
+
+        GLuint       bin_count[BIN_COUNT] = {0};
+        DCoordinate3 bin_low[BIN_COUNT], bin_high[BIN_COUNT];
+
+        for (GLuint b = 0; b < BIN_COUNT; ++b)
+            MakeEmpty(bin_low[b], bin_high[b]);
+
+        GLdouble scale = BIN_COUNT / extent;
+
+        for (GLuint i = begin; i < end; ++i)
+        {
+            GLuint f = _primitive[i];
+            GLuint b = min((GLuint)((centroid[f][axis] - centroid_low[axis]) * scale), BIN_COUNT - 1);
+
+            ++bin_count[b];
+            Enlarge(bin_low[b], bin_high[b], low[f], high[f]);
+        }
+
+        // right_area[b] and right_count[b] describe the union of the bins b, ..., BIN_COUNT - 1
+        GLdouble     right_area[BIN_COUNT];
+        GLuint       right_count[BIN_COUNT];
+        DCoordinate3 box_low, box_high;
+        GLuint       accumulated = 0;
+
+        MakeEmpty(box_low, box_high);
+
+        for (GLint b = BIN_COUNT - 1; b > 0; --b)
+        {
+            Enlarge(box_low, box_high, bin_low[b], bin_high[b]);
+            accumulated += bin_count[b];
+
+            right_area[b]  = HalfSurfaceArea(box_low, box_high);
+            right_count[b] = accumulated;
+        }
+
+        MakeEmpty(box_low, box_high);
+        accumulated = 0;
+
+        for (GLuint b = 1; b < BIN_COUNT; ++b)
+        {
+            Enlarge(box_low, box_high, bin_low[b - 1], bin_high[b - 1]);
+            accumulated += bin_count[b - 1];
+
+            if (!accumulated || !right_count[b])
+                continue;
+
+            GLdouble cost = HalfSurfaceArea(box_low, box_high) * accumulated + right_area[b] * right_count[b];
+
+            if (cost < best_cost)
+            {
+                best_cost  = cost;
+                best_axis  = axis;
+                best_split = b;
+            }
+        }
+    }
+
+    GLuint middle;
+
+    if (best_split)
+    {
+        if (node_area > 0.0 && 1.0 + best_cost / node_area >= count && count <= _maximum_leaf_size)
+            return;
+
+        GLdouble scale = BIN_COUNT / (centroid_high[best_axis] - centroid_low[best_axis]);
+
+        middle = (GLuint)(partition(_primitive.begin() + begin, _primitive.begin() + end,
+                                    [&](GLuint f)
+                                    {
+                                        return min((GLuint)((centroid[f][best_axis] - centroid_low[best_axis]) * scale),
+                                                   BIN_COUNT - 1) < best_split;
+                                    }) - _primitive.begin());
+    }
+    else
+    {
+        // all centroids coincide, the faces are halved arbitrarily unless they fit into a leaf
+        if (count <= _maximum_leaf_size)
+            return;
+
+        middle = (begin + end) / 2;
+    }
+
+    GLuint first_child = allocated_node_count.fetch_add(2);
+
+    node.first = first_child;
+    node.count = 0;
+
+    _Build(first_child, begin, middle, low, high, centroid, allocated_node_count, subtree_size, subtrees);
+    _Build(first_child + 1, middle, end, low, high, centroid, allocated_node_count, subtree_size, subtrees);
+}
+
+GLvoid BoundingVolumeHierarchy3::_UpdateLeaf(Node &node) const
+{
+    MakeEmpty(node.low, node.high);
+
+    for (GLuint i = node.first; i < node.first + node.count; ++i)
+    {
+        for (GLuint k = 0; k < 3; ++k)
+        {
+            const DCoordinate3 &p = _vertex[_triangle[3 * _primitive[i] + k]];
+            Enlarge(node.low, node.high, p, p);
+        }
+    }
+}
+
+GLvoid BoundingVolumeHierarchy3::Refit(GLdouble displacement_along_normals)
+{
+    if (!_node_count)
+        return;
+
+    for (GLuint i = 0; i < _mesh.size(); ++i)
+    {
+        if (!_mesh[i])
+            continue;
+
+        const TriangulatedMesh3 &mesh = *_mesh[i];
+        GLint count = (GLint)min(mesh.VertexCount(), _vertex_offset[i + 1] - _vertex_offset[i]);
+
+        TaskScheduler::Instance().ParallelFor(0, count, [&](GLint chunk_begin, GLint chunk_end)
+        {
+            for (GLint j = chunk_begin; j < chunk_end; ++j)
+            {
+                DCoordinate3 &p = _vertex[_vertex_offset[i] + j];
+
+                p = mesh.Vertex(j);
+
+                if (displacement_along_normals != 0.0)
+                    p += displacement_along_normals * mesh.Normal(j);
+            }
+        });
+    }
+
+    // leaves are independent, inner nodes are processed from the last one to the root
+    TaskScheduler::Instance().ParallelFor(0, (GLint)_node_count, [&](GLint chunk_begin, GLint chunk_end)
+    {
+        for (GLint i = chunk_begin; i < chunk_end; ++i)
+            if (_node[i].count)
+                _UpdateLeaf(_node[i]);
+    });
+
+    for (GLint i = (GLint)_node_count - 1; i >= 0; --i)
+    {
+        Node &node = _node[i];
+
+        if (node.count)
+            continue;
+
+        node.low  = _node[node.first].low;
+        node.high = _node[node.first].high;
+        Enlarge(node.low, node.high, _node[node.first + 1].low, _node[node.first + 1].high);
+    }
+}
+
+GLvoid BoundingVolumeHierarchy3::Clear()
+{
+    _mesh.clear();
+    _vertex_offset.clear();
+    _face_offset.clear();
+    _vertex.clear();
+    _triangle.clear();
+    _primitive.clear();
+    _node.clear();
+    _node_count = 0;
+}
+
+GLboolean BoundingVolumeHierarchy3::IsEmpty() const
+{
+    return !_node_count;
+}
+
+GLuint BoundingVolumeHierarchy3::GetNodeCount() const
+{
+    return _node_count;
+}
+
+GLvoid BoundingVolumeHierarchy3::GetBoundingBox(DCoordinate3 &low, DCoordinate3 &high) const
+{
+    if (_node_count)
+    {
+        low  = _node[0].low;
+        high = _node[0].high;
+    }
+    else
+        MakeEmpty(low, high);
+}
+
+GLvoid BoundingVolumeHierarchy3::_DecomposeFaceIndex(GLuint global_face_index, GLuint &mesh_index, GLuint &face_index) const
+{
+    mesh_index = (GLuint)(upper_bound(_face_offset.begin(), _face_offset.end(), global_face_index) - _face_offset.begin()) - 1;
+    face_index = global_face_index - _face_offset[mesh_index];
+}
+
+GLboolean BoundingVolumeHierarchy3::IntersectRay(const DCoordinate3 &origin, const DCoordinate3 &direction, Hit &hit,
+                                                 GLdouble maximum_distance) const
+{
+    if (!_node_count)
+        return GL_FALSE;
+
+    DCoordinate3 inverse;
+    for (GLuint r = 0; r < 3; ++r)
+        inverse[r] = 1.0 / direction[r];    // infinite components are handled by the slab test
+
+    GLdouble best = maximum_distance;
+    GLuint   best_face = 0;
+    GLdouble best_u = 0.0, best_v = 0.0;
+    GLboolean found = GL_FALSE;
+
+    // returns the entry parameter of the ray into the box of the given node, or infinity
+    auto entry = [&](const Node &node) -> GLdouble
+    {
+        GLdouble t_min = 0.0, t_max = best;
+
+        for (GLuint r = 0; r < 3; ++r)
+        {
+            GLdouble t0 = (node.low[r] - origin[r]) * inverse[r];
+            GLdouble t1 = (node.high[r] - origin[r]) * inverse[r];
+
+            if (t0 > t1)
+                swap(t0, t1);
+
+            t_min = max(t_min, t0);
+            t_max = min(t_max, t1);
+
+            // NaN, i.e. 0 * infinity, means that the ray lies on a slab boundary
+            if (t_min > t_max)
+                return numeric_limits<GLdouble>::infinity();
+        }
+
+        return t_min;
+    };
+
+    vector<GLuint> stack;
+    stack.reserve(64);
+
+    if (entry(_node[0]) == numeric_limits<GLdouble>::infinity())
+        return GL_FALSE;
+
+    stack.push_back(0);
+
+    while (!stack.empty())
+    {
+        const Node &node = _node[stack.back()];
+        stack.pop_back();
+
+        if (node.count)
+        {
+            // Moller-Trumbore intersection test of both sides of the faces
+            for (GLuint i = node.first; i < node.first + node.count; ++i)
+            {
+                GLuint f = _primitive[i];
+
+                const DCoordinate3 &a = _vertex[_triangle[3 * f]];
+                DCoordinate3 ab = _vertex[_triangle[3 * f + 1]] - a;
+                DCoordinate3 ac = _vertex[_triangle[3 * f + 2]] - a;
+
+                DCoordinate3 p = direction ^ ac;
+                GLdouble determinant = ab * p;
+
+                if (fabs(determinant) < numeric_limits<GLdouble>::min())
+                    continue;
+
+                GLdouble inverse_determinant = 1.0 / determinant;
+
+                DCoordinate3 s = origin - a;
+                GLdouble u = (s * p) * inverse_determinant;
+
+                if (u < 0.0 || u > 1.0)
+                    continue;
+
+                DCoordinate3 q = s ^ ab;
+                GLdouble v = (direction * q) * inverse_determinant;
+
+                if (v < 0.0 || u + v > 1.0)
+                    continue;
+
+                GLdouble t = (ac * q) * inverse_determinant;
+
+                if (t >= 0.0 && t <= best)
+                {
+                    best      = t;
+                    best_face = f;
+                    best_u    = u;
+                    best_v    = v;
+                    found     = GL_TRUE;
+                }
+            }
+
+            continue;
+        }
+
+        // the nearer child is visited first
+        GLdouble t_first  = entry(_node[node.first]);
+        GLdouble t_second = entry(_node[node.first + 1]);
+
+        GLuint first = node.first, second = node.first + 1;
+
+        if (t_second < t_first)
+        {
+            swap(t_first, t_second);
+            swap(first, second);
+        }
+
+        if (t_second != numeric_limits<GLdouble>::infinity())
+            stack.push_back(second);
+
+        if (t_first != numeric_limits<GLdouble>::infinity())
+            stack.push_back(first);
+    }
+
+    if (!found)
+        return GL_FALSE;
+
+    _DecomposeFaceIndex(best_face, hit.mesh_index, hit.face_index);
+
+    hit.distance = best;
+    hit.u        = best_u;
+    hit.v        = best_v;
+    hit.point    = origin + best * direction;
+
+    return GL_TRUE;
+}
+
+GLboolean BoundingVolumeHierarchy3::FindNearestFace(const DCoordinate3 &point, Hit &hit) const
+{
+    if (!_node_count)
+        return GL_FALSE;
+
+    GLdouble best = numeric_limits<GLdouble>::max();
+    GLuint   best_face = 0;
+    GLdouble best_u = 0.0, best_v = 0.0;
+
+    vector<GLuint> stack;
+    stack.reserve(64);
+
+    stack.push_back(0);
+
+    while (!stack.empty())
+    {
+        const Node &node = _node[stack.back()];
+        stack.pop_back();
+
+        if (SquaredDistance(point, node.low, node.high) >= best)
+            continue;
+
+        if (node.count)
+        {
+            for (GLuint i = node.first; i < node.first + node.count; ++i)
+            {
+                GLuint f = _primitive[i];
+
+                const DCoordinate3 &a = _vertex[_triangle[3 * f]];
+                const DCoordinate3 &b = _vertex[_triangle[3 * f + 1]];
+                const DCoordinate3 &c = _vertex[_triangle[3 * f + 2]];
+
+                GLdouble u, v;
+                ClosestPointOnTriangle(point, a, b, c, u, v);
+
+                DCoordinate3 difference = a + u * (b - a) + v * (c - a) - point;
+                GLdouble d = difference * difference;
+
+                if (d < best)
+                {
+                    best      = d;
+                    best_face = f;
+                    best_u    = u;
+                    best_v    = v;
+                }
+            }
+
+            continue;
+        }
+
+        // the nearer child is visited first
+        GLuint first = node.first, second = node.first + 1;
+
+        if (SquaredDistance(point, _node[second].low, _node[second].high) <
+            SquaredDistance(point, _node[first].low, _node[first].high))
+            swap(first, second);
+
+        stack.push_back(second);
+        stack.push_back(first);
+    }
+
+    _DecomposeFaceIndex(best_face, hit.mesh_index, hit.face_index);
+
+    const DCoordinate3 &a = _vertex[_triangle[3 * best_face]];
+    const DCoordinate3 &b = _vertex[_triangle[3 * best_face + 1]];
+    const DCoordinate3 &c = _vertex[_triangle[3 * best_face + 2]];
+
+    hit.u        = best_u;
+    hit.v        = best_v;
+    hit.point    = a + best_u * (b - a) + best_v * (c - a);
+    hit.distance = sqrt(best);
+
+    return GL_TRUE;
+}
+
+GLvoid BoundingVolumeHierarchy3::FindOverlappingFaces(const DCoordinate3 &low, const DCoordinate3 &high,
+                                                      vector<GLuint> &mesh_indices, vector<GLuint> &face_indices) const
+{
+    mesh_indices.clear();
+    face_indices.clear();
+
+    if (!_node_count)
+        return;
+
+    vector<GLuint> stack;
+    stack.reserve(64);
+
+    stack.push_back(0);
+
+    while (!stack.empty())
+    {
+        const Node &node = _node[stack.back()];
+        stack.pop_back();
+
+        GLboolean disjoint = GL_FALSE;
+        for (GLuint r = 0; r < 3 && !disjoint; ++r)
+            disjoint = (node.low[r] > high[r] || node.high[r] < low[r]);
+
+        if (disjoint)
+            continue;
+
+        if (node.count)
+        {
+            for (GLuint i = node.first; i < node.first + node.count; ++i)
+            {
+                GLuint f = _primitive[i];
+
+                if (TriangleOverlapsBox(_vertex[_triangle[3 * f]], _vertex[_triangle[3 * f + 1]],
+                                        _vertex[_triangle[3 * f + 2]], low, high))
+                {
+                    GLuint mesh_index, face_index;
+                    _DecomposeFaceIndex(f, mesh_index, face_index);
+
+                    mesh_indices.push_back(mesh_index);
+                    face_indices.push_back(face_index);
+                }
+            }
+
+            continue;
+        }
+
+        stack.push_back(node.first);
+        stack.push_back(node.first + 1);
+    }
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <atomic>
+#include <vector>
+#include "DCoordinates3.h"
+#include "TriangulatedMeshes3.h"
+
+namespace cagd
+{
+    //-------------------------------
+    // class BoundingVolumeHierarchy3
+    //-------------------------------
+    // Binary tree of axis aligned bounding boxes over the faces of one or more triangulated meshes,
+    // e.g. over all patch images of a quilt. Every split is chosen by the surface area heuristic
+    // evaluated over binned face centroids, independent subtrees are built by concurrent threads.
+    //
+    // The tree stores its own copy of the vertices, thus the meshes may be rendered or streamed
+    // freely, but they must outlive the hierarchy. If the vertices move without changing the
+    // connectivity (e.g. the breathing animation of models), Refit() updates the boxes in linear
+    // time while the topology of the tree is kept.
+    //
+    // Queries are const and can be issued concurrently from several threads.
+    class BoundingVolumeHierarchy3
+    {
+    public:
+        // result of ray casting and nearest face queries
+        class Hit
+        {
+        public:
+            GLuint       mesh_index, face_index;
+            DCoordinate3 point;
+            GLdouble     distance;      // along the ray, or from the query point
+            GLdouble     u, v;          // barycentric coordinates of point w.r.t. the 2nd and 3rd node of the face
+        };
+
+    protected:
+        // count > 0: leaf that references the faces _primitive[first], ..., _primitive[first + count - 1]
+        // count = 0: inner node whose children are stored at the positions first and first + 1
+        class Node
+        {
+        public:
+            DCoordinate3 low, high;
+            GLuint       first, count;
+        };
+
+        std::vector<const TriangulatedMesh3*> _mesh;
+        std::vector<GLuint>         _vertex_offset;     // prefix sums of vertex counts
+        std::vector<GLuint>         _face_offset;       // prefix sums of face counts
+        std::vector<DCoordinate3>   _vertex;            // vertices of all meshes, concatenated
+        std::vector<GLuint>         _triangle;          // 3 global vertex indices per face
+        std::vector<GLuint>         _primitive;         // permutation of the faces, grouped by leaves
+        std::vector<Node>           _node;              // children are always stored after their parent
+        GLuint                      _node_count;
+        GLuint                      _maximum_leaf_size;
+
+        // subtree whose construction is deferred, the faces _primitive[begin], ..., _primitive[end - 1]
+        // belong to the node stored at position node_index
+        class BuildTask
+        {
+        public:
+            GLuint node_index, begin, end;
+        };
+
+        // child nodes are allocated in pairs from the pre-sized node array by incrementing
+        // allocated_node_count, which is shared by the concurrently built subtrees of a single build;
+        // if subtrees is not null, ranges of fewer than subtree_size faces are appended to it
+        // instead of being processed
+        GLvoid    _Build(GLuint node_index, GLuint begin, GLuint end,
+                         const std::vector<DCoordinate3> &low, const std::vector<DCoordinate3> &high,
+                         const std::vector<DCoordinate3> &centroid, std::atomic<GLuint> &allocated_node_count,
+                         GLuint subtree_size, std::vector<BuildTask> *subtrees);
+        GLvoid    _UpdateLeaf(Node &node) const;
+        GLvoid    _DecomposeFaceIndex(GLuint global_face_index, GLuint &mesh_index, GLuint &face_index) const;
+
+    public:
+        // default constructor
+        BoundingVolumeHierarchy3();
+
+        // the previous tree is discarded; returns GL_FALSE if the meshes do not contain any faces
+        GLboolean Build(const TriangulatedMesh3 &mesh, GLuint maximum_leaf_size = 4);
+        GLboolean Build(const std::vector<const TriangulatedMesh3*> &meshes, GLuint maximum_leaf_size = 4);
+
+        // discards the tree and the references to the meshes
+        GLvoid    Clear();
+
+        // recomputes the bounding boxes after the vertices of the meshes have been modified in
+        // place, or, if the displacement is nonzero, for the vertices offset along their unit
+        // normal vectors (as done by TriangulatedMesh3::StreamDisplacementAlongNormals)
+        GLvoid    Refit(GLdouble displacement_along_normals = 0.0);
+
+        // get properties
+        GLboolean IsEmpty() const;
+        GLuint    GetNodeCount() const;
+        GLvoid    GetBoundingBox(DCoordinate3 &low, DCoordinate3 &high) const;
+
+        // closest intersection of the ray origin + t * direction, where 0 <= t <= maximum_distance,
+        // the direction does not need to be normalized
+        GLboolean IntersectRay(const DCoordinate3 &origin, const DCoordinate3 &direction, Hit &hit,
+                               GLdouble maximum_distance = 1.0e300) const;
+
+        // closest point of all faces to the given one
+        GLboolean FindNearestFace(const DCoordinate3 &point, Hit &hit) const;
+
+        // lists the faces that intersect the axis aligned box [low, high]
+        GLvoid    FindOverlappingFaces(const DCoordinate3 &low, const DCoordinate3 &high,
+                                       std::vector<GLuint> &mesh_indices, std::vector<GLuint> &face_indices) const;
+    };
+}
@@ -0,0 +1,132 @@
+#include "ControlPointIndices3.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace cagd;
+using namespace std;
+
+// special and default constructor
+ControlPointIndex3::Reference::Reference(GLuint owner, GLuint row, GLuint column):
+        owner(owner), row(row), column(column)
+{
+}
+
+GLboolean ControlPointIndex3::Build(const vector<DCoordinate3> &positions, const vector<Reference> &references)
+{
+    Clear();
+
+    if (positions.size() != references.size())
+        return GL_FALSE;
+
+    GLuint count = (GLuint)positions.size();
+
+    // the slots are sorted lexicographically by their positions, thus coinciding points form runs
+    vector<GLuint> order(count);
+
+    for (GLuint k = 0; k < count; ++k)
+        order[k] = k;
+
+    sort(order.begin(), order.end(),
+         [&positions](GLuint lhs, GLuint rhs)
+         {
+             const DCoordinate3 &a = positions[lhs], &b = positions[rhs];
+
+             if (a.x() != b.x())
+                 return a.x() < b.x();
+
+             if (a.y() != b.y())
+                 return a.y() < b.y();
+
+             return a.z() < b.z();
+         });
+
+    _reference.reserve(count);
+
+    for (GLuint k = 0; k < count; ++k)
+    {
+        const DCoordinate3 &position = positions[order[k]];
+
+        if (_point.empty() || position.x() != _point.back().x() ||
+            position.y() != _point.back().y() || position.z() != _point.back().z())
+        {
+            _point.push_back(position);
+            _first_reference.push_back(k);
+        }
+
+        _reference.push_back(references[order[k]]);
+    }
+
+    _first_reference.push_back(count);
+
+    _tree.Build(_point);
+
+    return GL_TRUE;
+}
+
+GLvoid ControlPointIndex3::Clear()
+{
+    _point.clear();
+    _first_reference.clear();
+    _reference.clear();
+    _tree.Build(_point);
+}
+
+GLboolean ControlPointIndex3::IsEmpty() const
+{
+    return _point.empty();
+}
+
+GLuint ControlPointIndex3::GetPointCount() const
+{
+    return (GLuint)_point.size();
+}
+
+const DCoordinate3& ControlPointIndex3::GetPoint(GLuint index) const
+{
+    return _point[index];
+}
+
+GLuint ControlPointIndex3::GetReferenceCount(GLuint index) const
+{
+    return _first_reference[index + 1] - _first_reference[index];
+}
+
+const ControlPointIndex3::Reference& ControlPointIndex3::GetReference(GLuint index, GLuint k) const
+{
+    return _reference[_first_reference[index] + k];
+}
+
+GLboolean ControlPointIndex3::GetBoundingBox(DCoordinate3 &low, DCoordinate3 &high) const
+{
+    return _tree.GetBoundingBox(low, high);
+}
+
+GLboolean ControlPointIndex3::FindNearest(const DCoordinate3 &query, GLuint &index, GLdouble &distance) const
+{
+    GLdouble squared_distance;
+
+    if (!_tree.FindNearest(query, index, squared_distance))
+        return GL_FALSE;
+
+    distance = sqrt(squared_distance);
+
+    return GL_TRUE;
+}
+
+GLboolean ControlPointIndex3::Pick(const DCoordinate3 &origin, const DCoordinate3 &direction, GLdouble radius,
+                                   GLuint &index) const
+{
+    GLdouble parameter;
+
+    return _tree.FindNearestToRay(origin, direction, radius, index, parameter);
+}
+
+GLboolean ControlPointIndex3::MovePoint(GLuint index, const DCoordinate3 &position)
+{
+    if (index >= _point.size())
+        return GL_FALSE;
+
+    _point[index] = position;
+
+    return _tree.SetPoint(index, position);
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <vector>
+#include "DCoordinates3.h"
+#include "KdTrees3.h"
+
+namespace cagd
+{
+    //-------------------------
+    // class ControlPointIndex3
+    //-------------------------
+    // Spatial index over the control points of a collection of patches or arcs. Control points
+    // that coincide exactly, e.g. the grid points shared by the neighbouring patches of a quilt,
+    // are merged into a single point that stores the list of slots (owner, row, column) referencing
+    // it. Points are located by ray picking or nearest neighbour queries in O(log n) expected time,
+    // and a moved point only requires the update of its own slots.
+    class ControlPointIndex3
+    {
+    public:
+        // slot of a control point: the owner is an arbitrary identifier of a patch or arc, e.g.
+        // pi * column count + pj for a patch of a quilt, the row and column locate the point in it
+        class Reference
+        {
+        public:
+            GLuint owner, row, column;
+
+            Reference(GLuint owner = 0, GLuint row = 0, GLuint column = 0);
+        };
+
+    protected:
+        std::vector<DCoordinate3>   _point;             // distinct positions
+        std::vector<GLuint>         _first_reference;   // the slots of point i are _reference[_first_reference[i]],
+        std::vector<Reference>      _reference;         // ..., _reference[_first_reference[i + 1] - 1]
+        KdTree3                     _tree;
+
+    public:
+        // the position of the slot references[k] is positions[k], exactly equal positions are merged
+        GLboolean Build(const std::vector<DCoordinate3> &positions, const std::vector<Reference> &references);
+        GLvoid    Clear();
+
+        // get properties
+        GLboolean IsEmpty() const;
+        GLuint    GetPointCount() const;
+        const DCoordinate3& GetPoint(GLuint index) const;
+        GLuint    GetReferenceCount(GLuint index) const;
+        const Reference& GetReference(GLuint index, GLuint k) const;
+        GLboolean GetBoundingBox(DCoordinate3 &low, DCoordinate3 &high) const;
+
+        // the point closest to the query
+        GLboolean FindNearest(const DCoordinate3 &query, GLuint &index, GLdouble &distance) const;
+
+        // the first point along the ray origin + t * direction (t >= 0) whose distance from the ray
+        // is at most radius
+        GLboolean Pick(const DCoordinate3 &origin, const DCoordinate3 &direction, GLdouble radius, GLuint &index) const;
+
+        // updates the position of a point, the referencing slots have to be updated by the caller
+        GLboolean MovePoint(GLuint index, const DCoordinate3 &position);
+    };
+}
@@ -0,0 +1,347 @@
+#include "CurvatureAnalyses3.h"
+#include "Constants.h"
+#include "TaskSchedulers.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace cagd;
+using namespace std;
+
+// default constructor
+CurvatureAnalysis3::CurvatureAnalysis3():
+        _singular_count(0)
+{
+}
+
+GLvoid CurvatureAnalysis3::_Resize(GLuint vertex_count)
+{
+    for (GLuint q = 0; q < QUANTITY_COUNT; ++q)
+        _value[q].assign(vertex_count, 0.0);
+
+    _singular_count = 0;
+}
+
+GLvoid CurvatureAnalysis3::_Store(GLuint vertex, GLdouble gaussian, GLdouble mean)
+{
+    // the principal curvatures are the roots of k^2 - 2Hk + K, the discriminant is clamped since
+    // the discrete estimates are not necessarily consistent
+    GLdouble root = sqrt(max(mean * mean - gaussian, 0.0));
+
+    _value[GAUSSIAN][vertex]          = gaussian;
+    _value[MEAN][vertex]              = mean;
+    _value[MAXIMUM_PRINCIPAL][vertex] = mean + root;
+    _value[MINIMUM_PRINCIPAL][vertex] = mean - root;
+}
+
+GLboolean CurvatureAnalysis3::Evaluate(const DCoordinate3 &s_u, const DCoordinate3 &s_v,
+                                       const DCoordinate3 &s_uu, const DCoordinate3 &s_uv, const DCoordinate3 &s_vv,
+                                       GLdouble &gaussian, GLdouble &mean)
+{
+    // coefficients of the first fundamental form
+    GLdouble E = s_u * s_u, F = s_u * s_v, G = s_v * s_v;
+    GLdouble determinant = E * G - F * F;
+
+    if (determinant <= 1.0e-14 * E * G || determinant <= 0.0)
+        return GL_FALSE;
+
+    DCoordinate3 normal = s_u ^ s_v;
+    normal /= sqrt(determinant);
+
+    // coefficients of the second fundamental form
+    GLdouble L = s_uu * normal, M = s_uv * normal, N = s_vv * normal;
+
+    gaussian = (L * N - M * M) / determinant;
+    mean     = (E * N - 2.0 * F * M + G * L) / (2.0 * determinant);
+
+    return GL_TRUE;
+}
+
+GLboolean CurvatureAnalysis3::Analyze(const TensorProductSurface3 &surface, GLuint u_div_point_count, GLuint v_div_point_count)
+{
+    GLdouble u_min, u_max, v_min, v_max;
+
+    surface.GetUInterval(u_min, u_max);
+    surface.GetVInterval(v_min, v_max);
+
+    return Analyze([&surface](GLdouble u, GLdouble v, TensorProductSurface3::PartialDerivatives &pd)
+                   {
+                       return surface.CalculatePartialDerivatives(2, u, v, pd);
+                   },
+                   u_min, u_max, v_min, v_max, u_div_point_count, v_div_point_count);
+}
+
+GLboolean CurvatureAnalysis3::Analyze(const Evaluator &evaluator,
+                                      GLdouble u_min, GLdouble u_max, GLdouble v_min, GLdouble v_max,
+                                      GLuint u_div_point_count, GLuint v_div_point_count)
+{
+    if (u_div_point_count < 2 || v_div_point_count < 2)
+        return GL_FALSE;
+
+    GLint vertex_count = (GLint)(u_div_point_count * v_div_point_count);
+
+    _Resize(vertex_count);
+
+    GLdouble du = (u_max - u_min) / (u_div_point_count - 1);
+    GLdouble dv = (v_max - v_min) / (v_div_point_count - 1);
+
+    atomic<GLboolean> success(GL_TRUE);
+
+    auto analyze = [&](GLint chunk_begin, GLint chunk_end, GLuint &partial_singular_count)
+    {
+        TensorProductSurface3::PartialDerivatives pd(2);
+
+        for (GLint k = chunk_begin; k < chunk_end; ++k)
+        {
+            GLuint i = k / v_div_point_count, j = k % v_div_point_count;
+
+            GLdouble u = min(u_min + i * du, u_max);
+            GLdouble v = min(v_min + j * dv, v_max);
+
+            GLdouble gaussian, mean;
+
+            if (!evaluator(u, v, pd))
+                success = GL_FALSE;
+            else if (Evaluate(pd(1, 0), pd(1, 1), pd(2, 0), pd(2, 1), pd(2, 2), gaussian, mean))
+                _Store(k, gaussian, mean);
+            else
+                ++partial_singular_count;
+        }
+    };
+
+    _singular_count = TaskScheduler::Instance().ParallelReduce(
+            0, vertex_count, (GLuint)0, analyze, [](GLuint &sum, GLuint count) { sum += count; }, 256);
+
+    return success;
+}
+
+GLboolean CurvatureAnalysis3::Analyze(const TriangulatedMesh3 &mesh)
+{
+    GLint vertex_count = (GLint)mesh._vertex.size();
+    GLint face_count   = (GLint)mesh._face.size();
+
+    _Resize(vertex_count);
+
+    if (!vertex_count)
+        return GL_FALSE;
+
+    // corner k of every face stores its angle, the cotangent of the angle and its part of the mixed
+    // Voronoi area of the vertex
+    vector<GLdouble> angle(3 * face_count), cotangent(3 * face_count), area(3 * face_count);
+
+    TaskScheduler::Instance().ParallelFor(0, face_count, [&](GLint chunk_begin, GLint chunk_end)
+    {
+        for (GLint f = chunk_begin; f < chunk_end; ++f)
+        {
+            const TriangularFace &face = mesh._face[f];
+
+            DCoordinate3 edge[3];       // edge[k] is opposite to corner k
+
+            for (GLuint k = 0; k < 3; ++k)
+                edge[k] = mesh._vertex[face[(k + 2) % 3]] - mesh._vertex[face[(k + 1) % 3]];
+
+            GLdouble twice_area = (edge[1] ^ edge[2]).length();
+
+            if (twice_area <= 0.0)
+            {
+                for (GLuint k = 0; k < 3; ++k)
+                    angle[3 * f + k] = cotangent[3 * f + k] = area[3 * f + k] = 0.0;
+
+                continue;
+            }
+
+            GLuint obtuse = 3;
+
+            for (GLuint k = 0; k < 3; ++k)
+            {
+                // the sides of corner k are -edge[(k + 2) % 3] and edge[(k + 1) % 3]
+                GLdouble dot = -(edge[(k + 2) % 3] * edge[(k + 1) % 3]);
+
+                angle[3 * f + k]     = atan2(twice_area, dot);
+                cotangent[3 * f + k] = dot / twice_area;
+
+                if (dot < 0.0)
+                    obtuse = k;
+            }
+
+            for (GLuint k = 0; k < 3; ++k)
+            {
+                if (obtuse == 3)
+                {
+                    // Voronoi region of a non-obtuse triangle
+                    GLuint i = (k + 1) % 3, j = (k + 2) % 3;
+
+                    area[3 * f + k] = (edge[j] * edge[j] * cotangent[3 * f + j] +
+                                       edge[i] * edge[i] * cotangent[3 * f + i]) / 8.0;
+                }
+                else
+                    area[3 * f + k] = twice_area / (obtuse == k ? 4.0 : 8.0);
+            }
+        }
+    });
+
+    // the corners incident to vertex v are corner[first[v]], ..., corner[first[v + 1] - 1]
+    vector<GLuint> first(vertex_count + 1, 0), corner(3 * face_count);
+
+    for (GLint f = 0; f < face_count; ++f)
+        for (GLuint k = 0; k < 3; ++k)
+            ++first[mesh._face[f][k] + 1];
+
+    for (GLint v = 0; v < vertex_count; ++v)
+        first[v + 1] += first[v];
+
+    {
+        vector<GLuint> position(first.begin(), first.end() - 1);
+
+        for (GLint f = 0; f < face_count; ++f)
+            for (GLuint k = 0; k < 3; ++k)
+                corner[position[mesh._face[f][k]]++] = 3 * f + k;
+    }
+
+    auto analyze = [&](GLint chunk_begin, GLint chunk_end, GLuint &partial_singular_count)
+    {
+        vector<GLuint> neighbour;
+
+        for (GLint v = chunk_begin; v < chunk_end; ++v)
+        {
+            GLdouble     mixed_area = 0.0, angle_sum = 0.0;
+            DCoordinate3 laplacian;
+
+            neighbour.clear();
+
+            for (GLuint c = first[v]; c < first[v + 1]; ++c)
+            {
+                GLuint f = corner[c] / 3, k = corner[c] % 3;
+                GLuint i = (k + 1) % 3, j = (k + 2) % 3;
+
+                const TriangularFace &face = mesh._face[f];
+
+                mixed_area += area[corner[c]];
+                angle_sum  += angle[corner[c]];
+
+                // the edge (v, face[i]) is opposite to corner j, and the edge (v, face[j]) to corner i
+                laplacian += cotangent[3 * f + j] * (mesh._vertex[v] - mesh._vertex[face[i]]);
+                laplacian += cotangent[3 * f + i] * (mesh._vertex[v] - mesh._vertex[face[j]]);
+
+                neighbour.push_back(face[i]);
+                neighbour.push_back(face[j]);
+            }
+
+            if (mixed_area <= 0.0)
+            {
+                ++partial_singular_count;
+                continue;
+            }
+
+            // every edge of an interior vertex is shared by two of its faces
+            sort(neighbour.begin(), neighbour.end());
+
+            GLboolean boundary = GL_FALSE;
+
+            for (GLuint n = 0; n < neighbour.size() && !boundary; )
+            {
+                GLuint m = n;
+
+                while (m < neighbour.size() && neighbour[m] == neighbour[n])
+                    ++m;
+
+                boundary = (m - n == 1);
+                n = m;
+            }
+
+            GLdouble gaussian = ((boundary ? PI : TWO_PI) - angle_sum) / mixed_area;
+
+            // the mean curvature normal is 2H times the unit normal, it points outwards on convex parts
+            laplacian /= 2.0 * mixed_area;
+
+            GLdouble mean = 0.5 * laplacian.length();
+
+            if (laplacian * mesh._normal[v] > 0.0)
+                mean = -mean;
+
+            _Store(v, gaussian, mean);
+        }
+    };
+
+    _singular_count = TaskScheduler::Instance().ParallelReduce(
+            0, vertex_count, (GLuint)0, analyze, [](GLuint &sum, GLuint count) { sum += count; }, 1024);
+
+    return GL_TRUE;
+}
+
+GLuint CurvatureAnalysis3::GetVertexCount() const
+{
+    return (GLuint)_value[GAUSSIAN].size();
+}
+
+GLuint CurvatureAnalysis3::GetSingularVertexCount() const
+{
+    return _singular_count;
+}
+
+GLdouble CurvatureAnalysis3::GetValue(Quantity quantity, GLuint vertex) const
+{
+    return _value[quantity][vertex];
+}
+
+const vector<GLdouble>& CurvatureAnalysis3::GetValues(Quantity quantity) const
+{
+    return _value[quantity];
+}
+
+GLboolean CurvatureAnalysis3::GetRange(Quantity quantity, GLdouble &minimum, GLdouble &maximum,
+                                       GLdouble ignored_fraction) const
+{
+    if (_value[quantity].empty())
+        return GL_FALSE;
+
+    vector<GLdouble> value(_value[quantity]);
+
+    GLuint count = (GLuint)value.size();
+    GLuint lower = min((GLuint)(ignored_fraction * count), count - 1);
+    GLuint upper = count - 1 - lower;
+
+    nth_element(value.begin(), value.begin() + lower, value.end());
+    minimum = value[lower];
+
+    nth_element(value.begin() + lower, value.begin() + upper, value.end());
+    maximum = value[upper];
+
+    return GL_TRUE;
+}
+
+Color4 CurvatureAnalysis3::ColorMap(GLdouble t)
+{
+    t = 4.0 * max(0.0, min(1.0, t));
+
+    if (t < 1.0)
+        return Color4(0.0f, (GLfloat)t, 1.0f);
+
+    if (t < 2.0)
+        return Color4(0.0f, 1.0f, (GLfloat)(2.0 - t));
+
+    if (t < 3.0)
+        return Color4((GLfloat)(t - 2.0), 1.0f, 0.0f);
+
+    return Color4(1.0f, (GLfloat)(4.0 - t), 0.0f);
+}
+
+GLboolean CurvatureAnalysis3::ApplyColorMap(TriangulatedMesh3 &mesh, Quantity quantity,
+                                            GLdouble minimum, GLdouble maximum) const
+{
+    GLint vertex_count = (GLint)_value[quantity].size();
+
+    if (vertex_count != (GLint)mesh.VertexCount())
+        return GL_FALSE;
+
+    GLdouble scale = (maximum > minimum) ? 1.0 / (maximum - minimum) : 0.0;
+
+    vector<Color4> color(vertex_count);
+
+    TaskScheduler::Instance().ParallelFor(0, vertex_count, [&](GLint chunk_begin, GLint chunk_end)
+    {
+        for (GLint v = chunk_begin; v < chunk_end; ++v)
+            color[v] = ColorMap((_value[quantity][v] - minimum) * scale);
+    });
+
+    return mesh.SetColors(color);
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <functional>
+#include <vector>
+#include "Colors4.h"
+#include "DCoordinates3.h"
+#include "TensorProductSurfaces3.h"
+#include "TriangulatedMeshes3.h"
+
+namespace cagd
+{
+    //-------------------------
+    // class CurvatureAnalysis3
+    //-------------------------
+    // Per vertex Gaussian, mean and principal curvatures of tessellated surfaces.
+    //
+    // Tensor product and parametric surfaces are evaluated exactly from their second order partial
+    // derivatives over the same uniform grid that their GenerateImage() methods use, thus the i-th
+    // value belongs to the i-th vertex of the image. Triangulated meshes are analyzed by discrete
+    // operators: the mean curvature is derived from the cotangent Laplacian, the Gaussian curvature
+    // from the angle deficit, both normalized by mixed Voronoi areas (Meyer et al., 2003).
+    //
+    // The mean curvature is positive where the surface bends towards its normal vectors, e.g. it is
+    // -1 / r on a sphere of radius r whose normals point outwards.
+    //
+    // Vertices and faces are processed in parallel chunks by the worker threads of the TaskScheduler.
+    class CurvatureAnalysis3
+    {
+    public:
+        enum Quantity
+        {
+            GAUSSIAN = 0, MEAN, MAXIMUM_PRINCIPAL, MINIMUM_PRINCIPAL,
+            QUANTITY_COUNT
+        };
+
+        // evaluates the point and the partial derivatives up to order 2 at (u, v), it has to be safe
+        // to call it from several threads
+        typedef std::function<GLboolean (GLdouble u, GLdouble v, TensorProductSurface3::PartialDerivatives &pd)>
+                Evaluator;
+
+    protected:
+        std::vector<GLdouble> _value[QUANTITY_COUNT];
+        GLuint                _singular_count;          // vertices where the curvatures are undefined
+
+        GLvoid _Resize(GLuint vertex_count);
+        GLvoid _Store(GLuint vertex, GLdouble gaussian, GLdouble mean);
+
+    public:
+        // default constructor
+        CurvatureAnalysis3();
+
+        // curvatures of a surface point from the partial derivatives s_u, s_v, s_uu, s_uv and s_vv;
+        // returns GL_FALSE if the surface is not regular at the point
+        static GLboolean Evaluate(const DCoordinate3 &s_u, const DCoordinate3 &s_v,
+                                  const DCoordinate3 &s_uu, const DCoordinate3 &s_uv, const DCoordinate3 &s_vv,
+                                  GLdouble &gaussian, GLdouble &mean);
+
+        // samples the grid of GenerateImage(u_div_point_count, v_div_point_count)
+        GLboolean Analyze(const TensorProductSurface3 &surface, GLuint u_div_point_count, GLuint v_div_point_count);
+
+        // samples the grid u_min + i * (u_max - u_min) / (u_div_point_count - 1),
+        // v_min + j * (v_max - v_min) / (v_div_point_count - 1), the vertex index is i * v_div_point_count + j
+        GLboolean Analyze(const Evaluator &evaluator,
+                          GLdouble u_min, GLdouble u_max, GLdouble v_min, GLdouble v_max,
+                          GLuint u_div_point_count, GLuint v_div_point_count);
+
+        // discrete curvatures of a mesh, the signs of the mean curvatures are determined by the
+        // unit normal vectors of the mesh
+        GLboolean Analyze(const TriangulatedMesh3 &mesh);
+
+        // get properties
+        GLuint    GetVertexCount() const;
+        GLuint    GetSingularVertexCount() const;
+        GLdouble  GetValue(Quantity quantity, GLuint vertex) const;
+        const std::vector<GLdouble>& GetValues(Quantity quantity) const;
+
+        // the given fractions of the sorted values are ignored at both ends, thus a few extreme
+        // values (e.g. at creases of meshes or at singular points) do not flatten the color map
+        GLboolean GetRange(Quantity quantity, GLdouble &minimum, GLdouble &maximum,
+                           GLdouble ignored_fraction = 0.02) const;
+
+        // maps the values of [minimum, maximum] to blue-cyan-green-yellow-red colors and stores them
+        // as the per vertex colors of the mesh, whose vertex count has to match
+        GLboolean ApplyColorMap(TriangulatedMesh3 &mesh, Quantity quantity,
+                                GLdouble minimum, GLdouble maximum) const;
+
+        static Color4 ColorMap(GLdouble t);
+    };
+}
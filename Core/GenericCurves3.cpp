@@ -1,4 +1,5 @@
 #include "GenericCurves3.h"
+#include "Profilers.h"
 
 using namespace cagd;
 using namespace std;
@@ -94,6 +95,7 @@ GLboolean GenericCurve3::RenderDerivatives(GLuint order, GLenum render_mode) con
                 }
 
                 glDrawArrays(render_mode, 0, point_count);
+                CAGD_PROFILE_COUNT(DRAW_CALLS, 1);
             }
             else
             {
@@ -105,6 +107,7 @@ GLboolean GenericCurve3::RenderDerivatives(GLuint order, GLenum render_mode) con
                 }
 
                 glDrawArrays(render_mode, 0, 2 * point_count);
+                CAGD_PROFILE_COUNT(DRAW_CALLS, 1);
             }
 
         glBindBuffer(GL_ARRAY_BUFFER, 0);
@@ -120,6 +123,8 @@ GLboolean GenericCurve3::UpdateVertexBufferObjects(GLenum usage_flag)
         usage_flag != GL_STATIC_DRAW  && usage_flag != GL_STATIC_READ  && usage_flag != GL_STATIC_COPY)
         return GL_FALSE;
 
+    CAGD_PROFILE_ZONE("GenericCurve3::UpdateVertexBufferObjects");
+
     DeleteVertexBufferObjects();
 
     _usage_flag = usage_flag;
@@ -150,6 +155,9 @@ GLboolean GenericCurve3::UpdateVertexBufferObjects(GLenum usage_flag)
     glBindBuffer(GL_ARRAY_BUFFER, _vbo_derivative(0));
     glBufferData(GL_ARRAY_BUFFER, curve_point_byte_size, 0, _usage_flag);
 
+    CAGD_PROFILE_COUNT(ALLOCATIONS, _derivative.GetRowCount());
+    CAGD_PROFILE_COUNT(ALLOCATED_BYTES, (2 * _derivative.GetRowCount() - 1) * curve_point_byte_size);
+
     coordinate = (GLfloat*)glMapBuffer(GL_ARRAY_BUFFER, GL_WRITE_ONLY);
 
     if (!coordinate)
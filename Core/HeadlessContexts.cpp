@@ -0,0 +1,165 @@
+#include "HeadlessContexts.h"
+
+#ifdef CAGD_HEADLESS_EGL
+    #include <EGL/egl.h>
+    #include <EGL/eglext.h>
+#endif
+
+// defined by GLEW 2.1 and later
+#ifndef GLEW_ERROR_NO_GLX_DISPLAY
+#define GLEW_ERROR_NO_GLX_DISPLAY 4
+#endif
+
+using namespace cagd;
+
+// default constructor
+HeadlessContext::HeadlessContext(): _display(nullptr), _surface(nullptr), _context(nullptr)
+{
+}
+
+GLboolean HeadlessContext::IsSupported()
+{
+#ifdef CAGD_HEADLESS_EGL
+    return GL_TRUE;
+#else
+    return GL_FALSE;
+#endif
+}
+
+GLboolean HeadlessContext::Create()
+{
+    Destroy();
+
+#ifdef CAGD_HEADLESS_EGL
+    EGLDisplay display = EGL_NO_DISPLAY;
+
+    // the surfaceless platform does not need a display server, nor a render node
+#ifdef EGL_PLATFORM_SURFACELESS_MESA
+    PFNEGLGETPLATFORMDISPLAYEXTPROC get_platform_display =
+            (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+
+    if (get_platform_display)
+        display = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+#endif
+
+    if (display == EGL_NO_DISPLAY)
+        display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+
+    EGLint major = 0, minor = 0;
+
+    if (display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor))
+        return GL_FALSE;
+
+    _display = display;
+
+    const EGLint config_attributes[] =
+    {
+        EGL_SURFACE_TYPE,       EGL_PBUFFER_BIT,
+        EGL_RENDERABLE_TYPE,    EGL_OPENGL_BIT,
+        EGL_RED_SIZE,           8,
+        EGL_GREEN_SIZE,         8,
+        EGL_BLUE_SIZE,          8,
+        EGL_DEPTH_SIZE,         24,
+        EGL_NONE
+    };
+
+    EGLConfig config = nullptr;
+    EGLint    config_count = 0;
+
+    if (!eglBindAPI(EGL_OPENGL_API) ||
+        !eglChooseConfig(display, config_attributes, &config, 1, &config_count) || !config_count)
+    {
+        Destroy();
+        return GL_FALSE;
+    }
+
+    // without attributes the context supports the compatibility profile of the highest version
+    _context = eglCreateContext(display, config, EGL_NO_CONTEXT, nullptr);
+
+    if (_context == EGL_NO_CONTEXT)
+    {
+        _context = nullptr;
+        Destroy();
+        return GL_FALSE;
+    }
+
+    // contexts that cannot be made current without a surface (EGL_KHR_surfaceless_context) get a
+    // pixel buffer, which is never rendered into
+    if (!MakeCurrent())
+    {
+        const EGLint pbuffer_attributes[] = {EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE};
+
+        _surface = eglCreatePbufferSurface(display, config, pbuffer_attributes);
+
+        if (_surface == EGL_NO_SURFACE || !MakeCurrent())
+        {
+            if (_surface == EGL_NO_SURFACE)
+                _surface = nullptr;
+
+            Destroy();
+            return GL_FALSE;
+        }
+    }
+
+    // GLEW built for GLX loads the entry points of OpenGL, and then fails to find the display of
+    // the GLX context; this error is expected under a surfaceless EGL context, which has none
+    GLenum error = glewInit();
+
+    if (error != GLEW_OK && error != GLEW_ERROR_NO_GLX_DISPLAY)
+    {
+        Destroy();
+        return GL_FALSE;
+    }
+
+    return GL_TRUE;
+#else
+    return GL_FALSE;
+#endif
+}
+
+GLboolean HeadlessContext::MakeCurrent() const
+{
+#ifdef CAGD_HEADLESS_EGL
+    if (!_context)
+        return GL_FALSE;
+
+    EGLSurface surface = _surface ? (EGLSurface)_surface : EGL_NO_SURFACE;
+
+    return eglMakeCurrent((EGLDisplay)_display, surface, surface, (EGLContext)_context) ? GL_TRUE : GL_FALSE;
+#else
+    return GL_FALSE;
+#endif
+}
+
+GLvoid HeadlessContext::Destroy()
+{
+#ifdef CAGD_HEADLESS_EGL
+    if (!_display)
+        return;
+
+    EGLDisplay display = (EGLDisplay)_display;
+
+    eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+
+    if (_context)
+        eglDestroyContext(display, (EGLContext)_context);
+
+    if (_surface)
+        eglDestroySurface(display, (EGLSurface)_surface);
+
+    eglTerminate(display);
+#endif
+
+    _display = _surface = _context = nullptr;
+}
+
+GLboolean HeadlessContext::IsCreated() const
+{
+    return _context != nullptr;
+}
+
+// destructor
+HeadlessContext::~HeadlessContext()
+{
+    Destroy();
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <GL/glew.h>
+
+namespace cagd
+{
+    //----------------------
+    // class HeadlessContext
+    //----------------------
+    // Rendering context without a window or a display server, e.g. for benchmarks and regression
+    // tests on machines without a GPU, where Mesa renders by llvmpipe. The context is created by
+    // EGL on the surfaceless platform of Mesa (or on the default display, if the former is not
+    // available) for the compatibility profile of desktop OpenGL, thus the fixed-function pipeline
+    // and the shader programs of the application can be used as they are.
+    //
+    // The context has no default framebuffer, rendering needs a framebuffer object, e.g. the one of
+    // an OffscreenRenderer. EGL is only used if the application is built with CAGD_HEADLESS_EGL
+    // (see QtFramework.pro), otherwise Create() fails.
+    class HeadlessContext
+    {
+    protected:
+        void *_display, *_surface, *_context;   // EGLDisplay, EGLSurface and EGLContext handles
+
+    private:
+        // contexts cannot be shared by several objects
+        HeadlessContext(const HeadlessContext&);
+        HeadlessContext& operator =(const HeadlessContext&);
+
+    public:
+        // default constructor
+        HeadlessContext();
+
+        // GL_TRUE if the application was built with EGL support
+        static GLboolean IsSupported();
+
+        // creates the context, makes it current and initializes GLEW; the previous context is destroyed
+        GLboolean Create();
+
+        GLboolean MakeCurrent() const;
+        GLvoid    Destroy();
+
+        GLboolean IsCreated() const;
+
+        // destructor
+        ~HeadlessContext();
+    };
+}
@@ -0,0 +1,302 @@
+#include "KdTrees3.h"
+#include <algorithm>
+#include <limits>
+
+using namespace cagd;
+using namespace std;
+
+// squared distance of a point from an axis aligned box
+static GLdouble SquaredDistance(const DCoordinate3 &point, const DCoordinate3 &low, const DCoordinate3 &high)
+{
+    GLdouble result = 0.0;
+
+    for (GLuint r = 0; r < 3; ++r)
+    {
+        GLdouble d = max(max(low[r] - point[r], point[r] - high[r]), 0.0);
+        result += d * d;
+    }
+
+    return result;
+}
+
+GLvoid KdTree3::Build(const vector<DCoordinate3> &points)
+{
+    _point = points;
+
+    GLuint count = (GLuint)_point.size();
+
+    _index.resize(count);
+
+    for (GLuint i = 0; i < count; ++i)
+        _index[i] = i;
+
+    _Build(0, count);
+
+    _position.resize(count);
+    _node.resize(count);
+    _low.resize(count);
+    _high.resize(count);
+
+    for (GLuint i = 0; i < count; ++i)
+    {
+        _position[_index[i]] = i;
+        _node[i] = _point[_index[i]];
+    }
+
+    _UpdateBoundingBoxes(0, count);
+}
+
+GLvoid KdTree3::_Build(GLuint begin, GLuint end)
+{
+    if (end - begin <= 1)
+        return;
+
+    // split along the axis of largest extent
+    DCoordinate3 low = _point[_index[begin]], high = low;
+
+    for (GLuint i = begin + 1; i < end; ++i)
+    {
+        const DCoordinate3 &p = _point[_index[i]];
+
+        for (GLuint r = 0; r < 3; ++r)
+        {
+            low[r]  = min(low[r], p[r]);
+            high[r] = max(high[r], p[r]);
+        }
+    }
+
+    GLuint axis = 0;
+
+    for (GLuint r = 1; r < 3; ++r)
+        if (high[r] - low[r] > high[axis] - low[axis])
+            axis = r;
+
+    GLuint middle = (begin + end) / 2;
+
+    nth_element(_index.begin() + begin, _index.begin() + middle, _index.begin() + end,
+                [this, axis](GLuint lhs, GLuint rhs) { return _point[lhs][axis] < _point[rhs][axis]; });
+
+    _Build(begin, middle);
+    _Build(middle + 1, end);
+}
+
+// recomputes the bounding box of the node stored in the middle of the given range from its point
+// and from the boxes of its children
+GLvoid KdTree3::_UpdateBoundingBox(GLuint begin, GLuint end)
+{
+    GLuint middle = (begin + end) / 2;
+
+    _low[middle] = _high[middle] = _node[middle];
+
+    GLuint    child[2]  = {(begin + middle) / 2, (middle + 1 + end) / 2};
+    GLboolean exists[2] = {begin < middle, middle + 1 < end};
+
+    for (GLuint c = 0; c < 2; ++c)
+    {
+        if (!exists[c])
+            continue;
+
+        for (GLuint r = 0; r < 3; ++r)
+        {
+            _low[middle][r]  = min(_low[middle][r], _low[child[c]][r]);
+            _high[middle][r] = max(_high[middle][r], _high[child[c]][r]);
+        }
+    }
+}
+
+GLvoid KdTree3::_UpdateBoundingBoxes(GLuint begin, GLuint end)
+{
+    if (begin >= end)
+        return;
+
+    GLuint middle = (begin + end) / 2;
+
+    _UpdateBoundingBoxes(begin, middle);
+    _UpdateBoundingBoxes(middle + 1, end);
+    _UpdateBoundingBox(begin, end);
+}
+
+GLuint KdTree3::GetPointCount() const
+{
+    return (GLuint)_point.size();
+}
+
+const DCoordinate3& KdTree3::GetPoint(GLuint index) const
+{
+    return _point[index];
+}
+
+GLboolean KdTree3::GetBoundingBox(DCoordinate3 &low, DCoordinate3 &high) const
+{
+    if (_point.empty())
+        return GL_FALSE;
+
+    GLuint root = (GLuint)_point.size() / 2;
+
+    low  = _low[root];
+    high = _high[root];
+
+    return GL_TRUE;
+}
+
+GLboolean KdTree3::SetPoint(GLuint index, const DCoordinate3 &position)
+{
+    if (index >= _point.size())
+        return GL_FALSE;
+
+    _point[index] = position;
+    _node[_position[index]] = position;
+
+    // the ranges of the ancestors are collected by descending from the root, the depth of the
+    // balanced tree is at most 32
+    GLuint target = _position[index];
+    GLuint path_begin[33], path_end[33];
+    GLint  depth = 0;
+
+    path_begin[0] = 0;
+    path_end[0]   = (GLuint)_point.size();
+
+    for (;;)
+    {
+        GLuint begin = path_begin[depth], end = path_end[depth];
+        GLuint middle = (begin + end) / 2;
+
+        if (target == middle)
+            break;
+
+        ++depth;
+        path_begin[depth] = (target < middle) ? begin : middle + 1;
+        path_end[depth]   = (target < middle) ? middle : end;
+    }
+
+    for (; depth >= 0; --depth)
+        _UpdateBoundingBox(path_begin[depth], path_end[depth]);
+
+    return GL_TRUE;
+}
+
+GLvoid KdTree3::_FindNearest(GLuint begin, GLuint end, const DCoordinate3 &query,
+                             GLuint &nearest, GLdouble &squared_distance) const
+{
+    GLuint middle = (begin + end) / 2;
+
+    if (SquaredDistance(query, _low[middle], _high[middle]) >= squared_distance)
+        return;
+
+    DCoordinate3 difference = query;
+    difference -= _node[middle];
+
+    GLdouble d = difference * difference;
+
+    if (d < squared_distance)
+    {
+        squared_distance = d;
+        nearest = _index[middle];
+    }
+
+    // the child whose box is closer to the query is visited first
+    GLuint    child_begin[2] = {begin, middle + 1}, child_end[2] = {middle, end};
+    GLdouble  distance[2];
+
+    for (GLuint c = 0; c < 2; ++c)
+    {
+        GLuint child = (child_begin[c] + child_end[c]) / 2;
+
+        distance[c] = (child_begin[c] < child_end[c])
+                      ? SquaredDistance(query, _low[child], _high[child])
+                      : numeric_limits<GLdouble>::max();
+    }
+
+    GLuint first = (distance[1] < distance[0]) ? 1 : 0;
+
+    for (GLuint k = 0; k < 2; ++k)
+    {
+        GLuint c = (first + k) % 2;
+
+        if (distance[c] < squared_distance)
+            _FindNearest(child_begin[c], child_end[c], query, nearest, squared_distance);
+    }
+}
+
+GLboolean KdTree3::FindNearest(const DCoordinate3 &query, GLuint &index, GLdouble &squared_distance) const
+{
+    if (_point.empty())
+        return GL_FALSE;
+
+    squared_distance = numeric_limits<GLdouble>::max();
+
+    _FindNearest(0, (GLuint)_point.size(), query, index, squared_distance);
+
+    return GL_TRUE;
+}
+
+GLvoid KdTree3::_FindNearestToRay(GLuint begin, GLuint end,
+                                  const DCoordinate3 &origin, const DCoordinate3 &direction, GLdouble radius,
+                                  GLuint &nearest, GLdouble &parameter) const
+{
+    if (begin >= end)
+        return;
+
+    GLuint middle = (begin + end) / 2;
+
+    // slab test of the ray segment [0, parameter] against the box enlarged by the radius
+    GLdouble t_min = 0.0, t_max = parameter;
+
+    for (GLuint r = 0; r < 3 && t_min <= t_max; ++r)
+    {
+        GLdouble low  = _low[middle][r] - radius - origin[r];
+        GLdouble high = _high[middle][r] + radius - origin[r];
+
+        if (direction[r] == 0.0)
+        {
+            if (low > 0.0 || high < 0.0)
+                return;
+
+            continue;
+        }
+
+        GLdouble t0 = low / direction[r], t1 = high / direction[r];
+
+        if (t0 > t1)
+            swap(t0, t1);
+
+        t_min = max(t_min, t0);
+        t_max = min(t_max, t1);
+    }
+
+    if (t_min > t_max)
+        return;
+
+    DCoordinate3 difference = _node[middle];
+    difference -= origin;
+
+    GLdouble t = (difference * direction) / (direction * direction);
+
+    if (t >= 0.0 && t < parameter)
+    {
+        DCoordinate3 offset = difference;
+        offset -= t * direction;
+
+        if (offset * offset <= radius * radius)
+        {
+            parameter = t;
+            nearest   = _index[middle];
+        }
+    }
+
+    _FindNearestToRay(begin, middle, origin, direction, radius, nearest, parameter);
+    _FindNearestToRay(middle + 1, end, origin, direction, radius, nearest, parameter);
+}
+
+GLboolean KdTree3::FindNearestToRay(const DCoordinate3 &origin, const DCoordinate3 &direction, GLdouble radius,
+                                    GLuint &index, GLdouble &parameter) const
+{
+    if (_point.empty() || direction * direction == 0.0)
+        return GL_FALSE;
+
+    parameter = numeric_limits<GLdouble>::max();
+
+    _FindNearestToRay(0, (GLuint)_point.size(), origin, direction, radius, index, parameter);
+
+    return parameter != numeric_limits<GLdouble>::max();
+}
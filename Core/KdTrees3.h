@@ -0,0 +1,63 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <vector>
+#include "DCoordinates3.h"
+
+namespace cagd
+{
+    //--------------
+    // class KdTree3
+    //--------------
+    // Balanced k-d tree over a set of points. The tree is stored implicitly in a permutation of the
+    // point indices: the median of every index range is the splitting node, and the two halves of
+    // the range form its subtrees, thus no node objects are allocated.
+    //
+    // Every node also stores the bounding box of its subtree, and queries are pruned by these boxes
+    // instead of the splitting planes. Therefore a point can be moved in O(log n) time by refitting
+    // the boxes along its path to the root; the tree stays valid, although its balance may degrade
+    // if the points move far from their original positions.
+    //
+    // Queries are const and can be issued concurrently from several threads.
+    class KdTree3
+    {
+    protected:
+        std::vector<DCoordinate3>   _point;
+        std::vector<GLuint>         _index;     // permutation of the points
+        std::vector<GLuint>         _position;  // inverse permutation: _index[_position[i]] = i
+        std::vector<DCoordinate3>   _node;      // _node[i] = _point[_index[i]], traversed contiguously
+        std::vector<DCoordinate3>   _low;       // corners of the bounding box of the subtree
+        std::vector<DCoordinate3>   _high;      // rooted at position i
+
+        GLvoid _Build(GLuint begin, GLuint end);
+        GLvoid _UpdateBoundingBox(GLuint begin, GLuint end);
+        GLvoid _UpdateBoundingBoxes(GLuint begin, GLuint end);
+        GLvoid _FindNearest(GLuint begin, GLuint end, const DCoordinate3 &query,
+                            GLuint &nearest, GLdouble &squared_distance) const;
+        GLvoid _FindNearestToRay(GLuint begin, GLuint end,
+                                 const DCoordinate3 &origin, const DCoordinate3 &direction, GLdouble radius,
+                                 GLuint &nearest, GLdouble &parameter) const;
+
+    public:
+        // builds the tree in O(n log n) time
+        GLvoid Build(const std::vector<DCoordinate3> &points);
+
+        GLuint GetPointCount() const;
+        const DCoordinate3& GetPoint(GLuint index) const;
+
+        // returns GL_FALSE if the tree is empty
+        GLboolean GetBoundingBox(DCoordinate3 &low, DCoordinate3 &high) const;
+
+        // moves a point in O(log n) time
+        GLboolean SetPoint(GLuint index, const DCoordinate3 &position);
+
+        // returns GL_FALSE if the tree is empty, otherwise the index of the point closest to the query
+        GLboolean FindNearest(const DCoordinate3 &query, GLuint &index, GLdouble &squared_distance) const;
+
+        // among the points whose distance from the ray origin + t * direction (t >= 0) is at most
+        // radius, determines the one with the smallest parameter t, i.e. the first one seen from
+        // the origin; returns GL_FALSE if there is no such point
+        GLboolean FindNearestToRay(const DCoordinate3 &origin, const DCoordinate3 &direction, GLdouble radius,
+                                   GLuint &index, GLdouble &parameter) const;
+    };
+}
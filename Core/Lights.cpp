@@ -1,7 +1,9 @@
 #include "Exceptions.h"
 #include "Lights.h"
+#include "RenderStates.h"
 
 using namespace cagd;
+using namespace std;
 
 // directional light
 DirectionalLight::DirectionalLight(
@@ -17,20 +19,32 @@ DirectionalLight::DirectionalLight(
     _diffuse_intensity(diffuse_intensity),
     _specular_intensity(specular_intensity)
 {
-    glLightfv(light_index, GL_POSITION, &_position.x());
-    glLightfv(light_index, GL_AMBIENT,  &_ambient_intensity.r());
-    glLightfv(light_index, GL_DIFFUSE,  &_diffuse_intensity.r());
-    glLightfv(light_index, GL_SPECULAR, &_specular_intensity.r());
+    RenderState::Lightfv(light_index, GL_POSITION, &_position.x());
+    RenderState::Lightfv(light_index, GL_AMBIENT,  &_ambient_intensity.r());
+    RenderState::Lightfv(light_index, GL_DIFFUSE,  &_diffuse_intensity.r());
+    RenderState::Lightfv(light_index, GL_SPECULAR, &_specular_intensity.r());
 }
 
 void DirectionalLight::Enable()
 {
-    glEnable(_light_index);
+    // the position is transformed by the current model view matrix, thus it is always resent,
+    // the intensities are only resent if another light used the same index in the meantime
+    RenderState::Lightfv(_light_index, GL_POSITION, &_position.x());
+    RenderState::Lightfv(_light_index, GL_AMBIENT,  &_ambient_intensity.r());
+    RenderState::Lightfv(_light_index, GL_DIFFUSE,  &_diffuse_intensity.r());
+    RenderState::Lightfv(_light_index, GL_SPECULAR, &_specular_intensity.r());
+
+    RenderState::Enable(_light_index);
 }
 
 void DirectionalLight::Disable()
 {
-    glDisable(_light_index);
+    RenderState::Disable(_light_index);
+}
+
+GLenum DirectionalLight::GetLightIndex() const
+{
+    return _light_index;
 }
 
 // point light
@@ -55,10 +69,10 @@ PointLight::PointLight(
     if (position.w() == 0.0)
         throw Exception("PointLight::PointLight - Wrong position.");
 
-    glLightf(_light_index, GL_SPOT_CUTOFF, 180.0);
-    glLightf(_light_index, GL_CONSTANT_ATTENUATION,  _constant_attenuation);
-    glLightf(_light_index, GL_LINEAR_ATTENUATION,    _linear_attenuation);
-    glLightf(_light_index, GL_QUADRATIC_ATTENUATION, _quadratic_attenuation);
+    RenderState::Lightf(_light_index, GL_SPOT_CUTOFF, 180.0);
+    RenderState::Lightf(_light_index, GL_CONSTANT_ATTENUATION,  _constant_attenuation);
+    RenderState::Lightf(_light_index, GL_LINEAR_ATTENUATION,    _linear_attenuation);
+    RenderState::Lightf(_light_index, GL_QUADRATIC_ATTENUATION, _quadratic_attenuation);
 }
 
 // spotlight
@@ -88,7 +102,48 @@ Spotlight::Spotlight(
     if (_spot_cutoff > 90.0)
         throw Exception("Spotlight::Spotlight - Wrong spot cutoff.");
 
-    glLightfv(_light_index, GL_SPOT_DIRECTION,	&_spot_direction.x());
-    glLightf (_light_index, GL_SPOT_CUTOFF,     _spot_cutoff);
-    glLightf (_light_index, GL_SPOT_EXPONENT,	_spot_exponent);
+    RenderState::Lightfv(_light_index, GL_SPOT_DIRECTION,	&_spot_direction.x());
+    RenderState::Lightf (_light_index, GL_SPOT_CUTOFF,     _spot_cutoff);
+    RenderState::Lightf (_light_index, GL_SPOT_EXPONENT,	_spot_exponent);
+}
+
+// light set
+GLvoid LightSet::Insert(DirectionalLight *light)
+{
+    if (light)
+        _light.push_back(light);
+}
+
+GLvoid LightSet::Enable() const
+{
+    RenderState::Enable(GL_LIGHTING);
+
+    GLboolean is_member[RenderState::MAX_LIGHT_COUNT] = {GL_FALSE};
+
+    for (vector<DirectionalLight*>::const_iterator lit = _light.begin(); lit != _light.end(); ++lit)
+    {
+        GLint index = (GLint)(*lit)->GetLightIndex() - GL_LIGHT0;
+
+        if (index >= 0 && index < RenderState::MAX_LIGHT_COUNT)
+            is_member[index] = GL_TRUE;
+
+        (*lit)->Enable();
+    }
+
+    for (GLint i = 0; i < RenderState::MAX_LIGHT_COUNT; ++i)
+        if (!is_member[i])
+            RenderState::Disable(GL_LIGHT0 + i);
+}
+
+GLvoid LightSet::Disable() const
+{
+    for (vector<DirectionalLight*>::const_iterator lit = _light.begin(); lit != _light.end(); ++lit)
+        (*lit)->Disable();
+
+    RenderState::Disable(GL_LIGHTING);
+}
+
+GLuint LightSet::GetLightCount() const
+{
+    return (GLuint)_light.size();
 }
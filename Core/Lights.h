@@ -3,6 +3,7 @@
 #include "Colors4.h"
 #include "HCoordinates3.h"
 #include <GL/glew.h>
+#include <vector>
 
 namespace cagd
 {
@@ -23,6 +24,8 @@ namespace cagd
 
         void Enable();
         void Disable();
+
+        GLenum GetLightIndex() const;
     };
 
     class PointLight: public DirectionalLight
@@ -65,4 +68,23 @@ namespace cagd
             GLfloat             spot_cutoff,
             GLfloat             spot_exponent);
     };
+
+    // lights that are switched on together, every other light index is switched off
+    // while the set is enabled; the lights are not owned by the set
+    class LightSet
+    {
+    protected:
+        std::vector<DirectionalLight*> _light;
+
+    public:
+        GLvoid Insert(DirectionalLight *light);
+
+        // enables lighting and the member lights
+        GLvoid Enable() const;
+
+        // disables the member lights and lighting
+        GLvoid Disable() const;
+
+        GLuint GetLightCount() const;
+    };
 }
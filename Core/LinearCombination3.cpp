@@ -1,4 +1,5 @@
 #include "LinearCombination3.h"
+#include "Profilers.h"
 #include "RealSquareMatrices.h"
 #include <algorithm>
 
@@ -96,6 +97,7 @@ GLboolean LinearCombination3::RenderData(GLenum render_mode) const
         glBindBuffer(GL_ARRAY_BUFFER, _vbo_data);
             glVertexPointer(3, GL_FLOAT, 0, (const GLvoid*)0);
             glDrawArrays(render_mode, 0, _data.GetRowCount());
+            CAGD_PROFILE_COUNT(DRAW_CALLS, 1);
         glBindBuffer(GL_ARRAY_BUFFER, 0);
     glDisableClientState(GL_VERTEX_ARRAY);
 
@@ -211,6 +213,9 @@ GenericCurve3* LinearCombination3::GenerateImage(GLuint max_order_of_derivatives
     if (div_point_count <= 2)
             return 0;
 
+        CAGD_PROFILE_ZONE("LinearCombination3::GenerateImage");
+        CAGD_PROFILE_COUNT(SAMPLES, div_point_count);
+
         GenericCurve3* result = 0;
 
         result = new (nothrow)GenericCurve3(max_order_of_derivatives, div_point_count, usage_flag);
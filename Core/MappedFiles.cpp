@@ -0,0 +1,214 @@
+#include "MappedFiles.h"
+
+#ifdef _WIN32
+    #ifndef NOMINMAX
+        #define NOMINMAX
+    #endif
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+using namespace cagd;
+using namespace std;
+
+// default constructor
+MappedFile::MappedFile():
+        _data(nullptr), _size(0), _writable(GL_FALSE),
+    #ifdef _WIN32
+        _file(INVALID_HANDLE_VALUE), _mapping(nullptr)
+    #else
+        _file(-1)
+    #endif
+{
+}
+
+#ifdef _WIN32
+
+GLboolean MappedFile::OpenForReading(const string &file_name)
+{
+    Close();
+
+    _file = CreateFileA(file_name.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                        OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+
+    LARGE_INTEGER file_size;
+
+    if (_file == INVALID_HANDLE_VALUE || !GetFileSizeEx(_file, &file_size) || !file_size.QuadPart)
+    {
+        Close();
+        return GL_FALSE;
+    }
+
+    _mapping = CreateFileMappingA(_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+    if (_mapping)
+        _data = (char*)MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0);
+
+    if (!_data)
+    {
+        Close();
+        return GL_FALSE;
+    }
+
+    _size = (GLuint64)file_size.QuadPart;
+
+    return GL_TRUE;
+}
+
+GLboolean MappedFile::Create(const string &file_name, GLuint64 size)
+{
+    Close();
+
+    if (!size)
+        return GL_FALSE;
+
+    _file = CreateFileA(file_name.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr,
+                        CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+
+    if (_file == INVALID_HANDLE_VALUE)
+    {
+        Close();
+        return GL_FALSE;
+    }
+
+    _mapping = CreateFileMappingA(_file, nullptr, PAGE_READWRITE,
+                                  (DWORD)(size >> 32), (DWORD)(size & 0xffffffffu), nullptr);
+
+    if (_mapping)
+        _data = (char*)MapViewOfFile(_mapping, FILE_MAP_WRITE, 0, 0, 0);
+
+    if (!_data)
+    {
+        Close();
+        return GL_FALSE;
+    }
+
+    _size     = size;
+    _writable = GL_TRUE;
+
+    return GL_TRUE;
+}
+
+GLvoid MappedFile::Close()
+{
+    if (_data)
+        UnmapViewOfFile(_data);
+
+    if (_mapping)
+        CloseHandle(_mapping);
+
+    if (_file != INVALID_HANDLE_VALUE)
+        CloseHandle(_file);
+
+    _data     = nullptr;
+    _size     = 0;
+    _writable = GL_FALSE;
+    _mapping  = nullptr;
+    _file     = INVALID_HANDLE_VALUE;
+}
+
+#else
+
+GLboolean MappedFile::OpenForReading(const string &file_name)
+{
+    Close();
+
+    _file = open(file_name.c_str(), O_RDONLY);
+
+    struct stat status;
+
+    if (_file < 0 || fstat(_file, &status) || status.st_size <= 0)
+    {
+        Close();
+        return GL_FALSE;
+    }
+
+    void *address = mmap(nullptr, (size_t)status.st_size, PROT_READ, MAP_PRIVATE, _file, 0);
+
+    if (address == MAP_FAILED)
+    {
+        Close();
+        return GL_FALSE;
+    }
+
+    _data = (char*)address;
+    _size = (GLuint64)status.st_size;
+
+    return GL_TRUE;
+}
+
+GLboolean MappedFile::Create(const string &file_name, GLuint64 size)
+{
+    Close();
+
+    if (!size)
+        return GL_FALSE;
+
+    _file = open(file_name.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+
+    if (_file < 0 || ftruncate(_file, (off_t)size))
+    {
+        Close();
+        return GL_FALSE;
+    }
+
+    void *address = mmap(nullptr, (size_t)size, PROT_READ | PROT_WRITE, MAP_SHARED, _file, 0);
+
+    if (address == MAP_FAILED)
+    {
+        Close();
+        return GL_FALSE;
+    }
+
+    _data     = (char*)address;
+    _size     = size;
+    _writable = GL_TRUE;
+
+    return GL_TRUE;
+}
+
+GLvoid MappedFile::Close()
+{
+    if (_data)
+        munmap(_data, (size_t)_size);
+
+    if (_file >= 0)
+        close(_file);
+
+    _data     = nullptr;
+    _size     = 0;
+    _writable = GL_FALSE;
+    _file     = -1;
+}
+
+#endif
+
+GLboolean MappedFile::IsOpen() const
+{
+    return _data != nullptr;
+}
+
+GLuint64 MappedFile::GetSize() const
+{
+    return _size;
+}
+
+const char* MappedFile::GetData() const
+{
+    return _data;
+}
+
+char* MappedFile::GetWritableData()
+{
+    return _writable ? _data : nullptr;
+}
+
+// destructor
+MappedFile::~MappedFile()
+{
+    Close();
+}
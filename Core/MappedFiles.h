@@ -0,0 +1,55 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <string>
+
+namespace cagd
+{
+    //-----------------
+    // class MappedFile
+    //-----------------
+    // Maps a whole file into the address space (mmap on POSIX systems, a file mapping object on
+    // Windows), thus the operating system pages it in and out on demand, and files larger than the
+    // physical memory can be processed.
+    class MappedFile
+    {
+    protected:
+        char     *_data;
+        GLuint64  _size;
+        GLboolean _writable;
+
+    #ifdef _WIN32
+        void     *_file, *_mapping;     // HANDLEs, windows.h is not included by this header
+    #else
+        int       _file;
+    #endif
+
+    private:
+        // files are mapped at most once
+        MappedFile(const MappedFile&);
+        MappedFile& operator =(const MappedFile&);
+
+    public:
+        // default constructor
+        MappedFile();
+
+        // maps an existing file for reading; the previous mapping is closed
+        GLboolean OpenForReading(const std::string &file_name);
+
+        // creates or truncates the file, resizes it to the given size and maps it for reading and
+        // writing; the previous mapping is closed
+        GLboolean Create(const std::string &file_name, GLuint64 size);
+
+        // unmaps the file, written pages are flushed by the operating system
+        GLvoid    Close();
+
+        // get properties
+        GLboolean IsOpen() const;
+        GLuint64  GetSize() const;
+        const char* GetData() const;
+        char*     GetWritableData();    // null unless the file was created
+
+        // destructor
+        ~MappedFile();
+    };
+}
@@ -1,4 +1,5 @@
 #include "Materials.h"
+#include "RenderStates.h"
 
 using namespace cagd;
 
@@ -260,17 +261,18 @@ GLvoid Material::SetShininess(GLenum face, GLfloat shininess)
 
 GLvoid Material::Apply()
 {
-    glMaterialfv(GL_FRONT, GL_AMBIENT,   &_front_ambient.r());
-    glMaterialfv(GL_FRONT, GL_DIFFUSE,   &_front_diffuse.r());
-    glMaterialfv(GL_FRONT, GL_SPECULAR,  &_front_specular.r());
-    glMaterialfv(GL_FRONT, GL_EMISSION,  &_front_emissive.r());
-    glMaterialf (GL_FRONT, GL_SHININESS, _front_shininess);
-
-    glMaterialfv(GL_BACK, GL_AMBIENT,    &_back_ambient.r());
-    glMaterialfv(GL_BACK, GL_DIFFUSE,    &_back_diffuse.r());
-    glMaterialfv(GL_BACK, GL_SPECULAR,   &_back_specular.r());
-    glMaterialfv(GL_BACK, GL_EMISSION,   &_back_emissive.r());
-    glMaterialf (GL_BACK, GL_SHININESS,  _back_shininess);
+    // parameters that equal the ones of the previously applied material are not emitted again
+    RenderState::Materialfv(GL_FRONT, GL_AMBIENT,   &_front_ambient.r());
+    RenderState::Materialfv(GL_FRONT, GL_DIFFUSE,   &_front_diffuse.r());
+    RenderState::Materialfv(GL_FRONT, GL_SPECULAR,  &_front_specular.r());
+    RenderState::Materialfv(GL_FRONT, GL_EMISSION,  &_front_emissive.r());
+    RenderState::Materialf (GL_FRONT, GL_SHININESS, _front_shininess);
+
+    RenderState::Materialfv(GL_BACK, GL_AMBIENT,    &_back_ambient.r());
+    RenderState::Materialfv(GL_BACK, GL_DIFFUSE,    &_back_diffuse.r());
+    RenderState::Materialfv(GL_BACK, GL_SPECULAR,   &_back_specular.r());
+    RenderState::Materialfv(GL_BACK, GL_EMISSION,   &_back_emissive.r());
+    RenderState::Materialf (GL_BACK, GL_SHININESS,  _back_shininess);
 }
 
 GLboolean Material::IsTransparent() const
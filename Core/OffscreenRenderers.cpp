@@ -0,0 +1,284 @@
+#include "OffscreenRenderers.h"
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+
+using namespace cagd;
+using namespace std;
+
+namespace cagd
+{
+    // reads the next number of a PPM header, comments last until the end of their lines
+    static GLboolean ReadPPMHeaderNumber(ifstream &f, GLuint &number)
+    {
+        f >> ws;
+
+        while (f.peek() == '#')
+        {
+            string comment;
+            getline(f, comment);
+            f >> ws;
+        }
+
+        return (f >> number) ? GL_TRUE : GL_FALSE;
+    }
+}
+
+// special and default constructor
+OffscreenRenderer::Image::Image(GLuint width, GLuint height):
+        width(width), height(height), pixels(3 * width * height, 0)
+{
+}
+
+GLboolean OffscreenRenderer::Image::SaveToPPM(const string &file_name) const
+{
+    ofstream f(file_name.c_str(), ios_base::out | ios_base::binary);
+
+    if (!f.good())
+        return GL_FALSE;
+
+    f << "P6\n" << width << " " << height << "\n255\n";
+
+    if (!pixels.empty())
+        f.write((const char*)&pixels[0], pixels.size());
+
+    f.close();
+
+    return !f.fail();
+}
+
+GLboolean OffscreenRenderer::Image::LoadFromPPM(const string &file_name)
+{
+    ifstream f(file_name.c_str(), ios_base::in | ios_base::binary);
+
+    if (!f.good())
+        return GL_FALSE;
+
+    string magic;
+    f >> magic;
+
+    GLuint w = 0, h = 0, maximum = 0;
+
+    if (magic != "P6" ||
+        !ReadPPMHeaderNumber(f, w) || !ReadPPMHeaderNumber(f, h) || !ReadPPMHeaderNumber(f, maximum) ||
+        maximum != 255)
+        return GL_FALSE;
+
+    // a single whitespace character separates the header from the pixels
+    f.get();
+
+    vector<GLubyte> p(3 * w * h);
+
+    if (!p.empty() && !f.read((char*)&p[0], p.size()))
+        return GL_FALSE;
+
+    width  = w;
+    height = h;
+    pixels.swap(p);
+
+    return GL_TRUE;
+}
+
+// default constructor
+OffscreenRenderer::OffscreenRenderer():
+        _width(0), _height(0),
+        _framebuffer(0), _color_renderbuffer(0), _depth_renderbuffer(0),
+        _previous_framebuffer(0)
+{
+    for (GLuint i = 0; i < 4; ++i)
+        _previous_viewport[i] = 0;
+}
+
+GLboolean OffscreenRenderer::Create(GLuint width, GLuint height)
+{
+    Delete();
+
+    if (!width || !height || !(GLEW_VERSION_3_0 || GLEW_ARB_framebuffer_object))
+        return GL_FALSE;
+
+    GLint previous_framebuffer = 0;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previous_framebuffer);
+
+    glGenRenderbuffers(1, &_color_renderbuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, _color_renderbuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+
+    glGenRenderbuffers(1, &_depth_renderbuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, _depth_renderbuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    glGenFramebuffers(1, &_framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, _framebuffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, _color_renderbuffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, _depth_renderbuffer);
+
+    GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, previous_framebuffer);
+
+    if (status != GL_FRAMEBUFFER_COMPLETE)
+    {
+        Delete();
+        return GL_FALSE;
+    }
+
+    _width  = width;
+    _height = height;
+
+    return GL_TRUE;
+}
+
+GLvoid OffscreenRenderer::Delete()
+{
+    if (_framebuffer)
+        glDeleteFramebuffers(1, &_framebuffer), _framebuffer = 0;
+
+    if (_color_renderbuffer)
+        glDeleteRenderbuffers(1, &_color_renderbuffer), _color_renderbuffer = 0;
+
+    if (_depth_renderbuffer)
+        glDeleteRenderbuffers(1, &_depth_renderbuffer), _depth_renderbuffer = 0;
+
+    _width = _height = 0;
+}
+
+GLboolean OffscreenRenderer::Begin()
+{
+    if (!_framebuffer)
+        return GL_FALSE;
+
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &_previous_framebuffer);
+    glGetIntegerv(GL_VIEWPORT, _previous_viewport);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, _framebuffer);
+    glViewport(0, 0, _width, _height);
+
+    return GL_TRUE;
+}
+
+GLvoid OffscreenRenderer::End()
+{
+    if (!_framebuffer)
+        return;
+
+    glBindFramebuffer(GL_FRAMEBUFFER, _previous_framebuffer);
+    glViewport(_previous_viewport[0], _previous_viewport[1], _previous_viewport[2], _previous_viewport[3]);
+}
+
+GLboolean OffscreenRenderer::ReadImage(Image &image) const
+{
+    if (!_framebuffer)
+        return GL_FALSE;
+
+    GLint previous_read_framebuffer = 0, previous_pack_alignment = 0;
+    glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &previous_read_framebuffer);
+    glGetIntegerv(GL_PACK_ALIGNMENT, &previous_pack_alignment);
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, _framebuffer);
+    glReadBuffer(GL_COLOR_ATTACHMENT0);
+
+    // the rows of the triplets are not padded
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+
+    Image result(_width, _height);
+    glReadPixels(0, 0, _width, _height, GL_RGB, GL_UNSIGNED_BYTE, &result.pixels[0]);
+
+    glPixelStorei(GL_PACK_ALIGNMENT, previous_pack_alignment);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, previous_read_framebuffer);
+
+    // OpenGL returns the bottom row first
+    GLuint row_size = 3 * _width;
+
+    for (GLuint r = 0; r < _height / 2; ++r)
+        swap_ranges(result.pixels.begin() + r * row_size, result.pixels.begin() + (r + 1) * row_size,
+                    result.pixels.begin() + (_height - 1 - r) * row_size);
+
+    image.width  = result.width;
+    image.height = result.height;
+    image.pixels.swap(result.pixels);
+
+    return GL_TRUE;
+}
+
+GLboolean OffscreenRenderer::Render(const function<GLvoid()> &scene, Image *image)
+{
+    if (!Begin())
+        return GL_FALSE;
+
+    scene();
+
+    GLboolean result = image ? ReadImage(*image) : GL_TRUE;
+
+    End();
+
+    return result;
+}
+
+GLuint OffscreenRenderer::GetWidth() const
+{
+    return _width;
+}
+
+GLuint OffscreenRenderer::GetHeight() const
+{
+    return _height;
+}
+
+GLboolean OffscreenRenderer::Compare(const Image &image, const Image &reference, GLint tolerance,
+                                     Difference &difference, Image *difference_image)
+{
+    difference.pixel_count = 0;
+    difference.maximum     = 0;
+    difference.mean        = 0.0;
+
+    if (image.width != reference.width || image.height != reference.height ||
+        image.pixels.size() != reference.pixels.size())
+        return GL_FALSE;
+
+    if (difference_image)
+        *difference_image = Image(reference.width, reference.height);
+
+    GLuint64 sum = 0;
+
+    for (GLuint p = 0; p < image.pixels.size(); p += 3)
+    {
+        GLint pixel_maximum = 0;
+
+        for (GLuint c = p; c < p + 3; ++c)
+        {
+            GLint d = abs((GLint)image.pixels[c] - (GLint)reference.pixels[c]);
+
+            sum += d;
+            pixel_maximum = max(pixel_maximum, d);
+        }
+
+        difference.maximum = max(difference.maximum, pixel_maximum);
+
+        GLboolean differs = pixel_maximum > tolerance;
+
+        if (differs)
+            ++difference.pixel_count;
+
+        if (difference_image)
+            for (GLuint c = p; c < p + 3; ++c)
+            {
+                if (differs)
+                    difference_image->pixels[c] = (c == p) ? 255 : 0;
+                else
+                    difference_image->pixels[c] = reference.pixels[c] / 4;
+            }
+    }
+
+    if (!image.pixels.empty())
+        difference.mean = (GLdouble)sum / image.pixels.size();
+
+    return GL_TRUE;
+}
+
+// destructor
+OffscreenRenderer::~OffscreenRenderer()
+{
+    Delete();
+}
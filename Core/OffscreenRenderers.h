@@ -0,0 +1,90 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace cagd
+{
+    //------------------------
+    // class OffscreenRenderer
+    //------------------------
+    // Renders into a framebuffer object with color and depth renderbuffers of a given size, instead
+    // of the window, and reads the rendered images back. It works in any rendering context that
+    // supports framebuffer objects (OpenGL 3.0 or ARB_framebuffer_object), e.g. a HeadlessContext.
+    //
+    // Images are stored as RGB triplets, the top row first, and can be saved and loaded in the
+    // binary portable pixmap format (PPM, P6). Rendered images are compared to reference images by
+    // Compare(), which tolerates small differences of the color channels, e.g. due to different
+    // rasterizers.
+    class OffscreenRenderer
+    {
+    public:
+        class Image
+        {
+        public:
+            GLuint               width, height;
+            std::vector<GLubyte> pixels;        // width * height RGB triplets, the top row first
+
+            // special and default constructor, the pixels are black
+            Image(GLuint width = 0, GLuint height = 0);
+
+            GLboolean SaveToPPM(const std::string &file_name) const;
+            GLboolean LoadFromPPM(const std::string &file_name);
+        };
+
+        class Difference
+        {
+        public:
+            GLuint   pixel_count;   // pixels that differ by more than the tolerance in a channel
+            GLint    maximum;       // largest difference of a channel
+            GLdouble mean;          // mean absolute difference of the channels
+        };
+
+    protected:
+        GLuint _width, _height;
+        GLuint _framebuffer, _color_renderbuffer, _depth_renderbuffer;
+
+        // restored by End()
+        GLint  _previous_framebuffer;
+        GLint  _previous_viewport[4];
+
+    private:
+        // renderers own framebuffer objects, they cannot be copied
+        OffscreenRenderer(const OffscreenRenderer&);
+        OffscreenRenderer& operator =(const OffscreenRenderer&);
+
+    public:
+        // default constructor
+        OffscreenRenderer();
+
+        // creates the framebuffer object, requires a current rendering context; the previous one is deleted
+        GLboolean Create(GLuint width, GLuint height);
+        GLvoid    Delete();
+
+        // binds the framebuffer object, and sets the viewport to its size
+        GLboolean Begin();
+
+        // binds the previous framebuffer object, and restores the viewport
+        GLvoid    End();
+
+        // reads the color buffer of the framebuffer object
+        GLboolean ReadImage(Image &image) const;
+
+        // calls the given function between Begin() and End(), and reads the image if it is not null
+        GLboolean Render(const std::function<GLvoid()> &scene, Image *image = nullptr);
+
+        // get properties
+        GLuint    GetWidth() const;
+        GLuint    GetHeight() const;
+
+        // fails if the sizes of the images differ; the difference image shows the reference image
+        // darkened, and the pixels that differ by more than the tolerance in red
+        static GLboolean Compare(const Image &image, const Image &reference, GLint tolerance,
+                                 Difference &difference, Image *difference_image = nullptr);
+
+        // destructor
+        ~OffscreenRenderer();
+    };
+}
@@ -0,0 +1,375 @@
+#include "PatchQuilts3.h"
+#include "MappedFiles.h"
+#include "TaskSchedulers.h"
+#include <algorithm>
+#include <cstring>
+
+using namespace cagd;
+using namespace std;
+
+namespace
+{
+    const char   QUILT_MAGIC[8] = {'C', 'A', 'G', 'D', 'Q', 'L', 'T', '\0'};
+    const GLuint QUILT_VERSION  = 1;
+
+    const GLuint U_CLOSED = 1, V_CLOSED = 2;
+
+    class QuiltHeader
+    {
+    public:
+        char   magic[8];
+        GLuint version, flags;
+        GLuint row_count, column_count;
+        GLuint image_vertex_count, image_face_count;
+        GLuint reserved[2];
+    };
+
+    // the sections of the file are copied directly from and into these arrays
+    static_assert(sizeof(QuiltHeader) == 40, "unexpected padding of the quilt header");
+    static_assert(sizeof(DCoordinate3) == 3 * sizeof(GLdouble), "unexpected layout of DCoordinate3");
+    static_assert(sizeof(TCoordinate4) == 4 * sizeof(GLfloat), "unexpected layout of TCoordinate4");
+    static_assert(sizeof(TriangularFace) == 3 * sizeof(GLuint), "unexpected layout of TriangularFace");
+
+    GLuint64 FacesByteCount(GLuint64 face_count)
+    {
+        return (face_count * sizeof(TriangularFace) + 7) / 8 * 8;
+    }
+
+    GLuint64 ImageByteCount(GLuint64 vertex_count)
+    {
+        return vertex_count * (2 * sizeof(DCoordinate3) + sizeof(TCoordinate4));
+    }
+}
+
+//------------------
+// class PatchQuilt3
+//------------------
+
+// default and special constructor
+PatchQuilt3::PatchQuilt3(GLuint row_count, GLuint column_count, GLboolean u_closed, GLboolean v_closed):
+        _row_count(row_count), _column_count(column_count),
+        _point(row_count * column_count),
+        _u_closed(u_closed), _v_closed(v_closed)
+{
+}
+
+GLboolean PatchQuilt3::Resize(GLuint row_count, GLuint column_count, GLboolean u_closed, GLboolean v_closed)
+{
+    vector<DCoordinate3> point;
+
+    try
+    {
+        point.resize((GLuint64)row_count * column_count);
+    }
+    catch (bad_alloc&)
+    {
+        return GL_FALSE;
+    }
+
+    for (GLuint r = 0; r < min(row_count, _row_count); ++r)
+        for (GLuint c = 0; c < min(column_count, _column_count); ++c)
+            point[r * column_count + c] = _point[r * _column_count + c];
+
+    _point.swap(point);
+
+    _row_count    = row_count;
+    _column_count = column_count;
+    _u_closed     = u_closed;
+    _v_closed     = v_closed;
+
+    return GL_TRUE;
+}
+
+DCoordinate3& PatchQuilt3::operator ()(GLuint row, GLuint column)
+{
+    return _point[row * _column_count + column];
+}
+
+const DCoordinate3& PatchQuilt3::operator ()(GLuint row, GLuint column) const
+{
+    return _point[row * _column_count + column];
+}
+
+DCoordinate3& PatchQuilt3::ControlPoint(GLuint pi, GLuint pj, GLuint i, GLuint j)
+{
+    return (*this)((pi + i) % _row_count, (pj + j) % _column_count);
+}
+
+const DCoordinate3& PatchQuilt3::ControlPoint(GLuint pi, GLuint pj, GLuint i, GLuint j) const
+{
+    return (*this)((pi + i) % _row_count, (pj + j) % _column_count);
+}
+
+GLuint PatchQuilt3::GetRowCount() const
+{
+    return _row_count;
+}
+
+GLuint PatchQuilt3::GetColumnCount() const
+{
+    return _column_count;
+}
+
+GLboolean PatchQuilt3::IsUClosed() const
+{
+    return _u_closed;
+}
+
+GLboolean PatchQuilt3::IsVClosed() const
+{
+    return _v_closed;
+}
+
+GLuint PatchQuilt3::GetPatchRowCount() const
+{
+    return _u_closed ? _row_count : (_row_count > 3 ? _row_count - 3 : 0);
+}
+
+GLuint PatchQuilt3::GetPatchColumnCount() const
+{
+    return _v_closed ? _column_count : (_column_count > 3 ? _column_count - 3 : 0);
+}
+
+GLboolean PatchQuilt3::Save(const string &file_name, const Matrix<TriangulatedMesh3*> *images) const
+{
+    GLuint patch_row_count = GetPatchRowCount(), patch_column_count = GetPatchColumnCount();
+
+    if (images && (images->GetRowCount() < patch_row_count || images->GetColumnCount() < patch_column_count))
+        return GL_FALSE;
+
+    const TriangulatedMesh3 *image_topology = nullptr;
+
+    if (images && patch_row_count && patch_column_count)
+    {
+        image_topology = (*images)(0, 0);
+
+        if (!image_topology)
+            return GL_FALSE;
+    }
+
+    PatchQuiltWriter writer;
+
+    if (!writer.Open(file_name, *this, image_topology))
+        return GL_FALSE;
+
+    if (image_topology)
+        for (GLuint pi = 0; pi < patch_row_count; ++pi)
+            for (GLuint pj = 0; pj < patch_column_count; ++pj)
+            {
+                const TriangulatedMesh3 *image = (*images)(pi, pj);
+
+                if (!image || !writer.WriteImage(*image))
+                    return GL_FALSE;
+            }
+
+    return writer.Close();
+}
+
+GLboolean PatchQuilt3::Load(const string &file_name, Matrix<TriangulatedMesh3*> *images, GLenum usage_flag)
+{
+    if (images)
+    {
+        images->ResizeRows(0);
+        images->ResizeColumns(0);
+    }
+
+    MappedFile file;
+
+    if (!file.OpenForReading(file_name) || file.GetSize() < sizeof(QuiltHeader))
+        return GL_FALSE;
+
+    const char *data = file.GetData();
+
+    QuiltHeader header;
+    memcpy(&header, data, sizeof(QuiltHeader));
+
+    if (memcmp(header.magic, QUILT_MAGIC, sizeof(QUILT_MAGIC)) || header.version != QUILT_VERSION)
+        return GL_FALSE;
+
+    GLuint64 point_count = (GLuint64)header.row_count * header.column_count;
+    GLuint64 offset      = sizeof(QuiltHeader);
+
+    if (file.GetSize() - offset < point_count * sizeof(DCoordinate3))
+        return GL_FALSE;
+
+    const char *points = data + offset;
+
+    offset += point_count * sizeof(DCoordinate3);
+
+    GLboolean u_closed = (header.flags & U_CLOSED) != 0, v_closed = (header.flags & V_CLOSED) != 0;
+
+    // as returned by GetPatchRowCount() and GetPatchColumnCount() after loading
+    GLint patch_row_count    = (GLint)(u_closed ? header.row_count : (header.row_count > 3 ? header.row_count - 3 : 0));
+    GLint patch_column_count = (GLint)(v_closed ? header.column_count : (header.column_count > 3 ? header.column_count - 3 : 0));
+    GLint patch_count        = patch_row_count * patch_column_count;
+
+    GLboolean load_images = images && header.image_vertex_count;
+
+    GLuint64 vertex_count = header.image_vertex_count, face_count = header.image_face_count;
+    GLuint64 image_bytes  = ImageByteCount(vertex_count);
+
+    const TriangularFace *faces = nullptr;
+
+    // every section is validated before the quilt is modified, thus a damaged file leaves it intact
+    if (load_images)
+    {
+        if (file.GetSize() - offset < FacesByteCount(face_count) + patch_count * image_bytes)
+            return GL_FALSE;
+
+        faces = (const TriangularFace*)(data + offset);
+
+        offset += FacesByteCount(face_count);
+
+        // the images share their faces, whose indices are checked once
+        for (GLuint64 f = 0; f < face_count; ++f)
+            for (GLuint k = 0; k < 3; ++k)
+                if (faces[f][k] >= vertex_count)
+                    return GL_FALSE;
+    }
+
+    vector<DCoordinate3> point;
+
+    try
+    {
+        point.resize(point_count);
+    }
+    catch (bad_alloc&)
+    {
+        return GL_FALSE;
+    }
+
+    if (point_count)
+        memcpy(&point[0], points, point_count * sizeof(DCoordinate3));
+
+    _point.swap(point);
+
+    _row_count    = header.row_count;
+    _column_count = header.column_count;
+    _u_closed     = u_closed;
+    _v_closed     = v_closed;
+
+    if (!load_images)
+        return GL_TRUE;
+
+    images->ResizeColumns(patch_column_count);
+    images->ResizeRows(patch_row_count);
+
+    // the pages of the mapping are copied into the meshes by concurrent threads
+    TaskScheduler::Instance().ParallelFor(0, patch_count, [&](GLint chunk_begin, GLint chunk_end)
+    {
+        for (GLint p = chunk_begin; p < chunk_end; ++p)
+        {
+            const char *source = data + offset + p * image_bytes;
+
+            TriangulatedMesh3 *image = new TriangulatedMesh3((GLuint)vertex_count, (GLuint)face_count, usage_flag);
+
+            copy(faces, faces + face_count, image->_face.begin());
+
+            memcpy(&image->_vertex[0], source, vertex_count * sizeof(DCoordinate3));
+            source += vertex_count * sizeof(DCoordinate3);
+
+            memcpy(&image->_normal[0], source, vertex_count * sizeof(DCoordinate3));
+            source += vertex_count * sizeof(DCoordinate3);
+
+            memcpy(&image->_tex[0], source, vertex_count * sizeof(TCoordinate4));
+
+            (*images)(p / patch_column_count, p % patch_column_count) = image;
+        }
+    }, 16);
+
+    return GL_TRUE;
+}
+
+//-----------------------
+// class PatchQuiltWriter
+//-----------------------
+
+// default constructor
+PatchQuiltWriter::PatchQuiltWriter():
+        _image_count(0), _written_image_count(0),
+        _image_vertex_count(0), _image_face_count(0)
+{
+}
+
+GLboolean PatchQuiltWriter::Open(const string &file_name, const PatchQuilt3 &quilt,
+                                 const TriangulatedMesh3 *image_topology)
+{
+    if (_file.is_open())
+        _file.close();
+
+    _file.clear();
+    _file.open(file_name.c_str(), ios::out | ios::binary | ios::trunc);
+
+    if (!_file)
+        return GL_FALSE;
+
+    QuiltHeader header;
+    memset(&header, 0, sizeof(QuiltHeader));
+    memcpy(header.magic, QUILT_MAGIC, sizeof(QUILT_MAGIC));
+
+    header.version      = QUILT_VERSION;
+    header.flags        = (quilt.IsUClosed() ? U_CLOSED : 0) | (quilt.IsVClosed() ? V_CLOSED : 0);
+    header.row_count    = quilt.GetRowCount();
+    header.column_count = quilt.GetColumnCount();
+
+    _written_image_count = 0;
+    _image_count = _image_vertex_count = _image_face_count = 0;
+
+    if (image_topology && image_topology->VertexCount())
+    {
+        _image_count        = quilt.GetPatchRowCount() * quilt.GetPatchColumnCount();
+        _image_vertex_count = header.image_vertex_count = image_topology->VertexCount();
+        _image_face_count   = header.image_face_count   = image_topology->FaceCount();
+    }
+
+    _file.write((const char*)&header, sizeof(QuiltHeader));
+
+    if (!quilt._point.empty())
+        _file.write((const char*)&quilt._point[0], quilt._point.size() * sizeof(DCoordinate3));
+
+    if (_image_vertex_count)
+    {
+        static const char padding[8] = {0};
+
+        GLuint64 face_bytes = (GLuint64)_image_face_count * sizeof(TriangularFace);
+
+        if (face_bytes)
+            _file.write((const char*)&image_topology->_face[0], face_bytes);
+
+        _file.write(padding, FacesByteCount(_image_face_count) - face_bytes);
+    }
+
+    return _file.good();
+}
+
+GLboolean PatchQuiltWriter::WriteImage(const TriangulatedMesh3 &image)
+{
+    if (!_file.is_open() || _written_image_count >= _image_count || image._compact ||
+        image.VertexCount() != _image_vertex_count || image.FaceCount() != _image_face_count)
+        return GL_FALSE;
+
+    _file.write((const char*)&image._vertex[0], (GLuint64)_image_vertex_count * sizeof(DCoordinate3));
+    _file.write((const char*)&image._normal[0], (GLuint64)_image_vertex_count * sizeof(DCoordinate3));
+    _file.write((const char*)&image._tex[0],    (GLuint64)_image_vertex_count * sizeof(TCoordinate4));
+
+    ++_written_image_count;
+
+    return _file.good();
+}
+
+GLboolean PatchQuiltWriter::Close()
+{
+    if (!_file.is_open())
+        return GL_FALSE;
+
+    _file.close();
+
+    return !_file.fail() && _written_image_count == _image_count;
+}
+
+// closes the file
+PatchQuiltWriter::~PatchQuiltWriter()
+{
+    if (_file.is_open())
+        _file.close();
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "DCoordinates3.h"
+#include "Matrices.h"
+#include "TriangulatedMeshes3.h"
+
+namespace cagd
+{
+    //------------------
+    // class PatchQuilt3
+    //------------------
+    // Control grid of a quilt of uniform bicubic B-spline patches. Every control point is stored
+    // once: the patch (pi, pj) is spanned by the grid points (pi + i, pj + j), 0 <= i, j <= 3, whose
+    // indices are reduced modulo the grid size in closed directions. Thus a grid of n x m points
+    // defines n (closed) or n - 3 (open) rows and m or m - 3 columns of patches.
+    //
+    // Quilts are saved in a versioned binary format that optionally caches the images of the
+    // patches, provided that all of them share the same topology, e.g. they were generated by
+    // GenerateImage() with the same numbers of subdivision points:
+    //
+    //      header              magic "CAGDQLT\0", version, flags (bit 0: closed in u, bit 1: closed
+    //                          in v), grid row and column counts, vertex and face counts of the
+    //                          images (0 if there are none), 8 bytes reserved
+    //      control grid        row count * column count points in row-major order, 3 doubles each
+    //      image topology      face count faces, 3 unsigned integers each, padded to 8 bytes
+    //      images              per patch in row-major order: the vertices and the unit normal
+    //                          vectors (3 doubles each), then the texture coordinates (4 floats each)
+    //
+    // Numbers are stored in the byte order of the host. Files are written by a PatchQuiltWriter,
+    // which streams the images one by one, and read by memory mapping.
+    class PatchQuilt3
+    {
+        friend class PatchQuiltWriter;
+
+    protected:
+        GLuint                    _row_count, _column_count;
+        std::vector<DCoordinate3> _point;           // row-major order, as stored in files
+        GLboolean                 _u_closed, _v_closed;
+
+    public:
+        // default and special constructor
+        PatchQuilt3(GLuint row_count = 0, GLuint column_count = 0,
+                    GLboolean u_closed = GL_FALSE, GLboolean v_closed = GL_FALSE);
+
+        // the points of the grid are kept where possible
+        GLboolean Resize(GLuint row_count, GLuint column_count, GLboolean u_closed, GLboolean v_closed);
+
+        // points of the control grid
+        DCoordinate3&       operator ()(GLuint row, GLuint column);
+        const DCoordinate3& operator ()(GLuint row, GLuint column) const;
+
+        // the control point (i, j), 0 <= i, j <= 3, of the patch (pi, pj)
+        DCoordinate3&       ControlPoint(GLuint pi, GLuint pj, GLuint i, GLuint j);
+        const DCoordinate3& ControlPoint(GLuint pi, GLuint pj, GLuint i, GLuint j) const;
+
+        // get properties
+        GLuint    GetRowCount() const;
+        GLuint    GetColumnCount() const;
+        GLboolean IsUClosed() const;
+        GLboolean IsVClosed() const;
+        GLuint    GetPatchRowCount() const;
+        GLuint    GetPatchColumnCount() const;
+
+        // if images is not null, it has to store a mesh for every patch, these are cached in the file
+        GLboolean Save(const std::string &file_name, const Matrix<TriangulatedMesh3*> *images = nullptr) const;
+
+        // if images is not null and the file caches images, the matrix is resized to the patch row
+        // and column counts and new meshes are allocated, whose deletion is the responsibility of the
+        // caller; otherwise the matrix is emptied, the meshes it referenced are not deleted
+        GLboolean Load(const std::string &file_name, Matrix<TriangulatedMesh3*> *images = nullptr,
+                       GLenum usage_flag = GL_STATIC_DRAW);
+    };
+
+    //-----------------------
+    // class PatchQuiltWriter
+    //-----------------------
+    // Writes a quilt file without keeping all images in memory: Open() writes the header and the
+    // control grid, then the images of the patches are appended in row-major order.
+    class PatchQuiltWriter
+    {
+    protected:
+        std::ofstream _file;
+        GLuint        _image_count, _written_image_count;
+        GLuint        _image_vertex_count, _image_face_count;
+
+    public:
+        // default constructor
+        PatchQuiltWriter();
+
+        // if image_topology is not null, an image of the same vertex and face counts has to be
+        // written for every patch, and the faces of image_topology are stored for all of them
+        GLboolean Open(const std::string &file_name, const PatchQuilt3 &quilt,
+                       const TriangulatedMesh3 *image_topology = nullptr);
+
+        // images are cached in double precision, compacted meshes have to be expanded first
+        GLboolean WriteImage(const TriangulatedMesh3 &image);
+
+        // returns GL_FALSE if fewer images were written than expected, or if writing failed
+        GLboolean Close();
+
+        // closes the file
+        ~PatchQuiltWriter();
+    };
+}
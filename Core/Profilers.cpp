@@ -0,0 +1,283 @@
+#include "Profilers.h"
+#include <algorithm>
+#include <fstream>
+#include <map>
+
+using namespace cagd;
+using namespace std;
+
+namespace cagd
+{
+    static GLvoid WriteJSONString(ofstream &f, const char *text)
+    {
+        f << '"';
+
+        for (const char *c = text; *c; ++c)
+        {
+            if (*c == '"' || *c == '\\')
+                f << '\\';
+
+            f << *c;
+        }
+
+        f << '"';
+    }
+}
+
+Profiler::FrameStatistics::FrameStatistics(): duration(0.0)
+{
+    for (GLuint i = 0; i < COUNTER_COUNT; ++i)
+        counter[i] = 0;
+}
+
+// default constructor
+Profiler::Profiler():
+        _start(chrono::steady_clock::now()),
+        _enabled(GL_FALSE), _tracing(GL_FALSE),
+        _capacity(1u << 20), _dropped_event_count(0),
+        _frame_begin(0)
+{
+    for (GLuint i = 0; i < COUNTER_COUNT; ++i)
+    {
+        _counter[i]          = 0;
+        _previous_counter[i] = 0;
+    }
+}
+
+Profiler& Profiler::Instance()
+{
+    static Profiler profiler;
+
+    return profiler;
+}
+
+const char* Profiler::CounterName(Counter counter)
+{
+    switch (counter)
+    {
+    case ALLOCATIONS:       return "allocations";
+    case ALLOCATED_BYTES:   return "allocated bytes";
+    case SAMPLES:           return "samples";
+    case TRIANGLES:         return "triangles";
+    case DRAW_CALLS:        return "draw calls";
+    case STATE_CHANGES:     return "state changes";
+    default:                return "";
+    }
+}
+
+Profiler::ThreadBuffer& Profiler::_CurrentThreadBuffer()
+{
+    // created by the first zone of the thread, it outlives the thread, thus the zones of finished
+    // workers can be exported
+    static thread_local shared_ptr<ThreadBuffer> current_thread_buffer;
+
+    if (!current_thread_buffer)
+    {
+        shared_ptr<ThreadBuffer> buffer(new ThreadBuffer());
+        buffer->summarized_count = 0;
+
+        lock_guard<mutex> lock(_buffer_mutex);
+
+        buffer->thread_index = (GLuint)_buffer.size();
+        _buffer.push_back(buffer);
+
+        current_thread_buffer = buffer;
+    }
+
+    return *current_thread_buffer;
+}
+
+GLvoid Profiler::_Record(const char *name, GLint64 begin, GLint64 end)
+{
+    ThreadBuffer &buffer = _CurrentThreadBuffer();
+
+    lock_guard<mutex> lock(buffer.mutex);
+
+    // without tracing the buffers are emptied by EndFrame(), they can only overflow if no frames
+    // are rendered
+    if (buffer.events.size() >= _capacity)
+    {
+        ++_dropped_event_count;
+        return;
+    }
+
+    Event event;
+    event.name  = name;
+    event.begin = begin;
+    event.end   = end;
+
+    buffer.events.push_back(event);
+}
+
+GLvoid Profiler::SetEnabled(GLboolean enabled)
+{
+    _enabled = enabled;
+}
+
+GLvoid Profiler::SetTracing(GLboolean tracing, GLuint capacity_per_thread)
+{
+    lock_guard<mutex> lock(_buffer_mutex);
+
+    _capacity = capacity_per_thread;
+    _tracing  = tracing;
+
+    if (!tracing)
+    {
+        for (GLuint i = 0; i < _buffer.size(); ++i)
+        {
+            lock_guard<mutex> buffer_lock(_buffer[i]->mutex);
+
+            _buffer[i]->events.erase(_buffer[i]->events.begin(),
+                                     _buffer[i]->events.begin() + _buffer[i]->summarized_count);
+            _buffer[i]->summarized_count = 0;
+        }
+
+        _frame_sample.clear();
+        _dropped_event_count = 0;
+    }
+}
+
+GLboolean Profiler::IsTracing() const
+{
+    return _tracing;
+}
+
+GLint64 Profiler::GetCounter(Counter counter) const
+{
+    return _counter[counter].load(memory_order_relaxed);
+}
+
+GLvoid Profiler::BeginFrame()
+{
+    _frame_begin = Now();
+}
+
+GLvoid Profiler::EndFrame()
+{
+    if (!IsEnabled())
+        return;
+
+    GLint64 frame_end = Now();
+
+    FrameStatistics statistics;
+    statistics.duration = (frame_end - _frame_begin) * 1.0e-6;
+
+    for (GLuint i = 0; i < COUNTER_COUNT; ++i)
+    {
+        GLint64 value = GetCounter((Counter)i);
+
+        statistics.counter[i] = value - _previous_counter[i];
+        _previous_counter[i]  = value;
+    }
+
+    // the zones of the same name are summed, the names are string literals
+    map<const char*, GLint64> total;
+
+    {
+        lock_guard<mutex> lock(_buffer_mutex);
+
+        for (GLuint i = 0; i < _buffer.size(); ++i)
+        {
+            ThreadBuffer &buffer = *_buffer[i];
+
+            lock_guard<mutex> buffer_lock(buffer.mutex);
+
+            for (GLuint j = buffer.summarized_count; j < buffer.events.size(); ++j)
+                total[buffer.events[j].name] += buffer.events[j].end - buffer.events[j].begin;
+
+            // without tracing only the unsummarized zones are kept
+            if (_tracing)
+                buffer.summarized_count = (GLuint)buffer.events.size();
+            else
+                buffer.events.clear();
+        }
+    }
+
+    for (map<const char*, GLint64>::const_iterator it = total.begin(); it != total.end(); ++it)
+        statistics.zones.push_back(make_pair(it->first, it->second * 1.0e-6));
+
+    sort(statistics.zones.begin(), statistics.zones.end(),
+         [](const pair<const char*, GLdouble> &lhs, const pair<const char*, GLdouble> &rhs)
+         {
+             return lhs.second > rhs.second;
+         });
+
+    _last_frame.duration = statistics.duration;
+    _last_frame.zones.swap(statistics.zones);
+
+    for (GLuint i = 0; i < COUNTER_COUNT; ++i)
+        _last_frame.counter[i] = statistics.counter[i];
+
+    if (_tracing)
+    {
+        FrameSample sample;
+        sample.end = frame_end;
+
+        for (GLuint i = 0; i < COUNTER_COUNT; ++i)
+            sample.counter[i] = statistics.counter[i];
+
+        _frame_sample.push_back(sample);
+    }
+}
+
+const Profiler::FrameStatistics& Profiler::GetLastFrame() const
+{
+    return _last_frame;
+}
+
+GLboolean Profiler::ExportChromeTrace(const string &file_name) const
+{
+    ofstream f(file_name.c_str(), ios_base::out);
+
+    if (!f.good())
+        return GL_FALSE;
+
+    f.setf(ios_base::fixed);
+    f.precision(3);
+
+    f << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+    GLboolean first = GL_TRUE;
+
+    // the timestamps and durations are given in microseconds
+    {
+        lock_guard<mutex> lock(_buffer_mutex);
+
+        for (GLuint i = 0; i < _buffer.size(); ++i)
+        {
+            ThreadBuffer &buffer = *_buffer[i];
+
+            lock_guard<mutex> buffer_lock(buffer.mutex);
+
+            for (vector<Event>::const_iterator it = buffer.events.begin(); it != buffer.events.end(); ++it)
+            {
+                f << (first ? "\n" : ",\n") << "{\"name\":";
+                WriteJSONString(f, it->name);
+                f << ",\"cat\":\"cagd\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer.thread_index
+                  << ",\"ts\":" << it->begin * 1.0e-3 << ",\"dur\":" << (it->end - it->begin) * 1.0e-3 << "}";
+
+                first = GL_FALSE;
+            }
+        }
+    }
+
+    // the counters of the frames are shown as separate tracks
+    for (vector<FrameSample>::const_iterator it = _frame_sample.begin(); it != _frame_sample.end(); ++it)
+    {
+        for (GLuint i = 0; i < COUNTER_COUNT; ++i)
+        {
+            f << (first ? "\n" : ",\n") << "{\"name\":";
+            WriteJSONString(f, CounterName((Counter)i));
+            f << ",\"ph\":\"C\",\"pid\":1,\"tid\":0,\"ts\":" << it->end * 1.0e-3
+              << ",\"args\":{\"value\":" << it->counter[i] << "}}";
+
+            first = GL_FALSE;
+        }
+    }
+
+    f << "\n],\"otherData\":{\"dropped zones\":" << _dropped_event_count.load() << "}}\n";
+
+    f.close();
+
+    return !f.fail();
+}
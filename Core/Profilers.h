@@ -0,0 +1,192 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+// The instrumentation macros compile to nothing, unless CAGD_PROFILING is defined (see
+// QtFramework.pro). Zone names have to be string literals, since only their addresses are recorded.
+#ifdef CAGD_PROFILING
+    #define CAGD_PROFILE_CONCATENATE_(a, b) a##b
+    #define CAGD_PROFILE_CONCATENATE(a, b)  CAGD_PROFILE_CONCATENATE_(a, b)
+
+    // measures the rest of the enclosing block
+    #define CAGD_PROFILE_ZONE(name) \
+        cagd::Profiler::Zone CAGD_PROFILE_CONCATENATE(_profile_zone_, __LINE__)(name)
+
+    #define CAGD_PROFILE_COUNT(counter, value) \
+        cagd::Profiler::Instance().Add(cagd::Profiler::counter, (GLint64)(value))
+#else
+    #define CAGD_PROFILE_ZONE(name)             ((void)0)
+    #define CAGD_PROFILE_COUNT(counter, value)  ((void)0)
+#endif
+
+namespace cagd
+{
+    //---------------
+    // class Profiler
+    //---------------
+    // Collects the durations of scoped zones (e.g. tessellations, uploads, the rendering of frames)
+    // and the values of a few counters, both on the thread of the user interface and on the worker
+    // threads of the TaskScheduler. Nothing is recorded until the profiler is enabled.
+    //
+    // The frames of the rendering loop are delimited by BeginFrame() and EndFrame(): the latter
+    // summarizes the zones that have been finished and the counters that have been increased since
+    // the previous frame, e.g. for an overlay of the widget. While tracing, the zones and the
+    // counters of the frames are also retained, and can be exported in the trace event format of
+    // Chrome (chrome://tracing, Perfetto).
+    class Profiler
+    {
+    public:
+        enum Counter
+        {
+            ALLOCATIONS,        // allocations of buffer objects
+            ALLOCATED_BYTES,    // sizes of the allocated buffer objects
+            SAMPLES,            // evaluations of curves and surfaces
+            TRIANGLES,          // rendered triangles
+            DRAW_CALLS,
+            STATE_CHANGES,      // emitted fixed-function state calls and shader program switches
+            COUNTER_COUNT
+        };
+
+        // the zone is measured from its construction to its destruction
+        class Zone
+        {
+        protected:
+            const char *_name;
+            GLint64     _begin;
+
+        public:
+            Zone(const char *name);
+            ~Zone();
+        };
+
+        class FrameStatistics
+        {
+        public:
+            GLdouble                                    duration;   // in milliseconds
+            GLint64                                     counter[COUNTER_COUNT];
+
+            // total durations of the zones finished since the previous frame, in milliseconds,
+            // ordered by decreasing duration
+            std::vector<std::pair<const char*, GLdouble> > zones;
+
+            FrameStatistics();
+        };
+
+    protected:
+        class Event
+        {
+        public:
+            const char *name;
+            GLint64     begin, end;                 // in nanoseconds since the start of the profiler
+        };
+
+        // the zones of a thread are appended to its own buffer, thus threads do not contend
+        class ThreadBuffer
+        {
+        public:
+            std::mutex          mutex;
+            GLuint              thread_index;
+            std::vector<Event>  events;
+            GLuint              summarized_count;   // events already summarized by EndFrame()
+        };
+
+        class FrameSample
+        {
+        public:
+            GLint64             end;
+            GLint64             counter[COUNTER_COUNT];
+        };
+
+        std::chrono::steady_clock::time_point        _start;
+        std::atomic<GLboolean>                       _enabled, _tracing;
+        std::atomic<GLint64>                         _counter[COUNTER_COUNT];
+
+        mutable std::mutex                           _buffer_mutex;
+        std::vector<std::shared_ptr<ThreadBuffer> >  _buffer;
+        GLuint                                       _capacity;         // events per thread
+        std::atomic<GLuint64>                        _dropped_event_count;
+
+        // accessed only by the thread that renders the frames
+        GLint64                                      _frame_begin;
+        GLint64                                      _previous_counter[COUNTER_COUNT];
+        FrameStatistics                              _last_frame;
+        std::vector<FrameSample>                     _frame_sample;
+
+        Profiler();
+
+        ThreadBuffer& _CurrentThreadBuffer();
+        GLvoid        _Record(const char *name, GLint64 begin, GLint64 end);
+
+    private:
+        Profiler(const Profiler&);
+        Profiler& operator =(const Profiler&);
+
+    public:
+        static Profiler& Instance();
+
+        static const char* CounterName(Counter counter);
+
+        // nanoseconds since the start of the profiler
+        GLint64   Now() const;
+
+        GLvoid    SetEnabled(GLboolean enabled);
+        GLboolean IsEnabled() const;
+
+        // the recorded zones and frames are retained for ExportChromeTrace(), at most the given count
+        // of zones per thread, the later ones are dropped; disabling discards the retained ones
+        GLvoid    SetTracing(GLboolean tracing, GLuint capacity_per_thread = 1u << 20);
+        GLboolean IsTracing() const;
+
+        GLvoid    Add(Counter counter, GLint64 value);
+        GLint64   GetCounter(Counter counter) const;
+
+        GLvoid    BeginFrame();
+        GLvoid    EndFrame();
+
+        const FrameStatistics& GetLastFrame() const;
+
+        GLboolean ExportChromeTrace(const std::string &file_name) const;
+    };
+
+    inline Profiler::Zone::Zone(const char *name): _name(name), _begin(-1)
+    {
+        Profiler &profiler = Profiler::Instance();
+
+        if (profiler.IsEnabled())
+            _begin = profiler.Now();
+    }
+
+    inline Profiler::Zone::~Zone()
+    {
+        if (_begin >= 0)
+        {
+            Profiler &profiler = Profiler::Instance();
+
+            profiler._Record(_name, _begin, profiler.Now());
+        }
+    }
+
+    inline GLint64 Profiler::Now() const
+    {
+        return (GLint64)std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - _start).count();
+    }
+
+    inline GLboolean Profiler::IsEnabled() const
+    {
+        return _enabled.load(std::memory_order_relaxed);
+    }
+
+    inline GLvoid Profiler::Add(Counter counter, GLint64 value)
+    {
+        if (IsEnabled())
+            _counter[counter].fetch_add(value, std::memory_order_relaxed);
+    }
+}
@@ -0,0 +1,362 @@
+#include "Projectors3.h"
+#include "TaskSchedulers.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace cagd;
+using namespace std;
+
+//----------------------
+// class CurveProjector3
+//----------------------
+
+// special constructor
+CurveProjector3::CurveProjector3(const LinearCombination3 &curve, GLuint sample_count):
+        _curve(&curve),
+        _sample_count(max(sample_count, 2u)),
+        _maximum_order_of_derivatives(2)
+{
+    Update();
+}
+
+GLboolean CurveProjector3::Update()
+{
+    GLdouble u_min, u_max;
+    _curve->GetDefinitionDomain(u_min, u_max);
+
+    // curves that cannot provide second order derivatives are refined by Gauss-Newton steps
+    LinearCombination3::Derivatives d;
+    _maximum_order_of_derivatives = _curve->CalculateDerivatives(2, u_min, d) ? 2 : 1;
+
+    GLint count = (GLint)_sample_count;
+    GLdouble step = (u_max - u_min) / (count - 1);
+
+    _parameter.resize(count);
+    vector<DCoordinate3> sample(count);
+    atomic<GLboolean> success(GL_TRUE);
+
+    TaskScheduler::Instance().ParallelFor(0, count, [&](GLint chunk_begin, GLint chunk_end)
+    {
+        for (GLint i = chunk_begin; i < chunk_end; ++i)
+        {
+            LinearCombination3::Derivatives sample_derivatives;
+
+            _parameter[i] = min(u_min + i * step, u_max);
+
+            if (_curve->CalculateDerivatives(0, _parameter[i], sample_derivatives))
+                sample[i] = sample_derivatives[0];
+            else
+                success = GL_FALSE;
+        }
+    });
+
+    _tree.Build(sample);
+
+    return success;
+}
+
+GLboolean CurveProjector3::FindClosestPoint(const DCoordinate3 &query,
+                                            GLdouble &u, DCoordinate3 &closest_point, GLdouble &distance,
+                                            GLuint maximum_iteration_count, GLdouble tolerance) const
+{
+    GLuint   nearest;
+    GLdouble squared_distance;
+
+    if (!_tree.FindNearest(query, nearest, squared_distance))
+        return GL_FALSE;
+
+    GLdouble u_min, u_max;
+    _curve->GetDefinitionDomain(u_min, u_max);
+
+    u = _parameter[nearest];
+
+    LinearCombination3::Derivatives d, next_d;
+
+    if (!_curve->CalculateDerivatives(_maximum_order_of_derivatives, u, d))
+        return GL_FALSE;
+
+    DCoordinate3 r = d[0];
+    r -= query;
+    squared_distance = r * r;
+
+    for (GLuint iteration = 0; iteration < maximum_iteration_count; ++iteration)
+    {
+        // derivatives of f(u) = |c(u) - q|^2 / 2
+        GLdouble gradient = r * d[1];
+        GLdouble hessian  = d[1] * d[1];
+
+        if (_maximum_order_of_derivatives > 1 && hessian + r * d[2] > 0.0)
+            hessian += r * d[2];
+
+        // the closest point is an end point of the domain
+        if (hessian <= 0.0 || (u <= u_min && gradient >= 0.0) || (u >= u_max && gradient <= 0.0))
+            break;
+
+        GLdouble step = -gradient / hessian;
+
+        // the step is halved until the distance decreases or the step becomes negligible, the
+        // derivatives evaluated at the accepted parameter are reused in the next iteration
+        GLboolean    accepted = GL_FALSE;
+        GLdouble     next_u = u;
+        DCoordinate3 next_r;
+
+        for (; !accepted && fabs(step) > tolerance * (u_max - u_min); step *= 0.5)
+        {
+            next_u = max(u_min, min(u_max, u + step));
+
+            if (!_curve->CalculateDerivatives(_maximum_order_of_derivatives, next_u, next_d))
+                return GL_FALSE;
+
+            next_r = next_d[0];
+            next_r -= query;
+
+            accepted = (next_r * next_r < squared_distance);
+        }
+
+        if (!accepted)
+            break;
+
+        GLdouble change = fabs(next_u - u);
+
+        u = next_u;
+        r = next_r;
+        squared_distance = r * r;
+        swap(d, next_d);
+
+        if (change <= tolerance * (u_max - u_min))
+            break;
+    }
+
+    closest_point = d[0];
+    distance = sqrt(squared_distance);
+
+    return GL_TRUE;
+}
+
+GLboolean CurveProjector3::FindClosestPoints(const ColumnMatrix<DCoordinate3> &queries,
+                                             ColumnMatrix<GLdouble> &u, ColumnMatrix<DCoordinate3> &closest_points,
+                                             ColumnMatrix<GLdouble> &distances,
+                                             GLuint maximum_iteration_count, GLdouble tolerance) const
+{
+    GLint count = (GLint)queries.GetRowCount();
+
+    u.ResizeRows(count);
+    closest_points.ResizeRows(count);
+    distances.ResizeRows(count);
+
+    atomic<GLboolean> success(GL_TRUE);
+
+    TaskScheduler::Instance().ParallelFor(0, count, [&](GLint chunk_begin, GLint chunk_end)
+    {
+        for (GLint i = chunk_begin; i < chunk_end; ++i)
+            if (!FindClosestPoint(queries[i], u[i], closest_points[i], distances[i], maximum_iteration_count, tolerance))
+                success = GL_FALSE;
+    }, 256);
+
+    return success;
+}
+
+//------------------------
+// class SurfaceProjector3
+//------------------------
+
+// special constructor
+SurfaceProjector3::SurfaceProjector3(const TensorProductSurface3 &surface,
+                                     GLuint u_sample_count, GLuint v_sample_count):
+        _surface(&surface),
+        _u_sample_count(max(u_sample_count, 2u)),
+        _v_sample_count(max(v_sample_count, 2u)),
+        _maximum_order_of_derivatives(2)
+{
+    Update();
+}
+
+GLboolean SurfaceProjector3::Update()
+{
+    GLdouble u_min, u_max, v_min, v_max;
+    _surface->GetUInterval(u_min, u_max);
+    _surface->GetVInterval(v_min, v_max);
+
+    TensorProductSurface3::PartialDerivatives pd;
+    _maximum_order_of_derivatives = _surface->CalculatePartialDerivatives(2, u_min, v_min, pd) ? 2 : 1;
+
+    GLint count = (GLint)(_u_sample_count * _v_sample_count);
+    GLdouble u_step = (u_max - u_min) / (_u_sample_count - 1);
+    GLdouble v_step = (v_max - v_min) / (_v_sample_count - 1);
+
+    _u_parameter.resize(count);
+    _v_parameter.resize(count);
+    vector<DCoordinate3> sample(count);
+    atomic<GLboolean> success(GL_TRUE);
+
+    TaskScheduler::Instance().ParallelFor(0, count, [&](GLint chunk_begin, GLint chunk_end)
+    {
+        for (GLint k = chunk_begin; k < chunk_end; ++k)
+        {
+            TensorProductSurface3::PartialDerivatives sample_derivatives;
+
+            GLuint i = k / _v_sample_count, j = k % _v_sample_count;
+
+            _u_parameter[k] = min(u_min + i * u_step, u_max);
+            _v_parameter[k] = min(v_min + j * v_step, v_max);
+
+            if (_surface->CalculatePartialDerivatives(0, _u_parameter[k], _v_parameter[k], sample_derivatives))
+                sample[k] = sample_derivatives(0, 0);
+            else
+                success = GL_FALSE;
+        }
+    });
+
+    _tree.Build(sample);
+
+    return success;
+}
+
+GLboolean SurfaceProjector3::FindClosestPoint(const DCoordinate3 &query,
+                                              GLdouble &u, GLdouble &v, DCoordinate3 &closest_point, GLdouble &distance,
+                                              GLuint maximum_iteration_count, GLdouble tolerance) const
+{
+    GLuint   nearest;
+    GLdouble squared_distance;
+
+    if (!_tree.FindNearest(query, nearest, squared_distance))
+        return GL_FALSE;
+
+    GLdouble u_min, u_max, v_min, v_max;
+    _surface->GetUInterval(u_min, u_max);
+    _surface->GetVInterval(v_min, v_max);
+
+    u = _u_parameter[nearest];
+    v = _v_parameter[nearest];
+
+    TensorProductSurface3::PartialDerivatives pd, next_pd;
+
+    if (!_surface->CalculatePartialDerivatives(_maximum_order_of_derivatives, u, v, pd))
+        return GL_FALSE;
+
+    DCoordinate3 r = pd(0, 0);
+    r -= query;
+    squared_distance = r * r;
+
+    for (GLuint iteration = 0; iteration < maximum_iteration_count; ++iteration)
+    {
+        const DCoordinate3 &s_u = pd(1, 0), &s_v = pd(1, 1);
+
+        // gradient and Hessian of f(u, v) = |s(u, v) - q|^2 / 2, the Gauss-Newton approximation
+        // of the Hessian is used whenever the exact one is not positive definite
+        GLdouble g_u  = r * s_u, g_v = r * s_v;
+        GLdouble h_uu = s_u * s_u, h_uv = s_u * s_v, h_vv = s_v * s_v;
+
+        if (_maximum_order_of_derivatives > 1)
+        {
+            GLdouble e_uu = h_uu + r * pd(2, 0), e_uv = h_uv + r * pd(2, 1), e_vv = h_vv + r * pd(2, 2);
+
+            if (e_uu > 0.0 && e_uu * e_vv - e_uv * e_uv > 0.0)
+            {
+                h_uu = e_uu;
+                h_uv = e_uv;
+                h_vv = e_vv;
+            }
+        }
+
+        // a parameter that lies on the boundary of the domain and whose descent direction points
+        // outwards is kept fixed, the remaining one is refined by a one dimensional step
+        GLboolean u_is_fixed = (u <= u_min && g_u >= 0.0) || (u >= u_max && g_u <= 0.0);
+        GLboolean v_is_fixed = (v <= v_min && g_v >= 0.0) || (v >= v_max && g_v <= 0.0);
+
+        GLdouble step_u = 0.0, step_v = 0.0;
+
+        if (u_is_fixed && v_is_fixed)
+            break;
+
+        if (u_is_fixed)
+        {
+            if (h_vv <= 0.0)
+                break;
+
+            step_v = -g_v / h_vv;
+        }
+        else if (v_is_fixed)
+        {
+            if (h_uu <= 0.0)
+                break;
+
+            step_u = -g_u / h_uu;
+        }
+        else
+        {
+            GLdouble determinant = h_uu * h_vv - h_uv * h_uv;
+
+            if (determinant <= 0.0)
+                break;
+
+            step_u = -(h_vv * g_u - h_uv * g_v) / determinant;
+            step_v = -(h_uu * g_v - h_uv * g_u) / determinant;
+        }
+
+        // the step is halved until the distance decreases or the step becomes negligible, the
+        // partial derivatives evaluated at the accepted parameters are reused in the next iteration
+        GLboolean    accepted = GL_FALSE;
+        GLdouble     next_u = u, next_v = v;
+        DCoordinate3 next_r;
+
+        for (GLdouble length = max(fabs(step_u) / (u_max - u_min), fabs(step_v) / (v_max - v_min));
+             !accepted && length > tolerance; length *= 0.5, step_u *= 0.5, step_v *= 0.5)
+        {
+            next_u = max(u_min, min(u_max, u + step_u));
+            next_v = max(v_min, min(v_max, v + step_v));
+
+            if (!_surface->CalculatePartialDerivatives(_maximum_order_of_derivatives, next_u, next_v, next_pd))
+                return GL_FALSE;
+
+            next_r = next_pd(0, 0);
+            next_r -= query;
+
+            accepted = (next_r * next_r < squared_distance);
+        }
+
+        if (!accepted)
+            break;
+
+        GLdouble change = max(fabs(next_u - u) / (u_max - u_min), fabs(next_v - v) / (v_max - v_min));
+
+        u = next_u;
+        v = next_v;
+        r = next_r;
+        squared_distance = r * r;
+        swap(pd, next_pd);
+
+        if (change <= tolerance)
+            break;
+    }
+
+    closest_point = pd(0, 0);
+    distance = sqrt(squared_distance);
+
+    return GL_TRUE;
+}
+
+GLboolean SurfaceProjector3::FindClosestPoints(const ColumnMatrix<DCoordinate3> &queries,
+                                               ColumnMatrix<GLdouble> &u, ColumnMatrix<GLdouble> &v,
+                                               ColumnMatrix<DCoordinate3> &closest_points,
+                                               ColumnMatrix<GLdouble> &distances,
+                                               GLuint maximum_iteration_count, GLdouble tolerance) const
+{
+    GLint count = (GLint)queries.GetRowCount();
+
+    u.ResizeRows(count);
+    v.ResizeRows(count);
+    closest_points.ResizeRows(count);
+    distances.ResizeRows(count);
+
+    atomic<GLboolean> success(GL_TRUE);
+
+    TaskScheduler::Instance().ParallelFor(0, count, [&](GLint chunk_begin, GLint chunk_end)
+    {
+        for (GLint i = chunk_begin; i < chunk_end; ++i)
+            if (!FindClosestPoint(queries[i], u[i], v[i], closest_points[i], distances[i], maximum_iteration_count, tolerance))
+                success = GL_FALSE;
+    }, 256);
+
+    return success;
+}
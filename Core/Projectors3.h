@@ -0,0 +1,85 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <vector>
+#include "DCoordinates3.h"
+#include "KdTrees3.h"
+#include "LinearCombination3.h"
+#include "Matrices.h"
+#include "TensorProductSurfaces3.h"
+
+namespace cagd
+{
+    //----------------------
+    // class CurveProjector3
+    //----------------------
+    // Closest point queries (point inversion) on a curve. The curve is sampled once at uniformly
+    // distributed parameter values; the samples are stored in a k-d tree that supplies the
+    // starting parameter of a Newton iteration minimizing the squared distance to the query.
+    //
+    // If the curve provides only first order derivatives, the Gauss-Newton method is used. The
+    // curve must outlive the projector, and Update() has to be called whenever its control
+    // points change.
+    class CurveProjector3
+    {
+    protected:
+        const LinearCombination3    *_curve;
+        GLuint                      _sample_count;
+        GLuint                      _maximum_order_of_derivatives;  // 1 or 2
+        std::vector<GLdouble>       _parameter;                     // of the samples
+        KdTree3                     _tree;
+
+    public:
+        // special constructor
+        CurveProjector3(const LinearCombination3 &curve, GLuint sample_count = 512);
+
+        // resamples the curve
+        GLboolean Update();
+
+        // returns the parameter and the position of the closest point, and its distance
+        GLboolean FindClosestPoint(const DCoordinate3 &query,
+                                   GLdouble &u, DCoordinate3 &closest_point, GLdouble &distance,
+                                   GLuint maximum_iteration_count = 16, GLdouble tolerance = 1.0e-12) const;
+
+        // batched queries, distributed among threads
+        GLboolean FindClosestPoints(const ColumnMatrix<DCoordinate3> &queries,
+                                    ColumnMatrix<GLdouble> &u, ColumnMatrix<DCoordinate3> &closest_points,
+                                    ColumnMatrix<GLdouble> &distances,
+                                    GLuint maximum_iteration_count = 16, GLdouble tolerance = 1.0e-12) const;
+    };
+
+    //------------------------
+    // class SurfaceProjector3
+    //------------------------
+    // Closest point queries on a tensor product surface, the samples form a uniform grid over
+    // the definition domain. The same requirements apply as in case of CurveProjector3.
+    class SurfaceProjector3
+    {
+    protected:
+        const TensorProductSurface3 *_surface;
+        GLuint                      _u_sample_count, _v_sample_count;
+        GLuint                      _maximum_order_of_derivatives;  // 1 or 2
+        std::vector<GLdouble>       _u_parameter, _v_parameter;     // of the samples
+        KdTree3                     _tree;
+
+    public:
+        // special constructor
+        SurfaceProjector3(const TensorProductSurface3 &surface,
+                          GLuint u_sample_count = 64, GLuint v_sample_count = 64);
+
+        // resamples the surface
+        GLboolean Update();
+
+        // returns the parameters and the position of the closest point, and its distance
+        GLboolean FindClosestPoint(const DCoordinate3 &query,
+                                   GLdouble &u, GLdouble &v, DCoordinate3 &closest_point, GLdouble &distance,
+                                   GLuint maximum_iteration_count = 16, GLdouble tolerance = 1.0e-12) const;
+
+        // batched queries, distributed among threads
+        GLboolean FindClosestPoints(const ColumnMatrix<DCoordinate3> &queries,
+                                    ColumnMatrix<GLdouble> &u, ColumnMatrix<GLdouble> &v,
+                                    ColumnMatrix<DCoordinate3> &closest_points,
+                                    ColumnMatrix<GLdouble> &distances,
+                                    GLuint maximum_iteration_count = 16, GLdouble tolerance = 1.0e-12) const;
+    };
+}
@@ -1,4 +1,5 @@
 #include "RealSquareMatrices.h"
+#include "Profilers.h"
 
 using namespace cagd;
 using namespace std;
@@ -47,6 +48,8 @@ GLboolean RealSquareMatrix::PerformLUDecomposition()
     if (_row_count <= 1)
         return GL_FALSE;
 
+    CAGD_PROFILE_ZONE("RealSquareMatrix::PerformLUDecomposition");
+
     const GLdouble tiny = numeric_limits<GLdouble>::min();
 
     GLuint size = (GLuint)_data.size();
@@ -0,0 +1,341 @@
+#include "RenderBatches.h"
+#include "Profilers.h"
+
+using namespace cagd;
+using namespace std;
+
+// default constructor
+RenderBatch::RenderBatch():
+        _vbo_vertices(0), _vbo_normals(0), _vbo_tex_coordinates(0), _vbo_indices(0),
+        _vbo_curve_points(0),
+        _triangle_count(0)
+{
+}
+
+GLboolean RenderBatch::AddMesh(const TriangulatedMesh3& mesh, Material& material, const ShaderProgram* shader)
+{
+    // the packed arrays of an uploaded batch have been released
+    if (_vbo_vertices || _vbo_curve_points)
+        return GL_FALSE;
+
+    if (!mesh.VertexCount() || mesh._face.empty())
+        return GL_FALSE;
+
+    // finding the group of the (shader, material) pair
+    vector<MeshGroup>::iterator git = _mesh_group.begin();
+    while (git != _mesh_group.end() && (git->shader != shader || git->material != &material))
+        ++git;
+
+    if (git == _mesh_group.end())
+    {
+        MeshGroup group;
+        group.shader   = shader;
+        group.material = &material;
+        _mesh_group.push_back(group);
+        git = _mesh_group.end() - 1;
+    }
+
+    // the indices of the mesh are rebased to the position of its first vertex in the shared buffers
+    GLuint first_vertex = (GLuint)_vertex.size() / 3;
+    GLuint first_index  = (GLuint)_index.size();
+
+    if (mesh._compact)
+    {
+        _vertex.insert(_vertex.end(), mesh._compact_vertex.begin(), mesh._compact_vertex.end());
+        _normal.insert(_normal.end(), mesh._compact_normal.begin(), mesh._compact_normal.end());
+    }
+    else
+    {
+        for (vector<DCoordinate3>::const_iterator
+             vit = mesh._vertex.begin(),
+             nit = mesh._normal.begin(); vit != mesh._vertex.end(); ++vit, ++nit)
+        {
+            for (GLint component = 0; component < 3; ++component)
+            {
+                _vertex.push_back((GLfloat)(*vit)[component]);
+                _normal.push_back((GLfloat)(*nit)[component]);
+            }
+        }
+    }
+
+    for (vector<TCoordinate4>::const_iterator tit = mesh._tex.begin(); tit != mesh._tex.end(); ++tit)
+    {
+        for (GLint component = 0; component < 4; ++component)
+            _tex.push_back((*tit)[component]);
+    }
+
+    for (vector<TriangularFace>::const_iterator fit = mesh._face.begin(); fit != mesh._face.end(); ++fit)
+    {
+        for (GLint node = 0; node < 3; ++node)
+            _index.push_back(first_vertex + (*fit)[node]);
+    }
+
+    git->count.push_back(3 * (GLsizei)mesh._face.size());
+    git->offset.push_back((const GLvoid*)(first_index * sizeof(GLuint)));
+
+    return GL_TRUE;
+}
+
+GLboolean RenderBatch::AddCurve(const GenericCurve3& curve, const Color4& color)
+{
+    if (_vbo_vertices || _vbo_curve_points)
+        return GL_FALSE;
+
+    GLuint point_count = curve.GetPointCount();
+
+    if (!point_count)
+        return GL_FALSE;
+
+    // finding the group of the color
+    vector<CurveGroup>::iterator git = _curve_group.begin();
+    while (git != _curve_group.end() &&
+           (git->color.r() != color.r() || git->color.g() != color.g() ||
+            git->color.b() != color.b() || git->color.a() != color.a()))
+        ++git;
+
+    if (git == _curve_group.end())
+    {
+        CurveGroup group;
+        group.color = color;
+        _curve_group.push_back(group);
+        git = _curve_group.end() - 1;
+    }
+
+    git->first.push_back((GLint)_curve_point.size() / 3);
+    git->count.push_back((GLsizei)point_count);
+
+    for (GLuint i = 0; i < point_count; ++i)
+    {
+        DCoordinate3 point = curve(0, i);
+
+        for (GLint component = 0; component < 3; ++component)
+            _curve_point.push_back((GLfloat)point[component]);
+    }
+
+    return GL_TRUE;
+}
+
+GLvoid RenderBatch::ReplaceShaderProgram(const ShaderProgram* old_shader, const ShaderProgram* new_shader)
+{
+    for (vector<MeshGroup>::iterator git = _mesh_group.begin(); git != _mesh_group.end(); ++git)
+        if (git->shader == old_shader)
+            git->shader = new_shader;
+}
+
+GLvoid RenderBatch::Clear()
+{
+    DeleteVertexBufferObjects();
+
+    _vertex.clear();
+    _normal.clear();
+    _tex.clear();
+    _index.clear();
+    _curve_point.clear();
+    _triangle_count = 0;
+
+    _mesh_group.clear();
+    _curve_group.clear();
+}
+
+GLvoid RenderBatch::DeleteVertexBufferObjects()
+{
+    GLuint *vbo[5] = {&_vbo_vertices, &_vbo_normals, &_vbo_tex_coordinates, &_vbo_indices, &_vbo_curve_points};
+
+    for (GLint i = 0; i < 5; ++i)
+    {
+        if (*vbo[i])
+        {
+            glDeleteBuffers(1, vbo[i]);
+            *vbo[i] = 0;
+        }
+    }
+}
+
+GLboolean RenderBatch::UpdateVertexBufferObjects(GLenum usage_flag)
+{
+    if (usage_flag != GL_STREAM_DRAW  && usage_flag != GL_STREAM_READ  && usage_flag != GL_STREAM_COPY
+     && usage_flag != GL_STATIC_DRAW  && usage_flag != GL_STATIC_READ  && usage_flag != GL_STATIC_COPY
+     && usage_flag != GL_DYNAMIC_DRAW && usage_flag != GL_DYNAMIC_READ && usage_flag != GL_DYNAMIC_COPY)
+        return GL_FALSE;
+
+    CAGD_PROFILE_ZONE("RenderBatch::UpdateVertexBufferObjects");
+
+    if (_vbo_vertices || _vbo_curve_points)
+        return GL_TRUE;
+
+    if (!_index.empty())
+    {
+        glGenBuffers(1, &_vbo_vertices);
+        glGenBuffers(1, &_vbo_normals);
+        glGenBuffers(1, &_vbo_tex_coordinates);
+        glGenBuffers(1, &_vbo_indices);
+
+        if (!_vbo_vertices || !_vbo_normals || !_vbo_tex_coordinates || !_vbo_indices)
+        {
+            DeleteVertexBufferObjects();
+            return GL_FALSE;
+        }
+
+        // the packed arrays already store single precision values, thus they can be uploaded directly
+        glBindBuffer(GL_ARRAY_BUFFER, _vbo_vertices);
+        glBufferData(GL_ARRAY_BUFFER, _vertex.size() * sizeof(GLfloat), &_vertex[0], usage_flag);
+
+        glBindBuffer(GL_ARRAY_BUFFER, _vbo_normals);
+        glBufferData(GL_ARRAY_BUFFER, _normal.size() * sizeof(GLfloat), &_normal[0], usage_flag);
+
+        glBindBuffer(GL_ARRAY_BUFFER, _vbo_tex_coordinates);
+        glBufferData(GL_ARRAY_BUFFER, _tex.size() * sizeof(GLfloat), &_tex[0], usage_flag);
+
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _vbo_indices);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, _index.size() * sizeof(GLuint), &_index[0], usage_flag);
+
+        CAGD_PROFILE_COUNT(ALLOCATIONS, 4);
+        CAGD_PROFILE_COUNT(ALLOCATED_BYTES, (_vertex.size() + _normal.size() + _tex.size()) * sizeof(GLfloat) +
+                                            _index.size() * sizeof(GLuint));
+    }
+
+    if (!_curve_point.empty())
+    {
+        glGenBuffers(1, &_vbo_curve_points);
+
+        if (!_vbo_curve_points)
+        {
+            DeleteVertexBufferObjects();
+            return GL_FALSE;
+        }
+
+        glBindBuffer(GL_ARRAY_BUFFER, _vbo_curve_points);
+        glBufferData(GL_ARRAY_BUFFER, _curve_point.size() * sizeof(GLfloat), &_curve_point[0], usage_flag);
+
+        CAGD_PROFILE_COUNT(ALLOCATIONS, 1);
+        CAGD_PROFILE_COUNT(ALLOCATED_BYTES, _curve_point.size() * sizeof(GLfloat));
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+    // the buffer objects store the only copy of the geometry from now on
+    _triangle_count = (GLuint)_index.size() / 3;
+
+    vector<GLfloat>().swap(_vertex);
+    vector<GLfloat>().swap(_normal);
+    vector<GLfloat>().swap(_tex);
+    vector<GLuint>().swap(_index);
+    vector<GLfloat>().swap(_curve_point);
+
+    return GL_TRUE;
+}
+
+GLboolean RenderBatch::RenderMeshes(GLenum render_mode) const
+{
+    if (!_vbo_vertices || !_vbo_normals || !_vbo_tex_coordinates || !_vbo_indices)
+        return GL_FALSE;
+
+    if (render_mode != GL_TRIANGLES && render_mode != GL_POINTS)
+        return GL_FALSE;
+
+    // enable client states of vertex, normal and texture coordinate arrays
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_NORMAL_ARRAY);
+    glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+
+        glBindBuffer(GL_ARRAY_BUFFER, _vbo_tex_coordinates);
+        glTexCoordPointer(4, GL_FLOAT, 0, (const GLvoid *)0);
+
+        glBindBuffer(GL_ARRAY_BUFFER, _vbo_normals);
+        glNormalPointer(GL_FLOAT, 0, (const GLvoid *)0);
+
+        glBindBuffer(GL_ARRAY_BUFFER, _vbo_vertices);
+        glVertexPointer(3, GL_FLOAT, 0, (const GLvoid *)0);
+
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _vbo_indices);
+
+        // one submission per (shader, material) pair
+        for (vector<MeshGroup>::const_iterator git = _mesh_group.begin(); git != _mesh_group.end(); ++git)
+        {
+            if (git->shader)
+                git->shader->Enable();
+            else
+                ShaderProgram::UseFixedFunctionPipeline();
+
+            git->material->Apply();
+
+            glMultiDrawElements(render_mode, &git->count[0], GL_UNSIGNED_INT,
+                                (const GLvoid* const*)&git->offset[0], (GLsizei)git->count.size());
+        }
+
+        ShaderProgram::UseFixedFunctionPipeline();
+
+        CAGD_PROFILE_COUNT(DRAW_CALLS, _mesh_group.size());
+
+        if (render_mode == GL_TRIANGLES)
+            CAGD_PROFILE_COUNT(TRIANGLES, _triangle_count);
+
+    glDisableClientState(GL_VERTEX_ARRAY);
+    glDisableClientState(GL_NORMAL_ARRAY);
+    glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+    return GL_TRUE;
+}
+
+GLboolean RenderBatch::RenderCurves(GLenum render_mode) const
+{
+    if (!_vbo_curve_points)
+        return GL_FALSE;
+
+    if (render_mode != GL_LINE_STRIP && render_mode != GL_POINTS)
+        return GL_FALSE;
+
+    glEnableClientState(GL_VERTEX_ARRAY);
+        glBindBuffer(GL_ARRAY_BUFFER, _vbo_curve_points);
+            glVertexPointer(3, GL_FLOAT, 0, (const GLvoid *)0);
+
+            // one submission per color
+            for (vector<CurveGroup>::const_iterator git = _curve_group.begin(); git != _curve_group.end(); ++git)
+            {
+                glColor4f(git->color.r(), git->color.g(), git->color.b(), git->color.a());
+                glMultiDrawArrays(render_mode, &git->first[0], &git->count[0], (GLsizei)git->count.size());
+            }
+
+            CAGD_PROFILE_COUNT(DRAW_CALLS, _curve_group.size());
+
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glDisableClientState(GL_VERTEX_ARRAY);
+
+    return GL_TRUE;
+}
+
+// get properties
+GLuint RenderBatch::MeshCount() const
+{
+    GLuint result = 0;
+
+    for (vector<MeshGroup>::const_iterator git = _mesh_group.begin(); git != _mesh_group.end(); ++git)
+        result += (GLuint)git->count.size();
+
+    return result;
+}
+
+GLuint RenderBatch::CurveCount() const
+{
+    GLuint result = 0;
+
+    for (vector<CurveGroup>::const_iterator git = _curve_group.begin(); git != _curve_group.end(); ++git)
+        result += (GLuint)git->count.size();
+
+    return result;
+}
+
+GLuint RenderBatch::DrawCallCount() const
+{
+    return (GLuint)(_mesh_group.size() + _curve_group.size());
+}
+
+// destructor
+RenderBatch::~RenderBatch()
+{
+    DeleteVertexBufferObjects();
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <vector>
+#include "Colors4.h"
+#include "GenericCurves3.h"
+#include "Materials.h"
+#include "ShaderPrograms.h"
+#include "TriangulatedMeshes3.h"
+
+namespace cagd
+{
+    //------------------
+    // class RenderBatch
+    //------------------
+    // Packs the geometry of several triangulated meshes and curves into shared vertex buffer objects.
+    //
+    // Meshes are grouped by (shader program, material) pairs, curves by colors. Rendering binds the
+    // shared buffers once, and issues a single glMultiDrawElements (meshes) or glMultiDrawArrays
+    // (curves) call per group, instead of a separate client state setup and draw call per object.
+    //
+    // The geometry is copied when an object is added, thus the original meshes and curves do not
+    // have to outlive the batch. Whenever they change, the batch has to be cleared and refilled.
+    //
+    // The packed arrays are released once they have been uploaded into the vertex buffer objects,
+    // thus the geometry lives only once, on the GPU. Therefore geometry cannot be appended to an
+    // uploaded batch, and deleting its buffer objects discards the geometry.
+    class RenderBatch
+    {
+    protected:
+        struct MeshGroup
+        {
+            const ShaderProgram         *shader;    // 0 denotes the fixed-function pipeline
+            Material                    *material;
+            std::vector<GLsizei>        count;      // number of indices per mesh
+            std::vector<const GLvoid*>  offset;     // byte offset of the first index per mesh
+        };
+
+        struct CurveGroup
+        {
+            Color4                      color;
+            std::vector<GLint>          first;      // index of the first point per curve
+            std::vector<GLsizei>        count;      // number of points per curve
+        };
+
+        // vertex buffer object identifiers
+        GLuint                      _vbo_vertices;
+        GLuint                      _vbo_normals;
+        GLuint                      _vbo_tex_coordinates;
+        GLuint                      _vbo_indices;
+        GLuint                      _vbo_curve_points;
+
+        // packed geometry
+        std::vector<GLfloat>        _vertex;
+        std::vector<GLfloat>        _normal;
+        std::vector<GLfloat>        _tex;
+        std::vector<GLuint>         _index;
+        std::vector<GLfloat>        _curve_point;
+        GLuint                      _triangle_count;    // of the uploaded meshes
+
+        std::vector<MeshGroup>      _mesh_group;
+        std::vector<CurveGroup>     _curve_group;
+
+    private:
+        // batches own vertex buffer objects, they cannot be copied
+        RenderBatch(const RenderBatch&);
+        RenderBatch& operator =(const RenderBatch&);
+
+    public:
+        // default constructor
+        RenderBatch();
+
+        // appends the geometry of a mesh to the group of the given material and shader program,
+        // fails if the batch has already been uploaded
+        GLboolean AddMesh(const TriangulatedMesh3& mesh, Material& material, const ShaderProgram* shader = 0);
+
+        // appends the zeroth order derivatives (i.e., the points) of a curve to the group of the given
+        // color, fails if the batch has already been uploaded
+        GLboolean AddCurve(const GenericCurve3& curve, const Color4& color);
+
+        // assigns the mesh groups of old_shader to new_shader, the geometry is not touched
+        GLvoid ReplaceShaderProgram(const ShaderProgram* old_shader, const ShaderProgram* new_shader);
+
+        // removes all geometry and groups, and deletes the vertex buffer objects
+        GLvoid Clear();
+
+        // vertex buffer object handling methods; the packed arrays are released by a successful
+        // upload, further calls keep the uploaded buffer objects
+        GLvoid    DeleteVertexBufferObjects();
+        GLboolean UpdateVertexBufferObjects(GLenum usage_flag = GL_STATIC_DRAW);
+
+        // renders all mesh groups, the shader programs are disabled on return
+        GLboolean RenderMeshes(GLenum render_mode = GL_TRIANGLES) const;
+
+        // renders all curve groups as line strips or points
+        GLboolean RenderCurves(GLenum render_mode = GL_LINE_STRIP) const;
+
+        // get properties
+        GLuint MeshCount() const;
+        GLuint CurveCount() const;
+        GLuint DrawCallCount() const;
+
+        // destructor
+        virtual ~RenderBatch();
+    };
+}
@@ -0,0 +1,371 @@
+#include "RenderPassProfilers.h"
+#include <algorithm>
+#include <fstream>
+
+using namespace cagd;
+using namespace std;
+
+// special and default constructor
+RenderPassProfiler::PassStatistics::PassStatistics(const string &name):
+        name(name),
+        gpu_time(-1.0), cpu_time(0.0), gpu_frame(0),
+        draw_calls(0), triangles(0), state_changes(0)
+{
+}
+
+GLdouble RenderPassProfiler::FrameRecord::GPUTime() const
+{
+    if (pending_count)
+        return -1.0;
+
+    GLdouble result = 0.0;
+
+    for (GLuint i = 0; i < pass_gpu_time.size(); ++i)
+        if (pass_gpu_time[i] >= 0.0)
+            result += pass_gpu_time[i];
+
+    return result;
+}
+
+// special and default constructor
+RenderPassProfiler::RenderPassProfiler(GLuint history_size, GLuint maximum_pending_count):
+        _enabled(GL_FALSE), _supported(GL_FALSE),
+        _maximum_pending_count(maximum_pending_count),
+        _current_pass(-1), _current_query(0), _current_query_issued(0), _pass_begin(0),
+        _frame(0), _inside_frame(GL_FALSE), _frame_begin(0), _previous_frame_begin(-1),
+        _history_size(history_size)
+{
+    for (GLuint i = 0; i < Profiler::COUNTER_COUNT; ++i)
+        _pass_counter[i] = 0;
+}
+
+GLvoid RenderPassProfiler::SetEnabled(GLboolean enabled)
+{
+    if (_current_pass >= 0)
+        EndPass();
+
+    _enabled   = enabled;
+    _supported = enabled && (GLEW_VERSION_3_3 || GLEW_ARB_timer_query || GLEW_EXT_timer_query);
+
+    if (!enabled)
+        DeleteQueries();
+}
+
+GLboolean RenderPassProfiler::IsEnabled() const
+{
+    return _enabled;
+}
+
+GLboolean RenderPassProfiler::IsGPUTimingSupported() const
+{
+    return _supported;
+}
+
+GLvoid RenderPassProfiler::BeginFrame()
+{
+    if (!_enabled)
+        return;
+
+    _frame_begin  = Profiler::Instance().Now();
+    _inside_frame = GL_TRUE;
+
+    FrameRecord record;
+    record.frame         = _frame;
+    record.frame_time    = _previous_frame_begin < 0 ? -1.0 : (_frame_begin - _previous_frame_begin) * 1.0e-6;
+    record.cpu_time      = 0.0;
+    record.pending_count = 0;
+
+    _previous_frame_begin = _frame_begin;
+
+    _history.push_back(record);
+
+    while (_history.size() > _history_size)
+        _history.pop_front();
+}
+
+GLvoid RenderPassProfiler::EndFrame()
+{
+    if (!_enabled || !_inside_frame)
+        return;
+
+    if (_current_pass >= 0)
+        EndPass();
+
+    _history.back().cpu_time = (Profiler::Instance().Now() - _frame_begin) * 1.0e-6;
+
+    _inside_frame = GL_FALSE;
+    ++_frame;
+
+    _CollectResults();
+}
+
+GLvoid RenderPassProfiler::BeginPass(const string &name)
+{
+    if (!_enabled)
+        return;
+
+    if (_current_pass >= 0)
+        EndPass();
+
+    map<string, GLuint>::const_iterator it = _pass_index.find(name);
+
+    if (it == _pass_index.end())
+    {
+        it = _pass_index.insert(make_pair(name, (GLuint)_pass.size())).first;
+        _pass.push_back(PassStatistics(name));
+    }
+
+    _current_pass  = (GLint)it->second;
+    _current_query = 0;
+
+    if (_supported && _inside_frame && _pending.size() < _maximum_pending_count)
+    {
+        if (_free_query.empty())
+        {
+            GLuint query = 0;
+            glGenQueries(1, &query);
+
+            if (query)
+                _free_query.push_back(query);
+        }
+
+        if (!_free_query.empty())
+        {
+            _current_query = _free_query.back();
+            _free_query.pop_back();
+
+            _current_query_issued = Profiler::Instance().Now();
+            glBeginQuery(GL_TIME_ELAPSED, _current_query);
+        }
+    }
+
+    Profiler &profiler = Profiler::Instance();
+
+    for (GLuint i = 0; i < Profiler::COUNTER_COUNT; ++i)
+        _pass_counter[i] = profiler.GetCounter((Profiler::Counter)i);
+
+    _pass_begin = profiler.Now();
+}
+
+GLvoid RenderPassProfiler::EndPass()
+{
+    if (!_enabled || _current_pass < 0)
+        return;
+
+    if (_current_query)
+    {
+        glEndQuery(GL_TIME_ELAPSED);
+
+        PendingQuery pending;
+        pending.query  = _current_query;
+        pending.pass   = (GLuint)_current_pass;
+        pending.frame  = _frame;
+        pending.issued = _current_query_issued;
+
+        _pending.push_back(pending);
+
+        if (_inside_frame)
+            ++_history.back().pending_count;
+    }
+
+    Profiler       &profiler = Profiler::Instance();
+    PassStatistics &pass     = _pass[_current_pass];
+
+    pass.cpu_time      = (profiler.Now() - _pass_begin) * 1.0e-6;
+    pass.draw_calls    = profiler.GetCounter(Profiler::DRAW_CALLS)    - _pass_counter[Profiler::DRAW_CALLS];
+    pass.triangles     = profiler.GetCounter(Profiler::TRIANGLES)     - _pass_counter[Profiler::TRIANGLES];
+    pass.state_changes = profiler.GetCounter(Profiler::STATE_CHANGES) - _pass_counter[Profiler::STATE_CHANGES];
+
+    _current_pass  = -1;
+    _current_query = 0;
+}
+
+// the queries finish in the order of their submission, thus the first unavailable result ends the
+// collection; checking the availability does not wait for the GPU
+GLvoid RenderPassProfiler::_CollectResults()
+{
+    while (!_pending.empty())
+    {
+        const PendingQuery &pending = _pending.front();
+        GLint64             now     = Profiler::Instance().Now();
+
+        GLint available = 0;
+        glGetQueryObjectiv(pending.query, GL_QUERY_RESULT_AVAILABLE, &available);
+
+        if (!available)
+            break;
+
+        GLuint64 elapsed = 0;
+
+        if (GLEW_VERSION_3_3 || GLEW_ARB_timer_query)
+            glGetQueryObjectui64v(pending.query, GL_QUERY_RESULT, &elapsed);
+        else
+            glGetQueryObjectui64vEXT(pending.query, GL_QUERY_RESULT, &elapsed);
+
+        // the GPU cannot have worked longer on the pass than the time passed since it was issued;
+        // e.g. the first query of a context rendering into a framebuffer object is measured from
+        // zero by llvmpipe, such results are treated as unmeasured
+        _SetPassGPUTime(pending.frame, pending.pass,
+                        (GLint64)elapsed <= now - pending.issued ? elapsed * 1.0e-6 : -1.0);
+
+        _free_query.push_back(pending.query);
+        _pending.pop_front();
+    }
+}
+
+GLvoid RenderPassProfiler::_SetPassGPUTime(GLuint64 frame, GLuint pass, GLdouble time)
+{
+    PassStatistics &statistics = _pass[pass];
+
+    if (time >= 0.0 && (statistics.gpu_time < 0.0 || frame >= statistics.gpu_frame))
+    {
+        statistics.gpu_time  = time;
+        statistics.gpu_frame = frame;
+    }
+
+    // the record may have left the window meanwhile
+    if (_history.empty() || frame < _history.front().frame || frame > _history.back().frame)
+        return;
+
+    FrameRecord &record = _history[(GLuint)(frame - _history.front().frame)];
+
+    --record.pending_count;
+
+    if (time < 0.0)
+        return;
+
+    if (record.pass_gpu_time.size() <= pass)
+        record.pass_gpu_time.resize(pass + 1, -1.0);
+
+    // a pass may be rendered several times by a frame
+    record.pass_gpu_time[pass] = (record.pass_gpu_time[pass] < 0.0 ? 0.0 : record.pass_gpu_time[pass]) + time;
+}
+
+const vector<RenderPassProfiler::PassStatistics>& RenderPassProfiler::GetPasses() const
+{
+    return _pass;
+}
+
+const deque<RenderPassProfiler::FrameRecord>& RenderPassProfiler::GetFrames() const
+{
+    return _history;
+}
+
+GLvoid RenderPassProfiler::FrameTimeHistogram(GLdouble bin_width, GLuint bin_count, vector<GLuint> &counts) const
+{
+    counts.assign(bin_count, 0);
+
+    if (!bin_count || bin_width <= 0.0)
+        return;
+
+    for (deque<FrameRecord>::const_iterator it = _history.begin(); it != _history.end(); ++it)
+    {
+        if (it->frame_time < 0.0)
+            continue;
+
+        GLuint bin = (GLuint)min(it->frame_time / bin_width, (GLdouble)(bin_count - 1));
+
+        ++counts[bin];
+    }
+}
+
+GLboolean RenderPassProfiler::ExportHistogramCSV(const string &file_name, GLdouble bin_width, GLuint bin_count) const
+{
+    vector<GLuint> counts;
+    FrameTimeHistogram(bin_width, bin_count, counts);
+
+    ofstream f(file_name.c_str(), ios_base::out);
+
+    if (!f.good())
+        return GL_FALSE;
+
+    f << "lower_ms,upper_ms,frame_count\n";
+
+    for (GLuint i = 0; i < counts.size(); ++i)
+    {
+        f << i * bin_width << ",";
+
+        // the last bin is unbounded
+        if (i + 1 < counts.size())
+            f << (i + 1) * bin_width;
+
+        f << "," << counts[i] << "\n";
+    }
+
+    f.close();
+
+    return !f.fail();
+}
+
+GLboolean RenderPassProfiler::ExportFramesCSV(const string &file_name) const
+{
+    ofstream f(file_name.c_str(), ios_base::out);
+
+    if (!f.good())
+        return GL_FALSE;
+
+    f << "frame,frame_time_ms,cpu_time_ms,gpu_time_ms";
+
+    for (GLuint i = 0; i < _pass.size(); ++i)
+        f << "," << _pass[i].name << "_gpu_ms";
+
+    f << "\n";
+
+    for (deque<FrameRecord>::const_iterator it = _history.begin(); it != _history.end(); ++it)
+    {
+        f << it->frame << ",";
+
+        if (it->frame_time >= 0.0)
+            f << it->frame_time;
+
+        f << "," << it->cpu_time << ",";
+
+        GLdouble gpu_time = it->GPUTime();
+
+        if (_supported && gpu_time >= 0.0)
+            f << gpu_time;
+
+        for (GLuint i = 0; i < _pass.size(); ++i)
+        {
+            f << ",";
+
+            if (i < it->pass_gpu_time.size() && it->pass_gpu_time[i] >= 0.0)
+                f << it->pass_gpu_time[i];
+        }
+
+        f << "\n";
+    }
+
+    f.close();
+
+    return !f.fail();
+}
+
+GLvoid RenderPassProfiler::DeleteQueries()
+{
+    if (_current_query)
+    {
+        glEndQuery(GL_TIME_ELAPSED);
+        _free_query.push_back(_current_query);
+        _current_query = 0;
+    }
+
+    for (deque<PendingQuery>::const_iterator it = _pending.begin(); it != _pending.end(); ++it)
+        _free_query.push_back(it->query);
+
+    _pending.clear();
+
+    if (!_free_query.empty())
+        glDeleteQueries((GLsizei)_free_query.size(), &_free_query[0]);
+
+    _free_query.clear();
+
+    // the discarded results are not waited for by the frames
+    for (deque<FrameRecord>::iterator it = _history.begin(); it != _history.end(); ++it)
+        it->pending_count = 0;
+}
+
+RenderPassProfiler::~RenderPassProfiler()
+{
+    DeleteQueries();
+}
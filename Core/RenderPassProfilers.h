@@ -0,0 +1,143 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+#include "Profilers.h"
+
+namespace cagd
+{
+    //-------------------------
+    // class RenderPassProfiler
+    //-------------------------
+    // Measures the GPU time of the render passes of a frame by GL_TIME_ELAPSED queries (OpenGL 3.3,
+    // ARB_timer_query or EXT_timer_query). The results are never waited for: a query is read back
+    // by a later frame, once its result has become available, thus the GPU times of a pass lag
+    // behind by a few frames. Queries are skipped while too many results are outstanding.
+    //
+    // For every pass the CPU time of issuing it and the draw calls, triangles and state changes of
+    // the Profiler counters are recorded as well (the counters are only increased if the
+    // application is built with CAGD_PROFILING, and the Profiler is enabled).
+    //
+    // The durations of the latest frames (the interval between the beginning of consecutive frames,
+    // i.e. the reciprocal of the frame rate) are kept in a rolling window, which can be exported as
+    // a histogram or frame by frame into CSV files.
+    //
+    // Timer queries cannot be nested, thus beginning a pass ends the running one. The methods have
+    // to be called by the thread of the rendering context.
+    class RenderPassProfiler
+    {
+    public:
+        class PassStatistics
+        {
+        public:
+            std::string name;
+
+            // in milliseconds, the GPU time belongs to the frame gpu_frame, it is negative until the
+            // first result is available (or if timer queries are not supported)
+            GLdouble    gpu_time, cpu_time;
+            GLuint64    gpu_frame;
+
+            // of the last frame that rendered the pass
+            GLint64     draw_calls, triangles, state_changes;
+
+            PassStatistics(const std::string &name = "");
+        };
+
+        class FrameRecord
+        {
+        public:
+            GLuint64               frame;
+            GLdouble               frame_time;      // since the beginning of the previous frame, in ms
+            GLdouble               cpu_time;        // from BeginFrame() to EndFrame(), in ms
+            GLint                  pending_count;   // count of unresolved timer queries
+
+            // GPU times of the passes (indexed as the passes), negative if the pass was not measured
+            std::vector<GLdouble>  pass_gpu_time;
+
+            // sum of the measured passes, negative while some of them are pending
+            GLdouble               GPUTime() const;
+        };
+
+    protected:
+        class PendingQuery
+        {
+        public:
+            GLuint      query;
+            GLuint      pass;
+            GLuint64    frame;
+            GLint64     issued;     // CPU time of glBeginQuery()
+        };
+
+        GLboolean                       _enabled;
+        GLboolean                       _supported;
+
+        std::vector<PassStatistics>     _pass;
+        std::map<std::string, GLuint>   _pass_index;
+
+        std::vector<GLuint>             _free_query;
+        std::deque<PendingQuery>        _pending;
+        GLuint                          _maximum_pending_count;
+
+        GLint                           _current_pass;  // -1 if no pass is running
+        GLuint                          _current_query; // 0 if the running pass is not measured
+        GLint64                         _current_query_issued;
+        GLint64                         _pass_begin;
+        GLint64                         _pass_counter[Profiler::COUNTER_COUNT];
+
+        GLuint64                        _frame;
+        GLboolean                       _inside_frame;
+        GLint64                         _frame_begin, _previous_frame_begin;
+
+        GLuint                          _history_size;
+        std::deque<FrameRecord>         _history;
+
+        GLvoid _CollectResults();
+        // a negative time marks an implausible result, which is discarded
+        GLvoid _SetPassGPUTime(GLuint64 frame, GLuint pass, GLdouble time);
+
+    private:
+        // the profiler owns query objects
+        RenderPassProfiler(const RenderPassProfiler&);
+        RenderPassProfiler& operator =(const RenderPassProfiler&);
+
+    public:
+        // special and default constructor
+        RenderPassProfiler(GLuint history_size = 1000, GLuint maximum_pending_count = 64);
+
+        // has to be called with a current rendering context, after the initialization of GLEW
+        GLvoid    SetEnabled(GLboolean enabled);
+        GLboolean IsEnabled() const;
+
+        // GL_TRUE if timer queries are supported by the enabled profiler
+        GLboolean IsGPUTimingSupported() const;
+
+        GLvoid    BeginFrame();
+        GLvoid    EndFrame();
+
+        GLvoid    BeginPass(const std::string &name);
+        GLvoid    EndPass();
+
+        const std::vector<PassStatistics>& GetPasses() const;
+        const std::deque<FrameRecord>&     GetFrames() const;
+
+        // counts of the frame times of the window in bins [i * bin_width, (i + 1) * bin_width),
+        // the last bin also counts the longer frames
+        GLvoid    FrameTimeHistogram(GLdouble bin_width, GLuint bin_count, std::vector<GLuint> &counts) const;
+
+        // columns: lower and upper bounds of the bins in milliseconds, counts of frame times
+        GLboolean ExportHistogramCSV(const std::string &file_name,
+                                     GLdouble bin_width = 1.0, GLuint bin_count = 100) const;
+
+        // columns: frame, frame time, CPU time, GPU time and the GPU times of the passes, in
+        // milliseconds; unknown GPU times are left empty
+        GLboolean ExportFramesCSV(const std::string &file_name) const;
+
+        // the query objects can only be deleted while the rendering context is current
+        GLvoid    DeleteQueries();
+
+        ~RenderPassProfiler();
+    };
+}
@@ -0,0 +1,145 @@
+#include "RenderQueues.h"
+#include "RenderStates.h"
+#include <algorithm>
+#include <functional>
+
+using namespace cagd;
+using namespace std;
+
+// default constructor
+RenderQueue::RenderQueue():
+        _shader_change_count(0), _material_change_count(0),
+        _light_set_change_count(0), _draw_call_count(0)
+{
+}
+
+bool RenderQueue::_Precedes(const Item &lhs, const Item &rhs)
+{
+    // opaque items first, transparent ones keep their submission order
+    if (lhs.transparent != rhs.transparent)
+        return !lhs.transparent;
+
+    if (lhs.transparent)
+        return lhs.order < rhs.order;
+
+    if (lhs.shader != rhs.shader)
+        return less<const ShaderProgram*>()(lhs.shader, rhs.shader);
+
+    if (lhs.material != rhs.material)
+        return less<const Material*>()(lhs.material, rhs.material);
+
+    if (lhs.lights != rhs.lights)
+        return less<const LightSet*>()(lhs.lights, rhs.lights);
+
+    return lhs.order < rhs.order;
+}
+
+GLvoid RenderQueue::Submit(const TriangulatedMesh3 &mesh, Material &material,
+                           const ShaderProgram *shader, const LightSet *lights, GLenum render_mode)
+{
+    Item item;
+
+    item.shader      = shader;
+    item.material    = &material;
+    item.lights      = lights;
+    item.mesh        = &mesh;
+    item.render_mode = render_mode;
+    item.transparent = material.IsTransparent();
+    item.order       = (GLuint)_item.size();
+
+    _item.push_back(item);
+}
+
+GLvoid RenderQueue::Flush()
+{
+    _shader_change_count = _material_change_count = _light_set_change_count = _draw_call_count = 0;
+
+    sort(_item.begin(), _item.end(), _Precedes);
+
+    const ShaderProgram *shader   = 0;
+    Material            *material = 0;
+    const LightSet      *lights   = 0;
+
+    for (vector<Item>::const_iterator it = _item.begin(); it != _item.end(); ++it)
+    {
+        if (it == _item.begin() || it->shader != shader)
+        {
+            shader = it->shader;
+
+            if (shader)
+                shader->Enable();
+            else
+                ShaderProgram::UseFixedFunctionPipeline();
+
+            ++_shader_change_count;
+        }
+
+        if (it == _item.begin() || it->lights != lights)
+        {
+            if (lights)
+                lights->Disable();
+
+            lights = it->lights;
+
+            if (lights)
+            {
+                lights->Enable();
+                RenderState::Enable(GL_NORMALIZE);
+            }
+
+            ++_light_set_change_count;
+        }
+
+        if (it->material != material)
+        {
+            material = it->material;
+            material->Apply();
+
+            ++_material_change_count;
+        }
+
+        it->mesh->Render(it->render_mode);
+        ++_draw_call_count;
+    }
+
+    if (lights)
+    {
+        lights->Disable();
+        RenderState::Disable(GL_NORMALIZE);
+    }
+
+    ShaderProgram::UseFixedFunctionPipeline();
+
+    _item.clear();
+}
+
+GLvoid RenderQueue::Clear()
+{
+    _item.clear();
+}
+
+// get properties
+GLuint RenderQueue::GetItemCount() const
+{
+    return (GLuint)_item.size();
+}
+
+GLuint RenderQueue::GetShaderChangeCount() const
+{
+    return _shader_change_count;
+}
+
+GLuint RenderQueue::GetMaterialChangeCount() const
+{
+    return _material_change_count;
+}
+
+GLuint RenderQueue::GetLightSetChangeCount() const
+{
+    return _light_set_change_count;
+}
+
+GLuint RenderQueue::GetDrawCallCount() const
+{
+    return _draw_call_count;
+}
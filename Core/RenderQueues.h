@@ -0,0 +1,70 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <vector>
+#include "Lights.h"
+#include "Materials.h"
+#include "ShaderPrograms.h"
+#include "TriangulatedMeshes3.h"
+
+namespace cagd
+{
+    //------------------
+    // class RenderQueue
+    //------------------
+    // Collects the meshes of a frame together with their render states, and renders them sorted
+    // by (shader program, material, light set), so that each state is bound once per run of
+    // equal keys. Transparent materials are rendered after every opaque one, in submission order.
+    //
+    // Together with the redundancy filter of RenderState (used by materials and lights) and
+    // the bound program tracking of ShaderProgram, consecutive items only cost the state
+    // changes in which they actually differ.
+    class RenderQueue
+    {
+    protected:
+        struct Item
+        {
+            const ShaderProgram     *shader;        // 0 denotes the fixed-function pipeline
+            Material                *material;
+            const LightSet          *lights;        // 0 denotes disabled lighting
+            const TriangulatedMesh3 *mesh;
+            GLenum                  render_mode;
+            GLboolean               transparent;
+            GLuint                  order;          // position of submission
+        };
+
+        std::vector<Item>   _item;
+
+        // statistics of the last Flush()
+        GLuint              _shader_change_count;
+        GLuint              _material_change_count;
+        GLuint              _light_set_change_count;
+        GLuint              _draw_call_count;
+
+        static bool         _Precedes(const Item &lhs, const Item &rhs);
+
+    public:
+        // default constructor
+        RenderQueue();
+
+        // the mesh, the material, the shader program and the light set have to stay alive until
+        // the next call of Flush() or Clear()
+        GLvoid Submit(const TriangulatedMesh3 &mesh, Material &material,
+                      const ShaderProgram *shader = 0, const LightSet *lights = 0,
+                      GLenum render_mode = GL_TRIANGLES);
+
+        // renders and removes every submitted item; on return the fixed-function pipeline is
+        // in use and lighting is disabled
+        GLvoid Flush();
+
+        // removes every submitted item without rendering it
+        GLvoid Clear();
+
+        // get properties
+        GLuint GetItemCount() const;
+        GLuint GetShaderChangeCount() const;
+        GLuint GetMaterialChangeCount() const;
+        GLuint GetLightSetChangeCount() const;
+        GLuint GetDrawCallCount() const;
+    };
+}
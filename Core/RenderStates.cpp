@@ -0,0 +1,205 @@
+#include "RenderStates.h"
+#include "Profilers.h"
+
+using namespace cagd;
+using namespace std;
+
+// nothing is mirrored before the first call
+map<GLenum, GLboolean>   RenderState::_capability;
+RenderState::CachedValue RenderState::_light[RenderState::MAX_LIGHT_COUNT][RenderState::LIGHT_PARAMETER_COUNT];
+RenderState::CachedValue RenderState::_material[2][RenderState::MATERIAL_PARAMETER_COUNT];
+
+GLuint RenderState::_emitted_call_count = 0;
+GLuint RenderState::_skipped_call_count = 0;
+
+GLint RenderState::_LightParameterIndex(GLenum parameter_name)
+{
+    switch (parameter_name)
+    {
+    case GL_AMBIENT:                return LIGHT_AMBIENT;
+    case GL_DIFFUSE:                return LIGHT_DIFFUSE;
+    case GL_SPECULAR:               return LIGHT_SPECULAR;
+    case GL_SPOT_CUTOFF:            return LIGHT_SPOT_CUTOFF;
+    case GL_SPOT_EXPONENT:          return LIGHT_SPOT_EXPONENT;
+    case GL_CONSTANT_ATTENUATION:   return LIGHT_CONSTANT_ATTENUATION;
+    case GL_LINEAR_ATTENUATION:     return LIGHT_LINEAR_ATTENUATION;
+    case GL_QUADRATIC_ATTENUATION:  return LIGHT_QUADRATIC_ATTENUATION;
+    default:                        return -1;
+    }
+}
+
+GLint RenderState::_MaterialParameterIndex(GLenum parameter_name)
+{
+    switch (parameter_name)
+    {
+    case GL_AMBIENT:                return MATERIAL_AMBIENT;
+    case GL_DIFFUSE:                return MATERIAL_DIFFUSE;
+    case GL_SPECULAR:               return MATERIAL_SPECULAR;
+    case GL_EMISSION:               return MATERIAL_EMISSION;
+    case GL_SHININESS:              return MATERIAL_SHININESS;
+    default:                        return -1;
+    }
+}
+
+GLboolean RenderState::_Update(CachedValue &cached, const GLfloat *values, GLint value_count)
+{
+    if (cached.valid)
+    {
+        GLint i = 0;
+        while (i < value_count && cached.value[i] == values[i])
+            ++i;
+
+        if (i == value_count)
+            return GL_FALSE;
+    }
+
+    for (GLint i = 0; i < value_count; ++i)
+        cached.value[i] = values[i];
+
+    cached.valid = GL_TRUE;
+
+    return GL_TRUE;
+}
+
+GLvoid RenderState::Invalidate()
+{
+    _capability.clear();
+
+    for (GLint i = 0; i < MAX_LIGHT_COUNT; ++i)
+        for (GLint j = 0; j < LIGHT_PARAMETER_COUNT; ++j)
+            _light[i][j].valid = GL_FALSE;
+
+    for (GLint i = 0; i < 2; ++i)
+        for (GLint j = 0; j < MATERIAL_PARAMETER_COUNT; ++j)
+            _material[i][j].valid = GL_FALSE;
+}
+
+GLvoid RenderState::Enable(GLenum capability)
+{
+    map<GLenum, GLboolean>::iterator it = _capability.find(capability);
+
+    if (it != _capability.end() && it->second)
+    {
+        ++_skipped_call_count;
+        return;
+    }
+
+    glEnable(capability);
+    _capability[capability] = GL_TRUE;
+    ++_emitted_call_count;
+    CAGD_PROFILE_COUNT(STATE_CHANGES, 1);
+}
+
+GLvoid RenderState::Disable(GLenum capability)
+{
+    map<GLenum, GLboolean>::iterator it = _capability.find(capability);
+
+    if (it != _capability.end() && !it->second)
+    {
+        ++_skipped_call_count;
+        return;
+    }
+
+    glDisable(capability);
+    _capability[capability] = GL_FALSE;
+    ++_emitted_call_count;
+    CAGD_PROFILE_COUNT(STATE_CHANGES, 1);
+}
+
+GLvoid RenderState::Lightfv(GLenum light, GLenum parameter_name, const GLfloat *values)
+{
+    GLint light_index = (GLint)light - GL_LIGHT0;
+    GLint parameter   = _LightParameterIndex(parameter_name);
+
+    if (light_index >= 0 && light_index < MAX_LIGHT_COUNT && parameter >= 0 &&
+        !_Update(_light[light_index][parameter], values, parameter < LIGHT_SPOT_CUTOFF ? 4 : 1))
+    {
+        ++_skipped_call_count;
+        return;
+    }
+
+    glLightfv(light, parameter_name, values);
+    ++_emitted_call_count;
+    CAGD_PROFILE_COUNT(STATE_CHANGES, 1);
+}
+
+GLvoid RenderState::Lightf(GLenum light, GLenum parameter_name, GLfloat value)
+{
+    GLint light_index = (GLint)light - GL_LIGHT0;
+    GLint parameter   = _LightParameterIndex(parameter_name);
+
+    if (light_index >= 0 && light_index < MAX_LIGHT_COUNT && parameter >= LIGHT_SPOT_CUTOFF &&
+        !_Update(_light[light_index][parameter], &value, 1))
+    {
+        ++_skipped_call_count;
+        return;
+    }
+
+    glLightf(light, parameter_name, value);
+    ++_emitted_call_count;
+    CAGD_PROFILE_COUNT(STATE_CHANGES, 1);
+}
+
+GLvoid RenderState::Materialfv(GLenum face, GLenum parameter_name, const GLfloat *values)
+{
+    if (parameter_name == GL_AMBIENT_AND_DIFFUSE)
+    {
+        Materialfv(face, GL_AMBIENT, values);
+        Materialfv(face, GL_DIFFUSE, values);
+        return;
+    }
+
+    GLint parameter = _MaterialParameterIndex(parameter_name);
+
+    if (parameter < 0)
+    {
+        glMaterialfv(face, parameter_name, values);
+        ++_emitted_call_count;
+        CAGD_PROFILE_COUNT(STATE_CHANGES, 1);
+        return;
+    }
+
+    GLint value_count = (parameter == MATERIAL_SHININESS) ? 1 : 4;
+
+    // the mirrors of both faces are updated before deciding which faces have to be emitted
+    GLboolean front_changed = (face != GL_BACK)  && _Update(_material[0][parameter], values, value_count);
+    GLboolean back_changed  = (face != GL_FRONT) && _Update(_material[1][parameter], values, value_count);
+
+    if (front_changed && back_changed)
+    {
+        glMaterialfv(face, parameter_name, values);
+        ++_emitted_call_count;
+        CAGD_PROFILE_COUNT(STATE_CHANGES, 1);
+    }
+    else if (front_changed || back_changed)
+    {
+        glMaterialfv(front_changed ? GL_FRONT : GL_BACK, parameter_name, values);
+        ++_emitted_call_count;
+        CAGD_PROFILE_COUNT(STATE_CHANGES, 1);
+    }
+    else
+    {
+        ++_skipped_call_count;
+    }
+}
+
+GLvoid RenderState::Materialf(GLenum face, GLenum parameter_name, GLfloat value)
+{
+    Materialfv(face, parameter_name, &value);
+}
+
+// get properties
+GLuint RenderState::GetEmittedCallCount()
+{
+    return _emitted_call_count;
+}
+
+GLuint RenderState::GetSkippedCallCount()
+{
+    return _skipped_call_count;
+}
+
+GLvoid RenderState::ResetCallCounts()
+{
+    _emitted_call_count = _skipped_call_count = 0;
+}
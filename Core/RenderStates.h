@@ -0,0 +1,80 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <map>
+
+namespace cagd
+{
+    //------------------
+    // class RenderState
+    //------------------
+    // Mirrors the fixed-function capabilities, light and material parameters that were last
+    // sent to OpenGL, and drops every call that would not change them.
+    //
+    // The mirror is only correct as long as these states are modified exclusively through this
+    // class, i.e., lights, materials and render queues use it instead of calling glEnable,
+    // glLight* and glMaterial* directly. Invalidate() has to be called whenever the rendering
+    // context is (re)created or foreign code might have changed the mirrored states.
+    //
+    // Light positions and spot directions are never skipped, since OpenGL transforms them by
+    // the model view matrix that is current at the time of the call.
+    class RenderState
+    {
+    public:
+        enum { MAX_LIGHT_COUNT = 8 };
+
+    protected:
+        enum LightParameter
+        {
+            LIGHT_AMBIENT = 0, LIGHT_DIFFUSE, LIGHT_SPECULAR,
+            LIGHT_SPOT_CUTOFF, LIGHT_SPOT_EXPONENT,
+            LIGHT_CONSTANT_ATTENUATION, LIGHT_LINEAR_ATTENUATION, LIGHT_QUADRATIC_ATTENUATION,
+            LIGHT_PARAMETER_COUNT
+        };
+
+        enum MaterialParameter
+        {
+            MATERIAL_AMBIENT = 0, MATERIAL_DIFFUSE, MATERIAL_SPECULAR, MATERIAL_EMISSION, MATERIAL_SHININESS,
+            MATERIAL_PARAMETER_COUNT
+        };
+
+        struct CachedValue
+        {
+            GLboolean valid;
+            GLfloat   value[4];
+        };
+
+        static std::map<GLenum, GLboolean> _capability;
+        static CachedValue                 _light[MAX_LIGHT_COUNT][LIGHT_PARAMETER_COUNT];
+        static CachedValue                 _material[2][MATERIAL_PARAMETER_COUNT];   // front and back faces
+
+        static GLuint                      _emitted_call_count;
+        static GLuint                      _skipped_call_count;
+
+        // return -1 for parameters that are not mirrored
+        static GLint     _LightParameterIndex(GLenum parameter_name);
+        static GLint     _MaterialParameterIndex(GLenum parameter_name);
+
+        // returns GL_TRUE and stores the new value if it differs from the mirrored one
+        static GLboolean _Update(CachedValue &cached, const GLfloat *values, GLint value_count);
+
+    public:
+        // forgets every mirrored state, thus the next calls will be emitted unconditionally
+        static GLvoid    Invalidate();
+
+        static GLvoid    Enable(GLenum capability);
+        static GLvoid    Disable(GLenum capability);
+
+        static GLvoid    Lightfv(GLenum light, GLenum parameter_name, const GLfloat *values);
+        static GLvoid    Lightf(GLenum light, GLenum parameter_name, GLfloat value);
+
+        // face can be GL_FRONT, GL_BACK or GL_FRONT_AND_BACK
+        static GLvoid    Materialfv(GLenum face, GLenum parameter_name, const GLfloat *values);
+        static GLvoid    Materialf(GLenum face, GLenum parameter_name, GLfloat value);
+
+        // number of emitted and skipped state changing calls since the last reset
+        static GLuint    GetEmittedCallCount();
+        static GLuint    GetSkippedCallCount();
+        static GLvoid    ResetCallCounts();
+    };
+}
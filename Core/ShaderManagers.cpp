@@ -0,0 +1,263 @@
+#include "ShaderManagers.h"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+
+using namespace cagd;
+using namespace std;
+
+// identifies the files of program binaries and their layout
+static const char   BINARY_MAGIC[8] = {'C', 'A', 'G', 'D', 'P', 'B', 'I', 'N'};
+static const GLuint BINARY_VERSION  = 1;
+
+// special constructor
+ShaderManager::ShaderManager(const string &cache_directory): _cache_directory(cache_directory)
+{
+    if (!_cache_directory.empty())
+    {
+        char last = _cache_directory[_cache_directory.size() - 1];
+        if (last != '/' && last != '\\')
+            _cache_directory += '/';
+    }
+}
+
+// 64-bit FNV-1a hash
+GLuint64 ShaderManager::_Hash(const string &data)
+{
+    GLuint64 result = 14695981039346656037ULL;
+
+    for (string::const_iterator it = data.begin(); it != data.end(); ++it)
+    {
+        result ^= (GLubyte)*it;
+        result *= 1099511628211ULL;
+    }
+
+    return result;
+}
+
+string ShaderManager::_BinaryFileName(GLuint64 key) const
+{
+    char name[32];
+    sprintf(name, "%016llx.bin", (unsigned long long)key);
+
+    return _cache_directory + name;
+}
+
+GLboolean ShaderManager::_LoadBinary(const Entry &entry, GLuint64 key, ShaderProgram &program) const
+{
+    fstream file(_BinaryFileName(key).c_str(), ios_base::in | ios_base::binary);
+
+    if (!file || !file.good())
+        return GL_FALSE;
+
+    char     magic[8];
+    GLuint   version = 0;
+    GLuint64 stored_key = 0;
+    GLenum   format = 0;
+    GLuint   length = 0;
+
+    file.read(magic, sizeof(magic));
+    file.read((char*)&version, sizeof(version));
+    file.read((char*)&stored_key, sizeof(stored_key));
+    file.read((char*)&format, sizeof(format));
+    file.read((char*)&length, sizeof(length));
+
+    if (!file.good() || !equal(magic, magic + 8, BINARY_MAGIC) ||
+        version != BINARY_VERSION || stored_key != key || !length)
+        return GL_FALSE;
+
+    vector<GLubyte> binary(length);
+    file.read((char*)&binary[0], length);
+
+    if (file.gcount() != (streamsize)length)
+        return GL_FALSE;
+
+    file.close();
+
+    return program.InstallProgramBinary(entry.vertex_shader_file_name, entry.fragment_shader_file_name, format, binary);
+}
+
+GLboolean ShaderManager::_SaveBinary(const ShaderProgram &program, GLuint64 key) const
+{
+    GLenum          format = 0;
+    vector<GLubyte> binary;
+
+    if (!program.GetProgramBinary(format, binary))
+        return GL_FALSE;
+
+    fstream file(_BinaryFileName(key).c_str(), ios_base::out | ios_base::binary | ios_base::trunc);
+
+    if (!file || !file.good())
+        return GL_FALSE;
+
+    GLuint length = (GLuint)binary.size();
+
+    file.write(BINARY_MAGIC, sizeof(BINARY_MAGIC));
+    file.write((const char*)&BINARY_VERSION, sizeof(BINARY_VERSION));
+    file.write((const char*)&key, sizeof(key));
+    file.write((const char*)&format, sizeof(format));
+    file.write((const char*)&length, sizeof(length));
+    file.write((const char*)&binary[0], length);
+
+    GLboolean result = file.good();
+
+    file.close();
+
+    return result;
+}
+
+GLboolean ShaderManager::_Build(
+        Entry &entry, const string &vertex_shader_source, const string &fragment_shader_source,
+        GLboolean logging_is_enabled, ostream &output)
+{
+    GLboolean persistent = !_cache_directory.empty() && ShaderProgram::ProgramBinariesAreSupported();
+
+    if (persistent && _driver_signature.empty())
+    {
+        const GLubyte *strings[3] = {glGetString(GL_VENDOR), glGetString(GL_RENDERER), glGetString(GL_VERSION)};
+
+        for (GLint i = 0; i < 3; ++i)
+        {
+            if (strings[i])
+                _driver_signature += (const char*)strings[i];
+            _driver_signature += '\n';
+        }
+    }
+
+    GLuint64 key = _Hash(_driver_signature + '\0' + vertex_shader_source + '\0' + fragment_shader_source);
+
+    ShaderProgram program;
+    GLboolean     loaded_from_binary = persistent && _LoadBinary(entry, key, program);
+
+    if (!loaded_from_binary)
+    {
+        if (!program.InstallShaderSources(entry.vertex_shader_file_name, entry.fragment_shader_file_name,
+                                          vertex_shader_source, fragment_shader_source,
+                                          logging_is_enabled, output))
+            return GL_FALSE;
+
+        if (persistent && !_SaveBinary(program, key) && logging_is_enabled)
+            output << "Could not store the binary of the program "
+                   << entry.vertex_shader_file_name << " + " << entry.fragment_shader_file_name << endl;
+    }
+
+    // the previous program (if any) is released by the destructor of the temporary object
+    entry.program->Swap(program);
+
+    entry.vertex_shader_source   = vertex_shader_source;
+    entry.fragment_shader_source = fragment_shader_source;
+    entry.loaded_from_binary     = loaded_from_binary;
+
+    return GL_TRUE;
+}
+
+GLuint ShaderManager::Register(const string &vertex_shader_file_name, const string &fragment_shader_file_name)
+{
+    Entry entry;
+
+    entry.vertex_shader_file_name   = vertex_shader_file_name;
+    entry.fragment_shader_file_name = fragment_shader_file_name;
+    entry.program                   = new ShaderProgram();
+    entry.loaded_from_binary        = GL_FALSE;
+
+    _entry.push_back(entry);
+
+    return (GLuint)_entry.size() - 1;
+}
+
+GLboolean ShaderManager::Install(GLboolean logging_is_enabled, ostream &output)
+{
+    GLboolean result = GL_TRUE;
+
+    for (vector<Entry>::iterator eit = _entry.begin(); eit != _entry.end(); ++eit)
+    {
+        if (eit->program->IsInstalled())
+            continue;
+
+        string vertex_shader_source, fragment_shader_source;
+
+        if (!ShaderProgram::LoadSourceFile(eit->vertex_shader_file_name, vertex_shader_source) ||
+            !ShaderProgram::LoadSourceFile(eit->fragment_shader_file_name, fragment_shader_source) ||
+            !_Build(*eit, vertex_shader_source, fragment_shader_source, logging_is_enabled, output))
+        {
+            output << "Could not install the program "
+                   << eit->vertex_shader_file_name << " + " << eit->fragment_shader_file_name << endl;
+            result = GL_FALSE;
+        }
+    }
+
+    return result;
+}
+
+GLuint ShaderManager::ReloadChangedPrograms(GLboolean logging_is_enabled, ostream &output)
+{
+    GLuint result = 0;
+
+    for (vector<Entry>::iterator eit = _entry.begin(); eit != _entry.end(); ++eit)
+    {
+        string vertex_shader_source, fragment_shader_source;
+
+        // files that are being rewritten by an editor may be missing for a short while
+        if (!ShaderProgram::LoadSourceFile(eit->vertex_shader_file_name, vertex_shader_source) ||
+            !ShaderProgram::LoadSourceFile(eit->fragment_shader_file_name, fragment_shader_source))
+            continue;
+
+        if (eit->program->IsInstalled() &&
+            vertex_shader_source == eit->vertex_shader_source &&
+            fragment_shader_source == eit->fragment_shader_source)
+            continue;
+
+        if (_Build(*eit, vertex_shader_source, fragment_shader_source, logging_is_enabled, output))
+            ++result;
+        else
+            output << "Could not reload the program "
+                   << eit->vertex_shader_file_name << " + " << eit->fragment_shader_file_name
+                   << ", the previous version is kept" << endl;
+    }
+
+    return result;
+}
+
+ShaderProgram& ShaderManager::operator [](GLuint index)
+{
+    return *_entry[index].program;
+}
+
+const ShaderProgram& ShaderManager::operator [](GLuint index) const
+{
+    return *_entry[index].program;
+}
+
+// get properties
+GLuint ShaderManager::GetProgramCount() const
+{
+    return (GLuint)_entry.size();
+}
+
+GLuint ShaderManager::GetProgramsLoadedFromBinariesCount() const
+{
+    GLuint result = 0;
+
+    for (vector<Entry>::const_iterator eit = _entry.begin(); eit != _entry.end(); ++eit)
+        if (eit->loaded_from_binary)
+            ++result;
+
+    return result;
+}
+
+const string& ShaderManager::GetVertexShaderFileName(GLuint index) const
+{
+    return _entry[index].vertex_shader_file_name;
+}
+
+const string& ShaderManager::GetFragmentShaderFileName(GLuint index) const
+{
+    return _entry[index].fragment_shader_file_name;
+}
+
+// destructor
+ShaderManager::~ShaderManager()
+{
+    for (vector<Entry>::iterator eit = _entry.begin(); eit != _entry.end(); ++eit)
+        delete eit->program, eit->program = 0;
+}
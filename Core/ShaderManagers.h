@@ -0,0 +1,87 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "ShaderPrograms.h"
+
+namespace cagd
+{
+    //--------------------
+    // class ShaderManager
+    //--------------------
+    // Keeps a fixed set of shader programs resident, so that switching between them only
+    // requires a glUseProgram call.
+    //
+    // Each program is built once by Install(). If a cache directory is given and the driver
+    // supports program binaries, the linked binary is stored in a file named after the hash
+    // of the driver identification strings and of both source codes. On the next start the
+    // binary is loaded instead of compiling and linking the sources again; changed sources,
+    // drivers or hardware simply lead to a different file name.
+    //
+    // ReloadChangedPrograms() re-reads the source files and rebuilds only the programs whose
+    // sources changed. A program that fails to compile or link keeps its previous version.
+    // The ShaderProgram objects are never reallocated, thus pointers to them stay valid, but
+    // uniform handles and uniform values have to be set again after a reload.
+    class ShaderManager
+    {
+    protected:
+        struct Entry
+        {
+            std::string     vertex_shader_file_name;
+            std::string     fragment_shader_file_name;
+            std::string     vertex_shader_source;       // sources of the resident program
+            std::string     fragment_shader_source;
+            ShaderProgram   *program;
+            GLboolean       loaded_from_binary;
+        };
+
+        std::string         _cache_directory;           // empty if binaries are not persisted
+        std::string         _driver_signature;          // vendor, renderer and version strings
+        std::vector<Entry>  _entry;
+
+        static GLuint64     _Hash(const std::string &data);
+        std::string         _BinaryFileName(GLuint64 key) const;
+
+        GLboolean           _LoadBinary(const Entry &entry, GLuint64 key, ShaderProgram &program) const;
+        GLboolean           _SaveBinary(const ShaderProgram &program, GLuint64 key) const;
+
+        // builds the given sources into a temporary program, and swaps it into the entry on success
+        GLboolean           _Build(Entry &entry, const std::string &vertex_shader_source, const std::string &fragment_shader_source,
+                                   GLboolean logging_is_enabled, std::ostream &output);
+
+    private:
+        // managers own their shader programs, they cannot be copied
+        ShaderManager(const ShaderManager&);
+        ShaderManager& operator =(const ShaderManager&);
+
+    public:
+        // special constructor, an empty directory name disables the persistence of program binaries
+        ShaderManager(const std::string &cache_directory = "");
+
+        // registers a program and returns its index, the program is built by Install()
+        GLuint Register(const std::string &vertex_shader_file_name, const std::string &fragment_shader_file_name);
+
+        // builds every registered program that has not been installed yet, requires a current
+        // rendering context; returns GL_FALSE if at least one of them could not be installed
+        GLboolean Install(GLboolean logging_is_enabled = GL_FALSE, std::ostream &output = std::cout);
+
+        // rebuilds the programs whose source files changed since their last successful build,
+        // requires a current rendering context; returns the number of replaced programs
+        GLuint ReloadChangedPrograms(GLboolean logging_is_enabled = GL_FALSE, std::ostream &output = std::cout);
+
+        // the returned programs are resident for the whole lifetime of the manager
+        ShaderProgram&       operator [](GLuint index);
+        const ShaderProgram& operator [](GLuint index) const;
+
+        // get properties
+        GLuint             GetProgramCount() const;
+        GLuint             GetProgramsLoadedFromBinariesCount() const;
+        const std::string& GetVertexShaderFileName(GLuint index) const;
+        const std::string& GetFragmentShaderFileName(GLuint index) const;
+
+        // destructor
+        virtual ~ShaderManager();
+    };
+}
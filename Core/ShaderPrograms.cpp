@@ -1,10 +1,35 @@
 #include "Exceptions.h"
 #include <fstream>
+#include <sstream>
+#include "Profilers.h"
 #include "ShaderPrograms.h"
 
 using namespace cagd;
 using namespace std;
 
+// no program is in use when the rendering context is created
+GLuint ShaderProgram::_current_program = 0;
+
+// default constructor of uniform handles
+ShaderProgram::Uniform::Uniform(): _program(0), _location(-1), _type(0)
+{
+}
+
+GLboolean ShaderProgram::Uniform::IsValid() const
+{
+    return _program && _location != -1;
+}
+
+GLint ShaderProgram::Uniform::GetLocation() const
+{
+    return _location;
+}
+
+GLenum ShaderProgram::Uniform::GetType() const
+{
+    return _type;
+}
+
 ShaderProgram::ShaderProgram():
         _vertex_shader(0), _fragment_shader(0), _program(0),
         _vertex_shader_file_name(""), _fragment_shader_file_name(""),
@@ -139,9 +164,89 @@ GLvoid ShaderProgram::_ListValidateInfoLog(ostream& output) const
     _ListOpenGLErrors(__FILE__, __LINE__, output);
 }
 
+// builds the cache of active uniform variables, built-in uniforms (gl_*) have no locations
+GLvoid ShaderProgram::_CacheActiveUniforms()
+{
+    _uniform.clear();
+
+    GLint uniform_count = 0, max_name_length = 0;
+    glGetProgramiv(_program, GL_ACTIVE_UNIFORMS, &uniform_count);
+    glGetProgramiv(_program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &max_name_length);
+
+    if (uniform_count <= 0 || max_name_length <= 0)
+        return;
+
+    vector<GLchar> name(max_name_length + 1);
+
+    for (GLint i = 0; i < uniform_count; ++i)
+    {
+        GLsizei length = 0;
+        GLint   size = 0;
+        GLenum  type = 0;
+
+        glGetActiveUniform(_program, i, max_name_length + 1, &length, &size, &type, &name[0]);
+
+        string uniform_name(&name[0], length);
+
+        Uniform uniform;
+        uniform._program  = _program;
+        uniform._location = glGetUniformLocation(_program, uniform_name.c_str());
+        uniform._type     = type;
+
+        if (uniform._location == -1)
+            continue;
+
+        _uniform[uniform_name] = uniform;
+
+        // arrays are reported as name[0], but they can also be referenced by their plain names
+        if (uniform_name.size() > 3 && uniform_name.compare(uniform_name.size() - 3, 3, "[0]") == 0)
+            _uniform[uniform_name.substr(0, uniform_name.size() - 3)] = uniform;
+    }
+}
+
+// checks whether the handle can be used for setting a value of the given base type
+GLboolean ShaderProgram::_PrepareUniform(const Uniform &uniform, GLenum type) const
+{
+    if (!_program || uniform._program != _program || uniform._location == -1)
+        return GL_FALSE;
+
+    switch (type)
+    {
+    case GL_INT:
+        return uniform._type == GL_INT || uniform._type == GL_BOOL ||
+               uniform._type == GL_SAMPLER_1D || uniform._type == GL_SAMPLER_2D ||
+               uniform._type == GL_SAMPLER_3D || uniform._type == GL_SAMPLER_CUBE ||
+               uniform._type == GL_SAMPLER_1D_SHADOW || uniform._type == GL_SAMPLER_2D_SHADOW;
+    case GL_INT_VEC2:
+        return uniform._type == GL_INT_VEC2 || uniform._type == GL_BOOL_VEC2;
+    case GL_INT_VEC3:
+        return uniform._type == GL_INT_VEC3 || uniform._type == GL_BOOL_VEC3;
+    case GL_INT_VEC4:
+        return uniform._type == GL_INT_VEC4 || uniform._type == GL_BOOL_VEC4;
+    default:
+        return uniform._type == type;
+    }
+}
+
+GLboolean ShaderProgram::GetUniform(const GLchar *name, Uniform &uniform) const
+{
+    map<string, Uniform>::const_iterator it = _uniform.find(name);
+
+    if (it == _uniform.end())
+    {
+        uniform = Uniform();
+        return GL_FALSE;
+    }
+
+    uniform = it->second;
+
+    return GL_TRUE;
+}
+
 GLint ShaderProgram::GetUniformVariableLocation(const GLchar *name, GLboolean logging_is_enabled, ostream& output) const
 {
-    GLint loc = glGetUniformLocation(_program, name);
+    map<string, Uniform>::const_iterator it = _uniform.find(name);
+    GLint loc = (it == _uniform.end()) ? -1 : it->second._location;
 
     if (loc == -1)
     {
@@ -156,70 +261,97 @@ GLint ShaderProgram::GetUniformVariableLocation(const GLchar *name, GLboolean lo
     return loc;
 }
 
-GLboolean ShaderProgram::InstallShaders(const string &vertex_shader_file_name, const string &fragment_shader_file_name, GLboolean logging_is_enabled, std::ostream &output)
+GLvoid ShaderProgram::_Release()
 {
-    // loading source codes into shader objects
-    _vertex_shader_file_name = vertex_shader_file_name;
-    _fragment_shader_file_name = fragment_shader_file_name;
+    // a previously installed program is released together with its cached uniform variables
+    if (_program)
+    {
+        if (_current_program == _program)
+            UseFixedFunctionPipeline();
+
+        glDeleteProgram(_program);
+        _program = 0;
+    }
+
+    _uniform.clear();
+    _vertex_shader = _fragment_shader = 0;
+    _vertex_shader_compiled = _fragment_shader_compiled = _linked = 0;
+}
 
-    fstream vertex_shader_file(vertex_shader_file_name.c_str(), ios_base::in);
+GLboolean ShaderProgram::LoadSourceFile(const string &file_name, string &source)
+{
+    fstream file(file_name.c_str(), ios_base::in);
 
-    if (!vertex_shader_file || !vertex_shader_file.good())
+    if (!file || !file.good())
     {
         return GL_FALSE;
     }
 
-    _vertex_shader_source = "";
+    source = "";
     string aux;
 
-    if (logging_is_enabled)
-    {
-        output << "Source of vertex shader" << endl;
-        output << "-----------------------" << endl;
-    }
-
-    while (!vertex_shader_file.eof())
+    while (!file.eof())
     {
-        getline(vertex_shader_file, aux, '\n');
-        _vertex_shader_source += aux + '\n';
-
-        if (logging_is_enabled)
-            output << "\t" << aux << endl;
+        getline(file, aux, '\n');
+        source += aux + '\n';
     }
 
-    vertex_shader_file.close();
+    file.close();
 
-    if (logging_is_enabled)
-        output << endl;
+    return GL_TRUE;
+}
 
-    fstream fragment_shader_file(fragment_shader_file_name.c_str(), ios_base::in);
+GLboolean ShaderProgram::InstallShaders(const string &vertex_shader_file_name, const string &fragment_shader_file_name, GLboolean logging_is_enabled, std::ostream &output)
+{
+    string vertex_shader_source, fragment_shader_source;
 
-    if (!fragment_shader_file || !fragment_shader_file.good())
+    // loading source codes
+    if (!LoadSourceFile(vertex_shader_file_name, vertex_shader_source) ||
+        !LoadSourceFile(fragment_shader_file_name, fragment_shader_source))
     {
         return GL_FALSE;
     }
 
-    _fragment_shader_source = "";
+    return InstallShaderSources(vertex_shader_file_name, fragment_shader_file_name,
+                                vertex_shader_source, fragment_shader_source,
+                                logging_is_enabled, output);
+}
+
+GLboolean ShaderProgram::InstallShaderSources(
+        const string &vertex_shader_file_name, const string &fragment_shader_file_name,
+        const string &vertex_shader_source, const string &fragment_shader_source,
+        GLboolean logging_is_enabled, ostream &output)
+{
+    _Release();
+
+    _vertex_shader_file_name = vertex_shader_file_name;
+    _fragment_shader_file_name = fragment_shader_file_name;
+
+    _vertex_shader_source = vertex_shader_source;
+    _fragment_shader_source = fragment_shader_source;
 
     if (logging_is_enabled)
     {
-        output << "Source of fragment shader" << endl;
-        output << "-------------------------" << endl;
-    }
+        string aux;
 
-    while (!fragment_shader_file.eof())
-    {
-            getline(fragment_shader_file, aux, '\n');
-            _fragment_shader_source += aux + '\n';
+        output << "Source of vertex shader" << endl;
+        output << "-----------------------" << endl;
 
-            if (logging_is_enabled)
-                output << "\t" << aux << endl;
-    }
+        istringstream vertex_shader_lines(_vertex_shader_source);
+        while (getline(vertex_shader_lines, aux, '\n'))
+            output << "\t" << aux << endl;
 
-    fragment_shader_file.close();
+        output << endl;
+
+        output << "Source of fragment shader" << endl;
+        output << "-------------------------" << endl;
+
+        istringstream fragment_shader_lines(_fragment_shader_source);
+        while (getline(fragment_shader_lines, aux, '\n'))
+            output << "\t" << aux << endl;
 
-    if (logging_is_enabled)
         output << endl;
+    }
 
     // 1) creating two empty shader objects
     {
@@ -328,6 +460,10 @@ GLboolean ShaderProgram::InstallShaders(const string &vertex_shader_file_name, c
         glAttachShader(_program, _vertex_shader);
         glAttachShader(_program, _fragment_shader);
 
+        // the linked binary can be retrieved and stored by ShaderManager
+        if (GLEW_VERSION_4_1 || GLEW_ARB_get_program_binary)
+            glProgramParameteri(_program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+
         // check for OpenGL errors
         if (logging_is_enabled)
         {
@@ -353,8 +489,12 @@ GLboolean ShaderProgram::InstallShaders(const string &vertex_shader_file_name, c
             glDeleteShader(_vertex_shader);
             glDeleteShader(_fragment_shader);
             glDeleteProgram(_program);
+            _program = 0;
             return GL_FALSE;
         }
+
+        // introspecting the active uniform variables
+        _CacheActiveUniforms();
     }
 
     // 6) flag shaders for deletion
@@ -374,6 +514,95 @@ GLboolean ShaderProgram::InstallShaders(const string &vertex_shader_file_name, c
     return GL_TRUE;
 }
 
+GLboolean ShaderProgram::InstallProgramBinary(
+        const string &vertex_shader_file_name, const string &fragment_shader_file_name,
+        GLenum format, const vector<GLubyte> &binary)
+{
+    if (!ProgramBinariesAreSupported() || binary.empty())
+        return GL_FALSE;
+
+    _Release();
+
+    _vertex_shader_file_name = vertex_shader_file_name;
+    _fragment_shader_file_name = fragment_shader_file_name;
+
+    _program = glCreateProgram();
+    if (!_program)
+        return GL_FALSE;
+
+    glProgramBinary(_program, format, &binary[0], (GLsizei)binary.size());
+    glGetProgramiv(_program, GL_LINK_STATUS, &_linked);
+
+    // the driver rejects binaries created by a different driver version or hardware
+    if (!_linked)
+    {
+        glDeleteProgram(_program);
+        _program = 0;
+        return GL_FALSE;
+    }
+
+    // there are no shader objects, but the program behaves as if both had been compiled
+    _vertex_shader_compiled = _fragment_shader_compiled = GL_TRUE;
+
+    _CacheActiveUniforms();
+
+    return GL_TRUE;
+}
+
+GLboolean ShaderProgram::GetProgramBinary(GLenum &format, vector<GLubyte> &binary) const
+{
+    if (!IsInstalled() || !ProgramBinariesAreSupported())
+        return GL_FALSE;
+
+    GLint length = 0;
+    glGetProgramiv(_program, GL_PROGRAM_BINARY_LENGTH, &length);
+
+    if (length <= 0)
+        return GL_FALSE;
+
+    binary.resize(length);
+
+    GLsizei written = 0;
+    glGetProgramBinary(_program, length, &written, &format, &binary[0]);
+
+    if (written <= 0)
+    {
+        binary.clear();
+        return GL_FALSE;
+    }
+
+    binary.resize(written);
+
+    return GL_TRUE;
+}
+
+GLboolean ShaderProgram::ProgramBinariesAreSupported()
+{
+    if (!GLEW_VERSION_4_1 && !GLEW_ARB_get_program_binary)
+        return GL_FALSE;
+
+    // some drivers expose the extension without any binary format
+    GLint format_count = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &format_count);
+
+    return format_count > 0;
+}
+
+GLvoid ShaderProgram::Swap(ShaderProgram &program)
+{
+    swap(_uniform, program._uniform);
+    swap(_vertex_shader, program._vertex_shader);
+    swap(_fragment_shader, program._fragment_shader);
+    swap(_program, program._program);
+    swap(_vertex_shader_file_name, program._vertex_shader_file_name);
+    swap(_fragment_shader_file_name, program._fragment_shader_file_name);
+    swap(_vertex_shader_source, program._vertex_shader_source);
+    swap(_fragment_shader_source, program._fragment_shader_source);
+    swap(_vertex_shader_compiled, program._vertex_shader_compiled);
+    swap(_fragment_shader_compiled, program._fragment_shader_compiled);
+    swap(_linked, program._linked);
+}
+
 GLboolean ShaderProgram::SetUniformVariable1i(const GLchar *name, GLint parameter) const
 {
     if (!_program)
@@ -488,20 +717,125 @@ GLboolean ShaderProgram::SetUniformVariable4i(const GLchar *name, GLint paramete
 }
 
 
+// uniform variable handling methods with typed handles
+GLboolean ShaderProgram::SetUniformVariable1i(const Uniform &uniform, GLint parameter) const
+{
+    if (!_PrepareUniform(uniform, GL_INT))
+        return GL_FALSE;
+
+    glUniform1i(uniform._location, parameter);
+
+    return GL_TRUE;
+}
+
+GLboolean ShaderProgram::SetUniformVariable1f(const Uniform &uniform, GLfloat parameter) const
+{
+    if (!_PrepareUniform(uniform, GL_FLOAT))
+        return GL_FALSE;
+
+    glUniform1f(uniform._location, parameter);
+
+    return GL_TRUE;
+}
+
+GLboolean ShaderProgram::SetUniformVariable2f(const Uniform &uniform, GLfloat parameter_1, GLfloat parameter_2) const
+{
+    if (!_PrepareUniform(uniform, GL_FLOAT_VEC2))
+        return GL_FALSE;
+
+    glUniform2f(uniform._location, parameter_1, parameter_2);
+
+    return GL_TRUE;
+}
+
+GLboolean ShaderProgram::SetUniformVariable3f(const Uniform &uniform, GLfloat parameter_1, GLfloat parameter_2, GLfloat parameter_3) const
+{
+    if (!_PrepareUniform(uniform, GL_FLOAT_VEC3))
+        return GL_FALSE;
+
+    glUniform3f(uniform._location, parameter_1, parameter_2, parameter_3);
+
+    return GL_TRUE;
+}
+
+GLboolean ShaderProgram::SetUniformVariable4f(const Uniform &uniform, GLfloat parameter_1, GLfloat parameter_2, GLfloat parameter_3, GLfloat parameter_4) const
+{
+    if (!_PrepareUniform(uniform, GL_FLOAT_VEC4))
+        return GL_FALSE;
+
+    glUniform4f(uniform._location, parameter_1, parameter_2, parameter_3, parameter_4);
+
+    return GL_TRUE;
+}
+
+GLboolean ShaderProgram::SetUniformVariable2i(const Uniform &uniform, GLint parameter_1, GLint parameter_2) const
+{
+    if (!_PrepareUniform(uniform, GL_INT_VEC2))
+        return GL_FALSE;
+
+    glUniform2i(uniform._location, parameter_1, parameter_2);
+
+    return GL_TRUE;
+}
+
+GLboolean ShaderProgram::SetUniformVariable3i(const Uniform &uniform, GLint parameter_1, GLint parameter_2, GLint parameter_3) const
+{
+    if (!_PrepareUniform(uniform, GL_INT_VEC3))
+        return GL_FALSE;
+
+    glUniform3i(uniform._location, parameter_1, parameter_2, parameter_3);
+
+    return GL_TRUE;
+}
+
+GLboolean ShaderProgram::SetUniformVariable4i(const Uniform &uniform, GLint parameter_1, GLint parameter_2, GLint parameter_3, GLint parameter_4) const
+{
+    if (!_PrepareUniform(uniform, GL_INT_VEC4))
+        return GL_FALSE;
+
+    glUniform4i(uniform._location, parameter_1, parameter_2, parameter_3, parameter_4);
+
+    return GL_TRUE;
+}
+
+GLboolean ShaderProgram::IsInstalled() const
+{
+    return _program && _vertex_shader_compiled && _fragment_shader_compiled && _linked;
+}
+
 GLvoid ShaderProgram::Disable() const
 {
-    glUseProgram(0);
+    UseFixedFunctionPipeline();
 }
 
 GLvoid ShaderProgram::Enable(GLboolean logging_is_enabled, ostream& output) const
 {
-    if (_vertex_shader_compiled && _fragment_shader_compiled && _linked)
+    if (IsInstalled())
     {
-        glUseProgram(_program);
-        glValidateProgram(_program);
+        if (_current_program != _program)
+        {
+            glUseProgram(_program);
+            _current_program = _program;
+
+            CAGD_PROFILE_COUNT(STATE_CHANGES, 1);
+        }
 
         if (logging_is_enabled)
+        {
+            glValidateProgram(_program);
             _ListValidateInfoLog(output);
+        }
+    }
+}
+
+GLvoid ShaderProgram::UseFixedFunctionPipeline()
+{
+    if (_current_program)
+    {
+        glUseProgram(0);
+        _current_program = 0;
+
+        CAGD_PROFILE_COUNT(STATE_CHANGES, 1);
     }
 }
 
@@ -511,5 +845,10 @@ ShaderProgram::~ShaderProgram()
     // because they are flagged for deletion, they will be automatically deleted
     // at that time as well
     if (_program)
+    {
+        if (_current_program == _program)
+            UseFixedFunctionPipeline();
+
         glDeleteProgram(_program);
+    }
 }
@@ -2,6 +2,7 @@
 
 #include <GL/glew.h>
 #include <iostream>
+#include <map>
 #include <vector>
 #include <string>
 
@@ -9,7 +10,40 @@ namespace cagd
 {
     class ShaderProgram
     {
+    public:
+        // a typed handle of an active uniform variable, obtained once by GetUniform and then
+        // used without any name lookup by the corresponding SetUniformVariable* method
+        class Uniform
+        {
+            friend class ShaderProgram;
+
+        protected:
+            GLuint  _program;   // the program that owns the uniform variable
+            GLint   _location;
+            GLenum  _type;      // GL_FLOAT, GL_FLOAT_VEC2, ..., GL_INT, GL_BOOL, GL_SAMPLER_2D, ...
+
+        public:
+            // default constructor, creates an invalid handle
+            Uniform();
+
+            GLboolean IsValid() const;
+            GLint     GetLocation() const;
+            GLenum    GetType() const;
+        };
+
     protected:
+        // the program object that is currently in use by the rendering context,
+        // it allows to skip redundant glUseProgram calls
+        static GLuint _current_program;
+
+        // active uniform variables of the linked program indexed by name, it is built once
+        // after linking by introspection
+        std::map<std::string, Uniform> _uniform;
+
+        GLvoid      _Release();
+        GLvoid      _CacheActiveUniforms();
+        GLboolean   _PrepareUniform(const Uniform &uniform, GLenum type) const;
+
         // handles of objects
         GLuint      _vertex_shader;
         GLuint      _fragment_shader;
@@ -41,6 +75,25 @@ namespace cagd
 
         GLboolean InstallShaders(const std::string &vertex_shader_file_name, const std::string &fragment_shader_file_name, GLboolean logging_is_enabled = GL_FALSE, std::ostream &output = std::cout);
 
+        // compiles and links already loaded source codes, the file names are only stored for logging
+        GLboolean InstallShaderSources(const std::string &vertex_shader_file_name, const std::string &fragment_shader_file_name,
+                                       const std::string &vertex_shader_source, const std::string &fragment_shader_source,
+                                       GLboolean logging_is_enabled = GL_FALSE, std::ostream &output = std::cout);
+
+        // reads the whole content of a shader source file
+        static GLboolean LoadSourceFile(const std::string &file_name, std::string &source);
+
+        // program binaries (OpenGL 4.1 or GL_ARB_get_program_binary) are only valid for the
+        // driver and hardware that created them, installing an incompatible binary fails
+        static GLboolean ProgramBinariesAreSupported();
+        GLboolean InstallProgramBinary(const std::string &vertex_shader_file_name, const std::string &fragment_shader_file_name,
+                                       GLenum format, const std::vector<GLubyte> &binary);
+        GLboolean GetProgramBinary(GLenum &format, std::vector<GLubyte> &binary) const;
+
+        // exchanges the installed programs, used for replacing a program without invalidating
+        // pointers and references to the ShaderProgram object
+        GLvoid Swap(ShaderProgram &program);
+
         GLboolean SetUniformVariable1i(const GLchar *name, GLint parameter) const;
         GLboolean SetUniformVariable1f(const GLchar *name, GLfloat parameter) const;
         GLboolean SetUniformVariable2f(const GLchar *name, GLfloat parameter_1, GLfloat parameter_2) const;
@@ -51,11 +104,34 @@ namespace cagd
         GLboolean SetUniformVariable3i(const GLchar *name, GLint parameter_1, GLint parameter_2, GLint parameter_3) const;
         GLboolean SetUniformVariable4i(const GLchar *name, GLint parameter_1, GLint parameter_2, GLint parameter_3, GLint parameter_4) const;
 
+        // the same methods with typed handles, they fail if the handle belongs to a different
+        // program or if its type does not match
+        GLboolean SetUniformVariable1i(const Uniform &uniform, GLint parameter) const;
+        GLboolean SetUniformVariable1f(const Uniform &uniform, GLfloat parameter) const;
+        GLboolean SetUniformVariable2f(const Uniform &uniform, GLfloat parameter_1, GLfloat parameter_2) const;
+        GLboolean SetUniformVariable3f(const Uniform &uniform, GLfloat parameter_1, GLfloat parameter_2, GLfloat parameter_3) const;
+        GLboolean SetUniformVariable4f(const Uniform &uniform, GLfloat parameter_1, GLfloat parameter_2, GLfloat parameter_3, GLfloat parameter_4) const;
+        GLboolean SetUniformVariable2i(const Uniform &uniform, GLint parameter_1, GLint parameter_2) const;
+        GLboolean SetUniformVariable3i(const Uniform &uniform, GLint parameter_1, GLint parameter_2, GLint parameter_3) const;
+        GLboolean SetUniformVariable4i(const Uniform &uniform, GLint parameter_1, GLint parameter_2, GLint parameter_3, GLint parameter_4) const;
+
+        // the location is taken from the cache built at link time
         GLint GetUniformVariableLocation(const GLchar *name, GLboolean logging_is_enabled = GL_FALSE, std::ostream& output = std::cout) const;
 
+        // returns GL_FALSE and an invalid handle if the program has no such active uniform variable
+        GLboolean GetUniform(const GLchar *name, Uniform &uniform) const;
+
+        // returns GL_TRUE if both shaders have been compiled and the program has been linked
+        GLboolean IsInstalled() const;
+
+        // both methods skip the glUseProgram call if the required program is already in use,
+        // the program is validated only if logging is enabled
         GLvoid Disable() const;
         GLvoid Enable(GLboolean logging_is_enabled = GL_FALSE, std::ostream& output = std::cout) const;
 
+        // switches to the fixed-function pipeline, regardless of which program is in use
+        static GLvoid UseFixedFunctionPipeline();
+
         virtual ~ShaderProgram();
     };
 }
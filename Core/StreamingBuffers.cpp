@@ -0,0 +1,237 @@
+#include "StreamingBuffers.h"
+
+using namespace cagd;
+using namespace std;
+
+// default/special constructor
+StreamingBuffer::StreamingBuffer(GLenum target):
+        _target(target),
+        _vbo(0),
+        _segment_byte_size(0),
+        _segment_count(0),
+        _current_segment(-1),
+        _next_segment(0),
+        _is_persistent(GL_FALSE),
+        _is_mapped(GL_FALSE),
+        _persistent_address(0)
+{
+}
+
+// blocks until the GPU has finished all draw calls that source the given segment
+GLvoid StreamingBuffer::_WaitForSegment(GLuint segment)
+{
+    if (!_fence[segment])
+        return;
+
+    GLenum status = glClientWaitSync(_fence[segment], 0, 0);
+
+    while (status == GL_TIMEOUT_EXPIRED)
+    {
+        // 1 millisecond, given in nanoseconds
+        status = glClientWaitSync(_fence[segment], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+    }
+
+    glDeleteSync(_fence[segment]);
+    _fence[segment] = 0;
+}
+
+GLboolean StreamingBuffer::Create(GLsizeiptr segment_byte_size, GLuint segment_count)
+{
+    if (segment_byte_size <= 0 || !segment_count)
+        return GL_FALSE;
+
+    Delete();
+
+    glGenBuffers(1, &_vbo);
+    if (!_vbo)
+        return GL_FALSE;
+
+    _segment_byte_size = segment_byte_size;
+    _current_segment   = -1;
+    _next_segment      = 0;
+
+    glBindBuffer(_target, _vbo);
+
+    if ((GLEW_VERSION_4_4 || GLEW_ARB_buffer_storage) && (GLEW_VERSION_3_2 || GLEW_ARB_sync))
+    {
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        GLsizeiptr total_byte_size = segment_count * segment_byte_size;
+
+        glBufferStorage(_target, total_byte_size, 0, flags);
+        _persistent_address = (GLubyte*)glMapBufferRange(_target, 0, total_byte_size, flags);
+
+        if (_persistent_address)
+        {
+            _is_persistent = GL_TRUE;
+            _segment_count = segment_count;
+            _fence.assign(_segment_count, (GLsync)0);
+
+            glBindBuffer(_target, 0);
+
+            return GL_TRUE;
+        }
+
+        // immutable storage cannot be reallocated, so we start again with a fresh buffer object
+        glBindBuffer(_target, 0);
+        glDeleteBuffers(1, &_vbo);
+        _vbo = 0;
+
+        glGenBuffers(1, &_vbo);
+        if (!_vbo)
+            return GL_FALSE;
+
+        glBindBuffer(_target, _vbo);
+    }
+
+    // orphaning fallback
+    _is_persistent = GL_FALSE;
+    _segment_count = 1;
+    _fence.clear();
+
+    glBufferData(_target, _segment_byte_size, 0, GL_STREAM_DRAW);
+    glBindBuffer(_target, 0);
+
+    return GL_TRUE;
+}
+
+GLvoid StreamingBuffer::Delete()
+{
+    for (vector<GLsync>::iterator fit = _fence.begin(); fit != _fence.end(); ++fit)
+    {
+        if (*fit)
+        {
+            glDeleteSync(*fit);
+            *fit = 0;
+        }
+    }
+    _fence.clear();
+
+    if (_vbo)
+    {
+        if (_is_persistent || _is_mapped)
+        {
+            glBindBuffer(_target, _vbo);
+            glUnmapBuffer(_target);
+            glBindBuffer(_target, 0);
+        }
+
+        glDeleteBuffers(1, &_vbo);
+        _vbo = 0;
+    }
+
+    _segment_byte_size  = 0;
+    _segment_count      = 0;
+    _current_segment    = -1;
+    _next_segment       = 0;
+    _is_persistent      = GL_FALSE;
+    _is_mapped          = GL_FALSE;
+    _persistent_address = 0;
+}
+
+GLvoid* StreamingBuffer::MapNextSegment()
+{
+    if (!_vbo || _is_mapped)
+        return 0;
+
+    if (_is_persistent)
+    {
+        _WaitForSegment(_next_segment);
+        _is_mapped = GL_TRUE;
+
+        return _persistent_address + _next_segment * _segment_byte_size;
+    }
+
+    glBindBuffer(_target, _vbo);
+
+    // orphaning: the driver detaches the old storage that may still be in use by the GPU
+    glBufferData(_target, _segment_byte_size, 0, GL_STREAM_DRAW);
+
+    GLvoid *result = 0;
+
+    if (GLEW_VERSION_3_0 || GLEW_ARB_map_buffer_range)
+        result = glMapBufferRange(_target, 0, _segment_byte_size,
+                                  GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+    else
+        result = glMapBuffer(_target, GL_WRITE_ONLY);
+
+    glBindBuffer(_target, 0);
+
+    _is_mapped = (result != 0);
+
+    return result;
+}
+
+GLboolean StreamingBuffer::UnmapSegment()
+{
+    if (!_vbo || !_is_mapped)
+        return GL_FALSE;
+
+    _is_mapped = GL_FALSE;
+
+    if (!_is_persistent)
+    {
+        glBindBuffer(_target, _vbo);
+        GLboolean result = glUnmapBuffer(_target);
+        glBindBuffer(_target, 0);
+
+        if (!result)
+        {
+            _current_segment = -1;
+            return GL_FALSE;
+        }
+    }
+
+    _current_segment = _next_segment;
+    _next_segment    = (_next_segment + 1) % _segment_count;
+
+    return GL_TRUE;
+}
+
+GLvoid StreamingBuffer::FenceCurrentSegment()
+{
+    if (!_is_persistent || _current_segment < 0)
+        return;
+
+    // a newer fence covers every earlier draw call that sourced the same segment
+    if (_fence[_current_segment])
+        glDeleteSync(_fence[_current_segment]);
+
+    _fence[_current_segment] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+// get properties
+GLuint StreamingBuffer::GetBufferObject() const
+{
+    return _vbo;
+}
+
+GLintptr StreamingBuffer::GetCurrentSegmentOffset() const
+{
+    return _current_segment < 0 ? 0 : _current_segment * _segment_byte_size;
+}
+
+GLsizeiptr StreamingBuffer::GetSegmentByteSize() const
+{
+    return _segment_byte_size;
+}
+
+GLuint StreamingBuffer::GetSegmentCount() const
+{
+    return _segment_count;
+}
+
+GLboolean StreamingBuffer::HasData() const
+{
+    return _vbo && _current_segment >= 0;
+}
+
+GLboolean StreamingBuffer::IsPersistentlyMapped() const
+{
+    return _is_persistent;
+}
+
+// destructor
+StreamingBuffer::~StreamingBuffer()
+{
+    Delete();
+}
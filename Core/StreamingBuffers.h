@@ -0,0 +1,75 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <vector>
+
+namespace cagd
+{
+    //----------------------
+    // class StreamingBuffer
+    //----------------------
+    // A buffer object that is rewritten by the CPU on (almost) every frame.
+    //
+    // If the driver supports immutable buffer storage (OpenGL 4.4 or GL_ARB_buffer_storage),
+    // the buffer is split into a ring of equally sized segments that stay persistently and
+    // coherently mapped. Each segment is protected by a fence that is inserted after the last
+    // draw call that sourced it, so the CPU only waits if it runs a whole ring ahead of the GPU.
+    //
+    // Otherwise a single segment is used and the storage is orphaned before each update, which
+    // lets the driver hand out fresh memory instead of synchronizing with pending draw calls.
+    //
+    // In neither case is the content of the buffer ever read back by the CPU.
+    class StreamingBuffer
+    {
+    protected:
+        GLenum              _target;
+        GLuint              _vbo;
+        GLsizeiptr          _segment_byte_size;
+        GLuint              _segment_count;
+        GLint               _current_segment;   // last completely written segment (-1 if none)
+        GLuint              _next_segment;      // segment that will be written next
+        GLboolean           _is_persistent;
+        GLboolean           _is_mapped;
+        GLubyte            *_persistent_address;
+        std::vector<GLsync> _fence;
+
+        GLvoid              _WaitForSegment(GLuint segment);
+
+    private:
+        // streaming buffers own driver resources and mapped pointers, they cannot be copied
+        StreamingBuffer(const StreamingBuffer&);
+        StreamingBuffer& operator =(const StreamingBuffer&);
+
+    public:
+        // default/special constructor
+        StreamingBuffer(GLenum target = GL_ARRAY_BUFFER);
+
+        // allocates segment_count segments of segment_byte_size bytes, the orphaning fallback
+        // always uses a single segment
+        GLboolean Create(GLsizeiptr segment_byte_size, GLuint segment_count = 3);
+
+        // releases the buffer object, its mapping and all pending fences
+        GLvoid Delete();
+
+        // returns a write-only pointer to the next free segment, waits only if the GPU
+        // has not yet consumed that segment
+        GLvoid* MapNextSegment();
+
+        // finishes the update started by MapNextSegment(), the written segment becomes current
+        GLboolean UnmapSegment();
+
+        // has to be called after the last draw call that sources the current segment
+        GLvoid FenceCurrentSegment();
+
+        // get properties
+        GLuint     GetBufferObject() const;
+        GLintptr   GetCurrentSegmentOffset() const;
+        GLsizeiptr GetSegmentByteSize() const;
+        GLuint     GetSegmentCount() const;
+        GLboolean  HasData() const;
+        GLboolean  IsPersistentlyMapped() const;
+
+        // destructor
+        virtual ~StreamingBuffer();
+    };
+}
@@ -0,0 +1,630 @@
+#include "StreamingOFFConverters.h"
+#include "MappedFiles.h"
+#include "TaskSchedulers.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <vector>
+
+using namespace cagd;
+using namespace std;
+
+namespace
+{
+    const char   MESH_MAGIC[8] = {'C', 'A', 'G', 'D', 'M', 'S', 'H', '\0'};
+    const GLuint MESH_VERSION  = 1;
+
+    class MeshHeader
+    {
+    public:
+        char     magic[8];
+        GLuint   version, vertex_count, face_count, reserved;
+        GLdouble origin[3], scale;
+    };
+
+    static_assert(sizeof(MeshHeader) == 56, "unexpected padding of the mesh header");
+
+    // the passes over the mapped arrays are distributed in blocks of this many elements, thus the
+    // indices of the parallel loops do not overflow for huge meshes
+    const GLuint BLOCK_SIZE = 1 << 16;
+
+    // partial results of the parallel passes over the vertices
+    class BoundingBox
+    {
+    public:
+        GLdouble low[3], high[3];
+
+        BoundingBox()
+        {
+            for (GLuint r = 0; r < 3; ++r)
+            {
+                low[r]  =  numeric_limits<GLdouble>::max();
+                high[r] = -numeric_limits<GLdouble>::max();
+            }
+        }
+
+        GLvoid Add(GLuint r, GLdouble value)
+        {
+            low[r]  = min(low[r], value);
+            high[r] = max(high[r], value);
+        }
+
+        GLvoid Merge(const BoundingBox &box)
+        {
+            for (GLuint r = 0; r < 3; ++r)
+            {
+                low[r]  = min(low[r], box.low[r]);
+                high[r] = max(high[r], box.high[r]);
+            }
+        }
+    };
+
+    GLuint64 MeshByteCount(GLuint64 vertex_count, GLuint64 face_count)
+    {
+        return sizeof(MeshHeader) + vertex_count * 6 * sizeof(GLfloat) + face_count * 3 * sizeof(GLuint);
+    }
+
+    // skips spaces and tabs, but not the end of the line
+    inline const char* SkipBlanks(const char *p)
+    {
+        while (*p == ' ' || *p == '\t' || *p == '\r')
+            ++p;
+
+        return p;
+    }
+
+    // locale independent parser of decimal numbers; if the mantissa has more than 17 significant
+    // digits or the exponent is out of [-22, 22], the result may differ from the correctly rounded
+    // value in the last bits
+    GLboolean ParseDouble(const char *&p, GLdouble &value)
+    {
+        static const GLdouble power_of_ten[23] =
+        {
+            1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+            1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+        };
+
+        p = SkipBlanks(p);
+
+        GLboolean negative = (*p == '-');
+
+        if (*p == '-' || *p == '+')
+            ++p;
+
+        GLuint64 mantissa = 0;
+        GLint    exponent = 0, digit_count = 0;
+
+        for (; *p >= '0' && *p <= '9'; ++p, ++digit_count)
+        {
+            if (mantissa < 10000000000000000ULL)
+                mantissa = 10 * mantissa + (*p - '0');
+            else
+                ++exponent;
+        }
+
+        if (*p == '.')
+            for (++p; *p >= '0' && *p <= '9'; ++p, ++digit_count)
+            {
+                if (mantissa < 10000000000000000ULL)
+                {
+                    mantissa = 10 * mantissa + (*p - '0');
+                    --exponent;
+                }
+            }
+
+        if (!digit_count)
+            return GL_FALSE;
+
+        if (*p == 'e' || *p == 'E')
+        {
+            const char *q = p + 1;
+            GLboolean negative_exponent = (*q == '-');
+
+            if (*q == '-' || *q == '+')
+                ++q;
+
+            if (*q >= '0' && *q <= '9')
+            {
+                GLint e = 0;
+
+                for (; *q >= '0' && *q <= '9'; ++q)
+                    if (e < 100000)
+                        e = 10 * e + (*q - '0');
+
+                exponent += negative_exponent ? -e : e;
+                p = q;
+            }
+        }
+
+        value = (GLdouble)mantissa;
+
+        if (exponent > 0)
+            value *= (exponent <= 22) ? power_of_ten[exponent] : pow(10.0, exponent);
+        else if (exponent < 0)
+            value /= (exponent >= -22) ? power_of_ten[-exponent] : pow(10.0, -exponent);
+
+        if (negative)
+            value = -value;
+
+        return GL_TRUE;
+    }
+
+    GLboolean ParseUnsigned(const char *&p, GLuint &value)
+    {
+        p = SkipBlanks(p);
+
+        if (*p < '0' || *p > '9')
+            return GL_FALSE;
+
+        GLuint64 result = 0;
+
+        for (; *p >= '0' && *p <= '9'; ++p)
+        {
+            result = 10 * result + (*p - '0');
+
+            if (result > numeric_limits<GLuint>::max())
+                return GL_FALSE;
+        }
+
+        value = (GLuint)result;
+
+        return GL_TRUE;
+    }
+}
+
+// special and default constructor
+StreamingOFFConverter::StreamingOFFConverter(GLuint64 chunk_size):
+        _chunk_size(max(chunk_size, (GLuint64)1024)),
+        _vertex_count(0), _face_count(0)
+{
+}
+
+GLboolean StreamingOFFConverter::Convert(const string &off_file_name, const string &binary_file_name,
+                                         GLboolean translate_and_scale_to_unit_cube)
+{
+    ifstream input(off_file_name.c_str(), ios::in | ios::binary);
+
+    if (!input)
+        return GL_FALSE;
+
+    enum State {HEADER, COUNTS, VERTICES, FACES, DONE};
+
+    State    state = HEADER;
+    GLuint   vertex_count = 0, face_count = 0;
+    GLuint   vertex_index = 0, face_index = 0;     // elements parsed so far
+
+    MappedFile output;
+    GLfloat   *vertex = nullptr, *normal = nullptr;
+    GLuint    *face   = nullptr;
+
+    // the parsed vertices are stored relative to the first one, thus large offsets of scanned data
+    // do not cost the precision of floats
+    GLdouble    origin[3] = {0.0, 0.0, 0.0};
+    BoundingBox bounds;
+
+    // small files are not padded to a whole chunk
+    input.seekg(0, ios::end);
+    GLuint64 chunk_size = min(_chunk_size, (GLuint64)max((streamoff)input.tellg(), (streamoff)1));
+    input.seekg(0, ios::beg);
+
+    // the last byte of the buffer terminates the text of the chunk
+    vector<char>        buffer(chunk_size + 1);
+    vector<const char*> lines;
+    vector<GLfloat>     face_normal;                // of the faces of the current chunk
+    GLuint64            filled = 0;
+    GLboolean           end_of_file = GL_FALSE;
+    atomic<GLboolean>   success(GL_TRUE);
+
+    while (success && state != DONE)
+    {
+        if (!end_of_file)
+        {
+            input.read(&buffer[filled], (streamsize)(chunk_size - filled));
+
+            GLuint64 read_count = (GLuint64)input.gcount();
+
+            end_of_file = (filled + read_count < chunk_size || input.peek() == char_traits<char>::eof());
+            filled += read_count;
+        }
+
+        if (!filled)
+            break;
+
+        // the chunk ends after its last complete line, the rest is carried over to the next one
+        GLuint64 end = filled;
+
+        if (!end_of_file)
+        {
+            while (end > 0 && buffer[end - 1] != '\n')
+                --end;
+
+            // the line does not fit into a chunk
+            if (!end)
+            {
+                success = GL_FALSE;
+                break;
+            }
+        }
+
+        char carried = buffer[end];
+        buffer[end] = '\0';
+
+        // significant lines, i.e. without empty lines and comments
+        lines.clear();
+
+        for (const char *p = &buffer[0], *chunk_end = &buffer[0] + end; p < chunk_end; )
+        {
+            const char *line_end = (const char*)memchr(p, '\n', chunk_end - p);
+
+            if (!line_end)
+                line_end = chunk_end;
+
+            const char *q = SkipBlanks(p);
+
+            if (q < line_end && *q != '#')
+                lines.push_back(q);
+
+            p = line_end + 1;
+        }
+
+        GLuint l = 0, line_count = (GLuint)lines.size();
+
+        while (success && l < line_count && state != DONE)
+        {
+            const char *p = lines[l];
+
+            if (state == HEADER)
+            {
+                // the counts may follow the keyword in the same line
+                if (strncmp(p, "OFF", 3))
+                {
+                    success = GL_FALSE;
+                    break;
+                }
+
+                p = SkipBlanks(p + 3);
+                state = COUNTS;
+
+                if (*p < '0' || *p > '9')
+                {
+                    ++l;
+                    continue;
+                }
+            }
+
+            if (state == COUNTS)
+            {
+                if (!ParseUnsigned(p, vertex_count) || !ParseUnsigned(p, face_count) ||
+                    !output.Create(binary_file_name, MeshByteCount(vertex_count, face_count)))
+                {
+                    success = GL_FALSE;
+                    break;
+                }
+
+                // the normals of the created file are zero-filled
+                vertex = (GLfloat*)(output.GetWritableData() + sizeof(MeshHeader));
+                normal = vertex + 3 * (GLuint64)vertex_count;
+                face   = (GLuint*)(normal + 3 * (GLuint64)vertex_count);
+
+                state = vertex_count ? VERTICES : (face_count ? FACES : DONE);
+                ++l;
+                continue;
+            }
+
+            if (state == VERTICES)
+            {
+                GLint count = (GLint)min(line_count - l, vertex_count - vertex_index);
+
+                if (!vertex_index)
+                {
+                    const char *q = p;
+
+                    if (!ParseDouble(q, origin[0]) || !ParseDouble(q, origin[1]) || !ParseDouble(q, origin[2]))
+                    {
+                        success = GL_FALSE;
+                        break;
+                    }
+                }
+
+                auto parse = [&](GLint chunk_begin, GLint chunk_end, BoundingBox &partial)
+                {
+                    for (GLint k = chunk_begin; k < chunk_end; ++k)
+                    {
+                        const char *q = lines[l + k];
+                        GLdouble    c[3];
+
+                        if (!ParseDouble(q, c[0]) || !ParseDouble(q, c[1]) || !ParseDouble(q, c[2]))
+                        {
+                            success = GL_FALSE;
+                            continue;
+                        }
+
+                        GLfloat *v = vertex + 3 * (GLuint64)(vertex_index + k);
+
+                        for (GLuint r = 0; r < 3; ++r)
+                        {
+                            v[r] = (GLfloat)(c[r] - origin[r]);
+                            partial.Add(r, c[r]);
+                        }
+                    }
+                };
+
+                bounds.Merge(TaskScheduler::Instance().ParallelReduce(
+                        0, count, BoundingBox(), parse,
+                        [](BoundingBox &box, const BoundingBox &partial) { box.Merge(partial); }));
+
+                vertex_index += count;
+                l += count;
+
+                if (vertex_index == vertex_count)
+                    state = face_count ? FACES : DONE;
+
+                continue;
+            }
+
+            if (state == FACES)
+            {
+                GLint count = (GLint)min(line_count - l, face_count - face_index);
+
+                // the face normals are weighted by the areas of the faces, as in
+                // TriangulatedMesh3::LoadFromOFF; the translation and scaling of the vertices
+                // do not change their directions
+                face_normal.resize(3 * (size_t)count);
+
+                TaskScheduler::Instance().ParallelFor(0, count, [&](GLint chunk_begin, GLint chunk_end)
+                {
+                    for (GLint k = chunk_begin; k < chunk_end; ++k)
+                    {
+                        const char *q = lines[l + k];
+                        GLuint      node_count, node[3];
+
+                        if (!ParseUnsigned(q, node_count) || node_count != 3 ||
+                            !ParseUnsigned(q, node[0]) || !ParseUnsigned(q, node[1]) || !ParseUnsigned(q, node[2]) ||
+                            node[0] >= vertex_count || node[1] >= vertex_count || node[2] >= vertex_count)
+                        {
+                            success = GL_FALSE;
+                            continue;
+                        }
+
+                        GLuint *f = face + 3 * (GLuint64)(face_index + k);
+
+                        const GLfloat *a = vertex + 3 * (GLuint64)node[0];
+                        const GLfloat *b = vertex + 3 * (GLuint64)node[1];
+                        const GLfloat *c = vertex + 3 * (GLuint64)node[2];
+
+                        DCoordinate3 n(b[0] - a[0], b[1] - a[1], b[2] - a[2]);
+                        n ^= DCoordinate3(c[0] - a[0], c[1] - a[1], c[2] - a[2]);
+
+                        for (GLuint i = 0; i < 3; ++i)
+                        {
+                            f[i] = node[i];
+                            face_normal[3 * k + i] = (GLfloat)n[i];
+                        }
+                    }
+                });
+
+                // the normals are accumulated in the order of the faces, thus the sums do not depend
+                // on the scheduling of the threads
+                if (success)
+                {
+                    for (GLint k = 0; k < count; ++k)
+                    {
+                        const GLuint *f = face + 3 * (GLuint64)(face_index + k);
+
+                        for (GLuint i = 0; i < 3; ++i)
+                        {
+                            GLfloat *m = normal + 3 * (GLuint64)f[i];
+
+                            for (GLuint r = 0; r < 3; ++r)
+                                m[r] += face_normal[3 * k + r];
+                        }
+                    }
+                }
+
+                face_index += count;
+                l += count;
+
+                if (face_index == face_count)
+                    state = DONE;
+            }
+        }
+
+        buffer[end] = carried;
+
+        memmove(&buffer[0], &buffer[end], filled - end);
+        filled -= end;
+    }
+
+    if (!success || state != DONE)
+    {
+        output.Close();
+        remove(binary_file_name.c_str());
+        return GL_FALSE;
+    }
+
+    // stored vertex = (vertex - header.origin) * header.scale
+    MeshHeader header;
+    memset(&header, 0, sizeof(MeshHeader));
+    memcpy(header.magic, MESH_MAGIC, sizeof(MESH_MAGIC));
+
+    header.version      = MESH_VERSION;
+    header.vertex_count = vertex_count;
+    header.face_count   = face_count;
+    header.scale        = 1.0;
+
+    if (translate_and_scale_to_unit_cube && vertex_count)
+    {
+        const GLdouble *low = bounds.low, *high = bounds.high;
+
+        GLdouble extent = max(high[0] - low[0], max(high[1] - low[1], high[2] - low[2]));
+
+        for (GLuint r = 0; r < 3; ++r)
+            header.origin[r] = 0.5 * (low[r] + high[r]);
+
+        if (extent > 0.0)
+            header.scale = 1.0 / extent;
+    }
+
+    GLdouble shift[3];
+
+    for (GLuint r = 0; r < 3; ++r)
+        shift[r] = origin[r] - header.origin[r];
+
+    GLint block_count = (GLint)((vertex_count + BLOCK_SIZE - 1) / BLOCK_SIZE);
+
+    TaskScheduler::Instance().ParallelFor(0, block_count, [&](GLint chunk_begin, GLint chunk_end)
+    {
+        for (GLint block = chunk_begin; block < chunk_end; ++block)
+        {
+            GLuint64 first = (GLuint64)block * BLOCK_SIZE;
+            GLuint64 last  = min(first + BLOCK_SIZE, (GLuint64)vertex_count);
+
+            for (GLuint64 i = first; i < last; ++i)
+            {
+                GLfloat *v = vertex + 3 * i, *n = normal + 3 * i;
+
+                for (GLuint r = 0; r < 3; ++r)
+                    v[r] = (GLfloat)((v[r] + shift[r]) * header.scale);
+
+                GLdouble length = sqrt((GLdouble)n[0] * n[0] + (GLdouble)n[1] * n[1] + (GLdouble)n[2] * n[2]);
+
+                if (length > 0.0)
+                    for (GLuint r = 0; r < 3; ++r)
+                        n[r] = (GLfloat)(n[r] / length);
+            }
+        }
+    });
+
+    memcpy(output.GetWritableData(), &header, sizeof(MeshHeader));
+    output.Close();
+
+    _vertex_count = vertex_count;
+    _face_count   = face_count;
+    _low          = DCoordinate3(bounds.low[0], bounds.low[1], bounds.low[2]);
+    _high         = DCoordinate3(bounds.high[0], bounds.high[1], bounds.high[2]);
+
+    return GL_TRUE;
+}
+
+GLuint StreamingOFFConverter::GetVertexCount() const
+{
+    return _vertex_count;
+}
+
+GLuint StreamingOFFConverter::GetFaceCount() const
+{
+    return _face_count;
+}
+
+GLvoid StreamingOFFConverter::GetBoundingBox(DCoordinate3 &low, DCoordinate3 &high) const
+{
+    low  = _low;
+    high = _high;
+}
+
+GLboolean StreamingOFFConverter::Load(const string &binary_file_name, TriangulatedMesh3 &mesh, GLboolean compact)
+{
+    MappedFile file;
+
+    if (!file.OpenForReading(binary_file_name) || file.GetSize() < sizeof(MeshHeader))
+        return GL_FALSE;
+
+    MeshHeader header;
+    memcpy(&header, file.GetData(), sizeof(MeshHeader));
+
+    if (memcmp(header.magic, MESH_MAGIC, sizeof(MESH_MAGIC)) || header.version != MESH_VERSION ||
+        file.GetSize() < MeshByteCount(header.vertex_count, header.face_count))
+        return GL_FALSE;
+
+    GLuint vertex_count = header.vertex_count, face_count = header.face_count;
+
+    const GLfloat *vertex = (const GLfloat*)(file.GetData() + sizeof(MeshHeader));
+    const GLfloat *normal = vertex + 3 * (GLuint64)vertex_count;
+    const GLuint  *face   = (const GLuint*)(normal + 3 * (GLuint64)vertex_count);
+
+    // the indices of a damaged file are rejected before the mesh is modified, as done by Convert()
+    for (GLuint64 i = 0; i < 3 * (GLuint64)face_count; ++i)
+        if (face[i] >= vertex_count)
+            return GL_FALSE;
+
+    if (compact)
+    {
+        mesh._compact_vertex.assign(vertex, vertex + 3 * (GLuint64)vertex_count);
+        mesh._compact_normal.assign(normal, normal + 3 * (GLuint64)vertex_count);
+        vector<DCoordinate3>().swap(mesh._vertex);
+        vector<DCoordinate3>().swap(mesh._normal);
+    }
+    else
+    {
+        mesh._vertex.resize(vertex_count);
+        mesh._normal.resize(vertex_count);
+        vector<GLfloat>().swap(mesh._compact_vertex);
+        vector<GLfloat>().swap(mesh._compact_normal);
+    }
+
+    mesh._compact = compact;
+    mesh._tex.assign(vertex_count, TCoordinate4());
+    mesh._face.resize(face_count);
+    mesh._color.clear();
+
+    GLint vertex_block_count = (GLint)((vertex_count + BLOCK_SIZE - 1) / BLOCK_SIZE);
+    GLint face_block_count   = (GLint)((face_count + BLOCK_SIZE - 1) / BLOCK_SIZE);
+
+    auto copy_vertices = [&](GLint first_block, GLint last_block, BoundingBox &partial)
+    {
+        for (GLint block = first_block; block < last_block; ++block)
+        {
+            GLuint first = block * BLOCK_SIZE, last = min(first + BLOCK_SIZE, vertex_count);
+
+            for (GLuint i = first; i < last; ++i)
+            {
+                const GLfloat *v = vertex + 3 * (GLuint64)i, *n = normal + 3 * (GLuint64)i;
+
+                if (!compact)
+                {
+                    mesh._vertex[i] = DCoordinate3(v[0], v[1], v[2]);
+                    mesh._normal[i] = DCoordinate3(n[0], n[1], n[2]);
+                }
+
+                for (GLuint r = 0; r < 3; ++r)
+                    partial.Add(r, v[r]);
+            }
+        }
+    };
+
+    // the faces are copied concurrently with the vertices
+    TaskScheduler::TaskGroup group;
+    BoundingBox              bounds;
+
+    group.Add([&]()
+    {
+        bounds = TaskScheduler::Instance().ParallelReduce(
+                0, vertex_block_count, BoundingBox(), copy_vertices,
+                [](BoundingBox &box, const BoundingBox &partial) { box.Merge(partial); }, 1);
+    });
+
+    group.Add([&]()
+    {
+        TaskScheduler::Instance().ParallelFor(0, face_block_count, [&](GLint first_block, GLint last_block)
+        {
+            for (GLint block = first_block; block < last_block; ++block)
+            {
+                GLuint first = block * BLOCK_SIZE, last = min(first + BLOCK_SIZE, face_count);
+
+                for (GLuint i = first; i < last; ++i)
+                    for (GLuint k = 0; k < 3; ++k)
+                        mesh._face[i][k] = face[3 * (GLuint64)i + k];
+            }
+        }, 1);
+    });
+
+    group.Run();
+
+    mesh._leftmost_vertex  = DCoordinate3(bounds.low[0], bounds.low[1], bounds.low[2]);
+    mesh._rightmost_vertex = DCoordinate3(bounds.high[0], bounds.high[1], bounds.high[2]);
+
+    return GL_TRUE;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <string>
+#include "DCoordinates3.h"
+#include "TriangulatedMeshes3.h"
+
+namespace cagd
+{
+    //----------------------------
+    // class StreamingOFFConverter
+    //----------------------------
+    // Out-of-core conversion of OFF files of triangle meshes into compact binary meshes, whose
+    // vertices and unit normal vectors are stored as floats, i.e. 24 bytes per vertex instead of the
+    // 56 bytes of TriangulatedMesh3.
+    //
+    // The text is read in chunks of bounded size. Every chunk is split into lines, whose numbers
+    // are parsed by concurrent threads directly into the memory-mapped output file, and the face
+    // normals of the chunk are accumulated at their vertices at once. Finally the vertices are
+    // optionally translated and scaled into the unit cube (as done by TriangulatedMesh3::LoadFromOFF),
+    // and the normals are normalized, both by parallel passes over the mapping. Thus only the current
+    // chunk is held in memory, the output file is paged by the operating system.
+    //
+    // Every vertex and face has to occupy a line of its own, as written by common exporters, lines
+    // starting with '#' are comments. Only triangular faces are supported. Numbers are parsed
+    // independently of the locale of the application.
+    //
+    // Binary format, numbers are stored in the byte order of the host:
+    //
+    //      header      magic "CAGDMSH\0", version, vertex and face counts, 4 bytes reserved, then
+    //                  the origin (3 doubles) and the scale (1 double): a stored vertex v belongs to
+    //                  the vertex origin + v / scale of the OFF file
+    //      vertices    3 floats each
+    //      normals     3 floats each
+    //      faces       3 unsigned integers each
+    class StreamingOFFConverter
+    {
+    protected:
+        GLuint64     _chunk_size;
+        GLuint       _vertex_count, _face_count;
+        DCoordinate3 _low, _high;                   // bounding box of the vertices of the OFF file
+
+    public:
+        // special and default constructor, the chunk size is given in bytes
+        StreamingOFFConverter(GLuint64 chunk_size = 64 << 20);
+
+        // the previous content of the binary file is lost, it is deleted if the conversion fails
+        GLboolean Convert(const std::string &off_file_name, const std::string &binary_file_name,
+                          GLboolean translate_and_scale_to_unit_cube = GL_FALSE);
+
+        // properties of the last successful conversion
+        GLuint    GetVertexCount() const;
+        GLuint    GetFaceCount() const;
+        GLvoid    GetBoundingBox(DCoordinate3 &low, DCoordinate3 &high) const;
+
+        // loads the stored vertices, normals and faces of a binary mesh by memory mapping; if compact
+        // is set, the single precision coordinates are kept as they are (see TriangulatedMesh3::Compact())
+        static GLboolean Load(const std::string &binary_file_name, TriangulatedMesh3 &mesh,
+                              GLboolean compact = GL_FALSE);
+    };
+}
@@ -0,0 +1,880 @@
+#include "SurfaceIntersections3.h"
+#include "BoundingVolumeHierarchies3.h"
+#include "TaskSchedulers.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace cagd;
+using namespace std;
+
+// six times the signed volume of the tetrahedron (a, b, c, d)
+static GLdouble Orientation(const DCoordinate3 &a, const DCoordinate3 &b, const DCoordinate3 &c, const DCoordinate3 &d)
+{
+    return ((b - a) ^ (c - a)) * (d - a);
+}
+
+// orientation of the edge (a0, a1) of the first mesh and the edge (b0, b1) of the second one; it is
+// evaluated in the order of the vertex indices, thus every face pair that contains the two edges
+// obtains exactly the same value, up to the sign that corresponds to the directions of the edges
+static GLdouble EdgeOrientation(const vector<DCoordinate3> &lhs, GLuint a0, GLuint a1,
+                                const vector<DCoordinate3> &rhs, GLuint b0, GLuint b1)
+{
+    GLdouble sign = 1.0;
+
+    if (a0 > a1)
+    {
+        swap(a0, a1);
+        sign = -sign;
+    }
+
+    if (b0 > b1)
+    {
+        swap(b0, b1);
+        sign = -sign;
+    }
+
+    return sign * Orientation(lhs[a0], lhs[a1], rhs[b0], rhs[b1]);
+}
+
+// decides whether the edge (a, b), a < b, crosses the face, if so, the crossing is a + t * (b - a);
+// edge_of_lhs tells whether the edge belongs to the first mesh
+//
+// Vertices that lie in the plane of the face are treated as if they were on its positive side, and
+// the sign bits of the edge orientations break their ties, i.e., a zero orientation is positive for
+// one of the two faces that share an edge and negative for the other one. Therefore all face pairs
+// that meet at a crossing arrive at the same decision, and the crossing joins their segments.
+static GLboolean Pierces(const vector<DCoordinate3> &edge_vertex, GLuint a, GLuint b,
+                         const vector<DCoordinate3> &face_vertex, const TriangularFace &face,
+                         GLboolean edge_of_lhs, GLdouble &t)
+{
+    const DCoordinate3 &r0 = face_vertex[face[0]], &r1 = face_vertex[face[1]], &r2 = face_vertex[face[2]];
+
+    GLdouble dp = Orientation(r0, r1, r2, edge_vertex[a]), dq = Orientation(r0, r1, r2, edge_vertex[b]);
+
+    if ((dp < 0.0) == (dq < 0.0))
+        return GL_FALSE;
+
+    GLboolean negative[3];
+
+    for (GLuint k = 0; k < 3; ++k)
+    {
+        GLuint c = face[k], d = face[(k + 1) % 3];
+
+        negative[k] = signbit(edge_of_lhs ? EdgeOrientation(edge_vertex, a, b, face_vertex, c, d)
+                                          : EdgeOrientation(face_vertex, c, d, edge_vertex, a, b));
+    }
+
+    if (negative[0] != negative[1] || negative[1] != negative[2])
+        return GL_FALSE;
+
+    t = dp / (dp - dq);
+
+    return GL_TRUE;
+}
+
+// deterministic pseudo-random offset in [-1, 1]^3 that belongs to the given vertex
+static DCoordinate3 Jitter(GLuint vertex)
+{
+    DCoordinate3 result;
+
+    for (GLuint r = 0; r < 3; ++r)
+    {
+        GLuint h = 3 * vertex + r + 1;
+
+        h ^= h >> 16;
+        h *= 0x7feb352dU;
+        h ^= h >> 15;
+        h *= 0x846ca68bU;
+        h ^= h >> 16;
+
+        result[r] = 2.0 * h / 4294967295.0 - 1.0;
+    }
+
+    return result;
+}
+
+// barycentric coordinates of the point w.r.t. the 2nd and 3rd vertex of the triangle (p0, p1, p2)
+static GLvoid Barycentric(const DCoordinate3 &point, const DCoordinate3 &p0, const DCoordinate3 &p1, const DCoordinate3 &p2,
+                          GLdouble &l1, GLdouble &l2)
+{
+    DCoordinate3 e1 = p1 - p0, e2 = p2 - p0, d = point - p0;
+
+    GLdouble d11 = e1 * e1, d12 = e1 * e2, d22 = e2 * e2;
+    GLdouble d1 = d * e1, d2 = d * e2;
+    GLdouble determinant = d11 * d22 - d12 * d12;
+
+    if (determinant == 0.0)
+    {
+        l1 = l2 = 0.0;
+        return;
+    }
+
+    l1 = (d22 * d1 - d12 * d2) / determinant;
+    l2 = (d11 * d2 - d12 * d1) / determinant;
+}
+
+// parameters of a vertex of the grid that is generated by _Tessellate()
+static GLvoid GridParameters(const SurfaceIntersection3::SampledSurface &surface, GLuint vertex, GLdouble &u, GLdouble &v)
+{
+    GLuint i = vertex / surface.v_div_point_count, j = vertex % surface.v_div_point_count;
+
+    u = min(surface.u_min + i * (surface.u_max - surface.u_min) / (surface.u_div_point_count - 1), surface.u_max);
+    v = min(surface.v_min + j * (surface.v_max - surface.v_min) / (surface.v_div_point_count - 1), surface.v_max);
+}
+
+// returns GL_TRUE if the parameter had to be clamped
+static GLboolean Clamp(GLdouble &parameter, GLdouble minimum, GLdouble maximum)
+{
+    GLdouble clamped = max(minimum, min(parameter, maximum));
+    GLboolean result = (clamped != parameter);
+
+    parameter = clamped;
+
+    return result;
+}
+
+// Newton iterations for normal * s(u, v) = offset, every step is the shortest one in the parameter
+// domain that annuls the linearized residual; parameters that reach the boundary of the domain
+// are fixed, since the solution lies on the boundary, e.g. on the seam of a closed surface. The
+// point is replaced only if the iterations converge.
+static GLvoid ProjectOntoPlane(const SurfaceIntersection3::SampledSurface &surface,
+                               const DCoordinate3 &normal, GLdouble offset,
+                               GLdouble u, GLdouble v, DCoordinate3 &point)
+{
+    TensorProductSurface3::PartialDerivatives pd(1);
+
+    GLdouble     scale = 1.0 + fabs(offset);
+    GLdouble     best  = numeric_limits<GLdouble>::max();
+    DCoordinate3 best_point;
+    GLboolean    fixed[2] = {GL_FALSE, GL_FALSE};
+
+    for (GLuint iteration = 0; iteration < 8; ++iteration)
+    {
+        if (!surface.evaluator(u, v, pd))
+            return;
+
+        GLdouble residual = normal * pd(0, 0) - offset;
+
+        if (fabs(residual) < best)
+        {
+            best       = fabs(residual);
+            best_point = pd(0, 0);
+        }
+
+        if (best <= 1.0e-12 * scale)
+            break;
+
+        GLdouble gu = fixed[0] ? 0.0 : normal * pd(1, 0);
+        GLdouble gv = fixed[1] ? 0.0 : normal * pd(1, 1);
+        GLdouble squared_norm = gu * gu + gv * gv;
+
+        if (squared_norm == 0.0)
+            break;
+
+        u -= residual * gu / squared_norm;
+        v -= residual * gv / squared_norm;
+
+        fixed[0] = fixed[0] || Clamp(u, surface.u_min, surface.u_max);
+        fixed[1] = fixed[1] || Clamp(v, surface.v_min, surface.v_max);
+    }
+
+    if (best <= 1.0e-6 * scale)
+        point = best_point;
+}
+
+// Newton iterations for s_0(u_0, v_0) = s_1(u_1, v_1) with the minimal norm steps of the
+// underdetermined linearized systems, i.e., the steps are perpendicular to the intersection curve;
+// parameters that reach the boundaries of the domains are fixed as above
+static GLvoid ProjectOntoIntersection(const SurfaceIntersection3::SampledSurface &lhs,
+                                      const SurfaceIntersection3::SampledSurface &rhs,
+                                      GLdouble u0, GLdouble v0, GLdouble u1, GLdouble v1, DCoordinate3 &point)
+{
+    TensorProductSurface3::PartialDerivatives p(1), q(1);
+
+    GLdouble     scale = 1.0 + point.length();
+    GLdouble     best  = numeric_limits<GLdouble>::max();
+    DCoordinate3 best_point;
+    GLboolean    fixed[4] = {GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE};
+
+    for (GLuint iteration = 0; iteration < 8; ++iteration)
+    {
+        if (!lhs.evaluator(u0, v0, p) || !rhs.evaluator(u1, v1, q))
+            return;
+
+        DCoordinate3 residual = p(0, 0) - q(0, 0);
+        GLdouble     error    = residual.length();
+
+        if (error < best)
+        {
+            best       = error;
+            best_point = 0.5 * (p(0, 0) + q(0, 0));
+        }
+
+        if (best <= 1.0e-12 * scale)
+            break;
+
+        // the columns of the Jacobian J and of J * J^T
+        DCoordinate3 column[4] = {p(1, 0), p(1, 1), -q(1, 0), -q(1, 1)};
+        DCoordinate3 m[3];
+
+        for (GLuint c = 0; c < 4; ++c)
+            if (fixed[c])
+                column[c] = DCoordinate3();
+
+        for (GLuint j = 0; j < 3; ++j)
+            for (GLuint c = 0; c < 4; ++c)
+                m[j] += column[c] * column[c][j];
+
+        GLdouble determinant = m[0] * (m[1] ^ m[2]);
+
+        if (determinant == 0.0)
+            break;
+
+        // Cramer's rule for J * J^T * y = residual, then the step is -J^T * y
+        DCoordinate3 y(residual * (m[1] ^ m[2]), m[0] * (residual ^ m[2]), m[0] * (m[1] ^ residual));
+        y /= determinant;
+
+        u0 -= column[0] * y;
+        v0 -= column[1] * y;
+        u1 -= column[2] * y;
+        v1 -= column[3] * y;
+
+        fixed[0] = fixed[0] || Clamp(u0, lhs.u_min, lhs.u_max);
+        fixed[1] = fixed[1] || Clamp(v0, lhs.v_min, lhs.v_max);
+        fixed[2] = fixed[2] || Clamp(u1, rhs.u_min, rhs.u_max);
+        fixed[3] = fixed[3] || Clamp(v1, rhs.v_min, rhs.v_max);
+    }
+
+    if (best <= 1.0e-6 * scale)
+        point = best_point;
+}
+
+// special constructors
+SurfaceIntersection3::SampledSurface::SampledSurface(
+        const Evaluator &evaluator,
+        GLdouble u_min, GLdouble u_max, GLdouble v_min, GLdouble v_max,
+        GLuint u_div_point_count, GLuint v_div_point_count):
+    evaluator(evaluator),
+    u_min(u_min), u_max(u_max), v_min(v_min), v_max(v_max),
+    u_div_point_count(u_div_point_count), v_div_point_count(v_div_point_count)
+{
+}
+
+SurfaceIntersection3::SampledSurface::SampledSurface(
+        const TensorProductSurface3 &surface, GLuint u_div_point_count, GLuint v_div_point_count):
+    evaluator([&surface](GLdouble u, GLdouble v, TensorProductSurface3::PartialDerivatives &pd)
+              {
+                  return surface.CalculatePartialDerivatives(1, u, v, pd);
+              }),
+    u_div_point_count(u_div_point_count), v_div_point_count(v_div_point_count)
+{
+    surface.GetUInterval(u_min, u_max);
+    surface.GetVInterval(v_min, v_max);
+}
+
+// crossings are ordered by their edges and faces, the parameters are determined by these
+GLboolean SurfaceIntersection3::Crossing::operator <(const Crossing &rhs) const
+{
+    if (mesh != rhs.mesh)
+        return mesh < rhs.mesh;
+
+    if (a != rhs.a)
+        return a < rhs.a;
+
+    if (b != rhs.b)
+        return b < rhs.b;
+
+    return face < rhs.face;
+}
+
+GLboolean SurfaceIntersection3::Crossing::operator ==(const Crossing &rhs) const
+{
+    return mesh == rhs.mesh && a == rhs.a && b == rhs.b && face == rhs.face;
+}
+
+// segments that share a crossing are joined; every crossing of a closed manifold mesh is shared by
+// exactly two segments, otherwise the polylines start and end at the crossings of odd degree
+GLvoid SurfaceIntersection3::_Chain(const vector<Segment> &segments, vector<Chain> &chains)
+{
+    chains.clear();
+
+    GLuint endpoint_count = 2 * (GLuint)segments.size();
+
+    // the endpoint e is segments[e / 2].end[e % 2], endpoints of the same crossing become adjacent
+    vector<GLuint> order(endpoint_count);
+
+    for (GLuint e = 0; e < endpoint_count; ++e)
+        order[e] = e;
+
+    sort(order.begin(), order.end(),
+         [&segments](GLuint lhs, GLuint rhs)
+         {
+             return segments[lhs / 2].end[lhs % 2] < segments[rhs / 2].end[rhs % 2];
+         });
+
+    // the endpoints of node n are order[first[n]], ..., order[first[n + 1] - 1]
+    vector<GLuint> node(endpoint_count), first;
+
+    for (GLuint k = 0; k < endpoint_count; ++k)
+    {
+        if (!k || !(segments[order[k] / 2].end[order[k] % 2] == segments[order[k - 1] / 2].end[order[k - 1] % 2]))
+            first.push_back(k);
+
+        node[order[k]] = (GLuint)first.size() - 1;
+    }
+
+    GLuint node_count = (GLuint)first.size();
+    first.push_back(endpoint_count);
+
+    vector<GLboolean> used(segments.size(), GL_FALSE);
+
+    // walks along unused segments starting with the one of the given endpoint
+    auto walk = [&](GLuint endpoint)
+    {
+        Chain chain;
+
+        chain.closed = GL_FALSE;
+        chain.crossing.push_back(segments[endpoint / 2].end[endpoint % 2]);
+
+        for (;;)
+        {
+            used[endpoint / 2] = GL_TRUE;
+
+            GLuint other = endpoint ^ 1;
+            chain.crossing.push_back(segments[other / 2].end[other % 2]);
+
+            GLuint n = node[other];
+            GLboolean found = GL_FALSE;
+
+            for (GLuint k = first[n]; k < first[n + 1] && !found; ++k)
+            {
+                if (!used[order[k] / 2])
+                {
+                    endpoint = order[k];
+                    found = GL_TRUE;
+                }
+            }
+
+            if (!found)
+                break;
+        }
+
+        if (chain.crossing.size() > 2 && chain.crossing.front() == chain.crossing.back())
+        {
+            chain.crossing.pop_back();
+            chain.closed = GL_TRUE;
+        }
+
+        chains.push_back(chain);
+    };
+
+    for (GLuint n = 0; n < node_count; ++n)
+        if ((first[n + 1] - first[n]) % 2)
+            for (GLuint k = first[n]; k < first[n + 1]; ++k)
+                if (!used[order[k] / 2])
+                    walk(order[k]);
+
+    for (GLuint s = 0; s < segments.size(); ++s)
+        if (!used[s])
+            walk(2 * s);
+}
+
+GLboolean SurfaceIntersection3::_Tessellate(const SampledSurface &surface, TriangulatedMesh3 &mesh)
+{
+    GLuint u_count = surface.u_div_point_count, v_count = surface.v_div_point_count;
+
+    if (u_count < 2 || v_count < 2)
+        return GL_FALSE;
+
+    GLint vertex_count = (GLint)(u_count * v_count);
+
+    mesh._vertex.resize(vertex_count);
+    mesh._face.resize(2 * (u_count - 1) * (v_count - 1));
+
+    atomic<GLboolean> success(GL_TRUE);
+
+    TaskScheduler::Instance().ParallelFor(0, vertex_count, [&](GLint chunk_begin, GLint chunk_end)
+    {
+        TensorProductSurface3::PartialDerivatives pd(1);
+
+        for (GLint k = chunk_begin; k < chunk_end; ++k)
+        {
+            GLdouble u, v;
+            GridParameters(surface, k, u, v);
+
+            if (surface.evaluator(u, v, pd))
+                mesh._vertex[k] = pd(0, 0);
+            else
+                success = GL_FALSE;
+        }
+    });
+
+    GLuint f = 0;
+
+    for (GLuint i = 0; i < u_count - 1; ++i)
+    {
+        for (GLuint j = 0; j < v_count - 1; ++j)
+        {
+            GLuint index[4] = {i * v_count + j, (i + 1) * v_count + j, (i + 1) * v_count + j + 1, i * v_count + j + 1};
+
+            mesh._face[f][0] = index[0];
+            mesh._face[f][1] = index[1];
+            mesh._face[f][2] = index[2];
+            ++f;
+
+            mesh._face[f][0] = index[0];
+            mesh._face[f][1] = index[2];
+            mesh._face[f][2] = index[3];
+            ++f;
+        }
+    }
+
+    return success;
+}
+
+GLboolean SurfaceIntersection3::_IntersectPlanes(const TriangulatedMesh3 &mesh, const SampledSurface *surface,
+                                                 const DCoordinate3 &normal, const vector<GLdouble> &offsets)
+{
+    _polyline.clear();
+
+    // compacted meshes have to be expanded to double precision first
+    if (normal * normal == 0.0 || mesh._compact)
+        return GL_FALSE;
+
+    GLint vertex_count = (GLint)mesh._vertex.size();
+    GLint face_count   = (GLint)mesh._face.size();
+    GLint plane_count  = (GLint)offsets.size();
+
+    vector<GLdouble> height(vertex_count);
+
+    TaskScheduler::Instance().ParallelFor(0, vertex_count, [&](GLint chunk_begin, GLint chunk_end)
+    {
+        for (GLint v = chunk_begin; v < chunk_end; ++v)
+            height[v] = normal * mesh._vertex[v];
+    });
+
+    // the planes are sorted by their offsets, then a face is cut by the planes whose offsets lie in
+    // the interval (lowest height, highest height] of its vertices
+    vector<GLuint>   plane(plane_count);
+    vector<GLdouble> sorted_offset(plane_count);
+
+    for (GLint k = 0; k < plane_count; ++k)
+        plane[k] = k;
+
+    sort(plane.begin(), plane.end(), [&offsets](GLuint lhs, GLuint rhs) { return offsets[lhs] < offsets[rhs]; });
+
+    for (GLint k = 0; k < plane_count; ++k)
+        sorted_offset[k] = offsets[plane[k]];
+
+    // the faces cut by the k-th sorted plane are face_of_plane[first[k]], ..., face_of_plane[first[k + 1] - 1]
+    vector<GLuint> range_begin(face_count), range_end(face_count), first(plane_count + 1, 0);
+
+    for (GLint f = 0; f < face_count; ++f)
+    {
+        const TriangularFace &face = mesh._face[f];
+
+        GLdouble lowest  = min(height[face[0]], min(height[face[1]], height[face[2]]));
+        GLdouble highest = max(height[face[0]], max(height[face[1]], height[face[2]]));
+
+        range_begin[f] = (GLuint)(upper_bound(sorted_offset.begin(), sorted_offset.end(), lowest) - sorted_offset.begin());
+        range_end[f]   = (GLuint)(upper_bound(sorted_offset.begin(), sorted_offset.end(), highest) - sorted_offset.begin());
+
+        for (GLuint k = range_begin[f]; k < range_end[f]; ++k)
+            ++first[k + 1];
+    }
+
+    for (GLint k = 0; k < plane_count; ++k)
+        first[k + 1] += first[k];
+
+    vector<GLuint> face_of_plane(first[plane_count]);
+
+    {
+        vector<GLuint> position(first.begin(), first.end() - 1);
+
+        for (GLint f = 0; f < face_count; ++f)
+            for (GLuint k = range_begin[f]; k < range_end[f]; ++k)
+                face_of_plane[position[k]++] = f;
+    }
+
+    // the sections are collected by the original indices of the planes
+    vector<vector<Polyline> > section(plane_count);
+
+    TaskScheduler::Instance().ParallelFor(0, plane_count, [&](GLint chunk_begin, GLint chunk_end)
+    {
+        vector<Segment> segments;
+        vector<Chain>   chains;
+
+        for (GLint k = chunk_begin; k < chunk_end; ++k)
+        {
+            GLdouble offset = sorted_offset[k];
+
+            segments.clear();
+
+            for (GLuint i = first[k]; i < first[k + 1]; ++i)
+            {
+                const TriangularFace &face = mesh._face[face_of_plane[i]];
+
+                Segment segment;
+                GLuint  end = 0;
+
+                for (GLuint e = 0; e < 3 && end < 2; ++e)
+                {
+                    GLuint a = face[e], b = face[(e + 1) % 3];
+
+                    if ((height[a] < offset) == (height[b] < offset))
+                        continue;
+
+                    if (a > b)
+                        swap(a, b);
+
+                    Crossing &crossing = segment.end[end++];
+
+                    crossing.mesh = 0;
+                    crossing.a    = a;
+                    crossing.b    = b;
+                    crossing.face = 0;
+                    crossing.t    = (offset - height[a]) / (height[b] - height[a]);
+                }
+
+                if (end == 2)
+                    segments.push_back(segment);
+            }
+
+            _Chain(segments, chains);
+
+            vector<Polyline> &polylines = section[plane[k]];
+
+            polylines.resize(chains.size());
+
+            for (GLuint c = 0; c < chains.size(); ++c)
+            {
+                const Chain &chain = chains[c];
+                Polyline &polyline = polylines[c];
+
+                polyline.plane_index = plane[k];
+                polyline.closed      = chain.closed;
+                polyline.point.resize(chain.crossing.size());
+
+                for (GLuint i = 0; i < chain.crossing.size(); ++i)
+                {
+                    const Crossing     &crossing = chain.crossing[i];
+                    const DCoordinate3 &a = mesh._vertex[crossing.a], &b = mesh._vertex[crossing.b];
+
+                    polyline.point[i] = a + crossing.t * (b - a);
+
+                    if (surface)
+                    {
+                        GLdouble ua, va, ub, vb;
+
+                        GridParameters(*surface, crossing.a, ua, va);
+                        GridParameters(*surface, crossing.b, ub, vb);
+
+                        ProjectOntoPlane(*surface, normal, offset,
+                                         ua + crossing.t * (ub - ua), va + crossing.t * (vb - va), polyline.point[i]);
+                    }
+                }
+            }
+        }
+    }, 1);
+
+    for (GLint k = 0; k < plane_count; ++k)
+        _polyline.insert(_polyline.end(), section[k].begin(), section[k].end());
+
+    return GL_TRUE;
+}
+
+GLboolean SurfaceIntersection3::_Intersect(const TriangulatedMesh3 &lhs, const SampledSurface *lhs_surface,
+                                           const TriangulatedMesh3 &rhs, const SampledSurface *rhs_surface)
+{
+    _polyline.clear();
+
+    if (&lhs == &rhs || lhs._face.empty() || lhs._compact || rhs._compact)
+        return GL_FALSE;
+
+    BoundingVolumeHierarchy3 hierarchy;
+
+    if (!hierarchy.Build(rhs))
+        return GL_FALSE;
+
+    DCoordinate3 low, high;
+    hierarchy.GetBoundingBox(low, high);
+
+    GLdouble extent = (high - low).length();
+
+    // the decisions are made for the vertices of the second mesh displaced by tiny deterministic
+    // offsets, since typical inputs contain exact degeneracies, e.g. vertices of one mesh that lie on
+    // the faces or edges of the other one, whose ties cannot be broken consistently otherwise
+    vector<DCoordinate3> rhs_vertex(rhs._vertex);
+
+    for (GLuint v = 0; v < rhs_vertex.size(); ++v)
+        rhs_vertex[v] += 1.0e-9 * extent * Jitter(v);
+
+    // the boxes of the faces are enlarged by more than the offsets
+    GLdouble margin = 1.0e-8 * extent;
+
+    GLint face_count = (GLint)lhs._face.size();
+
+    auto intersect = [&](GLint chunk_begin, GLint chunk_end, vector<Segment> &partial_segments)
+    {
+        vector<GLuint> mesh_indices, face_indices;
+
+        for (GLint f = chunk_begin; f < chunk_end; ++f)
+        {
+            const TriangularFace &face = lhs._face[f];
+            const DCoordinate3   *p[3] = {&lhs._vertex[face[0]], &lhs._vertex[face[1]], &lhs._vertex[face[2]]};
+
+            DCoordinate3 face_low = *p[0], face_high = *p[0];
+
+            for (GLuint r = 0; r < 3; ++r)
+            {
+                face_low[r]  = min(face_low[r], min((*p[1])[r], (*p[2])[r])) - margin;
+                face_high[r] = max(face_high[r], max((*p[1])[r], (*p[2])[r])) + margin;
+            }
+
+            hierarchy.FindOverlappingFaces(face_low, face_high, mesh_indices, face_indices);
+
+            for (GLuint i = 0; i < face_indices.size(); ++i)
+            {
+                GLuint g = face_indices[i];
+
+                const TriangularFace &other = rhs._face[g];
+
+                // the endpoints of the intersection of two triangles are the crossings of the edges of
+                // either triangle with the other one
+                Segment segment;
+                GLuint  end = 0;
+
+                for (GLuint m = 0; m < 2 && end <= 2; ++m)
+                {
+                    const TriangularFace &edge_face    = m ? other : face;
+                    const TriangularFace &pierced_face = m ? face : other;
+                    const vector<DCoordinate3> &edge_vertex = m ? rhs_vertex : lhs._vertex;
+                    const vector<DCoordinate3> &face_vertex = m ? lhs._vertex : rhs_vertex;
+
+                    for (GLuint e = 0; e < 3 && end <= 2; ++e)
+                    {
+                        GLuint a = edge_face[e], b = edge_face[(e + 1) % 3];
+
+                        if (a > b)
+                            swap(a, b);
+
+                        GLdouble t;
+
+                        if (!Pierces(edge_vertex, a, b, face_vertex, pierced_face, m == 0, t))
+                            continue;
+
+                        // more than two crossings only occur in degenerate configurations
+                        if (end == 2)
+                        {
+                            end = 3;
+                            continue;
+                        }
+
+                        Crossing &crossing = segment.end[end++];
+
+                        crossing.mesh = m;
+                        crossing.a    = a;
+                        crossing.b    = b;
+                        crossing.face = m ? f : g;
+                        crossing.t    = t;
+                    }
+                }
+
+                if (end == 2)
+                {
+                    if (segment.end[1] < segment.end[0])
+                        swap(segment.end[0], segment.end[1]);
+
+                    partial_segments.push_back(segment);
+                }
+            }
+        }
+    };
+
+    vector<Segment> segments = TaskScheduler::Instance().ParallelReduce(
+            0, face_count, vector<Segment>(), intersect,
+            [](vector<Segment> &result, const vector<Segment> &partial)
+            {
+                result.insert(result.end(), partial.begin(), partial.end());
+            },
+            64);
+
+    // the chains are traced from the sorted segments
+    sort(segments.begin(), segments.end(),
+         [](const Segment &l, const Segment &r)
+         {
+             return l.end[0] < r.end[0] || (l.end[0] == r.end[0] && l.end[1] < r.end[1]);
+         });
+
+    vector<Chain> chains;
+
+    _Chain(segments, chains);
+
+    GLint chain_count = (GLint)chains.size();
+
+    _polyline.resize(chain_count);
+
+    TaskScheduler::Instance().ParallelFor(0, chain_count, [&](GLint chunk_begin, GLint chunk_end)
+    {
+        for (GLint c = chunk_begin; c < chunk_end; ++c)
+        {
+            const Chain &chain = chains[c];
+            Polyline &polyline = _polyline[c];
+
+            polyline.plane_index = 0;
+            polyline.closed      = chain.closed;
+            polyline.point.resize(chain.crossing.size());
+
+            for (GLuint i = 0; i < chain.crossing.size(); ++i)
+            {
+                const Crossing &crossing = chain.crossing[i];
+
+                const TriangulatedMesh3 &edge_mesh = crossing.mesh ? rhs : lhs;
+                const TriangulatedMesh3 &face_mesh = crossing.mesh ? lhs : rhs;
+                const DCoordinate3 &a = edge_mesh._vertex[crossing.a], &b = edge_mesh._vertex[crossing.b];
+
+                polyline.point[i] = a + crossing.t * (b - a);
+
+                if (lhs_surface && rhs_surface)
+                {
+                    const SampledSurface &edge_surface = crossing.mesh ? *rhs_surface : *lhs_surface;
+                    const SampledSurface &face_surface = crossing.mesh ? *lhs_surface : *rhs_surface;
+
+                    // the parameters on the surface of the edge are interpolated linearly, those on the
+                    // surface of the face barycentrically
+                    GLdouble uv[2][2], ua, va, ub, vb;
+
+                    GridParameters(edge_surface, crossing.a, ua, va);
+                    GridParameters(edge_surface, crossing.b, ub, vb);
+
+                    uv[crossing.mesh][0] = ua + crossing.t * (ub - ua);
+                    uv[crossing.mesh][1] = va + crossing.t * (vb - va);
+
+                    const TriangularFace &face = face_mesh._face[crossing.face];
+                    GLdouble l1, l2, u[3], v[3];
+
+                    Barycentric(polyline.point[i],
+                                face_mesh._vertex[face[0]], face_mesh._vertex[face[1]], face_mesh._vertex[face[2]], l1, l2);
+
+                    for (GLuint k = 0; k < 3; ++k)
+                        GridParameters(face_surface, face[k], u[k], v[k]);
+
+                    uv[1 - crossing.mesh][0] = u[0] + l1 * (u[1] - u[0]) + l2 * (u[2] - u[0]);
+                    uv[1 - crossing.mesh][1] = v[0] + l1 * (v[1] - v[0]) + l2 * (v[2] - v[0]);
+
+                    ProjectOntoIntersection(*lhs_surface, *rhs_surface, uv[0][0], uv[0][1], uv[1][0], uv[1][1],
+                                            polyline.point[i]);
+                }
+            }
+        }
+    }, 1);
+
+    return GL_TRUE;
+}
+
+GLboolean SurfaceIntersection3::IntersectPlanes(const TriangulatedMesh3 &mesh,
+                                                const DCoordinate3 &normal, const vector<GLdouble> &offsets)
+{
+    return _IntersectPlanes(mesh, nullptr, normal, offsets);
+}
+
+GLboolean SurfaceIntersection3::IntersectPlanes(const SampledSurface &surface,
+                                                const DCoordinate3 &normal, const vector<GLdouble> &offsets)
+{
+    TriangulatedMesh3 mesh;
+
+    if (!_Tessellate(surface, mesh))
+    {
+        _polyline.clear();
+        return GL_FALSE;
+    }
+
+    return _IntersectPlanes(mesh, &surface, normal, offsets);
+}
+
+GLboolean SurfaceIntersection3::Slice(const TriangulatedMesh3 &mesh, const DCoordinate3 &normal, GLuint plane_count,
+                                      vector<GLdouble> *offsets)
+{
+    if (mesh._vertex.empty() || !plane_count || normal * normal == 0.0)
+    {
+        _polyline.clear();
+        return GL_FALSE;
+    }
+
+    GLdouble lowest = normal * mesh._vertex[0], highest = lowest;
+
+    for (GLuint v = 1; v < mesh._vertex.size(); ++v)
+    {
+        GLdouble height = normal * mesh._vertex[v];
+
+        lowest  = min(lowest, height);
+        highest = max(highest, height);
+    }
+
+    vector<GLdouble> offset(plane_count);
+    GLdouble step = (highest - lowest) / plane_count;
+
+    for (GLuint k = 0; k < plane_count; ++k)
+        offset[k] = lowest + (k + 0.5) * step;
+
+    if (offsets)
+        *offsets = offset;
+
+    return _IntersectPlanes(mesh, nullptr, normal, offset);
+}
+
+GLboolean SurfaceIntersection3::Intersect(const TriangulatedMesh3 &lhs, const TriangulatedMesh3 &rhs)
+{
+    return _Intersect(lhs, nullptr, rhs, nullptr);
+}
+
+GLboolean SurfaceIntersection3::Intersect(const SampledSurface &lhs, const SampledSurface &rhs)
+{
+    TriangulatedMesh3 lhs_mesh, rhs_mesh;
+
+    if (!_Tessellate(lhs, lhs_mesh) || !_Tessellate(rhs, rhs_mesh))
+    {
+        _polyline.clear();
+        return GL_FALSE;
+    }
+
+    return _Intersect(lhs_mesh, &lhs, rhs_mesh, &rhs);
+}
+
+GLvoid SurfaceIntersection3::Clear()
+{
+    _polyline.clear();
+}
+
+GLuint SurfaceIntersection3::GetPolylineCount() const
+{
+    return (GLuint)_polyline.size();
+}
+
+const SurfaceIntersection3::Polyline& SurfaceIntersection3::GetPolyline(GLuint index) const
+{
+    return _polyline[index];
+}
+
+RowMatrix<GenericCurve3*>* SurfaceIntersection3::GeneratePolylines(GLenum usage_flag) const
+{
+    RowMatrix<GenericCurve3*>* result = new RowMatrix<GenericCurve3*>((GLuint)_polyline.size());
+
+    for (GLuint i = 0; i < _polyline.size(); ++i)
+    {
+        const Polyline &polyline = _polyline[i];
+
+        GLuint point_count = (GLuint)polyline.point.size();
+
+        (*result)[i] = new GenericCurve3(0, point_count + (polyline.closed ? 1 : 0), usage_flag);
+
+        for (GLuint j = 0; j < point_count; ++j)
+            (*(*result)[i])(0, j) = polyline.point[j];
+
+        if (polyline.closed)
+            (*(*result)[i])(0, point_count) = polyline.point[0];
+    }
+
+    return result;
+}
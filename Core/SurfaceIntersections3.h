@@ -0,0 +1,129 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <functional>
+#include <vector>
+#include "DCoordinates3.h"
+#include "GenericCurves3.h"
+#include "Matrices.h"
+#include "TensorProductSurfaces3.h"
+#include "TriangulatedMeshes3.h"
+
+namespace cagd
+{
+    //---------------------------
+    // class SurfaceIntersection3
+    //---------------------------
+    // Plane sections (e.g. the slices of manufacturing) and surface-surface intersections, both
+    // represented by polylines.
+    //
+    // Triangulated meshes are contoured exactly: every vertex of a polyline is the crossing of a
+    // mesh edge with a plane or with a face of the other mesh, and it is identified by this edge and
+    // face, thus the segments of neighbouring faces are chained without any tolerance. The face pairs
+    // of two meshes are pruned by a bounding volume hierarchy. Planes, as well as the faces of the
+    // first mesh, are processed by concurrent threads.
+    //
+    // Smooth surfaces are tessellated on uniform grids and contoured as above, then the vertices of
+    // the polylines are moved onto the exact plane sections or intersections by Newton iterations.
+    // Curves are split where they cross the seams of closed surfaces.
+    class SurfaceIntersection3
+    {
+    public:
+        // evaluates the point and the first order partial derivatives at (u, v), it has to be safe
+        // to call it from several threads
+        typedef std::function<GLboolean (GLdouble u, GLdouble v, TensorProductSurface3::PartialDerivatives &pd)>
+                Evaluator;
+
+        // a surface and the grid u_min + i * (u_max - u_min) / (u_div_point_count - 1),
+        // v_min + j * (v_max - v_min) / (v_div_point_count - 1) on which it is tessellated
+        class SampledSurface
+        {
+        public:
+            Evaluator evaluator;
+            GLdouble  u_min, u_max, v_min, v_max;
+            GLuint    u_div_point_count, v_div_point_count;
+
+            // special constructors
+            SampledSurface(const Evaluator &evaluator,
+                           GLdouble u_min, GLdouble u_max, GLdouble v_min, GLdouble v_max,
+                           GLuint u_div_point_count, GLuint v_div_point_count);
+
+            // the surface is referenced, thus it has to outlive this object
+            SampledSurface(const TensorProductSurface3 &surface, GLuint u_div_point_count, GLuint v_div_point_count);
+        };
+
+        class Polyline
+        {
+        public:
+            GLuint                    plane_index;  // index of the cutting plane, 0 for surface-surface intersections
+            GLboolean                 closed;       // whether the last vertex is connected to the first one
+            std::vector<DCoordinate3> point;
+        };
+
+    protected:
+        // vertex of a polyline: the crossing of the edge (a, b), a < b, of the first (mesh = 0) or of the
+        // second (mesh = 1) mesh with a plane or with the given face of the other mesh, a + t * (b - a)
+        class Crossing
+        {
+        public:
+            GLuint   mesh, a, b, face;
+            GLdouble t;
+
+            GLboolean operator <(const Crossing &rhs) const;
+            GLboolean operator ==(const Crossing &rhs) const;
+        };
+
+        class Segment
+        {
+        public:
+            Crossing end[2];
+        };
+
+        class Chain
+        {
+        public:
+            std::vector<Crossing> crossing;
+            GLboolean             closed;
+        };
+
+        std::vector<Polyline> _polyline;
+
+        static GLvoid    _Chain(const std::vector<Segment> &segments, std::vector<Chain> &chains);
+        static GLboolean _Tessellate(const SampledSurface &surface, TriangulatedMesh3 &mesh);
+
+        // the surfaces are null unless the meshes have been tessellated by _Tessellate()
+        GLboolean _IntersectPlanes(const TriangulatedMesh3 &mesh, const SampledSurface *surface,
+                                   const DCoordinate3 &normal, const std::vector<GLdouble> &offsets);
+        GLboolean _Intersect(const TriangulatedMesh3 &lhs, const SampledSurface *lhs_surface,
+                             const TriangulatedMesh3 &rhs, const SampledSurface *rhs_surface);
+
+    public:
+        // sections by the planes normal * x = offsets[k], k = 0, 1, ..., offsets.size() - 1;
+        // returns GL_FALSE if the normal vanishes, or if the surface cannot be evaluated
+        GLboolean IntersectPlanes(const TriangulatedMesh3 &mesh,
+                                  const DCoordinate3 &normal, const std::vector<GLdouble> &offsets);
+        GLboolean IntersectPlanes(const SampledSurface &surface,
+                                  const DCoordinate3 &normal, const std::vector<GLdouble> &offsets);
+
+        // sections by plane_count equidistant planes perpendicular to the normal, which divide the
+        // extent of the mesh into plane_count layers and pass through their middles; the offsets of
+        // the planes are optionally returned
+        GLboolean Slice(const TriangulatedMesh3 &mesh, const DCoordinate3 &normal, GLuint plane_count,
+                        std::vector<GLdouble> *offsets = nullptr);
+
+        // intersection curves of two surfaces, the meshes must not be the same
+        GLboolean Intersect(const TriangulatedMesh3 &lhs, const TriangulatedMesh3 &rhs);
+        GLboolean Intersect(const SampledSurface &lhs, const SampledSurface &rhs);
+
+        // discards the polylines
+        GLvoid    Clear();
+
+        // get properties
+        GLuint    GetPolylineCount() const;
+        const Polyline& GetPolyline(GLuint index) const;
+
+        // copies the polylines into curves that store only zeroth order derivatives, closed polylines
+        // repeat their first vertex; the caller is responsible for deleting the curves
+        RowMatrix<GenericCurve3*>* GeneratePolylines(GLenum usage_flag = GL_STATIC_DRAW) const;
+    };
+}
@@ -0,0 +1,102 @@
+#include "SymmetricBandedMatrices.h"
+#include "TaskSchedulers.h"
+
+using namespace cagd;
+using namespace std;
+
+// special/default constructor
+SymmetricBandedMatrix::SymmetricBandedMatrix(GLuint size, GLuint half_bandwidth)
+{
+    Resize(size, half_bandwidth);
+}
+
+GLvoid SymmetricBandedMatrix::Resize(GLuint size, GLuint half_bandwidth)
+{
+    _size           = size;
+    _half_bandwidth = half_bandwidth;
+
+    _data.assign(size * (half_bandwidth + 1), 0.0);
+
+    _cholesky_decomposition_is_done = GL_FALSE;
+}
+
+GLvoid SymmetricBandedMatrix::LoadZeros()
+{
+    fill(_data.begin(), _data.end(), 0.0);
+
+    _cholesky_decomposition_is_done = GL_FALSE;
+}
+
+// get properties
+GLuint SymmetricBandedMatrix::GetSize() const
+{
+    return _size;
+}
+
+GLuint SymmetricBandedMatrix::GetHalfBandwidth() const
+{
+    return _half_bandwidth;
+}
+
+SymmetricBandedMatrix& SymmetricBandedMatrix::operator +=(const SymmetricBandedMatrix& rhs)
+{
+    GLint count = (GLint)_data.size();
+
+    TaskScheduler::Instance().ParallelFor(0, count, [&](GLint chunk_begin, GLint chunk_end)
+    {
+        for (GLint i = chunk_begin; i < chunk_end; ++i)
+            _data[i] += rhs._data[i];
+    });
+
+    _cholesky_decomposition_is_done = GL_FALSE;
+
+    return *this;
+}
+
+GLboolean SymmetricBandedMatrix::PerformCholeskyDecomposition()
+{
+    if (_cholesky_decomposition_is_done)
+        return GL_TRUE;
+
+    // right-looking variant: once column j is known, the elements of the next columns that depend
+    // on it are independent of each other, thus wide bands are updated in parallel
+    for (GLuint j = 0; j < _size; ++j)
+    {
+        GLuint first = (j > _half_bandwidth) ? j - _half_bandwidth : 0;
+
+        GLdouble pivot = _data[_Index(j, j)];
+
+        for (GLuint k = first; k < j; ++k)
+            pivot -= _data[_Index(j, k)] * _data[_Index(j, k)];
+
+        if (pivot <= 0.0)
+            return GL_FALSE;
+
+        pivot = sqrt(pivot);
+        _data[_Index(j, j)] = pivot;
+
+        GLint end = (GLint)min(_size, j + _half_bandwidth + 1);
+
+        // narrow bands are updated by the calling thread in a single chunk
+        GLint grain_size = (_half_bandwidth >= 64) ? 16 : (GLint)_half_bandwidth + 1;
+
+        TaskScheduler::Instance().ParallelFor((GLint)j + 1, end, [&](GLint chunk_begin, GLint chunk_end)
+        {
+            for (GLint i = chunk_begin; i < chunk_end; ++i)
+            {
+                GLuint i_first = ((GLuint)i > _half_bandwidth) ? i - _half_bandwidth : 0;
+
+                GLdouble sum = _data[_Index(i, j)];
+
+                for (GLuint k = max(first, i_first); k < j; ++k)
+                    sum -= _data[_Index(i, k)] * _data[_Index(j, k)];
+
+                _data[_Index(i, j)] = sum / pivot;
+            }
+        }, grain_size);
+    }
+
+    _cholesky_decomposition_is_done = GL_TRUE;
+
+    return GL_TRUE;
+}
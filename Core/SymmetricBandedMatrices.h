@@ -0,0 +1,118 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "Matrices.h"
+
+namespace cagd
+{
+    //----------------------------
+    // class SymmetricBandedMatrix
+    //----------------------------
+    // Symmetric square matrix whose nonzero elements satisfy |row - column| <= half_bandwidth.
+    // Only the lower band is stored, row by row, thus the memory requirement is
+    // size * (half_bandwidth + 1) instead of size * size.
+    //
+    // Normal equations of B-spline least squares problems have this structure, since two basis
+    // functions interact only if their supports overlap. The Cholesky decomposition preserves
+    // the band, and it costs O(size * half_bandwidth^2) operations.
+    class SymmetricBandedMatrix
+    {
+    protected:
+        GLuint                _size;
+        GLuint                _half_bandwidth;
+        std::vector<GLdouble> _data;
+        GLboolean             _cholesky_decomposition_is_done;
+
+        // position of the element (row, column), where column <= row <= column + half_bandwidth
+        GLuint                _Index(GLuint row, GLuint column) const;
+
+    public:
+        // special/default constructor, the elements are set to zero
+        SymmetricBandedMatrix(GLuint size = 1, GLuint half_bandwidth = 0);
+
+        // the elements are set to zero
+        GLvoid    Resize(GLuint size, GLuint half_bandwidth);
+        GLvoid    LoadZeros();
+
+        // get properties
+        GLuint    GetSize() const;
+        GLuint    GetHalfBandwidth() const;
+
+        // (row, column) and (column, row) denote the same element; elements outside of the
+        // band must not be referenced
+        GLdouble& operator ()(GLuint row, GLuint column);
+        GLdouble  operator ()(GLuint row, GLuint column) const;
+
+        // the operands have to be of the same size and half bandwidth
+        SymmetricBandedMatrix& operator +=(const SymmetricBandedMatrix& rhs);
+
+        // tries to determine the decomposition L * L^T of this matrix, where L is a lower
+        // triangular banded matrix that overwrites the elements; fails if the matrix is not
+        // positive definite
+        GLboolean PerformCholeskyDecomposition();
+
+        // solves the linear systems A * x = b column by column, where A corresponds to *this
+        template <class T>
+        GLboolean SolveLinearSystem(const Matrix<T>& b, Matrix<T>& x);
+    };
+
+    inline GLuint SymmetricBandedMatrix::_Index(GLuint row, GLuint column) const
+    {
+        return row * (_half_bandwidth + 1) + (column + _half_bandwidth - row);
+    }
+
+    inline GLdouble& SymmetricBandedMatrix::operator ()(GLuint row, GLuint column)
+    {
+        return row >= column ? _data[_Index(row, column)] : _data[_Index(column, row)];
+    }
+
+    inline GLdouble SymmetricBandedMatrix::operator ()(GLuint row, GLuint column) const
+    {
+        return row >= column ? _data[_Index(row, column)] : _data[_Index(column, row)];
+    }
+
+    template <class T>
+    GLboolean SymmetricBandedMatrix::SolveLinearSystem(const Matrix<T>& b, Matrix<T>& x)
+    {
+        if (!_cholesky_decomposition_is_done)
+            if (!PerformCholeskyDecomposition())
+                return GL_FALSE;
+
+        if (b.GetRowCount() != _size)
+            return GL_FALSE;
+
+        x = b;
+
+        for (GLuint k = 0; k < b.GetColumnCount(); ++k)
+        {
+            // forward substitution: L * y = b
+            for (GLuint i = 0; i < _size; ++i)
+            {
+                T sum = x(i, k);
+                GLuint first = (i > _half_bandwidth) ? i - _half_bandwidth : 0;
+
+                for (GLuint j = first; j < i; ++j)
+                    sum -= _data[_Index(i, j)] * x(j, k);
+
+                x(i, k) = sum /= _data[_Index(i, i)];
+            }
+
+            // back substitution: L^T * x = y
+            for (GLint i = (GLint)_size - 1; i >= 0; --i)
+            {
+                T sum = x(i, k);
+                GLuint last = std::min(_size - 1, (GLuint)i + _half_bandwidth);
+
+                for (GLuint j = i + 1; j <= last; ++j)
+                    sum -= _data[_Index(j, i)] * x(j, k);
+
+                x(i, k) = sum /= _data[_Index(i, i)];
+            }
+        }
+
+        return GL_TRUE;
+    }
+}
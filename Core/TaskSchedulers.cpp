@@ -0,0 +1,417 @@
+#include "TaskSchedulers.h"
+#include <algorithm>
+#include <chrono>
+
+using namespace cagd;
+using namespace std;
+
+namespace cagd
+{
+    // identifies the deque of the current thread, if it is a worker of the scheduler
+    static thread_local const TaskScheduler *current_scheduler    = nullptr;
+    static thread_local GLuint               current_worker_index = 0;
+}
+
+TaskScheduler::Latch::Latch(GLint count): remaining(count)
+{
+}
+
+// default constructor
+TaskScheduler::TaskScheduler():
+        _queued_count(0), _stopping(GL_FALSE),
+        _thread_count(0), _deterministic(GL_FALSE)
+{
+    _Start(0);
+}
+
+TaskScheduler& TaskScheduler::Instance()
+{
+    static TaskScheduler scheduler;
+
+    return scheduler;
+}
+
+GLvoid TaskScheduler::_Start(GLuint thread_count)
+{
+    if (!thread_count)
+        thread_count = max(thread::hardware_concurrency(), 1u);
+
+    _thread_count = thread_count;
+    _stopping     = GL_FALSE;
+
+    // the deques have to exist before the workers start to steal
+    for (GLuint i = 0; i < thread_count; ++i)
+        _worker.push_back(unique_ptr<Worker>(new Worker()));
+
+    for (GLuint i = 0; i + 1 < thread_count; ++i)
+        _thread.push_back(thread(&TaskScheduler::_Work, this, i));
+}
+
+GLvoid TaskScheduler::_Stop()
+{
+    {
+        lock_guard<mutex> lock(_sleep_mutex);
+        _stopping = GL_TRUE;
+    }
+
+    _task_available.notify_all();
+
+    for (GLuint i = 0; i < _thread.size(); ++i)
+        _thread[i].join();
+
+    _thread.clear();
+    _worker.clear();
+}
+
+GLvoid TaskScheduler::_Work(GLuint worker_index)
+{
+    current_scheduler    = this;
+    current_worker_index = worker_index;
+
+    for (;;)
+    {
+        Task task;
+
+        if (_Pop(worker_index, task) || _Steal(worker_index, task) || _PopDetached(task))
+        {
+            _Execute(task);
+            continue;
+        }
+
+        unique_lock<mutex> lock(_sleep_mutex);
+
+        // queued tasks are finished before stopping
+        while (!_stopping && _queued_count <= 0)
+            _task_available.wait(lock);
+
+        if (_stopping && _queued_count <= 0)
+            return;
+    }
+}
+
+GLuint TaskScheduler::_CurrentWorkerIndex() const
+{
+    return current_scheduler == this ? current_worker_index : (GLuint)_worker.size() - 1;
+}
+
+GLvoid TaskScheduler::_Push(const Task &task)
+{
+    if (task.latch)
+    {
+        Worker &worker = *_worker[_CurrentWorkerIndex()];
+
+        lock_guard<mutex> lock(worker.mutex);
+        worker.tasks.push_back(task);
+        ++_queued_count;
+    }
+    else
+    {
+        lock_guard<mutex> lock(_detached_mutex);
+        _detached.push_back(task);
+        ++_queued_count;
+    }
+
+    // a worker that has checked the count before the increment is already waiting
+    {
+        lock_guard<mutex> lock(_sleep_mutex);
+    }
+
+    _task_available.notify_one();
+}
+
+GLboolean TaskScheduler::_Pop(GLuint worker_index, Task &task)
+{
+    Worker &worker = *_worker[worker_index];
+
+    lock_guard<mutex> lock(worker.mutex);
+
+    if (worker.tasks.empty())
+        return GL_FALSE;
+
+    task = worker.tasks.back();
+    worker.tasks.pop_back();
+    --_queued_count;
+
+    return GL_TRUE;
+}
+
+GLboolean TaskScheduler::_Steal(GLuint worker_index, Task &task)
+{
+    GLuint worker_count = (GLuint)_worker.size();
+
+    for (GLuint i = 1; i < worker_count; ++i)
+    {
+        Worker &victim = *_worker[(worker_index + i) % worker_count];
+
+        lock_guard<mutex> lock(victim.mutex);
+
+        if (!victim.tasks.empty())
+        {
+            task = victim.tasks.front();
+            victim.tasks.pop_front();
+            --_queued_count;
+
+            return GL_TRUE;
+        }
+    }
+
+    return GL_FALSE;
+}
+
+GLboolean TaskScheduler::_PopDetached(Task &task)
+{
+    lock_guard<mutex> lock(_detached_mutex);
+
+    if (_detached.empty())
+        return GL_FALSE;
+
+    task = _detached.front();
+    _detached.pop_front();
+    --_queued_count;
+
+    return GL_TRUE;
+}
+
+GLvoid TaskScheduler::_Execute(Task &task)
+{
+    try
+    {
+        task.work();
+    }
+    catch (...)
+    {
+        if (task.latch)
+        {
+            lock_guard<mutex> lock(task.latch->mutex);
+
+            if (!task.latch->exception)
+                task.latch->exception = current_exception();
+        }
+    }
+
+    // the waiting thread may destroy the latch as soon as it is released
+    if (task.latch)
+        --task.latch->remaining;
+}
+
+GLvoid TaskScheduler::_Help(Latch &latch)
+{
+    GLuint worker_index = _CurrentWorkerIndex();
+    GLuint idle_count   = 0;
+
+    while (latch.remaining > 0)
+    {
+        Task task;
+
+        if (_Pop(worker_index, task) || _Steal(worker_index, task))
+        {
+            _Execute(task);
+            idle_count = 0;
+        }
+        else if (++idle_count < 64)
+            this_thread::yield();
+        else
+            this_thread::sleep_for(chrono::microseconds(50));
+    }
+
+    if (latch.exception)
+        rethrow_exception(latch.exception);
+}
+
+GLint TaskScheduler::_ChunkCount(GLint count, GLint grain_size) const
+{
+    GLint64 chunk_count;
+
+    if (grain_size > 0)
+        chunk_count = ((GLint64)count + grain_size - 1) / grain_size;
+    else if (_deterministic)
+        chunk_count = 64;
+    else
+        chunk_count = 4 * (GLint64)_thread_count;
+
+    return (GLint)max((GLint64)1, min(chunk_count, (GLint64)count));
+}
+
+GLvoid TaskScheduler::SetThreadCount(GLuint thread_count)
+{
+    _Stop();
+    _Start(thread_count);
+}
+
+GLuint TaskScheduler::GetThreadCount() const
+{
+    return _thread_count;
+}
+
+GLvoid TaskScheduler::SetDeterministic(GLboolean deterministic)
+{
+    _deterministic = deterministic;
+}
+
+GLboolean TaskScheduler::IsDeterministic() const
+{
+    return _deterministic;
+}
+
+GLvoid TaskScheduler::ParallelFor(GLint begin, GLint end, const function<GLvoid(GLint, GLint)> &body,
+                                  GLint grain_size)
+{
+    if (end <= begin)
+        return;
+
+    GLint chunk_count = _ChunkCount(end - begin, grain_size);
+
+    if (chunk_count == 1 || _thread_count == 1)
+    {
+        for (GLint c = 0; c < chunk_count; ++c)
+            body(_ChunkBegin(begin, end, chunk_count, c), _ChunkBegin(begin, end, chunk_count, c + 1));
+
+        return;
+    }
+
+    Latch latch(chunk_count);
+
+    // pushed in reverse order, thus the caller pops the chunks in increasing order, while the
+    // thieves take the last ones
+    for (GLint c = chunk_count - 1; c >= 0; --c)
+    {
+        GLint first = _ChunkBegin(begin, end, chunk_count, c);
+        GLint last  = _ChunkBegin(begin, end, chunk_count, c + 1);
+
+        Task task;
+        task.work  = [&body, first, last]() { body(first, last); };
+        task.latch = &latch;
+
+        _Push(task);
+    }
+
+    _Help(latch);
+}
+
+GLvoid TaskScheduler::Spawn(const function<GLvoid()> &work)
+{
+    if (_thread_count == 1)
+    {
+        try
+        {
+            work();
+        }
+        catch (...)
+        {
+        }
+
+        return;
+    }
+
+    Task task;
+    task.work  = work;
+    task.latch = nullptr;
+
+    _Push(task);
+}
+
+// destructor
+TaskScheduler::~TaskScheduler()
+{
+    _Stop();
+}
+
+// special and default constructor
+TaskScheduler::TaskGroup::TaskGroup(TaskScheduler &scheduler):
+        _scheduler(scheduler), _failed(GL_FALSE)
+{
+}
+
+TaskScheduler::TaskGroup::Task TaskScheduler::TaskGroup::Add(
+        const function<GLvoid()> &work, const vector<Task> &dependencies)
+{
+    Task task = (Task)_node.size();
+
+    unique_ptr<Node> node(new Node());
+    node->work             = work;
+    node->dependency_count = (GLint)dependencies.size();
+
+    for (GLuint i = 0; i < dependencies.size(); ++i)
+        _node[dependencies[i]]->successors.push_back(task);
+
+    _node.push_back(move(node));
+
+    return task;
+}
+
+GLvoid TaskScheduler::TaskGroup::_Start(Task task, Latch &latch)
+{
+    TaskScheduler::Task scheduled;
+    scheduled.latch = &latch;
+    scheduled.work  = [this, task, &latch]()
+    {
+        Node &node = *_node[task];
+
+        if (!_failed)
+        {
+            try
+            {
+                node.work();
+            }
+            catch (...)
+            {
+                lock_guard<mutex> lock(latch.mutex);
+
+                if (!latch.exception)
+                    latch.exception = current_exception();
+
+                _failed = GL_TRUE;
+            }
+        }
+
+        // the successors are released before this task, thus the latch cannot be released early
+        for (GLuint i = 0; i < node.successors.size(); ++i)
+            if (--_node[node.successors[i]]->unfinished_dependency_count == 0)
+                _Start(node.successors[i], latch);
+    };
+
+    _scheduler._Push(scheduled);
+}
+
+GLvoid TaskScheduler::TaskGroup::Run()
+{
+    vector<unique_ptr<Node> > node;
+    node.swap(_node);
+
+    if (node.empty())
+        return;
+
+    // the tasks were added in a topological order
+    if (_scheduler.GetThreadCount() == 1)
+    {
+        for (GLuint i = 0; i < node.size(); ++i)
+            node[i]->work();
+
+        return;
+    }
+
+    node.swap(_node);
+
+    _failed = GL_FALSE;
+
+    Latch latch((GLint)_node.size());
+
+    for (GLuint i = 0; i < _node.size(); ++i)
+        _node[i]->unfinished_dependency_count = _node[i]->dependency_count;
+
+    for (GLuint i = 0; i < _node.size(); ++i)
+        if (!_node[i]->dependency_count)
+            _Start(i, latch);
+
+    try
+    {
+        _scheduler._Help(latch);
+    }
+    catch (...)
+    {
+        _node.clear();
+        throw;
+    }
+
+    _node.clear();
+}
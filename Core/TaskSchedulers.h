@@ -0,0 +1,216 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace cagd
+{
+    //--------------------
+    // class TaskScheduler
+    //--------------------
+    // Pool of worker threads that is shared by the parallel algorithms of the library (tessellation,
+    // normal vector computation, parsing of OFF files, fitting, curvature analysis, intersections,
+    // background tessellation of the user interface, etc.), thus nested or concurrent parallel
+    // algorithms do not oversubscribe the processor.
+    //
+    // Every worker owns a deque of tasks: it pushes and pops its own tasks at the back, while the
+    // idle workers steal the oldest tasks from the front of the deques of the others. Threads that
+    // are not workers (e.g. the thread of the user interface) submit their tasks into a shared deque.
+    // A thread that waits for the completion of its tasks executes pending tasks meanwhile, thus
+    // nested parallel loops do not deadlock, even if every worker is waiting.
+    //
+    // The thread count includes the calling thread: with a single thread every task is executed by
+    // the caller, in increasing order of the indices.
+    //
+    // In deterministic mode the chunks of ParallelFor() depend only on the range and the grain size,
+    // i.e. they are independent of the thread count. Since ParallelReduce() combines the partial
+    // results of the chunks in their order, floating point reductions yield identical results by
+    // every thread count and scheduling.
+    class TaskScheduler
+    {
+    public:
+        class TaskGroup;
+
+    protected:
+        // counts the unfinished tasks of a parallel loop or task group, and stores the first exception
+        // thrown by them
+        class Latch
+        {
+        public:
+            std::atomic<GLint>      remaining;
+            std::mutex              mutex;
+            std::exception_ptr      exception;
+
+            Latch(GLint count);
+        };
+
+        class Task
+        {
+        public:
+            std::function<GLvoid()> work;
+            Latch                   *latch;         // nullptr for detached tasks
+        };
+
+        class Worker
+        {
+        public:
+            std::mutex              mutex;
+            std::deque<Task>        tasks;
+        };
+
+        // _worker[i] belongs to the i-th worker thread, the last one is shared by the other threads
+        std::vector<std::unique_ptr<Worker> > _worker;
+        std::vector<std::thread>    _thread;
+
+        // detached tasks are executed only by the worker threads, thus a waiting thread is not
+        // delayed by long-running jobs that it is not waiting for
+        std::mutex                  _detached_mutex;
+        std::deque<Task>            _detached;
+
+        std::atomic<GLint>          _queued_count;
+        std::mutex                  _sleep_mutex;
+        std::condition_variable     _task_available;
+        GLboolean                   _stopping;
+
+        GLuint                      _thread_count;
+        std::atomic<GLboolean>      _deterministic;
+
+        TaskScheduler();
+
+        GLvoid    _Start(GLuint thread_count);
+        GLvoid    _Stop();
+
+        GLvoid    _Work(GLuint worker_index);
+        GLuint    _CurrentWorkerIndex() const;
+
+        GLvoid    _Push(const Task &task);
+        GLboolean _Pop(GLuint worker_index, Task &task);
+        GLboolean _Steal(GLuint worker_index, Task &task);
+        GLboolean _PopDetached(Task &task);
+        GLvoid    _Execute(Task &task);
+
+        // executes pending tasks until the latch is released, then rethrows the first exception
+        GLvoid    _Help(Latch &latch);
+
+        GLint     _ChunkCount(GLint count, GLint grain_size) const;
+
+        // first index of the given chunk, the chunks differ in size by at most one
+        static GLint _ChunkBegin(GLint begin, GLint end, GLint chunk_count, GLint chunk);
+
+    private:
+        TaskScheduler(const TaskScheduler&);
+        TaskScheduler& operator =(const TaskScheduler&);
+
+    public:
+        // the scheduler of the process, it is started on first use with the hardware concurrency
+        static TaskScheduler& Instance();
+
+        // 0 denotes the hardware concurrency; must not be called while tasks are running
+        GLvoid    SetThreadCount(GLuint thread_count);
+        GLuint    GetThreadCount() const;
+
+        GLvoid    SetDeterministic(GLboolean deterministic);
+        GLboolean IsDeterministic() const;
+
+        // calls body(first, last) for consecutive chunks [first, last) covering [begin, end), and
+        // returns after every call has finished; chunks contain about grain_size indices, by default
+        // the range is split into a few chunks per thread (into 64 chunks in deterministic mode);
+        // the first exception thrown by the body is rethrown to the caller
+        GLvoid    ParallelFor(GLint begin, GLint end, const std::function<GLvoid(GLint, GLint)> &body,
+                              GLint grain_size = 0);
+
+        // every chunk [first, last) is accumulated by body(first, last, partial) into a copy of
+        // identity, then the partial results are combined by combine(result, partial) in the order
+        // of the chunks
+        template <typename T, typename Body, typename Combine>
+        T         ParallelReduce(GLint begin, GLint end, const T &identity,
+                                 const Body &body, const Combine &combine, GLint grain_size = 0);
+
+        // the work is executed asynchronously by a worker thread (or immediately by the caller, if
+        // the scheduler has a single thread); exceptions are ignored
+        GLvoid    Spawn(const std::function<GLvoid()> &work);
+
+        // joins the worker threads
+        ~TaskScheduler();
+    };
+
+    //--------------------------------
+    // class TaskScheduler::TaskGroup
+    //--------------------------------
+    // Graph of tasks: a task is started after all of its dependencies are finished. The tasks are
+    // added in a topological order, since only already added tasks can be referenced.
+    class TaskScheduler::TaskGroup
+    {
+    public:
+        typedef GLuint Task;
+
+    protected:
+        class Node
+        {
+        public:
+            std::function<GLvoid()> work;
+            std::vector<Task>       successors;
+            GLint                   dependency_count;
+            std::atomic<GLint>      unfinished_dependency_count;
+        };
+
+        TaskScheduler                       &_scheduler;
+        std::vector<std::unique_ptr<Node> > _node;
+        std::atomic<GLboolean>              _failed;
+
+        GLvoid _Start(Task task, Latch &latch);
+
+    public:
+        TaskGroup(TaskScheduler &scheduler = TaskScheduler::Instance());
+
+        Task   Add(const std::function<GLvoid()> &work,
+                   const std::vector<Task> &dependencies = std::vector<Task>());
+
+        // executes the added tasks and removes them from the group; after a task has thrown an
+        // exception, the tasks that have not yet started are skipped, and the first exception is
+        // rethrown when the running ones have finished
+        GLvoid Run();
+    };
+
+    inline GLint TaskScheduler::_ChunkBegin(GLint begin, GLint end, GLint chunk_count, GLint chunk)
+    {
+        return begin + (GLint)((GLint64)(end - begin) * chunk / chunk_count);
+    }
+
+    template <typename T, typename Body, typename Combine>
+    T TaskScheduler::ParallelReduce(GLint begin, GLint end, const T &identity,
+                                    const Body &body, const Combine &combine, GLint grain_size)
+    {
+        T result(identity);
+
+        if (end <= begin)
+            return result;
+
+        GLint chunk_count = _ChunkCount(end - begin, grain_size);
+
+        std::vector<T> partial(chunk_count, identity);
+
+        ParallelFor(0, chunk_count,
+                    [&](GLint first_chunk, GLint last_chunk)
+                    {
+                        for (GLint c = first_chunk; c < last_chunk; ++c)
+                            body(_ChunkBegin(begin, end, chunk_count, c),
+                                 _ChunkBegin(begin, end, chunk_count, c + 1),
+                                 partial[c]);
+                    },
+                    1);
+
+        for (GLint c = 0; c < chunk_count; ++c)
+            combine(result, partial[c]);
+
+        return result;
+    }
+}
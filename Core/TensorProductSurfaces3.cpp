@@ -1,6 +1,10 @@
 #include "TensorProductSurfaces3.h"
+#include "Profilers.h"
 #include "RealSquareMatrices.h"
+#include "TaskSchedulers.h"
 #include <algorithm>
+#include <atomic>
+#include <vector>
 
 using namespace cagd;
 using namespace std;
@@ -17,12 +21,16 @@ TriangulatedMesh3* TensorProductSurface3::GenerateImage(GLuint u_div_point_count
     if (u_div_point_count <= 1 || v_div_point_count <= 1)
         return GL_FALSE;
 
+    CAGD_PROFILE_ZONE("TensorProductSurface3::GenerateImage");
+
     // calculating number of vertices, unit normal vectors and texture coordinates
     GLuint vertex_count = u_div_point_count * v_div_point_count;
 
     // calculating number of triangular faces
     GLuint face_count = 2 * (u_div_point_count - 1) * (v_div_point_count - 1);
 
+    CAGD_PROFILE_COUNT(SAMPLES, vertex_count);
+
     TriangulatedMesh3 *result = nullptr;
     result = new TriangulatedMesh3(vertex_count, face_count, usage_flag);
 
@@ -37,63 +45,69 @@ TriangulatedMesh3* TensorProductSurface3::GenerateImage(GLuint u_div_point_count
     GLfloat sdu = 1.0f / (u_div_point_count - 1);
     GLfloat tdv = 1.0f / (v_div_point_count - 1);
 
-    // for face indexing
-    GLuint current_face = 0;
-
-    // partial derivatives of order 0, 1, 2, and 3
-    PartialDerivatives pd;
-
-    for (GLuint i = 0; i < u_div_point_count; ++i)
+    // the rows of the grid are evaluated in parallel, the faces of row i start at index
+    // 2 * i * (v_div_point_count - 1)
+    TaskScheduler::Instance().ParallelFor(0, (GLint)u_div_point_count, [&](GLint chunk_begin, GLint chunk_end)
     {
-        GLdouble u = _u_min + i * du;
-        GLfloat  s = i * sdu;
-        for (GLuint j = 0; j < v_div_point_count; ++j)
+        // partial derivatives of order 0, 1, 2, and 3
+        PartialDerivatives pd;
+
+        for (GLuint i = (GLuint)chunk_begin; i < (GLuint)chunk_end; ++i)
         {
-            GLdouble v = _v_min + j * dv;
-            GLfloat  t = j * tdv;
-
-            /*
-                3-2
-                |/|
-                0-1
-            */
-            GLuint index[4];
-
-            index[0] = i * v_div_point_count + j;
-            index[1] = index[0] + 1;
-            index[2] = index[1] + v_div_point_count;
-            index[3] = index[2] - 1;
-
-            // calculating all needed surface data
-            CalculatePartialDerivatives(1, u, v, pd);
-
-            // surface point
-            (*result)._vertex[index[0]] = pd(0, 0);
-
-            // unit surface normal
-            (*result)._normal[index[0]] = pd(1, 0);
-            (*result)._normal[index[0]] ^= pd(1, 1);
-            (*result)._normal[index[0]].normalize();
-
-            // texture coordinates
-            (*result)._tex[index[0]].s() = s;
-            (*result)._tex[index[0]].t() = t;
-
-            // faces
-            if (i < u_div_point_count - 1 && j < v_div_point_count - 1)
+            GLdouble u = _u_min + i * du;
+            GLfloat  s = i * sdu;
+
+            // for face indexing
+            GLuint current_face = 2 * i * (v_div_point_count - 1);
+
+            for (GLuint j = 0; j < v_div_point_count; ++j)
             {
-                (*result)._face[current_face][0] = index[0];
-                (*result)._face[current_face][1] = index[1];
-                (*result)._face[current_face][2] = index[2];
-                ++current_face;
-
-                (*result)._face[current_face][0] = index[0];
-                (*result)._face[current_face][1] = index[2];
-                (*result)._face[current_face][2] = index[3];
-                ++current_face;
+                GLdouble v = _v_min + j * dv;
+                GLfloat  t = j * tdv;
+
+                /*
+                    3-2
+                    |/|
+                    0-1
+                */
+                GLuint index[4];
+
+                index[0] = i * v_div_point_count + j;
+                index[1] = index[0] + 1;
+                index[2] = index[1] + v_div_point_count;
+                index[3] = index[2] - 1;
+
+                // calculating all needed surface data
+                CalculatePartialDerivatives(1, u, v, pd);
+
+                // surface point
+                (*result)._vertex[index[0]] = pd(0, 0);
+
+                // unit surface normal
+                (*result)._normal[index[0]] = pd(1, 0);
+                (*result)._normal[index[0]] ^= pd(1, 1);
+                (*result)._normal[index[0]].normalize();
+
+                // texture coordinates
+                (*result)._tex[index[0]].s() = s;
+                (*result)._tex[index[0]].t() = t;
+
+                // faces
+                if (i < u_div_point_count - 1 && j < v_div_point_count - 1)
+                {
+                    (*result)._face[current_face][0] = index[0];
+                    (*result)._face[current_face][1] = index[1];
+                    (*result)._face[current_face][2] = index[2];
+                    ++current_face;
+
+                    (*result)._face[current_face][0] = index[0];
+                    (*result)._face[current_face][1] = index[2];
+                    (*result)._face[current_face][2] = index[3];
+                    ++current_face;
+                }
             }
         }
-    }
+    });
 
     return result;
 }
@@ -200,6 +214,7 @@ TensorProductSurface3::TensorProductSurface3(
     _data.ResizeColumns(column_count);
     _u_closed = u_closed;
     _v_closed = v_closed;
+    _vbo_data = 0;
 }
 
 // copy constructor
@@ -366,6 +381,8 @@ GLboolean TensorProductSurface3::RenderData(GLenum render_mode) const
         offset += _data.GetRowCount();
     }
 
+    CAGD_PROFILE_COUNT(DRAW_CALLS, _data.GetRowCount() + _data.GetColumnCount());
+
     glBindBuffer(GL_ARRAY_BUFFER, 0);
     glDisableClientState(GL_VERTEX_ARRAY);
 
@@ -388,6 +405,9 @@ GLboolean TensorProductSurface3::UpdateVertexBufferObjectsOfData(GLenum usage_fl
     glBindBuffer(GL_ARRAY_BUFFER, _vbo_data);
     glBufferData(GL_ARRAY_BUFFER, 2 * _data.GetRowCount() * _data.GetColumnCount() * 3 * sizeof(GLfloat), 0, usage_flag);
 
+    CAGD_PROFILE_COUNT(ALLOCATIONS, 1);
+    CAGD_PROFILE_COUNT(ALLOCATED_BYTES, 2 * _data.GetRowCount() * _data.GetColumnCount() * 3 * sizeof(GLfloat));
+
     GLfloat *coordinate = (GLfloat*)glMapBuffer(GL_ARRAY_BUFFER, GL_WRITE_ONLY);
     if (!coordinate)
     {
@@ -433,65 +453,160 @@ GLboolean TensorProductSurface3::UpdateVertexBufferObjectsOfData(GLenum usage_fl
 
 }
 
-// generate u-directional isoparametric lines
-// correct ????
-RowMatrix<GenericCurve3*>* TensorProductSurface3::GenerateUIsoparametricLines(GLuint iso_line_count,
-                                                      GLuint maximum_order_of_derivatives,
-                                                      GLuint div_point_count,
-                                                      GLenum usage_flag) const
+// by default the blending functions provide no derivatives
+GLboolean TensorProductSurface3::UBlendingFunctionDerivatives(
+        GLuint /*maximum_order_of_derivatives*/, GLdouble /*u_knot*/, Matrix<GLdouble>& /*derivatives*/) const
+{
+    return GL_FALSE;
+}
+
+GLboolean TensorProductSurface3::VBlendingFunctionDerivatives(
+        GLuint /*maximum_order_of_derivatives*/, GLdouble /*v_knot*/, Matrix<GLdouble>& /*derivatives*/) const
+{
+    return GL_FALSE;
+}
+
+RowMatrix<GenericCurve3*>* TensorProductSurface3::_GenerateIsoparametricLines(
+        GLboolean u_direction,
+        GLuint iso_line_count,
+        GLuint maximum_order_of_derivatives,
+        GLuint div_point_count,
+        GLenum usage_flag) const
 {
-    RowMatrix<GenericCurve3*>* result = new RowMatrix<GenericCurve3*> (iso_line_count);
-    double ustep = (_u_max - _u_min) / (div_point_count - 1);
-    double vstep = (_v_max - _v_min) / (iso_line_count - 1);
-    PartialDerivatives pd;
+    if (!iso_line_count || div_point_count < 2)
+        return nullptr;
+
+    CAGD_PROFILE_ZONE("TensorProductSurface3::GenerateIsoparametricLines");
+    CAGD_PROFILE_COUNT(SAMPLES, iso_line_count * div_point_count);
+
+    // the lines run in direction u at fixed values of v, or vice versa
+    GLdouble running_min = u_direction ? _u_min : _v_min, running_max = u_direction ? _u_max : _v_max;
+    GLdouble fixed_min   = u_direction ? _v_min : _u_min, fixed_max   = u_direction ? _v_max : _u_max;
+
+    GLdouble running_step = (running_max - running_min) / (div_point_count - 1);
+    GLdouble fixed_step   = iso_line_count > 1 ? (fixed_max - fixed_min) / (iso_line_count - 1) : 0.0;
+
+    // count of control points along the lines
+    GLuint polygon_size = u_direction ? _data.GetRowCount() : _data.GetColumnCount();
+
+    RowMatrix<GenericCurve3*>* result = new RowMatrix<GenericCurve3*>(iso_line_count);
+
+    for (GLuint i = 0; i < iso_line_count; ++i)
+        (*result)[i] = new GenericCurve3(maximum_order_of_derivatives, div_point_count, usage_flag);
 
-    for(int i = 0; i < iso_line_count; i++)
+    // the blending functions of the running direction are shared by every line:
+    // running_derivatives[j](k, l) is the k-th derivative of the l-th function at the j-th sample
+    vector<Matrix<GLdouble> > running_derivatives(div_point_count);
+    atomic<GLboolean>         factored(GL_TRUE);
+
+    TaskScheduler &scheduler = TaskScheduler::Instance();
+
+    scheduler.ParallelFor(0, (GLint)div_point_count, [&](GLint chunk_begin, GLint chunk_end)
+    {
+        for (GLuint j = (GLuint)chunk_begin; j < (GLuint)chunk_end && factored; ++j)
+        {
+            GLdouble t = min(running_min + j * running_step, running_max);
+
+            if (!(u_direction ? UBlendingFunctionDerivatives(maximum_order_of_derivatives, t, running_derivatives[j])
+                              : VBlendingFunctionDerivatives(maximum_order_of_derivatives, t, running_derivatives[j]))
+                || running_derivatives[j].GetColumnCount() != polygon_size)
+                factored = GL_FALSE;
+        }
+    });
+
+    scheduler.ParallelFor(0, (GLint)iso_line_count, [&](GLint chunk_begin, GLint chunk_end)
     {
-        GLdouble v = min(_v_min + i * vstep, _v_max);
-        (*result)[i] = new GenericCurve3(1, div_point_count, usage_flag) ;
+        Matrix<GLdouble>     fixed_values;
+        vector<DCoordinate3> polygon(polygon_size);
+        PartialDerivatives   pd;
 
-        for(int j = 0; j < div_point_count; j++)
+        for (GLuint i = (GLuint)chunk_begin; i < (GLuint)chunk_end; ++i)
         {
-            GLdouble u = min(_u_min + j * ustep, _u_max);
-            CalculatePartialDerivatives(maximum_order_of_derivatives,u,v,pd);
+            GenericCurve3 &curve = *(*result)[i];
+            GLdouble      fixed  = min(fixed_min + i * fixed_step, fixed_max);
+
+            GLboolean reduced = factored &&
+                    (u_direction ? VBlendingFunctionDerivatives(0, fixed, fixed_values)
+                                 : UBlendingFunctionDerivatives(0, fixed, fixed_values)) &&
+                    fixed_values.GetColumnCount() == (u_direction ? _data.GetColumnCount() : _data.GetRowCount());
 
-            for (GLuint r = 0; r<=maximum_order_of_derivatives;r++)
+            if (reduced)
             {
-                (*(*result)[i])(r, j) = pd(r, 0);
+                // control polygon of the isoparametric line, only the non-vanishing blending
+                // functions of the fixed direction contribute
+                for (GLuint k = 0; k < polygon_size; ++k)
+                    polygon[k] = DCoordinate3();
+
+                for (GLuint l = 0; l < fixed_values.GetColumnCount(); ++l)
+                {
+                    GLdouble value = fixed_values(0, l);
+
+                    if (value == 0.0)
+                        continue;
+
+                    for (GLuint k = 0; k < polygon_size; ++k)
+                        polygon[k] += value * (u_direction ? _data(k, l) : _data(l, k));
+                }
+
+                for (GLuint j = 0; j < div_point_count; ++j)
+                {
+                    const Matrix<GLdouble> &derivatives = running_derivatives[j];
+
+                    for (GLuint r = 0; r <= maximum_order_of_derivatives; ++r)
+                    {
+                        DCoordinate3 &point = curve(r, j);
+                        point = DCoordinate3();
+
+                        for (GLuint k = 0; k < polygon_size; ++k)
+                        {
+                            GLdouble coefficient = derivatives(r, k);
+
+                            if (coefficient != 0.0)
+                                point += coefficient * polygon[k];
+                        }
+                    }
+                }
+            }
+            else
+            {
+                // pd(r, 0) and pd(r, r) are the pure derivatives in direction u and v, respectively
+                for (GLuint j = 0; j < div_point_count; ++j)
+                {
+                    GLdouble t = min(running_min + j * running_step, running_max);
+
+                    if (u_direction)
+                        CalculatePartialDerivatives(maximum_order_of_derivatives, t, fixed, pd);
+                    else
+                        CalculatePartialDerivatives(maximum_order_of_derivatives, fixed, t, pd);
+
+                    for (GLuint r = 0; r <= maximum_order_of_derivatives; ++r)
+                        curve(r, j) = u_direction ? pd(r, 0) : pd(r, r);
+                }
             }
         }
-    }
+    });
+
     return result;
 }
 
+// generate u-directional isoparametric lines
+RowMatrix<GenericCurve3*>* TensorProductSurface3::GenerateUIsoparametricLines(GLuint iso_line_count,
+                                                      GLuint maximum_order_of_derivatives,
+                                                      GLuint div_point_count,
+                                                      GLenum usage_flag) const
+{
+    return _GenerateIsoparametricLines(GL_TRUE, iso_line_count, maximum_order_of_derivatives,
+                                       div_point_count, usage_flag);
+}
+
 // generate v-directional isoparametric lines
-// correct ????
 RowMatrix<GenericCurve3*>* TensorProductSurface3::GenerateVIsoparametricLines(GLuint iso_line_count,
                                                       GLuint maximum_order_of_derivatives,
                                                       GLuint div_point_count,
                                                       GLenum usage_flag) const
 {
-    RowMatrix<GenericCurve3*>* result = new RowMatrix<GenericCurve3*> (iso_line_count);
-    double ustep = (_u_max - _u_min) / (iso_line_count - 1);
-    double vstep = (_v_max - _v_min) / (div_point_count - 1);
-    PartialDerivatives pd;
-
-    for(int i = 0; i < iso_line_count; i++)
-    {
-        GLdouble u = min(_u_min +i * ustep, _u_max);
-        (*result)[i] = new GenericCurve3(1, div_point_count, usage_flag) ;
-
-        for(int j = 0; j < div_point_count; j++)
-        {
-            GLdouble v = min(_v_min +j * vstep, _v_max);
-            CalculatePartialDerivatives(maximum_order_of_derivatives,u,v,pd);
-            for (GLuint r = 0; r<=maximum_order_of_derivatives;r++)
-            {
-                (*(*result)[i])(r, j) = pd(r, r);
-            }
-        }
-    }
-    return result;
+    return _GenerateIsoparametricLines(GL_FALSE, iso_line_count, maximum_order_of_derivatives,
+                                       div_point_count, usage_flag);
 }
 
 // destructor
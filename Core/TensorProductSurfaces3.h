@@ -30,6 +30,14 @@ namespace cagd
         GLdouble             _v_min, _v_max;       // definition domain in direction v
         Matrix<DCoordinate3> _data;                // the control net (usually stores position vectors)
 
+        // common implementation of the isoparametric lines of both directions, i.e. of the lines
+        // that run in direction u (if u_direction is set) at fixed values of v, or vice versa
+        RowMatrix<GenericCurve3*>* _GenerateIsoparametricLines(GLboolean u_direction,
+                                                               GLuint iso_line_count,
+                                                               GLuint maximum_order_of_derivatives,
+                                                               GLuint div_point_count,
+                                                               GLenum usage_flag) const;
+
     public:
         // homework: special constructor
         TensorProductSurface3(
@@ -73,6 +81,17 @@ namespace cagd
         virtual GLboolean VBlendingFunctionValues(
                 GLdouble v_knot, RowMatrix<GLdouble>& blending_values) const = 0;
 
+        // blending function values and derivatives in u- and v-direction, derivatives(k, i) is the
+        // k-th order derivative of the i-th blending function, k = 0, ..., maximum order; surfaces
+        // that do not override them (or whose shape does not factor into the blending functions of
+        // the two directions, e.g. rational ones) fail, then their isoparametric lines are evaluated
+        // point by point by CalculatePartialDerivatives()
+        virtual GLboolean UBlendingFunctionDerivatives(
+                GLuint maximum_order_of_derivatives, GLdouble u_knot, Matrix<GLdouble>& derivatives) const;
+
+        virtual GLboolean VBlendingFunctionDerivatives(
+                GLuint maximum_order_of_derivatives, GLdouble v_knot, Matrix<GLdouble>& derivatives) const;
+
         // calculates the point and higher order (mixed) partial derivatives of the
         // tensor product surface
         //
@@ -102,6 +121,11 @@ namespace cagd
         virtual GLboolean UpdateVertexBufferObjectsOfData(GLenum usage_flag = GL_STATIC_DRAW);
 
         // homework: generate u-directional isoparametric lines
+        //
+        // The blending functions of the running direction are evaluated once for every sample
+        // parameter, and the control net is reduced once per line to the control polygon of the
+        // isoparametric curve, whose points and derivatives are then linear combinations of the
+        // polygon; the lines are generated in parallel.
         RowMatrix<GenericCurve3*>* GenerateUIsoparametricLines(GLuint iso_line_count,
                                                               GLuint maximum_order_of_derivatives,
                                                               GLuint div_point_count,
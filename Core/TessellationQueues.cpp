@@ -0,0 +1,230 @@
+#include "TessellationQueues.h"
+
+using namespace cagd;
+using namespace std;
+
+GLvoid TessellationQueue::Result::Discard()
+{
+    for (GLuint i = 0; i < meshes.size(); ++i)
+        delete meshes[i];
+
+    for (GLuint i = 0; i < curves.size(); ++i)
+        delete curves[i];
+
+    meshes.clear();
+    curves.clear();
+}
+
+// special and default constructor
+TessellationQueue::TessellationQueue(TaskScheduler &scheduler):
+        _scheduler(scheduler),
+        _next_ticket(0), _minimum_ticket(0),
+        _runner_count(0)
+{
+}
+
+GLvoid TessellationQueue::_Run()
+{
+    PendingJob pending;
+
+    {
+        lock_guard<mutex> lock(_mutex);
+
+        // the job of this runner has been cancelled
+        if (_pending.empty())
+        {
+            if (!--_runner_count)
+                _runner_finished.notify_all();
+
+            return;
+        }
+
+        pending = _pending.front();
+        _pending.pop_front();
+
+        PendingJob running;
+        running.key    = pending.key;
+        running.ticket = pending.ticket;
+        _running.push_back(running);
+    }
+
+    Result    result;
+    GLboolean succeeded = GL_TRUE;
+
+    result.key = pending.key;
+
+    // a failed job does not affect the others, its partial result is discarded
+    try
+    {
+        pending.job(result);
+    }
+    catch (...)
+    {
+        succeeded = GL_FALSE;
+    }
+
+    GLboolean notify = GL_FALSE;
+
+    lock_guard<mutex> lock(_mutex);
+
+    for (vector<PendingJob>::iterator it = _running.begin(); it != _running.end(); ++it)
+        if (it->ticket == pending.ticket)
+        {
+            _running.erase(it);
+            break;
+        }
+
+    GLuint64 &minimum = _minimum_ticket_of_key[pending.key];
+
+    if (succeeded && pending.ticket >= _minimum_ticket && pending.ticket >= minimum)
+    {
+        minimum = pending.ticket + 1;
+
+        notify = _completed.empty();
+        _completed.push_back(result);
+    }
+    else
+        result.Discard();
+
+    if (_pending.empty() && _running.empty())
+    {
+        notify = GL_TRUE;
+        _job_finished.notify_all();
+    }
+
+    // the handler is called under the lock, thus it cannot run after the destructor has
+    // returned
+    if (notify && _completion_handler)
+        _completion_handler();
+
+    if (!--_runner_count)
+        _runner_finished.notify_all();
+}
+
+GLvoid TessellationQueue::SetCompletionHandler(const function<GLvoid()> &handler)
+{
+    lock_guard<mutex> lock(_mutex);
+
+    _completion_handler = handler;
+}
+
+GLvoid TessellationQueue::Submit(GLuint64 key, const Job &job)
+{
+    {
+        lock_guard<mutex> lock(_mutex);
+
+        PendingJob pending;
+        pending.key    = key;
+        pending.ticket = _next_ticket++;
+        pending.job    = job;
+
+        // the waiting job of the same key is replaced in place, thus it keeps its position in the
+        // queue, and it needs no further runner
+        for (deque<PendingJob>::iterator it = _pending.begin(); it != _pending.end(); ++it)
+            if (it->key == key)
+            {
+                *it = pending;
+                return;
+            }
+
+        _pending.push_back(pending);
+        ++_runner_count;
+    }
+
+    // a scheduler without worker threads runs the job immediately, thus the lock has to be released
+    _scheduler.Spawn([this]() { _Run(); });
+}
+
+GLvoid TessellationQueue::Cancel(GLuint64 key)
+{
+    Cancel(key, key);
+}
+
+GLvoid TessellationQueue::Cancel(GLuint64 first_key, GLuint64 last_key)
+{
+    lock_guard<mutex> lock(_mutex);
+
+    for (deque<PendingJob>::iterator it = _pending.begin(); it != _pending.end(); )
+    {
+        if (it->key >= first_key && it->key <= last_key)
+            it = _pending.erase(it);
+        else
+            ++it;
+    }
+
+    for (vector<PendingJob>::iterator it = _running.begin(); it != _running.end(); ++it)
+        if (it->key >= first_key && it->key <= last_key)
+            _minimum_ticket_of_key[it->key] = _next_ticket;
+
+    for (vector<Result>::iterator it = _completed.begin(); it != _completed.end(); )
+    {
+        if (it->key >= first_key && it->key <= last_key)
+        {
+            it->Discard();
+            it = _completed.erase(it);
+        }
+        else
+            ++it;
+    }
+
+    if (_pending.empty() && _running.empty())
+        _job_finished.notify_all();
+}
+
+GLvoid TessellationQueue::CancelAll()
+{
+    lock_guard<mutex> lock(_mutex);
+
+    _pending.clear();
+    _minimum_ticket = _next_ticket;
+
+    for (vector<Result>::iterator it = _completed.begin(); it != _completed.end(); ++it)
+        it->Discard();
+
+    _completed.clear();
+
+    if (_running.empty())
+        _job_finished.notify_all();
+}
+
+GLuint TessellationQueue::Drain(vector<Result> &results)
+{
+    lock_guard<mutex> lock(_mutex);
+
+    GLuint count = (GLuint)_completed.size();
+
+    results.insert(results.end(), _completed.begin(), _completed.end());
+    _completed.clear();
+
+    return count;
+}
+
+GLuint TessellationQueue::GetJobCount() const
+{
+    lock_guard<mutex> lock(_mutex);
+
+    return (GLuint)(_pending.size() + _running.size());
+}
+
+GLvoid TessellationQueue::Wait()
+{
+    unique_lock<mutex> lock(_mutex);
+
+    while (!_pending.empty() || !_running.empty())
+        _job_finished.wait(lock);
+}
+
+TessellationQueue::~TessellationQueue()
+{
+    {
+        unique_lock<mutex> lock(_mutex);
+
+        _pending.clear();
+
+        while (_runner_count)
+            _runner_finished.wait(lock);
+    }
+
+    for (vector<Result>::iterator it = _completed.begin(); it != _completed.end(); ++it)
+        it->Discard();
+}
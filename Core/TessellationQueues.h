@@ -0,0 +1,110 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <vector>
+#include "GenericCurves3.h"
+#include "TaskSchedulers.h"
+#include "TriangulatedMeshes3.h"
+
+namespace cagd
+{
+    //------------------------
+    // class TessellationQueue
+    //------------------------
+    // Generates meshes and curves by the worker threads of a TaskScheduler, thus long tessellations do
+    // not block the thread of the user interface. Every job is submitted with a key that identifies the tessellated object
+    // (e.g. a patch of a quilt): a job that is still waiting is replaced by the next one of the same
+    // key, thus consecutive edits of a dragged control point are coalesced, and the results of jobs
+    // that are overtaken by newer ones of the same key, or that are cancelled, are discarded.
+    //
+    // The results are collected by Drain(), which is meant to be called by the thread of the
+    // rendering context, since the vertex buffer objects of the results can only be created there.
+    // Jobs must not call OpenGL, and have to work on their own copies of the data they tessellate
+    // (e.g. copies of control nets that were taken by the submitting thread), since the objects of
+    // the application may be modified concurrently.
+    class TessellationQueue
+    {
+    public:
+        class Result
+        {
+        public:
+            GLuint64                        key;
+            std::vector<TriangulatedMesh3*> meshes;     // owned by the receiver of the result
+            std::vector<GenericCurve3*>     curves;
+
+            // deletes the meshes and curves
+            GLvoid Discard();
+        };
+
+        typedef std::function<GLvoid(Result&)> Job;
+
+    protected:
+        class PendingJob
+        {
+        public:
+            GLuint64 key, ticket;
+            Job      job;
+        };
+
+        TaskScheduler                &_scheduler;
+        mutable std::mutex           _mutex;
+        std::condition_variable      _job_finished, _runner_finished;
+
+        std::deque<PendingJob>       _pending;
+        std::vector<PendingJob>      _running;      // without jobs, only keys and tickets
+        std::vector<Result>          _completed;
+
+        // tickets are increasing, a result is accepted if its ticket is not less than the minimum of
+        // its key and the global minimum
+        GLuint64                     _next_ticket, _minimum_ticket;
+        std::map<GLuint64, GLuint64> _minimum_ticket_of_key;
+
+        std::function<GLvoid()>      _completion_handler;
+
+        // every job that is appended to _pending spawns a runner task, which executes the first
+        // waiting job (if any remains) when the scheduler starts it
+        GLuint                       _runner_count;
+
+        GLvoid _Run();
+
+    private:
+        // the runners refer to the queue
+        TessellationQueue(const TessellationQueue&);
+        TessellationQueue& operator =(const TessellationQueue&);
+
+    public:
+        // special and default constructor
+        TessellationQueue(TaskScheduler &scheduler = TaskScheduler::Instance());
+
+        // the handler is called by the worker threads whenever results become available for Drain(),
+        // or the queue becomes idle, e.g. it may schedule the repaint of a widget; it must not call
+        // the methods of the queue
+        GLvoid SetCompletionHandler(const std::function<GLvoid()> &handler);
+
+        // supersedes the previously submitted jobs of the same key
+        GLvoid Submit(GLuint64 key, const Job &job);
+
+        // the waiting jobs of the given keys are removed, the results of the running ones and the
+        // completed but not yet drained results are discarded
+        GLvoid Cancel(GLuint64 key);
+        GLvoid Cancel(GLuint64 first_key, GLuint64 last_key);    // keys of the closed interval
+        GLvoid CancelAll();
+
+        // appends the completed results in the order of their completion, and returns their count
+        GLuint Drain(std::vector<Result> &results);
+
+        // count of waiting and running jobs
+        GLuint GetJobCount() const;
+
+        // blocks the caller until every submitted job is finished
+        GLvoid Wait();
+
+        // cancels the waiting jobs and waits for the running ones
+        ~TessellationQueue();
+    };
+}
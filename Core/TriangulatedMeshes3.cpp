@@ -3,6 +3,8 @@
 #include <fstream>
 #include <limits>
 #include <algorithm>
+#include "Profilers.h"
+#include "TaskSchedulers.h"
 #include "TriangulatedMeshes3.h"
 
 using namespace cagd;
@@ -10,23 +12,33 @@ using namespace std;
 
 TriangulatedMesh3::TriangulatedMesh3(GLuint vertex_count, GLuint face_count, GLenum usage_flag):
 	_usage_flag(usage_flag),
-	_vbo_vertices(0), _vbo_normals(0), _vbo_tex_coordinates(0), _vbo_indices(0),
+	_vbo_vertices(0), _vbo_normals(0), _vbo_tex_coordinates(0), _vbo_indices(0), _vbo_colors(0),
+	_stream(0),
 	_vertex(vertex_count), _normal(vertex_count), _tex(vertex_count),
-	_face(face_count)
+	_face(face_count),
+	_compact(GL_FALSE)
 {
 }
 
 TriangulatedMesh3::TriangulatedMesh3(const TriangulatedMesh3 &mesh):
         _usage_flag(mesh._usage_flag),
-        _vbo_vertices(0), _vbo_normals(0), _vbo_tex_coordinates(0), _vbo_indices(0),
+        _vbo_vertices(0), _vbo_normals(0), _vbo_tex_coordinates(0), _vbo_indices(0), _vbo_colors(0),
+        _stream(0),
 		_leftmost_vertex(mesh._leftmost_vertex), _rightmost_vertex(mesh._rightmost_vertex),
         _vertex(mesh._vertex),
         _normal(mesh._normal),
         _tex(mesh._tex),
-        _face(mesh._face)
+        _face(mesh._face),
+        _color(mesh._color),
+        _compact(mesh._compact),
+        _compact_vertex(mesh._compact_vertex),
+        _compact_normal(mesh._compact_normal)
 {
     if (mesh._vbo_vertices && mesh._vbo_normals && mesh._vbo_tex_coordinates && mesh._vbo_indices)
         UpdateVertexBufferObjects(mesh._usage_flag);
+
+    if (mesh._stream)
+        EnableStreaming(mesh._stream->GetSegmentCount());
 }
 
 TriangulatedMesh3& TriangulatedMesh3::operator =(const TriangulatedMesh3& rhs)
@@ -42,9 +54,19 @@ TriangulatedMesh3& TriangulatedMesh3::operator =(const TriangulatedMesh3& rhs)
         _normal		      = rhs._normal;
         _tex              = rhs._tex;
         _face             = rhs._face;
+        _color            = rhs._color;
+        _compact          = rhs._compact;
+        _compact_vertex   = rhs._compact_vertex;
+        _compact_normal   = rhs._compact_normal;
 
         if (rhs._vbo_vertices && rhs._vbo_normals && rhs._vbo_tex_coordinates && rhs._vbo_indices)
             UpdateVertexBufferObjects(_usage_flag);
+
+        // the ring of the previous geometry is never reused
+        if (rhs._stream)
+            EnableStreaming(rhs._stream->GetSegmentCount());
+        else
+            DisableStreaming();
     }
 
     return *this;
@@ -58,7 +80,31 @@ GLvoid TriangulatedMesh3::DeleteVertexBufferObjects()
         _vbo_vertices = 0;
     }
 
-    // homework: delete vertex buffer objects of unit normal vectors, texture coordinates, and indices
+    if (_vbo_normals)
+    {
+        glDeleteBuffers(1, &_vbo_normals);
+        _vbo_normals = 0;
+    }
+
+    if (_vbo_tex_coordinates)
+    {
+        glDeleteBuffers(1, &_vbo_tex_coordinates);
+        _vbo_tex_coordinates = 0;
+    }
+
+    if (_vbo_indices)
+    {
+        glDeleteBuffers(1, &_vbo_indices);
+        _vbo_indices = 0;
+    }
+
+    if (_vbo_colors)
+    {
+        glDeleteBuffers(1, &_vbo_colors);
+        _vbo_colors = 0;
+    }
+
+    DisableStreaming();
 }
 
 GLboolean TriangulatedMesh3::Render(GLenum render_mode) const
@@ -79,15 +125,35 @@ GLboolean TriangulatedMesh3::Render(GLenum render_mode) const
         // specify the location and data format of texture coordinates
         glTexCoordPointer(4, GL_FLOAT, 0, (const GLvoid *)0);
 
-        // activate the VBO of normal vectors
-        glBindBuffer(GL_ARRAY_BUFFER, _vbo_normals);
-        // specify the location and data format of normal vectors
-        glNormalPointer(GL_FLOAT, 0, (const GLvoid *)0);
+        if (_stream && _stream->HasData())
+        {
+            // the current ring segment stores the deformed vertices followed by their normals
+            GLintptr offset = _stream->GetCurrentSegmentOffset();
+
+            glBindBuffer(GL_ARRAY_BUFFER, _stream->GetBufferObject());
+            glNormalPointer(GL_FLOAT, 0, (const GLvoid *)(offset + 3 * VertexCount() * sizeof(GLfloat)));
+            glVertexPointer(3, GL_FLOAT, 0, (const GLvoid *)offset);
+        }
+        else
+        {
+            // activate the VBO of normal vectors
+            glBindBuffer(GL_ARRAY_BUFFER, _vbo_normals);
+            // specify the location and data format of normal vectors
+            glNormalPointer(GL_FLOAT, 0, (const GLvoid *)0);
+
+            // activate the VBO of vertices
+            glBindBuffer(GL_ARRAY_BUFFER, _vbo_vertices);
+            // specify the location and data format of vertices
+            glVertexPointer(3, GL_FLOAT, 0, (const GLvoid *)0);
+        }
 
-        // activate the VBO of vertices
-        glBindBuffer(GL_ARRAY_BUFFER, _vbo_vertices);
-        // specify the location and data format of vertices
-        glVertexPointer(3, GL_FLOAT, 0, (const GLvoid *)0);
+        // per vertex colors replace the current color
+        if (_vbo_colors)
+        {
+            glEnableClientState(GL_COLOR_ARRAY);
+            glBindBuffer(GL_ARRAY_BUFFER, _vbo_colors);
+            glColorPointer(4, GL_FLOAT, 0, (const GLvoid *)0);
+        }
 
         // activate the element array buffer for indexed vertices of triangular faces
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _vbo_indices);
@@ -95,12 +161,24 @@ GLboolean TriangulatedMesh3::Render(GLenum render_mode) const
         // render primitives
         glDrawElements(render_mode, 3 * (GLsizei)_face.size(), GL_UNSIGNED_INT, (const GLvoid *)0);
 
+        CAGD_PROFILE_COUNT(DRAW_CALLS, 1);
+
+        if (render_mode == GL_TRIANGLES)
+            CAGD_PROFILE_COUNT(TRIANGLES, _face.size());
+
+        // the segment cannot be overwritten until the GPU has finished the draw call above
+        if (_stream)
+            _stream->FenceCurrentSegment();
+
 
     // disable individual client-side capabilities
     glDisableClientState(GL_VERTEX_ARRAY);
     glDisableClientState(GL_NORMAL_ARRAY);
     glDisableClientState(GL_TEXTURE_COORD_ARRAY);
 
+    if (_vbo_colors)
+        glDisableClientState(GL_COLOR_ARRAY);
+
     // unbind any buffer object previously bound and restore client memory usage
     // for these buffer object targets
     glBindBuffer(GL_ARRAY_BUFFER, 0);
@@ -116,9 +194,14 @@ GLboolean TriangulatedMesh3::UpdateVertexBufferObjects(GLenum usage_flag)
      && usage_flag != GL_DYNAMIC_DRAW && usage_flag != GL_DYNAMIC_READ && usage_flag != GL_DYNAMIC_COPY)
         return GL_FALSE;
 
+    CAGD_PROFILE_ZONE("TriangulatedMesh3::UpdateVertexBufferObjects");
+
     // updating usage flag
     _usage_flag = usage_flag;
 
+    // the size of the streamed segments depends on the vertex count, thus they are recreated
+    GLuint stream_segment_count = _stream ? _stream->GetSegmentCount() : 0;
+
     // deleting old vertex buffer objects
     DeleteVertexBufferObjects();
 
@@ -171,7 +254,7 @@ GLboolean TriangulatedMesh3::UpdateVertexBufferObjects(GLenum usage_flag)
 
     // Notice that multiple buffers can be mapped simultaneously.
 
-    GLuint vertex_byte_size = 3 * (GLuint)_vertex.size() * sizeof(GLfloat);
+    GLuint vertex_byte_size = 3 * VertexCount() * sizeof(GLfloat);
 
     glBindBuffer(GL_ARRAY_BUFFER, _vbo_vertices);
     glBufferData(GL_ARRAY_BUFFER, vertex_byte_size, 0, _usage_flag);
@@ -183,17 +266,26 @@ GLboolean TriangulatedMesh3::UpdateVertexBufferObjects(GLenum usage_flag)
 
     GLfloat *normal_coordinate = (GLfloat*)glMapBuffer(GL_ARRAY_BUFFER, GL_WRITE_ONLY);
 
-    for (vector<DCoordinate3>::const_iterator
-         vit = _vertex.begin(),
-         nit = _normal.begin(); vit != _vertex.end(); ++vit, ++nit)
+    // compacted meshes already store the layout of the buffers
+    if (_compact)
+    {
+        memcpy(vertex_coordinate, &_compact_vertex[0], vertex_byte_size);
+        memcpy(normal_coordinate, &_compact_normal[0], vertex_byte_size);
+    }
+    else
     {
-        for (GLint component = 0; component < 3; ++component)
+        for (vector<DCoordinate3>::const_iterator
+             vit = _vertex.begin(),
+             nit = _normal.begin(); vit != _vertex.end(); ++vit, ++nit)
         {
-            *vertex_coordinate = (GLfloat)(*vit)[component];
-            ++vertex_coordinate;
-
-            *normal_coordinate = (GLfloat)(*nit)[component];
-            ++normal_coordinate;
+            for (GLint component = 0; component < 3; ++component)
+            {
+                *vertex_coordinate = (GLfloat)(*vit)[component];
+                ++vertex_coordinate;
+
+                *normal_coordinate = (GLfloat)(*nit)[component];
+                ++normal_coordinate;
+            }
         }
     }
 
@@ -209,6 +301,9 @@ GLboolean TriangulatedMesh3::UpdateVertexBufferObjects(GLenum usage_flag)
     
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _vbo_indices);
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, index_byte_size, 0, _usage_flag);
+
+    CAGD_PROFILE_COUNT(ALLOCATIONS, 4);
+    CAGD_PROFILE_COUNT(ALLOCATED_BYTES, 2 * vertex_byte_size + tex_byte_size + index_byte_size);
     GLuint *element = (GLuint*)glMapBuffer(GL_ELEMENT_ARRAY_BUFFER, GL_WRITE_ONLY);
 
     for (vector<TriangularFace>::const_iterator fit = _face.begin(); fit != _face.end(); ++fit)
@@ -242,12 +337,83 @@ GLboolean TriangulatedMesh3::UpdateVertexBufferObjects(GLenum usage_flag)
     glBindBuffer(GL_ARRAY_BUFFER, 0);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 
+    if (!_UpdateColorBufferObject())
+        return GL_FALSE;
+
+    if (stream_segment_count)
+        return EnableStreaming(stream_segment_count);
+
     return GL_TRUE;
 }
 
+// the colors are stored in a separate buffer object, thus they can be replaced without touching
+// the geometry
+GLboolean TriangulatedMesh3::_UpdateColorBufferObject()
+{
+    if (_color.empty())
+    {
+        if (_vbo_colors)
+        {
+            glDeleteBuffers(1, &_vbo_colors);
+            _vbo_colors = 0;
+        }
+
+        return GL_TRUE;
+    }
+
+    if (!_vbo_colors)
+    {
+        glGenBuffers(1, &_vbo_colors);
+
+        if (!_vbo_colors)
+            return GL_FALSE;
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, _vbo_colors);
+    glBufferData(GL_ARRAY_BUFFER, 4 * _color.size() * sizeof(GLfloat), &_color[0][0], _usage_flag);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    CAGD_PROFILE_COUNT(ALLOCATIONS, 1);
+    CAGD_PROFILE_COUNT(ALLOCATED_BYTES, 4 * _color.size() * sizeof(GLfloat));
+
+    return GL_TRUE;
+}
+
+GLboolean TriangulatedMesh3::SetColors(const vector<Color4> &colors)
+{
+    if (colors.size() != VertexCount())
+        return GL_FALSE;
+
+    _color = colors;
+
+    // the buffer object is created only if the geometry has already been uploaded
+    if (_vbo_vertices)
+        return _UpdateColorBufferObject();
+
+    return GL_TRUE;
+}
+
+GLvoid TriangulatedMesh3::RemoveColors()
+{
+    _color.clear();
+
+    if (_vbo_colors)
+    {
+        glDeleteBuffers(1, &_vbo_colors);
+        _vbo_colors = 0;
+    }
+}
+
+GLboolean TriangulatedMesh3::HasColors() const
+{
+    return !_color.empty();
+}
+
 GLboolean TriangulatedMesh3::LoadFromOFF(
         const string &file_name, GLboolean translate_and_scale_to_unit_cube)
 {
+    CAGD_PROFILE_ZONE("TriangulatedMesh3::LoadFromOFF");
+
     fstream f(file_name.c_str(), ios_base::in);
 
     if (!f || !f.good())
@@ -267,10 +433,15 @@ GLboolean TriangulatedMesh3::LoadFromOFF(
     f >> vertex_count >> face_count >> edge_count;
 
     // allocating memory for vertices, unit normal vectors, texture coordinates, and faces
+    _compact = GL_FALSE;
+    _compact_vertex.clear();
+    _compact_normal.clear();
+
     _vertex.resize(vertex_count);
     _normal.resize(vertex_count);
     _tex.resize(vertex_count);
     _face.resize(face_count);
+    _color.clear();
 
     // initializing the leftmost and rightmost corners of the bounding box
     _leftmost_vertex.x() = _leftmost_vertex.y() = _leftmost_vertex.z() = numeric_limits<GLdouble>::max();
@@ -306,34 +477,52 @@ GLboolean TriangulatedMesh3::LoadFromOFF(
         DCoordinate3 middle(_leftmost_vertex);
         middle += _rightmost_vertex;
         middle *= 0.5;
-        for (vector<DCoordinate3>::iterator vit = _vertex.begin(); vit != _vertex.end(); ++vit)
+
+        TaskScheduler::Instance().ParallelFor(0, (GLint)vertex_count, [&](GLint chunk_begin, GLint chunk_end)
         {
-            *vit -= middle;
-            *vit *= scale;
-        }
+            for (GLint i = chunk_begin; i < chunk_end; ++i)
+            {
+                _vertex[i] -= middle;
+                _vertex[i] *= scale;
+            }
+        });
     }
 
     // loading faces
     for (vector<TriangularFace>::iterator fit = _face.begin(); fit != _face.end(); ++fit)
         f >> *fit;
 
-    // calculating average unit normal vectors associated with vertices
-    for (vector<TriangularFace>::const_iterator fit = _face.begin(); fit != _face.end(); ++fit)
+    // calculating average unit normal vectors associated with vertices: the face normals are
+    // determined in parallel, but they are summed up in the order of the faces
+    vector<DCoordinate3> face_normal(face_count);
+
+    TaskScheduler::Instance().ParallelFor(0, (GLint)face_count, [&](GLint chunk_begin, GLint chunk_end)
     {
-        DCoordinate3 n = _vertex[(*fit)[1]];
-        n -= _vertex[(*fit)[0]];
+        for (GLint i = chunk_begin; i < chunk_end; ++i)
+        {
+            const TriangularFace &face = _face[i];
+
+            DCoordinate3 n = _vertex[face[1]];
+            n -= _vertex[face[0]];
+
+            DCoordinate3 p = _vertex[face[2]];
+            p -= _vertex[face[0]];
 
-        DCoordinate3 p = _vertex[(*fit)[2]];
-        p -= _vertex[(*fit)[0]];
+            n ^= p;
 
-        n ^= p;
+            face_normal[i] = n;
+        }
+    });
 
+    for (GLuint i = 0; i < face_count; ++i)
         for (GLint node = 0; node < 3; ++node)
-            _normal[(*fit)[node]] += n;
-    }
+            _normal[_face[i][node]] += face_normal[i];
 
-    for (vector<DCoordinate3>::iterator nit = _normal.begin(); nit != _normal.end(); ++nit)
-        nit->normalize();
+    TaskScheduler::Instance().ParallelFor(0, (GLint)vertex_count, [&](GLint chunk_begin, GLint chunk_end)
+    {
+        for (GLint i = chunk_begin; i < chunk_end; ++i)
+            _normal[i].normalize();
+    });
 
     f.close();
 
@@ -398,9 +587,184 @@ GLvoid TriangulatedMesh3::UnmapTextureBuffer() const
 }
 
 
+GLboolean TriangulatedMesh3::EnableStreaming(GLuint segment_count)
+{
+    if (!VertexCount() || !segment_count)
+        return GL_FALSE;
+
+    DisableStreaming();
+
+    _stream = new (nothrow) StreamingBuffer(GL_ARRAY_BUFFER);
+
+    if (!_stream)
+        return GL_FALSE;
+
+    // vertices and normals are stored next to each other in every segment
+    if (!_stream->Create(6 * VertexCount() * sizeof(GLfloat), segment_count))
+    {
+        DisableStreaming();
+        return GL_FALSE;
+    }
+
+    return GL_TRUE;
+}
+
+GLvoid TriangulatedMesh3::DisableStreaming()
+{
+    if (_stream)
+    {
+        delete _stream;
+        _stream = 0;
+    }
+}
+
+GLboolean TriangulatedMesh3::IsStreaming() const
+{
+    return _stream != 0;
+}
+
+GLboolean TriangulatedMesh3::BeginStreamingUpdate(GLfloat* &vertex, GLfloat* &normal)
+{
+    vertex = normal = 0;
+
+    if (!_stream)
+        return GL_FALSE;
+
+    vertex = (GLfloat*)_stream->MapNextSegment();
+
+    if (!vertex)
+        return GL_FALSE;
+
+    normal = vertex + 3 * VertexCount();
+
+    return GL_TRUE;
+}
+
+GLboolean TriangulatedMesh3::EndStreamingUpdate()
+{
+    if (!_stream)
+        return GL_FALSE;
+
+    return _stream->UnmapSegment();
+}
+
+GLboolean TriangulatedMesh3::StreamDisplacementAlongNormals(GLdouble displacement)
+{
+    GLfloat *vertex = 0, *normal = 0;
+
+    if (!BeginStreamingUpdate(vertex, normal))
+        return GL_FALSE;
+
+    // the mapped memory is write-only, therefore every value is computed from the CPU-side geometry
+    if (_compact)
+    {
+        for (GLuint i = 0; i < (GLuint)_compact_vertex.size(); ++i)
+        {
+            vertex[i] = (GLfloat)(_compact_vertex[i] + displacement * _compact_normal[i]);
+            normal[i] = _compact_normal[i];
+        }
+    }
+    else
+    {
+        for (vector<DCoordinate3>::const_iterator
+             vit = _vertex.begin(),
+             nit = _normal.begin(); vit != _vertex.end(); ++vit, ++nit)
+        {
+            for (GLint component = 0; component < 3; ++component)
+            {
+                *vertex = (GLfloat)((*vit)[component] + displacement * (*nit)[component]);
+                ++vertex;
+
+                *normal = (GLfloat)(*nit)[component];
+                ++normal;
+            }
+        }
+    }
+
+    return EndStreamingUpdate();
+}
+
+GLvoid TriangulatedMesh3::Compact()
+{
+    if (_compact)
+        return;
+
+    GLint vertex_count = (GLint)_vertex.size();
+
+    _compact_vertex.resize(3 * vertex_count);
+    _compact_normal.resize(3 * vertex_count);
+
+    TaskScheduler::Instance().ParallelFor(0, vertex_count, [&](GLint chunk_begin, GLint chunk_end)
+    {
+        for (GLint i = chunk_begin; i < chunk_end; ++i)
+        {
+            for (GLint component = 0; component < 3; ++component)
+            {
+                _compact_vertex[3 * i + component] = (GLfloat)_vertex[i][component];
+                _compact_normal[3 * i + component] = (GLfloat)_normal[i][component];
+            }
+        }
+    });
+
+    // clear() would keep the capacities
+    vector<DCoordinate3>().swap(_vertex);
+    vector<DCoordinate3>().swap(_normal);
+
+    _compact = GL_TRUE;
+}
+
+GLvoid TriangulatedMesh3::Expand()
+{
+    if (!_compact)
+        return;
+
+    GLint vertex_count = (GLint)VertexCount();
+
+    _vertex.resize(vertex_count);
+    _normal.resize(vertex_count);
+
+    TaskScheduler::Instance().ParallelFor(0, vertex_count, [&](GLint chunk_begin, GLint chunk_end)
+    {
+        for (GLint i = chunk_begin; i < chunk_end; ++i)
+        {
+            for (GLint component = 0; component < 3; ++component)
+            {
+                _vertex[i][component] = _compact_vertex[3 * i + component];
+                _normal[i][component] = _compact_normal[3 * i + component];
+            }
+        }
+    });
+
+    vector<GLfloat>().swap(_compact_vertex);
+    vector<GLfloat>().swap(_compact_normal);
+
+    _compact = GL_FALSE;
+}
+
+GLboolean TriangulatedMesh3::IsCompact() const
+{
+    return _compact;
+}
+
+DCoordinate3 TriangulatedMesh3::Vertex(GLuint index) const
+{
+    if (_compact)
+        return DCoordinate3(_compact_vertex[3 * index], _compact_vertex[3 * index + 1], _compact_vertex[3 * index + 2]);
+
+    return _vertex[index];
+}
+
+DCoordinate3 TriangulatedMesh3::Normal(GLuint index) const
+{
+    if (_compact)
+        return DCoordinate3(_compact_normal[3 * index], _compact_normal[3 * index + 1], _compact_normal[3 * index + 2]);
+
+    return _normal[index];
+}
+
 GLuint TriangulatedMesh3::VertexCount() const // homework
 {
-    return _vertex.size();
+    return _compact ? (GLuint)_compact_vertex.size() / 3 : (GLuint)_vertex.size();
 }
 
 GLuint TriangulatedMesh3::FaceCount() const   // homework
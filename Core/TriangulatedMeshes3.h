@@ -1,9 +1,11 @@
 #pragma once
 
+#include "Colors4.h"
 #include "DCoordinates3.h"
 #include <GL/glew.h>
 #include <iostream>
 #include <string>
+#include "StreamingBuffers.h"
 #include "TriangularFaces.h"
 #include "TCoordinates4.h"
 #include <vector>
@@ -14,6 +16,14 @@ namespace cagd
     {
         friend class ParametricSurface3;
         friend class TensorProductSurface3;
+        friend class RenderBatch;
+        friend class BSplineSurface3;
+        friend class BoundingVolumeHierarchy3;
+        friend class CurvatureAnalysis3;
+        friend class SurfaceIntersection3;
+        friend class PatchQuilt3;
+        friend class PatchQuiltWriter;
+        friend class StreamingOFFConverter;
 
         // homework: output to stream:
         // vertex count, face count
@@ -33,6 +43,11 @@ namespace cagd
         GLuint                      _vbo_normals;
         GLuint                      _vbo_tex_coordinates;
         GLuint                      _vbo_indices;
+        GLuint                      _vbo_colors;
+
+        // ring of persistently mapped (or orphaned) segments that store deformed vertices
+        // followed by their normals, it is 0 unless streaming has been enabled
+        StreamingBuffer             *_stream;
 
         // corners of bounding box
         DCoordinate3                 _leftmost_vertex;
@@ -44,6 +59,17 @@ namespace cagd
         std::vector<TCoordinate4>    _tex;
         std::vector<TriangularFace>  _face;
 
+        // optional per vertex colors, e.g. color maps of curvatures, empty by default
+        std::vector<Color4>          _color;
+
+        // single precision storage of compacted meshes: 3 floats per vertex and normal, packed as
+        // expected by the vertex buffer objects; if _compact is set, _vertex and _normal are empty
+        GLboolean                    _compact;
+        std::vector<GLfloat>         _compact_vertex;
+        std::vector<GLfloat>         _compact_normal;
+
+        GLboolean _UpdateColorBufferObject();
+
     public:
         // special and default constructor
         TriangulatedMesh3(GLuint vertex_count = 0, GLuint face_count = 0, GLenum usage_flag = GL_STATIC_DRAW);
@@ -80,10 +106,44 @@ namespace cagd
         GLvoid UnmapNormalBuffer() const;   // homework
         GLvoid UnmapTextureBuffer() const;  // homework
 
+        // streaming of dynamically deformed geometry: once enabled, Render() sources vertices and
+        // normals from the most recently written ring segment, while texture coordinates and
+        // indices remain in the static vertex buffer objects
+        GLboolean EnableStreaming(GLuint segment_count = 3);
+        GLvoid    DisableStreaming();
+        GLboolean IsStreaming() const;
+
+        // returns write-only pointers to the 3 * VertexCount() vertex and normal coordinates of the
+        // next free segment, the previous content of the segment is undefined
+        GLboolean BeginStreamingUpdate(GLfloat* &vertex, GLfloat* &normal);
+        GLboolean EndStreamingUpdate();
+
+        // streams the CPU-side geometry offset along the unit normal vectors by the given distance
+        GLboolean StreamDisplacementAlongNormals(GLdouble displacement);
+
+        // per vertex colors: if the mesh has them, Render() sources the current color from a color
+        // array, thus they appear as the ambient and diffuse reflectances whenever GL_COLOR_MATERIAL is
+        // enabled; the count of colors has to be equal to VertexCount()
+        GLboolean SetColors(const std::vector<Color4> &colors);
+        GLvoid    RemoveColors();
+        GLboolean HasColors() const;
+
+        // single precision storage: Compact() converts the vertices and unit normal vectors to
+        // floats and releases their double precision arrays, which roughly halves the memory of the
+        // mesh, and UpdateVertexBufferObjects() uploads the packed arrays as they are; Expand()
+        // restores the double precision arrays required by geometric computations (e.g. curvature
+        // analyses and intersections), the bits dropped by Compact() are not recovered
+        GLvoid    Compact();
+        GLvoid    Expand();
+        GLboolean IsCompact() const;
+
+        // per vertex access independent of the storage precision
+        DCoordinate3 Vertex(GLuint index) const;
+        DCoordinate3 Normal(GLuint index) const;
+
         // get properties of geometry
         GLuint VertexCount() const; // homework
         GLuint FaceCount() const;   // homework
-
         // destructor
         virtual ~TriangulatedMesh3();
     };
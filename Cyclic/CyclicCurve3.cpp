@@ -14,9 +14,48 @@ namespace cagd
         LinearCombination3(0.0, TWO_PI, 2 * n + 1, data_usage_flag),
         _n(n),
         _c_n(_CalcuateNormalizingCoefficients(n)),
-        _lambda_n(TWO_PI / (2 * n +1))
+        _lambda_n(TWO_PI / (2 * n +1)),
+        _cache_is_valid(GL_FALSE)
     {
         _CalculateBinomialCoefficients(2*_n, _bc);
+
+        _weight.ResizeColumns(_n + 1);
+        _weight[0] = 0.0;
+
+        for (GLuint j = 1; j <= _n; ++j)
+        {
+            _weight[j] = 2.0 * _bc(2 * _n, _n - j) / ((2 * _n + 1) * _bc(2 * _n, _n));
+        }
+    }
+
+    CyclicCurve3::CyclicCurve3(const CyclicCurve3& curve):
+        LinearCombination3(curve),
+        _n(curve._n),
+        _c_n(curve._c_n),
+        _lambda_n(curve._lambda_n),
+        _bc(curve._bc),
+        _weight(curve._weight),
+        _cache_is_valid(GL_FALSE)
+    {
+    }
+
+    CyclicCurve3& CyclicCurve3::operator =(const CyclicCurve3& rhs)
+    {
+        if (this != &rhs)
+        {
+            LinearCombination3::operator =(rhs);
+
+            _n = rhs._n;
+            _c_n = rhs._c_n;
+            _lambda_n = rhs._lambda_n;
+            _bc = rhs._bc;
+            _weight = rhs._weight;
+
+            lock_guard<mutex> lock(_cache_mutex);
+            _cache_is_valid = GL_FALSE;
+        }
+
+        return *this;
     }
 
     GLdouble CyclicCurve3::_CalcuateNormalizingCoefficients(GLuint n)
@@ -55,13 +94,89 @@ namespace cagd
         }
     }
 
+    GLvoid CyclicCurve3::_UpdateCacheIfNeeded() const
+    {
+        GLuint data_count = 2 * _n + 1;
+
+        // the control points can be modified through references, thus they are compared
+        // with the ones that the cached sums were computed from
+        if (_cache_is_valid)
+        {
+            GLuint i = 0;
+
+            while (i < data_count &&
+                   _cached_data[i][0] == _data[i][0] &&
+                   _cached_data[i][1] == _data[i][1] &&
+                   _cached_data[i][2] == _data[i][2])
+            {
+                ++i;
+            }
+
+            if (i == data_count)
+            {
+                return;
+            }
+        }
+
+        _cached_data = _data;
+
+        _centroid = DCoordinate3();
+        for (GLuint i = 0; i < data_count; ++i)
+        {
+            _centroid += _data[i];
+        }
+        _centroid /= (GLdouble)data_count;
+
+        _cosine_sum.ResizeColumns(_n + 1);
+        _sine_sum.ResizeColumns(_n + 1);
+
+        for (GLuint j = 1; j <= _n; ++j)
+        {
+            // cos(j * i * lambda) and sin(j * i * lambda) are generated by successive rotations
+            GLdouble cos_step = cos(j * _lambda_n), sin_step = sin(j * _lambda_n);
+            GLdouble c = 1.0, s = 0.0;
+
+            DCoordinate3 cosine_sum, sine_sum;
+
+            for (GLuint i = 0; i < data_count; ++i)
+            {
+                cosine_sum += c * _data[i];
+                sine_sum   += s * _data[i];
+
+                GLdouble next_c = c * cos_step - s * sin_step;
+                s = s * cos_step + c * sin_step;
+                c = next_c;
+            }
+
+            _cosine_sum[j] = _weight[j] * cosine_sum;
+            _sine_sum[j]   = _weight[j] * sine_sum;
+        }
+
+        _cache_is_valid = GL_TRUE;
+    }
+
     GLboolean CyclicCurve3::BlendingFunctionValues(GLdouble u, RowMatrix<GLdouble>& values) const
     {
-        values.ResizeRows(2 * _n + 1);
+        values.ResizeColumns(2 * _n + 1);
+
+        // cos(u - i * lambda) is generated by successive rotations with -lambda
+        GLdouble cos_step = cos(_lambda_n), sin_step = sin(_lambda_n);
+        GLdouble c = cos(u), s = sin(u);
 
         for (GLuint i = 0; i < 2 * _n + 1; ++i)
         {
-            values[i] = _c_n * pow(1.0 + cos(u - i * _lambda_n), (GLint)_n );
+            GLdouble base = 1.0 + c, power = 1.0;
+
+            for (GLuint k = 0; k < _n; ++k)
+            {
+                power *= base;
+            }
+
+            values[i] = _c_n * power;
+
+            GLdouble next_c = c * cos_step + s * sin_step;
+            s = s * cos_step - c * sin_step;
+            c = next_c;
         }
 
         return GL_TRUE;
@@ -72,33 +187,37 @@ namespace cagd
         d.ResizeRows( max_order_of_derivatives + 1 );
         d.LoadNullVectors();
 
-        DCoordinate3 centroid;
+        lock_guard<mutex> lock(_cache_mutex);
 
-        for ( GLuint i = 0; i <= 2 * _n; ++i)
-        {
-            centroid += _data[i];
-        }
-        centroid /= (GLdouble)(2 * _n + 1);
+        _UpdateCacheIfNeeded();
 
-        for ( GLuint r = 0; r <= max_order_of_derivatives; ++r )
+        // (cos(j * u), sin(j * u)) is generated by successive rotations with u
+        GLdouble cos_u = cos(u), sin_u = sin(u);
+        GLdouble c = 1.0, s = 0.0;
+
+        for (GLuint j = 1; j <= _n; ++j)
         {
-            for (GLuint i = 0; i <= 2 * _n; ++i)
+            GLdouble next_c = c * cos_u - s * sin_u;
+            s = s * cos_u + c * sin_u;
+            c = next_c;
+
+            // the phase shift r * PI / 2 of the r-th derivative is a rotation by a right angle,
+            // while j^r is accumulated order by order
+            GLdouble x = c, y = s, power = 1.0;
+
+            for (GLuint r = 0; r <= max_order_of_derivatives; ++r)
             {
-                GLdouble sum_k = 0.0;
+                d[r] += power * (x * _cosine_sum[j] + y * _sine_sum[j]);
 
-                for (GLuint k = 0; k <= _n -1; ++k)
-                {
-                    sum_k += pow(_n - k, (GLint)r) * _bc(2 * _n, k) * cos((_n - k) * (u - i * _lambda_n) + r * PI / 2.0);
-                }
+                GLdouble next_x = -y;
+                y = x;
+                x = next_x;
 
-                d[r] += sum_k * _data[i];
+                power *= j;
             }
-            d[r] *= 2.0;
-            d[r] /= (GLdouble)(2 * _n + 1);
-            d[r] /= _bc(2 * _n, _n);
         }
 
-        d[0] += centroid;
+        d[0] += _centroid;
 
         return GL_TRUE;
     }
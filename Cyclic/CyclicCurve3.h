@@ -6,6 +6,8 @@
 #include "../Core/LinearCombination3.h"
 #include "../Core/Matrices.h"
 
+#include <mutex>
+
 namespace cagd
 {
     class CyclicCurve3: public LinearCombination3
@@ -17,14 +19,43 @@ namespace cagd
 
         TriangularMatrix<GLdouble>  _bc;        // binomial coefficients
 
+        // _weight[j] = 2 * bc(2n, n - j) / ((2n + 1) * bc(2n, n)), j = 1, ..., n
+        RowMatrix<GLdouble>         _weight;
+
+        // Derivatives are evaluated from the trigonometric (Fourier) form of the curve
+        //
+        //   c^(r)(u) = delta_{r,0} * centroid + sum_{j=1}^{n} j^r * cos(j * u + r * PI / 2) * _cosine_sum[j]
+        //                                     + sum_{j=1}^{n} j^r * sin(j * u + r * PI / 2) * _sine_sum[j],
+        //
+        // where _cosine_sum[j] = _weight[j] * sum_{i=0}^{2n} _data[i] * cos(j * i * _lambda_n) and
+        // _sine_sum[j] = _weight[j] * sum_{i=0}^{2n} _data[i] * sin(j * i * _lambda_n) depend only on
+        // the control points. These sums are cached and rebuilt whenever the control points differ
+        // from the ones they were computed from, thus a sample costs O(n) operations per derivative
+        // order and only one cos/sin pair, the remaining multiple angles are obtained by rotation.
+        mutable std::mutex                  _cache_mutex;
+        mutable GLboolean                   _cache_is_valid;
+        mutable ColumnMatrix<DCoordinate3>  _cached_data;
+        mutable DCoordinate3                _centroid;
+        mutable RowMatrix<DCoordinate3>     _cosine_sum;
+        mutable RowMatrix<DCoordinate3>     _sine_sum;
+
         GLdouble    _CalcuateNormalizingCoefficients(GLuint n);
 
         GLvoid      _CalculateBinomialCoefficients(GLuint m, TriangularMatrix<GLdouble> &bc);
 
+        // has to be called while _cache_mutex is locked
+        GLvoid      _UpdateCacheIfNeeded() const;
+
     public:
         // special constructor
         CyclicCurve3(GLuint n, GLenum data_usage_flag = GL_STATIC_DRAW);
 
+        // copy constructor
+        CyclicCurve3(const CyclicCurve3& curve);
+
+        // assignment operator
+        CyclicCurve3& operator =(const CyclicCurve3& rhs);
+
         // redeclare and define inherited pure virtual methods
         GLboolean BlendingFunctionValues(GLdouble u, RowMatrix<GLdouble>& values) const;
 
@@ -1,6 +1,11 @@
 #include "GLWidget.h"
 #include <iostream>
 #include <GL/glu.h>
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QMouseEvent>
 #include <Core/Exceptions.h>
 
 #include "../Core/Constants.h"
@@ -8,6 +13,10 @@
 #include "../Test/TestFunctions.h"
 #include "../Core/Lights.h"
 #include "../Core/Materials.h"
+#include "../Core/Profilers.h"
+#include "../Core/RenderStates.h"
+#include "../Core/TaskSchedulers.h"
+#include <algorithm>
 #include <fstream>
 
 using namespace std;
@@ -22,9 +31,64 @@ namespace cagd
         _timer->setInterval(0);
 
         _angle = 0.0;
+
+        // saving a file usually results in several notifications, these are coalesced into a
+        // single reload that runs from the event loop, i.e., never during paintGL()
+        _shader_watcher = new QFileSystemWatcher(this);
+        _shader_reload_timer = new QTimer(this);
+        _shader_reload_timer->setSingleShot(true);
+        _shader_reload_timer->setInterval(100);
+
+        connect(_shader_watcher, SIGNAL(fileChanged(QString)), this, SLOT(_shader_source_changed(QString)));
+        connect(_shader_reload_timer, SIGNAL(timeout()), this, SLOT(reload_shaders()));
+
+        // the programs are only registered here, they are built by init_shaders() once the
+        // rendering context exists; the indices of the first four programs coincide with the
+        // shader indices of the side widget
+        _shader_manager.Register("Shaders/directional_light.vert", "Shaders/directional_light.frag");
+        _shader_manager.Register("Shaders/two_sided_lighting.vert", "Shaders/two_sided_lighting.frag");
+        _shader_manager.Register("Shaders/toon.vert", "Shaders/toon.frag");
+        _shader_manager.Register("Shaders/reflection_lines.vert", "Shaders/reflection_lines.frag");
+
+        GLuint displacement = _shader_manager.Register("Shaders/displacement.vert", "Shaders/two_sided_lighting.frag");
+
+        _displacement_shader = &_shader_manager[displacement];
+
+        _shader_index = 1;
+        _shader = &_shader_manager[_shader_index];
+
+        // the results of background tessellations are uploaded by the next repaint
+        _tessellation.SetCompletionHandler([this]() { QMetaObject::invokeMethod(this, "updateGL", Qt::QueuedConnection); });
+        _batch_refresh_timer.start();
+
+        // the profiler is enabled by main() when the overlay or a trace is requested; the render
+        // passes are timed if the overlay or one of the CSV files of the frame times is requested
+        QStringList arguments = QCoreApplication::arguments();
+
+        _profiler_overlay = arguments.contains("--profile");
+
+        int frame_times_index = arguments.indexOf("--frame-times");
+        if (frame_times_index >= 0 && frame_times_index + 1 < arguments.size())
+            _frame_times_file_name = arguments[frame_times_index + 1];
+
+        int frame_histogram_index = arguments.indexOf("--frame-histogram");
+        if (frame_histogram_index >= 0 && frame_histogram_index + 1 < arguments.size())
+            _frame_histogram_file_name = arguments[frame_histogram_index + 1];
     }
 
     GLWidget::~GLWidget() {
+        if (!_frame_times_file_name.isEmpty() &&
+            !_render_passes.ExportFramesCSV(_frame_times_file_name.toStdString()))
+            cout << "Could not write the frame times " << _frame_times_file_name.toStdString() << endl;
+
+        if (!_frame_histogram_file_name.isEmpty() &&
+            !_render_passes.ExportHistogramCSV(_frame_histogram_file_name.toStdString()))
+            cout << "Could not write the frame histogram " << _frame_histogram_file_name.toStdString() << endl;
+
+        // running jobs are finished by the destructor of the queue, their results are discarded
+        _tessellation.SetCompletionHandler(std::function<GLvoid()>());
+        _tessellation.CancelAll();
+
         for (GLuint i = 0; i < _num_of_pc; i++)
             if (_pc[i])
                 delete _pc[i], _pc[i] = 0;
@@ -53,6 +117,15 @@ namespace cagd
             if (_image_of_mo[i])
                 delete _image_of_mo[i], _image_of_mo[i] = 0;
 
+        for (GLuint i = 0; i < _num_of_mo; i++)
+            if (_slices_of_mo[i])
+            {
+                for (GLuint k = 0; k < _slices_of_mo[i]->GetColumnCount(); k++)
+                    delete (*_slices_of_mo[i])[k];
+
+                delete _slices_of_mo[i], _slices_of_mo[i] = 0;
+            }
+
 
 
         if (_before_interpolation)
@@ -60,6 +133,9 @@ namespace cagd
 
         if (_after_interpolation)
             delete _after_interpolation, _after_interpolation = 0;
+
+        if (_light)
+            delete _light, _light = 0;
     }
 
     //--------------------------------------------------------------------------------------
@@ -116,17 +192,37 @@ namespace cagd
                                 "Try to update your driver or buy a new graphics adapter!");
             }
 
+            // the rendering context is new, nothing is known about its fixed-function state
+            RenderState::Invalidate();
+
+            if (_profiler_overlay || !_frame_times_file_name.isEmpty() || !_frame_histogram_file_name.isEmpty())
+            {
+                _render_passes.SetEnabled(GL_TRUE);
+
+                if (!_render_passes.IsGPUTimingSupported())
+                    cout << "Timer queries are not supported, only the CPU times of the render passes are measured" << endl;
+            }
+
+            // a single directional light is shared by every page
+            HCoordinate3 direction(0.0, 0.0, 1.0, 0.0);
+            Color4 ambient(0.4, 0.4, 0.4, 1.0);
+            Color4 diffuse(0.8, 0.8, 0.8, 1.0);
+            Color4 specular(1.0, 1.0, 1.0, 1.0);
+
+            _light = new DirectionalLight(GL_LIGHT0, direction, ambient, diffuse, specular);
+            _light_set.Insert(_light);
+
             // create and store your geometry in display lists or vertex buffer objects
             _index = 0;
             _page_index = 0;
             // knim1445
+            init_shaders();
             init_parametric_curves();
             init_cyclic_curves();
             init_parametric_surfaces();
             init_models();
             init_bspline_arc();
             init_patch();
-            set_shader_index(1);
         }
         catch (Exception &e)
         {
@@ -145,6 +241,15 @@ namespace cagd
         glEnable(GL_DEPTH_TEST);
 
         glewInit();     
+
+        if (QCoreApplication::arguments().contains("--benchmark-animation"))
+            QTimer::singleShot(0, this, SLOT(benchmark_animation()));
+
+        if (QCoreApplication::arguments().contains("--benchmark-curvature"))
+            QTimer::singleShot(0, this, SLOT(benchmark_curvature()));
+
+        if (QCoreApplication::arguments().contains("--benchmark-intersections"))
+            QTimer::singleShot(0, this, SLOT(benchmark_intersections()));
     }
 
     //-----------------------
@@ -152,6 +257,33 @@ namespace cagd
     //-----------------------
     void GLWidget::paintGL()
     {
+        Profiler &profiler = Profiler::Instance();
+
+        profiler.BeginFrame();
+        _render_passes.BeginFrame();
+
+        {
+            CAGD_PROFILE_ZONE("GLWidget::paintGL");
+
+            _render_frame();
+        }
+
+        profiler.EndFrame();
+        _render_passes.EndFrame();
+
+        // the overlay is not part of the measured frame
+        if (_profiler_overlay)
+            _render_profiler_overlay();
+    }
+
+    void GLWidget::_render_frame()
+    {
+        // every pass lasts until the next one begins
+        _render_passes.BeginPass("upload");
+        _receive_tessellations();
+
+        _render_passes.BeginPass("clear");
+
         // clears the color and depth buffers
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
@@ -159,43 +291,136 @@ namespace cagd
         glPushMatrix();
 
             // applying transformations
-            glRotatef(_angle_x, 1.0, 0.0, 0.0);
-            glRotatef(_angle_y, 0.0, 1.0, 0.0);
-            glRotatef(_angle_z, 0.0, 0.0, 1.0);
-            glTranslated(_trans_x, _trans_y, _trans_z);
-            glScaled(_zoom, _zoom, _zoom);
+            _apply_transformations();
 
             switch (_page_index) {
             case 1:
-                _shader.Disable();
+                _shader->Disable();
+                _render_passes.BeginPass("render_pc");
                 render_pc();
                 break;
             case 2:
-                _shader.Disable();
+                _shader->Disable();
+                _render_passes.BeginPass("render_cc");
                 render_cc();
                 break;
             case 3:
+                _render_passes.BeginPass("render_mo");
                 render_mo();
                 break;
             case 4:
-                _shader.Disable();
+                _shader->Disable();
+                _render_passes.BeginPass("render_ps");
                 render_ps();
                 break;
             case 6:
-                //_shader.Disable();
+                //_shader->Disable();
+                _render_passes.BeginPass("render_patch");
                 render_patch();
                 break;
             default:
                 //render_patch();
+                _render_passes.BeginPass("render_bspline_arc");
                 render_bspline_arc();
                 break;
             }
 
+            _render_passes.BeginPass("markers");
+
+            // marker of the last picked surface point
+            if (_picked_hierarchy && _picked_hierarchy == _displayed_hierarchy())
+            {
+                _shader->Disable();
+                _light_set.Disable();
+
+                glPointSize(8.0f);
+                glColor3f(1.0f, 1.0f, 0.0f);
+                glBegin(GL_POINTS);
+                    glVertex3d(_picked_point.x(), _picked_point.y(), _picked_point.z());
+                glEnd();
+                glPointSize(1.0f);
+            }
+
+            // marker of the selected control point
+            if (_selected_index && _selected_index == _displayed_control_points())
+            {
+                const DCoordinate3 &point = _selected_index->GetPoint(_selected_control_point);
+
+                _shader->Disable();
+                _light_set.Disable();
+
+                glPointSize(12.0f);
+                glColor3f(0.0f, 1.0f, 1.0f);
+                glBegin(GL_POINTS);
+                    glVertex3d(point.x(), point.y(), point.z());
+                glEnd();
+                glPointSize(1.0f);
+                glColor3f(1.0f, 1.0f, 1.0f);
+            }
+
+            _render_passes.EndPass();
+
         // pops the current matrix stack, replacing the current matrix with the one below it on the stack,
         // i.e., the original model view matrix is restored
         glPopMatrix();
     }
 
+    // the durations and counters of the last frame, and the zones finished since the previous one
+    void GLWidget::_render_profiler_overlay()
+    {
+        const Profiler::FrameStatistics &frame = Profiler::Instance().GetLastFrame();
+
+        _shader->Disable();
+        _light_set.Disable();
+        glDisable(GL_DEPTH_TEST);
+        glColor3f(1.0f, 1.0f, 0.0f);
+
+        int y = 20;
+
+        renderText(10, y, QString("frame: %1 ms").arg(frame.duration, 0, 'f', 2));
+
+        for (GLuint i = 0; i < Profiler::COUNTER_COUNT; ++i)
+        {
+            y += 16;
+            renderText(10, y, QString("%1: %2").arg(Profiler::CounterName((Profiler::Counter)i))
+                                               .arg(frame.counter[i]));
+        }
+
+        y += 8;
+
+        for (GLuint i = 0; i < frame.zones.size() && i < 16; ++i)
+        {
+            y += 16;
+            renderText(10, y, QString("%1 ms  %2").arg(frame.zones[i].second, 8, 'f', 3)
+                                                  .arg(QString(frame.zones[i].first)));
+        }
+
+        // the GPU times lag behind by a few frames
+        const vector<RenderPassProfiler::PassStatistics> &passes = _render_passes.GetPasses();
+
+        y += 8;
+
+        for (GLuint i = 0; i < passes.size(); ++i)
+        {
+            const RenderPassProfiler::PassStatistics &pass = passes[i];
+
+            y += 16;
+            renderText(10, y, QString("%1: GPU %2 ms, CPU %3 ms, %4 draw calls, %5 triangles, %6 state changes")
+                                      .arg(QString::fromStdString(pass.name))
+                                      .arg(pass.gpu_time, 0, 'f', 3)
+                                      .arg(pass.cpu_time, 0, 'f', 3)
+                                      .arg(pass.draw_calls)
+                                      .arg(pass.triangles)
+                                      .arg(pass.state_changes));
+        }
+
+        glColor3f(1.0f, 1.0f, 1.0f);
+        glEnable(GL_DEPTH_TEST);
+
+        // the text is painted by Qt, which does not restore every fixed-function state
+        RenderState::Invalidate();
+    }
+
     //----------------------------------------------------------------------------
     // when the main window is resized one needs to redefine the projection matrix
     //----------------------------------------------------------------------------
@@ -219,6 +444,164 @@ namespace cagd
         updateGL();
     }
 
+    void GLWidget::_apply_transformations()
+    {
+        glRotatef(_angle_x, 1.0, 0.0, 0.0);
+        glRotatef(_angle_y, 0.0, 1.0, 0.0);
+        glRotatef(_angle_z, 0.0, 0.0, 1.0);
+        glTranslated(_trans_x, _trans_y, _trans_z);
+        glScaled(_zoom, _zoom, _zoom);
+    }
+
+    // hierarchy of the surfaces shown on the current page, or 0 if nothing can be picked there
+    BoundingVolumeHierarchy3* GLWidget::_displayed_hierarchy()
+    {
+        switch (_page_index) {
+        case 3:
+            return &_bvh_of_mo[_mo_index];
+        case 4:
+            return &_bvh_of_ps[_ps_index];
+        case 6:
+            switch (_patch_index) {
+            case 1:
+                return &_bvh_toroid;
+            case 2:
+                return &_bvh_cylindric;
+            case 4:
+                return &_bvh_loaded;
+            default:
+                return 0;
+            }
+        default:
+            return 0;
+        }
+    }
+
+    // index of the control net shown on the current page, or 0 if nothing can be edited there
+    ControlPointIndex3* GLWidget::_displayed_control_points()
+    {
+        if (_page_index != 6)
+            return 0;
+
+        switch (_patch_index) {
+        case 1:
+            return &_cp_toroid;
+        case 2:
+            return &_cp_cylindric;
+        case 3:
+            return &_cp_arcs;
+        case 4:
+            return &_cp_loaded;
+        default:
+            return 0;
+        }
+    }
+
+    // casts a ray through the clicked pixel, selects the first control point within a few pixels of it,
+    // or, if there is no such point, marks the closest intersection with the displayed surfaces
+    void GLWidget::mousePressEvent(QMouseEvent *event)
+    {
+        BoundingVolumeHierarchy3 *hierarchy = _displayed_hierarchy();
+        ControlPointIndex3 *control_points = _displayed_control_points();
+
+        if (!hierarchy && !control_points)
+            return;
+
+        makeCurrent();
+
+        GLdouble model_view[16], projection[16];
+        GLint    viewport[4];
+
+        glPushMatrix();
+            _apply_transformations();
+            glGetDoublev(GL_MODELVIEW_MATRIX, model_view);
+        glPopMatrix();
+
+        glGetDoublev(GL_PROJECTION_MATRIX, projection);
+        glGetIntegerv(GL_VIEWPORT, viewport);
+
+        GLdouble x = event->x() * devicePixelRatio();
+        GLdouble y = viewport[3] - event->y() * devicePixelRatio() - 1.0;
+
+        DCoordinate3 near_point, far_point;
+
+        gluUnProject(x, y, 0.0, model_view, projection, viewport, &near_point[0], &near_point[1], &near_point[2]);
+        gluUnProject(x, y, 1.0, model_view, projection, viewport, &far_point[0], &far_point[1], &far_point[2]);
+
+        if (control_points && !control_points->IsEmpty())
+        {
+            // the picking radius corresponds to 8 pixels at the depth of the center of the control net
+            DCoordinate3 low, high;
+            control_points->GetBoundingBox(low, high);
+
+            DCoordinate3 center = 0.5 * (low + high);
+            GLdouble     window[3];
+
+            gluProject(center.x(), center.y(), center.z(), model_view, projection, viewport,
+                       &window[0], &window[1], &window[2]);
+
+            DCoordinate3 a, b;
+
+            gluUnProject(x, y, window[2], model_view, projection, viewport, &a[0], &a[1], &a[2]);
+            gluUnProject(x + 8.0 * devicePixelRatio(), y, window[2], model_view, projection, viewport,
+                         &b[0], &b[1], &b[2]);
+
+            GLuint point;
+
+            if (control_points->Pick(near_point, far_point - near_point, (b - a).length(), point))
+            {
+                _selected_index         = control_points;
+                _selected_control_point = point;
+
+                updateGL();
+                return;
+            }
+        }
+
+        if (!hierarchy)
+            return;
+
+        if (hierarchy->IsEmpty())
+        {
+            if (_page_index == 3 && _image_of_mo[_mo_index])
+                hierarchy->Build(*_image_of_mo[_mo_index]);
+            else if (_page_index == 4 && _image_of_ps[_ps_index])
+                hierarchy->Build(*_image_of_ps[_ps_index]);
+            else if (_page_index == 6)
+            {
+                switch (_patch_index) {
+                case 1:
+                    _build_patch_hierarchy(*hierarchy, bi_toroid);
+                    break;
+                case 2:
+                    _build_patch_hierarchy(*hierarchy, bi_cylindric);
+                    break;
+                case 4:
+                    _build_patch_hierarchy(*hierarchy, bi_loaded);
+                    break;
+                default:
+                    break;
+                }
+            }
+        }
+
+        // the model is displaced along its normals by the breathing animation
+        if (_page_index == 3)
+            hierarchy->Refit(_breathing_displacement());
+
+        BoundingVolumeHierarchy3::Hit hit;
+
+        if (hierarchy->IntersectRay(near_point, far_point - near_point, hit, 1.0))
+        {
+            _picked_hierarchy = hierarchy;
+            _picked_point     = hit.point;
+        }
+        else
+            _picked_hierarchy = nullptr;
+
+        updateGL();
+    }
+
     //-----------------------------------
     // implementation of the public slots
     //-----------------------------------
@@ -324,6 +707,7 @@ namespace cagd
             _mo_index = index;
             _page_index = 3;
             _angle = 0.0;
+            _update_model_curvature();
             _timer->start();
             updateGL();
         }
@@ -335,6 +719,39 @@ namespace cagd
         {
             _ps_index = index;
             _page_index = 4;
+            _update_parametric_surface_curvature();
+            updateGL();
+        }
+    }
+
+    void GLWidget::set_parametric_surface_curvature(int quantity)
+    {
+        if (_ps_curvature != quantity)
+        {
+            _ps_curvature = quantity;
+            _page_index = 4;
+            _update_parametric_surface_curvature();
+            updateGL();
+        }
+    }
+
+    void GLWidget::set_models_curvature(int quantity)
+    {
+        if (_mo_curvature != quantity)
+        {
+            _mo_curvature = quantity;
+            _page_index = 3;
+            _update_model_curvature();
+            updateGL();
+        }
+    }
+
+    void GLWidget::set_models_slices(bool value)
+    {
+        if (_mo_slices != (GLboolean)value)
+        {
+            _mo_slices = value;
+            _page_index = 3;
             updateGL();
         }
     }
@@ -342,6 +759,8 @@ namespace cagd
 
     // knim1445
     void GLWidget::init_parametric_curves(){
+        CAGD_PROFILE_ZONE("GLWidget::init_parametric_curves");
+
         _num_of_pc = 6;
         _pc.ResizeColumns(_num_of_pc);
 
@@ -399,6 +818,8 @@ namespace cagd
     }
 
     void GLWidget::render_pc(){
+        CAGD_PROFILE_ZONE("GLWidget::render_pc");
+
         if (_image_of_pc[_index]) {
             glColor3f(1.0,1.0,1.0);
             _image_of_pc[_index]->RenderDerivatives(0, GL_LINE_STRIP);
@@ -418,6 +839,7 @@ namespace cagd
     }
 
     void GLWidget::init_cyclic_curves(){
+        CAGD_PROFILE_ZONE("GLWidget::init_cyclic_curves");
 
         _num_of_cc = 2;
         _cc.ResizeColumns(_num_of_cc);
@@ -475,6 +897,8 @@ namespace cagd
     }
 
     void GLWidget::render_cc(){
+        CAGD_PROFILE_ZONE("GLWidget::render_cc");
+
         if (_cc[_cc_index])
         {
             _cc[_cc_index]->RenderData(GL_LINE_LOOP);
@@ -504,6 +928,8 @@ namespace cagd
     }
 
     void GLWidget::init_parametric_surfaces(){
+        CAGD_PROFILE_ZONE("GLWidget::init_parametric_surfaces");
+
         _num_of_ps = 5;
         _ps.ResizeColumns(_num_of_ps);
 
@@ -535,9 +961,11 @@ namespace cagd
         _ps[4] = new ParametricSurface3(pderivative, sphere::u_min, sphere::u_max,sphere::v_min,sphere::v_max);
 
          _image_of_ps.ResizeColumns(_num_of_ps);
+        _bvh_of_ps.ResizeColumns(_num_of_ps);
+        _curvature_of_ps.ResizeColumns(_num_of_ps);
 
-        GLuint div_point_count = 500;
-        GLuint v_point_count = 500;
+        GLuint div_point_count = _ps_u_div_point_count;
+        GLuint v_point_count = _ps_v_div_point_count;
         GLenum usage_flag = GL_STATIC_DRAW;
 
         for (GLuint i = 0; i < _num_of_ps; i++) {
@@ -558,32 +986,28 @@ namespace cagd
     }
 
     void GLWidget::render_ps(){
-        if (_image_of_ps[_ps_index]) {
-            glEnable(GL_LIGHTING);
-            glEnable(GL_NORMALIZE);
-
-            DirectionalLight *dl = 0;
-            HCoordinate3 direction(0.0, 0.0, 1.0, 0.0);
-            Color4 ambient(0.4, 0.4, 0.4, 1.0);
-            Color4 diffuse(0.8, 0.8, 0.8, 1.0);
-            Color4 specular(1.0, 1.0, 1.0, 1.0);
+        CAGD_PROFILE_ZONE("GLWidget::render_ps");
 
-            dl = new DirectionalLight(GL_LIGHT0,direction,ambient,diffuse,specular);
-            if(dl)
+        if (_image_of_ps[_ps_index]) {
+            if (_image_of_ps[_ps_index]->HasColors())
             {
-                dl->Enable();
-                MatFBRuby.Apply();
-                _image_of_ps[_ps_index]->Render();
-                dl->Disable();
+                _render_colored_mesh(*_image_of_ps[_ps_index]);
+                return;
             }
-            glDisable(GL_LIGHTING);
-            glDisable(GL_NORMALIZE);
+
+            _render_queue.Submit(*_image_of_ps[_ps_index], MatFBRuby, 0, &_light_set);
+            _render_queue.Flush();
         }
     }
 
     void GLWidget::init_models(){
+        CAGD_PROFILE_ZONE("GLWidget::init_models");
+
         _num_of_mo = 3;
         _image_of_mo.ResizeColumns(_num_of_mo);
+        _bvh_of_mo.ResizeColumns(_num_of_mo);
+        _curvature_of_mo.ResizeColumns(_num_of_mo);
+        _slices_of_mo.ResizeColumns(_num_of_mo);
 
         _image_of_mo[0] = new TriangulatedMesh3();
         _image_of_mo[0]->LoadFromOFF("Models/mouse.off",true);
@@ -594,135 +1018,513 @@ namespace cagd
 
         for(GLuint i = 0; i < _num_of_mo; i++)
         {
-            _image_of_mo[i]->UpdateVertexBufferObjects(GL_DYNAMIC_DRAW);
+            // the static buffers are never rewritten, the CPU fallback of the animation
+            // streams into a ring of segments
+            _image_of_mo[i]->UpdateVertexBufferObjects(GL_STATIC_DRAW);
+            _image_of_mo[i]->EnableStreaming();
         }
+
+        if (!_displacement_shader->IsInstalled())
+            cout << "Could not install the displacement shader, models will be animated on the CPU" << endl;
     }
 
     void GLWidget::render_mo(){
+        CAGD_PROFILE_ZONE("GLWidget::render_mo");
+
          if (_image_of_mo[_mo_index]) {
 
-             glEnable(GL_LIGHTING);
-             glEnable(GL_NORMALIZE);
+             if (_mo_slices)
+                 _render_model_slices();
 
-             DirectionalLight *dl = 0;
-             HCoordinate3 direction(0.0, 0.0, 1.0, 0.0);
-             Color4 ambient(0.4, 0.4, 0.4, 1.0);
-             Color4 diffuse(0.8, 0.8, 0.8, 1.0);
-             Color4 specular(1.0, 1.0, 1.0, 1.0);
+             // the color map is not evaluated by the shaders, thus the models are not deformed
+             // by the vertex shader while it is shown
+             if (_image_of_mo[_mo_index]->HasColors())
+             {
+                 _render_colored_mesh(*_image_of_mo[_mo_index]);
+                 return;
+             }
 
-             dl = new DirectionalLight(GL_LIGHT0,direction,ambient,diffuse,specular);
-             if(dl)
+             const ShaderProgram *shader = _shader;
+
+             if (_gpu_animation && _displacement_shader->IsInstalled())
              {
-                 dl->Enable();
-                 _shader.Enable();
-                 MatFBRuby.Apply();
-                 _image_of_mo[_mo_index]->Render();
-                 dl->Disable();
-                 _shader.Disable();
+                 // uniform variables can only be set while their program is in use
+                 _displacement_shader->Enable();
+                 _displacement_shader->SetUniformVariable1f(_displacement_time, _angle);
+                 shader = _displacement_shader;
              }
-             glDisable(GL_LIGHTING);
-             glDisable(GL_NORMALIZE);
+
+             _render_queue.Submit(*_image_of_mo[_mo_index], MatFBRuby, shader, &_light_set);
+             _render_queue.Flush();
          }
     }
 
-    void  GLWidget::_animate()
+    // total offset along the normals after _angle / DEG_TO_RADIAN ticks, each of which moves
+    // the vertices by sin(angle) / 3000, i.e., the closed form of the sum that is also used
+    // by Shaders/displacement.vert
+    GLdouble GLWidget::_breathing_displacement() const
+    {
+        GLdouble half_step = 0.5 * DEG_TO_RADIAN;
+
+        return sin(0.5 * _angle) * sin(0.5 * _angle + half_step) / sin(half_step) / 3000.0;
+    }
+
+    GLboolean GLWidget::_advance_animation()
     {
         _angle += DEG_TO_RADIAN;
         if (_angle >= TWO_PI)
             _angle -= TWO_PI;
 
-        GLfloat* vertex = _image_of_mo[_mo_index]->MapVertexBuffer(GL_READ_WRITE);
-        GLfloat* normal = _image_of_mo[_mo_index]->MapNormalBuffer(GL_READ_ONLY);
+        // the vertex shader only needs the new value of the uniform variable time,
+        // which is set in render_mo()
+        if (_gpu_animation && _displacement_shader->IsInstalled())
+            return GL_TRUE;
+
+        return _image_of_mo[_mo_index]->StreamDisplacementAlongNormals(_breathing_displacement());
+    }
+
+    void  GLWidget::_animate()
+    {
+        if (_advance_animation())
+            updateGL();
+    }
 
-        if (vertex && normal)
+    void GLWidget::set_gpu_animation(bool value)
+    {
+        if (_gpu_animation != (GLboolean)value)
         {
-            GLfloat scale = sin(_angle) / 3000.0;
+            _gpu_animation = value;
 
-            for (GLuint i = 0; i < _image_of_mo[_mo_index]->VertexCount(); ++i)
-            {
-                for (GLuint coordinate = 0; coordinate < 3; ++coordinate, ++vertex, ++normal)
-                    *vertex += scale * (*normal);
-            }
+            // recreating the streams discards the segments written by the CPU fallback,
+            // thus the vertex shader will displace the original geometry
+            for (GLuint i = 0; i < _num_of_mo; i++)
+                _image_of_mo[i]->EnableStreaming();
 
-            _image_of_mo[_mo_index]->UnmapVertexBuffer();
-            _image_of_mo[_mo_index]->UnmapNormalBuffer();
             updateGL();
         }
     }
 
-    void GLWidget::set_shader_scale_factor(double value)
+    // renders a full period of the animation of the current model both on the CPU and on the GPU,
+    // and lists the average update and frame times
+    void GLWidget::benchmark_animation()
     {
-        _shader.Enable();
-        if (_shader_index == 3){
-            _scale_factor = value;
-            _shader.SetUniformVariable1f("scale_factor",_scale_factor);
-            updateGL();
+        const GLuint frame_count = 360;
+
+        GLboolean gpu_animation = _gpu_animation;
+        GLfloat   angle         = _angle;
+        GLint     page_index    = _page_index;
+
+        _page_index = 3;
+        makeCurrent();
+
+        cout << "Animation benchmark: model " << _mo_index << ", "
+             << _image_of_mo[_mo_index]->VertexCount() << " vertices, "
+             << frame_count << " frames" << endl;
+
+        for (GLint mode = 0; mode < 2; mode++)
+        {
+            set_gpu_animation(mode == 1);
+
+            if (mode == 1 && !_displacement_shader->IsInstalled())
+            {
+                cout << "\tGPU: displacement shader is not available" << endl;
+                continue;
+            }
+
+            qint64 update_time = 0, frame_time = 0;
+            QElapsedTimer timer;
+
+            RenderState::ResetCallCounts();
+
+            for (GLuint frame = 0; frame < frame_count; frame++)
+            {
+                timer.start();
+                _advance_animation();
+                update_time += timer.nsecsElapsed();
+
+                updateGL();
+                glFinish();
+                frame_time += timer.nsecsElapsed();
+            }
+
+            cout << (mode ? "\tGPU" : "\tCPU")
+                 << ": update " << update_time / 1.0e6 / frame_count << " ms/frame"
+                 << ", frame " << frame_time / 1.0e6 / frame_count << " ms/frame"
+                 << ", fixed-function state calls " << (GLdouble)RenderState::GetEmittedCallCount() / frame_count
+                 << " emitted / " << (GLdouble)RenderState::GetSkippedCallCount() / frame_count
+                 << " skipped per frame" << endl;
         }
+
+        set_gpu_animation(gpu_animation);
+        _angle = angle;
+        _page_index = page_index;
+        updateGL();
     }
 
-    void GLWidget::set_shader_smoothing(double value)
+    // the test surfaces only provide first order partial derivatives, the second order ones are
+    // approximated by ParametricSurface3
+    GLboolean GLWidget::_analyze_parametric_surface(GLuint index, CurvatureAnalysis3 &analysis,
+                                                    GLuint u_div_point_count, GLuint v_div_point_count) const
     {
-         _shader.Enable();
-        if (_shader_index == 3){
-            _smoothing = value;
-            _shader.SetUniformVariable1f("smoothing",_smoothing);
-            updateGL();
-        }
+        const ParametricSurface3 *surface = _ps[index];
+
+        GLdouble u_min, u_max, v_min, v_max;
+
+        surface->GetUInterval(u_min, u_max);
+        surface->GetVInterval(v_min, v_max);
+
+        return analysis.Analyze([surface](GLdouble u, GLdouble v, TensorProductSurface3::PartialDerivatives &pd)
+                                {
+                                    return surface->CalculatePartialDerivatives(2, u, v, pd);
+                                },
+                                u_min, u_max, v_min, v_max, u_div_point_count, v_div_point_count);
     }
 
-    void GLWidget::set_shader_shading(double value)
+    void GLWidget::_update_parametric_surface_curvature()
     {
-         _shader.Enable();
-        if (_shader_index == 3){
-            _shading = value;
-            _shader.SetUniformVariable1f("shading",_shading);
-            updateGL();
-        }
+        if (!_image_of_ps[_ps_index])
+            return;
+
+        CurvatureAnalysis3 &analysis = _curvature_of_ps[_ps_index];
+
+        if (_ps_curvature && !analysis.GetVertexCount())
+            _analyze_parametric_surface(_ps_index, analysis, _ps_u_div_point_count, _ps_v_div_point_count);
+
+        _show_curvature(analysis, *_image_of_ps[_ps_index], _ps_curvature);
     }
 
-    void GLWidget::set_shader_index(int index)
+    void GLWidget::_update_model_curvature()
     {
-        if (_shader_index != index)
+        if (!_image_of_mo[_mo_index])
+            return;
+
+        CurvatureAnalysis3 &analysis = _curvature_of_mo[_mo_index];
+
+        if (_mo_curvature && !analysis.GetVertexCount())
+            analysis.Analyze(*_image_of_mo[_mo_index]);
+
+        _show_curvature(analysis, *_image_of_mo[_mo_index], _mo_curvature);
+    }
+
+    void GLWidget::_show_curvature(const CurvatureAnalysis3 &analysis, TriangulatedMesh3 &mesh, int quantity)
+    {
+        makeCurrent();
+
+        if (quantity <= 0)
         {
-            _shader_index = index;
-            init_shader(_shader_index);
-            updateGL();
+            mesh.RemoveColors();
+            return;
         }
+
+        CurvatureAnalysis3::Quantity q = (CurvatureAnalysis3::Quantity)(quantity - 1);
+        GLdouble minimum, maximum;
+
+        if (!analysis.GetRange(q, minimum, maximum) || !analysis.ApplyColorMap(mesh, q, minimum, maximum))
+            mesh.RemoveColors();
     }
 
-    void GLWidget::init_shader(int index)
+    // the vertex colors replace the ambient and diffuse reflectances of the material; OpenGL
+    // changes these behind RenderState, therefore its mirror is invalidated afterwards
+    void GLWidget::_render_colored_mesh(const TriangulatedMesh3 &mesh)
     {
+        glColorMaterial(GL_FRONT_AND_BACK, GL_AMBIENT_AND_DIFFUSE);
+        RenderState::Enable(GL_COLOR_MATERIAL);
 
-        switch (index) {
-        case 0:
-            _shader.InstallShaders("Shaders/directional_light.vert",
-                                   "Shaders/directional_light.frag",GL_TRUE);
-            break;
-        case 1:
-            _shader.InstallShaders("Shaders/two_sided_lighting.vert",
-                                   "Shaders/two_sided_lighting.frag",GL_TRUE);
-            break;
-        case 2:
-            _shader.InstallShaders("Shaders/toon.vert",
-                                   "Shaders/toon.frag",GL_TRUE);
-            break;
-        case 3:
-            _shader.InstallShaders("Shaders/reflection_lines.vert",
-                                   "Shaders/reflection_lines.frag",GL_TRUE);
-            break;
-        default:
-            break;
+        _render_queue.Submit(mesh, MatFBSilver, 0, &_light_set);
+        _render_queue.Flush();
+
+        RenderState::Disable(GL_COLOR_MATERIAL);
+        RenderState::Invalidate();
+        glColor3f(1.0f, 1.0f, 1.0f);
+    }
+
+    // analyzes the models discretely, the parametric surfaces on the grids of their images and the
+    // patches of the toroidal quilt, and lists the average times and throughputs
+    void GLWidget::benchmark_curvature()
+    {
+        const GLuint repetition_count = 5;
+
+        CurvatureAnalysis3 analysis;
+        QElapsedTimer timer;
+
+        cout << "Curvature benchmark: average of " << repetition_count << " runs on "
+             << TaskScheduler::Instance().GetThreadCount() << " threads" << endl;
+
+        auto report = [](const char *name, GLuint index, GLuint vertex_count, qint64 time)
+        {
+            GLdouble milliseconds = time / 1.0e6 / repetition_count;
+
+            cout << "\t" << name << " " << index << ": " << vertex_count << " vertices, "
+                 << milliseconds << " ms, " << vertex_count / milliseconds / 1.0e3 << " Mvertices/s" << endl;
+        };
+
+        for (GLuint i = 0; i < _num_of_mo; i++)
+        {
+            timer.start();
+            for (GLuint r = 0; r < repetition_count; r++)
+                analysis.Analyze(*_image_of_mo[i]);
+
+            report("model (discrete)", i, analysis.GetVertexCount(), timer.nsecsElapsed());
+        }
+
+        for (GLuint i = 0; i < _num_of_ps; i++)
+        {
+            timer.start();
+            for (GLuint r = 0; r < repetition_count; r++)
+                _analyze_parametric_surface(i, analysis, _ps_u_div_point_count, _ps_v_div_point_count);
+
+            report("parametric surface", i, analysis.GetVertexCount(), timer.nsecsElapsed());
+        }
+
+        GLuint vertex_count = 0;
+
+        timer.start();
+        for (GLuint r = 0; r < repetition_count; r++)
+        {
+            vertex_count = 0;
+
+            for (GLuint pi = 0; pi < _patch_toroid.GetRowCount(); pi++)
+                for (GLuint pj = 0; pj < _patch_toroid.GetColumnCount(); pj++)
+                {
+                    analysis.Analyze(*_patch_toroid(pi, pj), 30, 30);
+                    vertex_count += analysis.GetVertexCount();
+                }
+        }
+
+        report("toroidal quilt", 0, vertex_count, timer.nsecsElapsed());
+    }
+
+    void GLWidget::_render_model_slices()
+    {
+        RowMatrix<GenericCurve3*> *&slices = _slices_of_mo[_mo_index];
+
+        if (!slices)
+        {
+            SurfaceIntersection3 sections;
+
+            if (!sections.Slice(*_image_of_mo[_mo_index], DCoordinate3(0.0, 1.0, 0.0), _mo_slice_count))
+                return;
+
+            slices = sections.GeneratePolylines();
+
+            for (GLuint k = 0; k < slices->GetColumnCount(); k++)
+                (*slices)[k]->UpdateVertexBufferObjects();
         }
-        _shader.Enable();
-        if (index == 3)
+
+        glColor3f(1.0f, 1.0f, 0.0f);
+
+        for (GLuint k = 0; k < slices->GetColumnCount(); k++)
+            (*slices)[k]->RenderDerivatives(0, GL_LINE_STRIP);
+
+        glColor3f(1.0f, 1.0f, 1.0f);
+    }
+
+    // slices every model along the three axes, intersects every parametric surface with a shifted
+    // copy of itself, and lists the average times
+    void GLWidget::benchmark_intersections()
+    {
+        const GLuint repetition_count = 5;
+        const GLuint slice_count = 200, div_point_count = 200;
+
+        SurfaceIntersection3 intersection;
+        QElapsedTimer timer;
+
+        cout << "Intersection benchmark: average of " << repetition_count << " runs" << endl;
+
+        auto report = [&intersection](const char *name, GLuint index, qint64 time)
+        {
+            GLuint point_count = 0;
+
+            for (GLuint k = 0; k < intersection.GetPolylineCount(); k++)
+                point_count += (GLuint)intersection.GetPolyline(k).point.size();
+
+            cout << "\t" << name << " " << index << ": " << intersection.GetPolylineCount() << " polylines, "
+                 << point_count << " points, " << time / 1.0e6 / repetition_count << " ms" << endl;
+        };
+
+        for (GLuint i = 0; i < _num_of_mo; i++)
+            for (GLuint axis = 0; axis < 3; axis++)
+            {
+                DCoordinate3 normal;
+                normal[axis] = 1.0;
+
+                timer.start();
+                for (GLuint r = 0; r < repetition_count; r++)
+                    intersection.Slice(*_image_of_mo[i], normal, slice_count);
+
+                report(axis == 0 ? "model (x slices)" : axis == 1 ? "model (y slices)" : "model (z slices)",
+                       i, timer.nsecsElapsed());
+            }
+
+        const DCoordinate3 shift(0.3, 0.2, 0.1);
+
+        for (GLuint i = 0; i < _num_of_ps; i++)
         {
-            _shader.SetUniformVariable1f("scale_factor",_scale_factor);
-            _shader.SetUniformVariable1f("smoothing",_smoothing);
-            _shader.SetUniformVariable1f("shading",_shading);
+            const ParametricSurface3 *surface = _ps[i];
+
+            GLdouble u_min, u_max, v_min, v_max;
+
+            surface->GetUInterval(u_min, u_max);
+            surface->GetVInterval(v_min, v_max);
+
+            SurfaceIntersection3::SampledSurface original(
+                    [surface](GLdouble u, GLdouble v, TensorProductSurface3::PartialDerivatives &pd)
+                    {
+                        return surface->CalculatePartialDerivatives(1, u, v, pd);
+                    },
+                    u_min, u_max, v_min, v_max, div_point_count, div_point_count);
+            SurfaceIntersection3::SampledSurface shifted(
+                    [surface, &shift](GLdouble u, GLdouble v, TensorProductSurface3::PartialDerivatives &pd)
+                    {
+                        if (!surface->CalculatePartialDerivatives(1, u, v, pd))
+                            return GL_FALSE;
+
+                        pd(0, 0) += shift;
+
+                        return GL_TRUE;
+                    },
+                    u_min, u_max, v_min, v_max, div_point_count, div_point_count);
+
+            timer.start();
+            for (GLuint r = 0; r < repetition_count; r++)
+                intersection.Intersect(original, shifted);
+
+            report("parametric surface", i, timer.nsecsElapsed());
         }
     }
 
+    void GLWidget::set_shader_scale_factor(double value)
+    {
+        _shader->Enable();
+        if (_shader_index == 3){
+            _scale_factor = value;
+            _shader->SetUniformVariable1f("scale_factor",_scale_factor);
+            updateGL();
+        }
+    }
+
+    void GLWidget::set_shader_smoothing(double value)
+    {
+         _shader->Enable();
+        if (_shader_index == 3){
+            _smoothing = value;
+            _shader->SetUniformVariable1f("smoothing",_smoothing);
+            updateGL();
+        }
+    }
+
+    void GLWidget::set_shader_shading(double value)
+    {
+         _shader->Enable();
+        if (_shader_index == 3){
+            _shading = value;
+            _shader->SetUniformVariable1f("shading",_shading);
+            updateGL();
+        }
+    }
+
+    void GLWidget::set_shader_index(int index)
+    {
+        if (_shader_index != index)
+        {
+            _shader_index = index;
+            init_shader(_shader_index);
+            updateGL();
+        }
+    }
+
+    void GLWidget::init_shaders()
+    {
+        CAGD_PROFILE_ZONE("GLWidget::init_shaders");
+
+        // linked program binaries are stored next to the executable
+        QDir().mkpath("ShaderCache");
+
+        _shader_manager.Install(GL_TRUE);
+
+        cout << _shader_manager.GetProgramsLoadedFromBinariesCount() << " of "
+             << _shader_manager.GetProgramCount() << " shader programs were loaded from binaries" << endl;
+
+        _configure_shaders();
+        _watch_shader_sources();
+    }
+
+    void GLWidget::_configure_shaders()
+    {
+        // uniform values are lost whenever a program is rebuilt
+        ShaderProgram &reflection_lines = _shader_manager[3];
+
+        reflection_lines.Enable();
+        reflection_lines.SetUniformVariable1f("scale_factor", _scale_factor);
+        reflection_lines.SetUniformVariable1f("smoothing", _smoothing);
+        reflection_lines.SetUniformVariable1f("shading", _shading);
+
+        // the time is updated on every frame, so its location is looked up only once
+        _displacement_shader->GetUniform("time", _displacement_time);
+
+        _displacement_shader->Enable();
+        _displacement_shader->SetUniformVariable1f(_displacement_time, _angle);
+        _displacement_shader->SetUniformVariable1f("angle_step", DEG_TO_RADIAN);
+        _displacement_shader->SetUniformVariable1f("amplitude", 1.0 / 3000.0);
+
+        _shader->Enable();
+    }
+
+    void GLWidget::_watch_shader_sources()
+    {
+        QStringList file_names;
+
+        for (GLuint i = 0; i < _shader_manager.GetProgramCount(); ++i)
+        {
+            file_names << QString::fromStdString(_shader_manager.GetVertexShaderFileName(i))
+                       << QString::fromStdString(_shader_manager.GetFragmentShaderFileName(i));
+        }
+
+        file_names.removeDuplicates();
+
+        // editors often replace files instead of rewriting them, which removes them from the watcher
+        foreach (const QString &file_name, file_names)
+            if (!_shader_watcher->files().contains(file_name) && QFile::exists(file_name))
+                _shader_watcher->addPath(file_name);
+    }
+
+    void GLWidget::_shader_source_changed(const QString &)
+    {
+        _shader_reload_timer->start();
+    }
+
+    void GLWidget::reload_shaders()
+    {
+        makeCurrent();
+
+        if (_shader_manager.ReloadChangedPrograms(GL_TRUE))
+        {
+            _configure_shaders();
+            updateGL();
+        }
+
+        _watch_shader_sources();
+    }
+
+    void GLWidget::init_shader(int index)
+    {
+        if (index < 0 || index > 3)
+            return;
+
+        // every program is resident, switching only changes the one in use
+        ShaderProgram *previous = _shader;
+        _shader = &_shader_manager[index];
+
+        _batch_toroid.ReplaceShaderProgram(previous, _shader);
+        _batch_cylindric.ReplaceShaderProgram(previous, _shader);
+        _batch_loaded.ReplaceShaderProgram(previous, _shader);
+
+        _shader->Enable();
+    }
+
     void GLWidget::init_bspline_arc() {
+        CAGD_PROFILE_ZONE("GLWidget::init_bspline_arc");
+
         GLuint _n = 8;
         _num_of_bspa = 8;
         _bspa.ResizeColumns(_num_of_bspa);
@@ -761,10 +1563,27 @@ namespace cagd
             _img_bspa[i] = _bspa[i]->GenerateImage(_mod, _div);
             _img_bspa[i]->UpdateVertexBufferObjects();
         }
+
+        // the control point j of the arc i is referenced by the slot (i, 0, j)
+        vector<DCoordinate3> positions;
+        vector<ControlPointIndex3::Reference> references;
+
+        for (GLuint i = 0; i < _num_of_bspa; ++i)
+            for (GLuint j = 0; j < 4; ++j) {
+                positions.push_back((*_bspa[i])[j]);
+                references.push_back(ControlPointIndex3::Reference(i, 0, j));
+            }
+
+        _cp_arcs.Build(positions, references);
+
+        if (_selected_index == &_cp_arcs)
+            _selected_index = nullptr;
     }
 
     void GLWidget::render_bspline_arc(){
-        _shader.Disable();
+        CAGD_PROFILE_ZONE("GLWidget::render_bspline_arc");
+
+        _shader->Disable();
         for ( GLuint i = 0; i <_num_of_bspa; ++i ) {
             if (_bspa[i])
             {
@@ -827,6 +1646,8 @@ namespace cagd
 
     void GLWidget::init_patch()
     {
+        CAGD_PROFILE_ZONE("GLWidget::init_patch");
+
         cGridn=10;
         cGridm=12;
         nPatchn=10;
@@ -838,17 +1659,13 @@ namespace cagd
         GLuint n = cGridn;
         GLuint m = cGridm;
 
-        Matrix<DCoordinate3> cp;
-        cp.ResizeRows(n);
-        cp.ResizeColumns(m);
-        Matrix<DCoordinate3> cp2;
-        cp2.ResizeRows(n);
-        cp2.ResizeColumns(m);
+        _quilt_toroid.Resize(n, m, GL_TRUE, GL_TRUE);
+        _quilt_cylindric.Resize(n, m, GL_FALSE, GL_TRUE);
 
         for (GLuint i = 0; i < n; ++i)
             for (GLuint j = 0; j < m; ++j){
-                cp(i,j) = getTorusPoint(i,j,n-1,m-1);
-                cp2(i,j) = getCylinderPoint(i,j,n-1,m-1);
+                _quilt_toroid(i,j) = getTorusPoint(i,j,n-1,m-1);
+                _quilt_cylindric(i,j) = getCylinderPoint(i,j,n-1,m-1);
             }
 
 
@@ -863,21 +1680,9 @@ namespace cagd
                 _patch_cylindric(i,j) = new BicubicBSplinePatch();
             }
 
-        for (GLuint pi = 0; pi < n; ++pi)
-            for (GLuint pj = 0; pj < m; ++pj)
-                for (GLuint i = 0; i < 4; ++i)
-                    for (GLuint j = 0; j < 4; ++j) {
-                        _patch_toroid(pi,pj)->SetData(i,j,cp((pi+i)%n,(pj+j)%m)[0],cp((pi+i)%n,(pj+j)%m)[1],cp((pi+i)%n,(pj+j)%m)[2]);
-
-                    }
-
-        for (GLuint pi = 0; pi < n - 3; ++pi)
-            for (GLuint pj = 0; pj < m; ++pj)
-                for (GLuint i = 0; i < 4; ++i)
-                    for (GLuint j = 0; j < 4; ++j) {
-                        _patch_cylindric(pi,pj)->SetData(i,j,cp2((pi+i),(pj+j)%m)[0],cp2((pi+i),(pj+j)%m)[1],cp2((pi+i),(pj+j)%m)[2]);
-
-                    }
+        // the open cylindric quilt only defines the first n - 3 rows of patches
+        _quilt_to_patches(_quilt_toroid, _patch_toroid);
+        _quilt_to_patches(_quilt_cylindric, _patch_cylindric);
 
         bi_toroid.ResizeRows(n);
         bi_toroid.ResizeColumns(m);
@@ -911,6 +1716,13 @@ namespace cagd
                 _patch_vLines_cylindric(pi,pj) = _patch_cylindric(pi,pj)->GenerateVIsoparametricLines(_vLine_num,1,divpoints);
             }
 
+        _update_patch_batch(_batch_toroid, _bvh_toroid, bi_toroid, GL_TRUE);
+        _update_patch_batch(_batch_cylindric, _bvh_cylindric, bi_cylindric, GL_FALSE, &_patch_uLines_cylindric, &_patch_vLines_cylindric);
+
+        // the last three rows of the cylindric quilt are not initialized
+        _build_control_point_index(_cp_toroid, _patch_toroid, n);
+        _build_control_point_index(_cp_cylindric, _patch_cylindric, n - 3);
+
         _patch.SetData(0, 0, -2.0, -2.0, 0.0);
         _patch.SetData(0, 1, -2.0, -1.0, 0.0);
         _patch.SetData(0, 2, -2.0, 1.0, 0.0);
@@ -979,11 +1791,265 @@ namespace cagd
 
     }
 
+    void GLWidget::_update_patch_batch(RenderBatch &batch, BoundingVolumeHierarchy3 &hierarchy,
+                                       const Matrix<TriangulatedMesh3*> &images, GLboolean checkerboard,
+                                       const Matrix<RowMatrix<GenericCurve3*>*> *u_lines,
+                                       const Matrix<RowMatrix<GenericCurve3*>*> *v_lines)
+    {
+        CAGD_PROFILE_ZONE("GLWidget::_update_patch_batch");
+
+        batch.Clear();
+
+        Color4 u_line_color(1.0, 0.0, 0.0);
+        Color4 v_line_color(0.0, 0.0, 1.0);
+
+        for (GLuint pi = 0; pi < images.GetRowCount(); ++pi)
+            for (GLuint pj = 0; pj < images.GetColumnCount(); ++pj) {
+                if (images(pi,pj))
+                {
+                    if (checkerboard && (pi + pj) % 2)
+                        batch.AddMesh(*images(pi,pj), MatFBSilver, _shader);
+                    else
+                        batch.AddMesh(*images(pi,pj), MatFBRuby, _shader);
+                }
+
+                if (u_lines && (*u_lines)(pi,pj))
+                    for (GLuint i = 0; i < _uLine_num; i++)
+                        batch.AddCurve(*(*(*u_lines)(pi,pj))[i], u_line_color);
+
+                if (v_lines && (*v_lines)(pi,pj))
+                    for (GLuint i = 0; i < _vLine_num; i++)
+                        batch.AddCurve(*(*(*v_lines)(pi,pj))[i], v_line_color);
+            }
+
+        if (!batch.UpdateVertexBufferObjects())
+            cout << "Could not create the vertex buffer objects of the patch batch" << endl;
+
+        // the hierarchy is rebuilt by the next click, thus repeated edits do not pay for it
+        hierarchy.Clear();
+
+        if (_picked_hierarchy == &hierarchy)
+            _picked_hierarchy = nullptr;
+    }
+
+    void GLWidget::_build_patch_hierarchy(BoundingVolumeHierarchy3 &hierarchy, const Matrix<TriangulatedMesh3*> &images)
+    {
+        // the mesh of the hit face (pi, pj) has the index pi * column count + pj
+        vector<const TriangulatedMesh3*> meshes;
+
+        for (GLuint pi = 0; pi < images.GetRowCount(); ++pi)
+            for (GLuint pj = 0; pj < images.GetColumnCount(); ++pj)
+                meshes.push_back(images(pi,pj));
+
+        hierarchy.Build(meshes);
+    }
+
+    // indexes the control nets of the first row_count rows of a quilt, the slot (i, j) of the patch
+    // (pi, pj) is referenced by the owner pi * column count + pj
+    void GLWidget::_build_control_point_index(ControlPointIndex3 &index, const Matrix<BicubicBSplinePatch*> &patches,
+                                              GLuint row_count)
+    {
+        vector<DCoordinate3> positions;
+        vector<ControlPointIndex3::Reference> references;
+
+        GLuint column_count = patches.GetColumnCount();
+
+        for (GLuint pi = 0; pi < row_count && pi < patches.GetRowCount(); ++pi)
+            for (GLuint pj = 0; pj < column_count; ++pj) {
+                if (!patches(pi,pj))
+                    continue;
+
+                for (GLuint i = 0; i < 4; ++i)
+                    for (GLuint j = 0; j < 4; ++j) {
+                        DCoordinate3 position;
+                        patches(pi,pj)->GetData(i, j, position);
+
+                        positions.push_back(position);
+                        references.push_back(ControlPointIndex3::Reference(pi * column_count + pj, i, j));
+                    }
+            }
+
+        index.Build(positions, references);
+
+        if (_selected_index == &index)
+            _selected_index = nullptr;
+    }
+
+    // writes the position of an indexed control point into all referencing patch slots and submits
+    // the images of these patches only
+    void GLWidget::_move_patch_control_point(const ControlPointIndex3 &index, GLuint point,
+                                             const Matrix<BicubicBSplinePatch*> &patches, GLuint quilt)
+    {
+        const DCoordinate3 &position = index.GetPoint(point);
+
+        GLuint column_count = patches.GetColumnCount();
+        vector<GLuint> owners;
+
+        for (GLuint k = 0; k < index.GetReferenceCount(point); ++k)
+        {
+            const ControlPointIndex3::Reference &reference = index.GetReference(point, k);
+
+            patches(reference.owner / column_count, reference.owner % column_count)->SetData(reference.row, reference.column, position);
+            owners.push_back(reference.owner);
+        }
+
+        sort(owners.begin(), owners.end());
+        owners.erase(unique(owners.begin(), owners.end()), owners.end());
+
+        for (GLuint k = 0; k < owners.size(); ++k)
+        {
+            GLuint pi = owners[k] / column_count, pj = owners[k] % column_count;
+
+            patches(pi,pj)->UpdateVertexBufferObjectsOfData();
+
+            _submit_patch_image(quilt, *patches(pi,pj), owners[k]);
+        }
+    }
+
+    GLuint64 GLWidget::_tessellation_key(GLuint quilt, GLuint index)
+    {
+        return ((GLuint64)quilt << 32) | index;
+    }
+
+    Matrix<TriangulatedMesh3*>* GLWidget::_quilt_images(GLuint quilt)
+    {
+        switch (quilt) {
+        case 1:
+            return &bi_toroid;
+        case 2:
+            return &bi_cylindric;
+        case 4:
+            return &bi_loaded;
+        default:
+            return nullptr;
+        }
+    }
+
+    // the copy constructor of the patch would also copy the vertex buffer object of its control net,
+    // therefore the worker tessellates a new patch of the same control points
+    void GLWidget::_submit_patch_image(GLuint quilt, const BicubicBSplinePatch &patch, GLuint index)
+    {
+        Matrix<DCoordinate3> net(4, 4);
+
+        for (GLuint i = 0; i < 4; ++i)
+            for (GLuint j = 0; j < 4; ++j)
+                patch.GetData(i, j, net(i,j));
+
+        _tessellation.Submit(_tessellation_key(quilt, index), [net](TessellationQueue::Result &result)
+        {
+            BicubicBSplinePatch copy;
+
+            for (GLuint i = 0; i < 4; ++i)
+                for (GLuint j = 0; j < 4; ++j)
+                    copy.SetData(i, j, net(i,j));
+
+            result.meshes.push_back(copy.GenerateImage(30,30,GL_STATIC_DRAW));
+        });
+    }
+
+    void GLWidget::_submit_arc_image(GLuint index)
+    {
+        RowMatrix<DCoordinate3> data(4);
+
+        for (GLuint j = 0; j < 4; ++j)
+            data[j] = (*_bspa[index])[j];
+
+        GLuint mod = _mod, div = _div;
+
+        _tessellation.Submit(_tessellation_key(3, index), [data, mod, div](TessellationQueue::Result &result)
+        {
+            BicubicBSplineArc copy;
+
+            for (GLuint j = 0; j < 4; ++j)
+                copy[j] = data[j];
+
+            result.curves.push_back(copy.GenerateImage(mod, div));
+        });
+    }
+
+    // replaces the images by the finished tessellations and uploads them, it requires the rendering context
+    void GLWidget::_receive_tessellations()
+    {
+        CAGD_PROFILE_ZONE("GLWidget::_receive_tessellations");
+
+        vector<TessellationQueue::Result> results;
+
+        _tessellation.Drain(results);
+
+        for (GLuint r = 0; r < results.size(); ++r)
+        {
+            TessellationQueue::Result &result = results[r];
+
+            GLuint quilt = (GLuint)(result.key >> 32), index = (GLuint)result.key;
+
+            if (quilt == 3)
+            {
+                if (index < _num_of_bspa && !result.curves.empty())
+                {
+                    delete _img_bspa[index];
+                    _img_bspa[index] = result.curves[0];
+                    result.curves[0] = nullptr;
+
+                    if (_img_bspa[index])
+                        _img_bspa[index]->UpdateVertexBufferObjects();
+                }
+            }
+            else if (Matrix<TriangulatedMesh3*> *images = _quilt_images(quilt))
+            {
+                GLuint m = images->GetColumnCount();
+
+                if (m && index / m < images->GetRowCount() && !result.meshes.empty())
+                {
+                    TriangulatedMesh3 *&image = (*images)(index / m, index % m);
+
+                    delete image;
+                    image = result.meshes[0];
+                    result.meshes[0] = nullptr;
+
+                    if (image)
+                        image->UpdateVertexBufferObjects();
+
+                    _outdated_batches |= 1u << quilt;
+                }
+            }
+
+            // deletes the unused parts of the result
+            result.Discard();
+        }
+
+        if (_outdated_batches && (!_tessellation.GetJobCount() || _batch_refresh_timer.elapsed() >= 250))
+        {
+            for (GLuint quilt = 0; quilt < 32; ++quilt)
+                if (_outdated_batches & (1u << quilt))
+                    _refresh_patch_batch(quilt);
+
+            _outdated_batches = 0;
+            _batch_refresh_timer.restart();
+        }
+    }
+
+    void GLWidget::_refresh_patch_batch(GLuint quilt)
+    {
+        switch (quilt) {
+        case 1:
+            _update_patch_batch(_batch_toroid, _bvh_toroid, bi_toroid, GL_TRUE);
+            break;
+        case 2:
+            _update_patch_batch(_batch_cylindric, _bvh_cylindric, bi_cylindric, GL_FALSE, &_patch_uLines_cylindric, &_patch_vLines_cylindric);
+            break;
+        case 4:
+            _update_patch_batch(_batch_loaded, _bvh_loaded, bi_loaded, GL_FALSE);
+            break;
+        default:
+            break;
+        }
+    }
+
     void GLWidget::render_patch(){
+        CAGD_PROFILE_ZONE("GLWidget::render_patch");
 
-        glEnable(GL_LIGHTING);
-        glEnable(GL_NORMALIZE);
-        glEnable(GL_LIGHT0);
+        _light_set.Enable();
+        RenderState::Enable(GL_NORMALIZE);
 
         GLuint n = cGridn;
         GLuint m = cGridm;
@@ -991,11 +2057,11 @@ namespace cagd
         switch (_patch_index) {
         case 0:
             _patch.RenderData(GL_LINE_STRIP);
-            _shader.Enable();
+            _shader->Enable();
             MatFBRuby.Apply();
             if (_before_interpolation)
                 _before_interpolation->Render();
-            _shader.Disable();
+            _shader->Disable();
             if (_after_interpolation)
             {
                 glEnable(GL_BLEND);
@@ -1024,102 +2090,41 @@ namespace cagd
 
             break;
         case 1:
-            if (bi_toroid(0,0))
-            {
-                _shader.Enable();
-                for (GLuint pi = 0; pi < n; ++pi)
-                    for (GLuint pj = 0; pj < m; ++pj) {
-                        if ((pi + pj) % 2 == 0){
-                            MatFBRuby.Apply();
-                            bi_toroid(pi,pj)->Render();
-                        }
-                        else {
-                            MatFBSilver.Apply();
-                            bi_toroid(pi,pj)->Render();
-
-                        }
-                        /*// ulines
-                        for (GLuint i = 0; i < _uLine_num; i++) {
-                            (*_patch_uLines_toroid(pi,pj))[i]->UpdateVertexBufferObjects();
-                            glColor3f(1.0, 0.0, 0.0);
-                            (*_patch_uLines_toroid(pi,pj))[i]->RenderDerivatives(0, GL_LINE_STRIP);
-                        }
-                        // vlines
-                        for (GLuint i = 0; i < _vLine_num; i++) {
-                            (*_patch_vLines_toroid(pi,pj))[i]->UpdateVertexBufferObjects();
-                            glColor3f(0.0, 0.0, 1.0);
-                            (*_patch_vLines_toroid(pi,pj))[i]->RenderDerivatives(0, GL_LINE_STRIP);
-                        }*/
-                    }
-                _shader.Disable();
-            }
-            glDisable(GL_LIGHTING);
-            glDisable(GL_NORMALIZE);
-            glDisable(GL_LIGHT0);
+            // ruby and silver patches alternate, i.e., two submissions for the whole quilt
+            _batch_toroid.RenderMeshes();
+            _light_set.Disable();
+            RenderState::Disable(GL_NORMALIZE);
             for (GLuint pi = 0; pi < n; ++pi)
                 for (GLuint pj = 0; pj < m; ++pj) {
                     _patch_toroid(pi,pj)->RenderData(GL_LINE_STRIP);
                 }
             break;
         case 2:
-            if (bi_cylindric(0,0))
-            {
-                _shader.Enable();
-                MatFBRuby.Apply();
-
-                for (GLuint pi = 0; pi < n; ++pi)
-                    for (GLuint pj = 0; pj < m; ++pj) {
-                        bi_cylindric(pi,pj)->Render();
-                    }
-                _shader.Disable();
-            }
+            _batch_cylindric.RenderMeshes();
 
-            glDisable(GL_LIGHTING);
-            glDisable(GL_NORMALIZE);
-            glDisable(GL_LIGHT0);
+            _light_set.Disable();
+            RenderState::Disable(GL_NORMALIZE);
             for (GLuint pi = 0; pi < n; ++pi)
                 for (GLuint pj = 0; pj < m; ++pj) {
                     _patch_cylindric(pi,pj)->RenderData(GL_LINE_STRIP);
-                    // ulines
-                    for (GLuint i = 0; i < _uLine_num; i++) {
-                        (*_patch_uLines_cylindric(pi,pj))[i]->UpdateVertexBufferObjects();
-                        glColor3f(1.0, 0.0, 0.0);
-                        (*_patch_uLines_cylindric(pi,pj))[i]->RenderDerivatives(0, GL_LINE_STRIP);
-                    }
-                    // vlines
-                    for (GLuint i = 0; i < _vLine_num; i++) {
-                        (*_patch_vLines_cylindric(pi,pj))[i]->UpdateVertexBufferObjects();
-                        glColor3f(0.0, 0.0, 1.0);
-                        (*_patch_vLines_cylindric(pi,pj))[i]->RenderDerivatives(0, GL_LINE_STRIP);
-                    }
                 }
+
+            // red u- and blue v-directional isoparametric lines
+            _batch_cylindric.RenderCurves(GL_LINE_STRIP);
             break;
         case 3:
-            glDisable(GL_LIGHTING);
-            glDisable(GL_NORMALIZE);
-            glDisable(GL_LIGHT0);
-            _shader.Disable();
+            _light_set.Disable();
+            RenderState::Disable(GL_NORMALIZE);
+            _shader->Disable();
             render_bspline_arc();
             break;
         case 4:
-            if (bi_loaded(0,0))
-            {
-                _shader.Enable();
-                MatFBRuby.Apply();
+            _batch_loaded.RenderMeshes();
 
-                for (GLuint pi = 0; pi < n; ++pi)
-                    for (GLuint pj = 0; pj < m; ++pj) {
-                        if (bi_loaded(pi,pj))
-                            bi_loaded(pi,pj)->Render();
-                    }
-                _shader.Disable();
-            }
-
-            glDisable(GL_LIGHTING);
-            glDisable(GL_NORMALIZE);
-            glDisable(GL_LIGHT0);
-            for (GLuint pi = 0; pi < n; ++pi)
-                for (GLuint pj = 0; pj < m; ++pj) {
+            _light_set.Disable();
+            RenderState::Disable(GL_NORMALIZE);
+            for (GLuint pi = 0; pi < _patch_loaded.GetRowCount(); ++pi)
+                for (GLuint pj = 0; pj < _patch_loaded.GetColumnCount(); ++pj) {
                     if (_patch_loaded(pi,pj))
                         _patch_loaded(pi,pj)->RenderData(GL_LINE_STRIP);
                 }
@@ -1129,22 +2134,6 @@ namespace cagd
         }
     }
 
-    void GLWidget::set_patch_i(double value){
-        if (_patch_i != value )
-            _patch_i = value;
-    }
-    void GLWidget::set_patch_j(double value){
-        if (_patch_j != value )
-            _patch_j = value;
-    }
-    void GLWidget::set_dcoord_i(double value){
-        if (_dcoord_i != value )
-            _dcoord_i = value;
-    }
-    void GLWidget::set_dcoord_j(double value){
-        if (_dcoord_j != value )
-            _dcoord_j = value;
-    }
     void GLWidget::set_modify_x(double value){
         if (_modify_x != value)
             _modify_x = value;
@@ -1161,109 +2150,45 @@ namespace cagd
         modify();
     }
 
+    // moves the selected control point by the values of the modify spin boxes, only the patches or arcs
+    // that reference the point are regenerated, by worker threads, thus dragging never waits for them
     void GLWidget::modify(){
-        GLuint n = cGridn;
-        GLuint m = cGridm;
+        ControlPointIndex3 *control_points = _displayed_control_points();
 
-        DCoordinate3 temp;
-        DCoordinate3 temp2;
-        DCoordinate3 prev;
+        if (!control_points || control_points != _selected_index)
+            return;
+
+        makeCurrent();
+
+        DCoordinate3 position = control_points->GetPoint(_selected_control_point);
+
+        position.x() += _modify_x;
+        position.y() += _modify_y;
+        position.z() += _modify_z;
+
+        control_points->MovePoint(_selected_control_point, position);
 
         switch (_patch_index) {
         case 1:
-            _patch_toroid(_patch_i,_patch_j)->GetData(_dcoord_i,_dcoord_j,temp);
-            prev.x() = temp.x();
-            prev.y() = temp.y();
-            prev.z() = temp.z();
-
-            temp.x() += _modify_x;
-            temp.y() += _modify_y;
-            temp.z() += _modify_z;
-            //_patch_toroid(_patch_i,_patch_j)->SetData(_dcoord_i,_dcoord_j,_modify_x,_modify_y,_modify_z);
-            _patch_toroid(_patch_i,_patch_j)->SetData(_dcoord_i,_dcoord_j,temp.x(),temp.y(),temp.z());
-            _patch_toroid(_patch_i,_patch_j)->UpdateVertexBufferObjectsOfData();
-            bi_toroid(_patch_i,_patch_j) = _patch_toroid(_patch_i,_patch_j)->GenerateImage(30,30,GL_STATIC_DRAW);
-            if (bi_toroid(_patch_i,_patch_j))
-                bi_toroid(_patch_i,_patch_j)->UpdateVertexBufferObjects();
-
-            //Update the others
-            for (GLuint pi = 0; pi < n; ++pi)
-                for (GLuint pj = 0; pj < m; ++pj)
-                    for (GLuint i = 0; i < 4; ++i)
-                        for (GLuint j = 0; j < 4; ++j) {
-                            _patch_toroid(pi,pj)->GetData(i,j,temp2);
-                            if (prev.x() == temp2.x() && prev.y() == temp2.y() && prev.z() == temp2.z()){
-                                _patch_toroid(pi,pj)->SetData(i,j,temp.x(),temp.y(),temp.z());
-                                _patch_toroid(pi,pj)->UpdateVertexBufferObjectsOfData();
-                                bi_toroid(pi,pj) = _patch_toroid(pi,pj)->GenerateImage(30,30,GL_STATIC_DRAW);
-                                if (bi_toroid(pi,pj))
-                                    bi_toroid(pi,pj)->UpdateVertexBufferObjects();
-                            }
-                        }
-            render_patch();
+            _move_patch_control_point(*control_points, _selected_control_point, _patch_toroid, 1);
             break;
         case 2:
-            _patch_cylindric(_patch_i,_patch_j)->GetData(_dcoord_i,_dcoord_j,temp);
-            prev.x() = temp.x();
-            prev.y() = temp.y();
-            prev.z() = temp.z();
-
-            temp.x() += _modify_x;
-            temp.y() += _modify_y;
-            temp.z() += _modify_z;
-            //_patch_toroid(_patch_i,_patch_j)->SetData(_dcoord_i,_dcoord_j,_modify_x,_modify_y,_modify_z);
-            _patch_cylindric(_patch_i,_patch_j)->SetData(_dcoord_i,_dcoord_j,temp.x(),temp.y(),temp.z());
-            _patch_cylindric(_patch_i,_patch_j)->UpdateVertexBufferObjectsOfData();
-            bi_cylindric(_patch_i,_patch_j) = _patch_cylindric(_patch_i,_patch_j)->GenerateImage(30,30,GL_STATIC_DRAW);
-            if (bi_cylindric(_patch_i,_patch_j))
-                bi_cylindric(_patch_i,_patch_j)->UpdateVertexBufferObjects();
-
-            //Update the others
-            for (GLuint pi = 0; pi < n; ++pi)
-                for (GLuint pj = 0; pj < m; ++pj)
-                    for (GLuint i = 0; i < 4; ++i)
-                        for (GLuint j = 0; j < 4; ++j) {
-                            _patch_cylindric(pi,pj)->GetData(i,j,temp2);
-                            if (prev.x() == temp2.x() && prev.y() == temp2.y() && prev.z() == temp2.z()){
-                                _patch_cylindric(pi,pj)->SetData(i,j,temp.x(),temp.y(),temp.z());
-                                _patch_cylindric(pi,pj)->UpdateVertexBufferObjectsOfData();
-                                bi_cylindric(pi,pj) = _patch_cylindric(pi,pj)->GenerateImage(30,30,GL_STATIC_DRAW);
-                                if (bi_cylindric(pi,pj))
-                                    bi_cylindric(pi,pj)->UpdateVertexBufferObjects();
-                            }
-                        }
-            render_patch();
+            _move_patch_control_point(*control_points, _selected_control_point, _patch_cylindric, 2);
             break;
-          case 3:
-
-            temp = (*_bspa[_patch_i])[_patch_j];
-            prev.x() = temp.x();
-            prev.y() = temp.y();
-            prev.z() = temp.z();
-
-            temp.x() += _modify_x;
-            temp.y() += _modify_y;
-            temp.z() += _modify_z;
-
-            (*_bspa[_patch_i])[_patch_j].x()=temp.x();
-            (*_bspa[_patch_i])[_patch_j].y()=temp.y();
-            (*_bspa[_patch_i])[_patch_j].z()=temp.z();
-            _bspa[_patch_i]->UpdateVertexBufferObjectsOfData();
-            _img_bspa[_patch_i] = _bspa[_patch_i]->GenerateImage(_mod, _div);
-            _img_bspa[_patch_i]->UpdateVertexBufferObjects();
-
-            for (GLuint i = 0 ; i < _num_of_bspa; ++i)
-            for (GLuint j = 0 ; j < 4; ++j) {
-                if ((*_bspa[i])[j].x() == prev.x() && (*_bspa[i])[j].y() == prev.y() && (*_bspa[i])[j].z() == prev.z()){
-                    (*_bspa[i])[j].x()=temp.x();
-                    (*_bspa[i])[j].y()=temp.y();
-                    (*_bspa[i])[j].z()=temp.z();
-                    _bspa[i]->UpdateVertexBufferObjectsOfData();
-                    _img_bspa[i] = _bspa[i]->GenerateImage(_mod, _div);
-                    _img_bspa[i]->UpdateVertexBufferObjects();
-                }
+        case 3:
+            for (GLuint k = 0; k < control_points->GetReferenceCount(_selected_control_point); ++k)
+            {
+                GLuint i = control_points->GetReference(_selected_control_point, k).owner;
+                GLuint j = control_points->GetReference(_selected_control_point, k).column;
+
+                (*_bspa[i])[j] = position;
+                _bspa[i]->UpdateVertexBufferObjectsOfData();
+
+                _submit_arc_image(i);
             }
-            render_bspline_arc();
+            break;
+        case 4:
+            _move_patch_control_point(*control_points, _selected_control_point, _patch_loaded, 4);
             break;
         default:
             break;
@@ -1271,80 +2196,114 @@ namespace cagd
         updateGL();
     }
 
-    void GLWidget::save_patch( const Matrix<BicubicBSplinePatch*>& _tpatch ){
-        GLuint n = _tpatch.GetRowCount();
-        GLuint m = _tpatch.GetColumnCount();
+    // sets the control points of the first GetPatchRowCount() x GetPatchColumnCount() patches,
+    // missing patches are allocated
+    void GLWidget::_quilt_to_patches(const PatchQuilt3 &quilt, Matrix<BicubicBSplinePatch*> &patches)
+    {
+        for (GLuint pi = 0; pi < quilt.GetPatchRowCount(); ++pi)
+            for (GLuint pj = 0; pj < quilt.GetPatchColumnCount(); ++pj) {
+                if (!patches(pi,pj))
+                    patches(pi,pj) = new BicubicBSplinePatch();
 
-        fstream fs;
-        fs.open ("test.txt", fstream::out);
+                for (GLuint i = 0; i < 4; ++i)
+                    for (GLuint j = 0; j < 4; ++j)
+                        patches(pi,pj)->SetData(i, j, quilt.ControlPoint(pi, pj, i, j));
+            }
+    }
 
-        fs << n << " " << m << endl;
+    // every grid point is read from the last patch that references it
+    void GLWidget::_patches_to_quilt(const Matrix<BicubicBSplinePatch*> &patches, PatchQuilt3 &quilt)
+    {
+        GLuint n = quilt.GetPatchRowCount(), m = quilt.GetPatchColumnCount();
 
-        for (GLuint pi = 0; pi < n; ++pi)
-            for (GLuint pj = 0; pj < m; ++pj)
-                for (GLuint i = 0; i < 4; ++i)
-                    for (GLuint j = 0; j < 4; ++j) {
+        if (!n || !m)
+            return;
 
-                        DCoordinate3 point;
-                        _tpatch(pi,pj)->GetData(i,j,point);
-                        fs << point << endl;
-                    }
-        fs.close();
+        for (GLuint r = 0; r < quilt.GetRowCount(); ++r)
+            for (GLuint c = 0; c < quilt.GetColumnCount(); ++c) {
+                GLuint pi = min(r, n - 1), pj = min(c, m - 1);
+
+                patches(pi,pj)->GetData(r - pi, c - pj, quilt(r,c));
+            }
     }
 
-    void GLWidget::load_patch( Matrix<BicubicBSplinePatch*>& _tpatch ){
+    void GLWidget::save_patch(PatchQuilt3 &quilt, const Matrix<BicubicBSplinePatch*> &patches,
+                              const Matrix<TriangulatedMesh3*> &images){
+        // the cached images have to match the control points
+        makeCurrent();
+        _tessellation.Wait();
+        _receive_tessellations();
 
-        GLuint n, m;
+        _patches_to_quilt(patches, quilt);
 
-        fstream fs;
-        fs.open ("test.txt", fstream::in);
+        if (!quilt.Save("quilt.pqb", &images))
+            cout << "Could not save the patch quilt" << endl;
+    }
 
-        fs >> n >> m;
+    // the images cached in the file are only uploaded, otherwise they are generated by the worker
+    // threads of the tessellation queue, and appear as they are finished
+    void GLWidget::load_patch(){
+        Matrix<TriangulatedMesh3*> images;
 
-        _tpatch.ResizeRows(n);
-        _tpatch.ResizeColumns(m);
-        bi_loaded.ResizeColumns(m);
-        bi_loaded.ResizeRows(n);
+        if (!_quilt_loaded.Load("quilt.pqb", &images)) {
+            cout << "Could not load the patch quilt" << endl;
+            return;
+        }
 
-        for (GLuint i = 0; i < n; ++i)
-            for (GLuint j = 0; j < m; ++j) {
-                if (_tpatch(i,j) == NULL)
-                    _tpatch(i,j) = new BicubicBSplinePatch();
-            }
+        makeCurrent();
 
-        for (GLuint pi = 0; pi < n; ++pi)
-            for (GLuint pj = 0; pj < m; ++pj)
-                for (GLuint i = 0; i < 4; ++i)
-                    for (GLuint j = 0; j < 4; ++j) {
+        // the jobs of the previous quilt are superseded
+        _tessellation.Cancel(_tessellation_key(4, 0), _tessellation_key(4, 0xffffffffu));
 
-                        DCoordinate3 point;
-                        fs >> point;
-                        _tpatch(pi,pj)->SetData(i,j,point.x(),point.y(),point.z());
-                    }
+        for (GLuint pi = 0; pi < _patch_loaded.GetRowCount(); ++pi)
+            for (GLuint pj = 0; pj < _patch_loaded.GetColumnCount(); ++pj)
+                delete _patch_loaded(pi,pj), _patch_loaded(pi,pj) = 0;
+
+        for (GLuint pi = 0; pi < bi_loaded.GetRowCount(); ++pi)
+            for (GLuint pj = 0; pj < bi_loaded.GetColumnCount(); ++pj)
+                delete bi_loaded(pi,pj), bi_loaded(pi,pj) = 0;
+
+        GLuint n = _quilt_loaded.GetPatchRowCount();
+        GLuint m = _quilt_loaded.GetPatchColumnCount();
+
+        _patch_loaded.ResizeRows(0);
+        _patch_loaded.ResizeColumns(m);
+        _patch_loaded.ResizeRows(n);
+
+        _quilt_to_patches(_quilt_loaded, _patch_loaded);
+
+        if (images.GetRowCount() != n || images.GetColumnCount() != m) {
+            images.ResizeColumns(m);
+            images.ResizeRows(n);
+
+            for (GLuint p = 0; p < n * m; ++p)
+                _submit_patch_image(4, *_patch_loaded(p / m, p % m), p);
+        }
+
+        bi_loaded = images;
 
         for (GLuint pi = 0; pi < n; ++pi)
             for (GLuint pj = 0; pj < m; ++pj) {
-                _tpatch(pi,pj)->UpdateVertexBufferObjectsOfData();
-
-                bi_loaded(pi,pj) = _tpatch(pi,pj)->GenerateImage(30,30,GL_STATIC_DRAW);
+                _patch_loaded(pi,pj)->UpdateVertexBufferObjectsOfData();
 
                 if (bi_loaded(pi,pj))
                     bi_loaded(pi,pj)->UpdateVertexBufferObjects();
             }
 
-        fs.close();
+        _update_patch_batch(_batch_loaded, _bvh_loaded, bi_loaded, GL_FALSE);
+        _build_control_point_index(_cp_loaded, _patch_loaded, n);
     }
 
     void GLWidget::callsave(){
         switch(_patch_index){
         case 1:
-            save_patch(_patch_toroid);
+            save_patch(_quilt_toroid, _patch_toroid, bi_toroid);
             break;
         case 2:
-            save_patch(_patch_cylindric);
+            save_patch(_quilt_cylindric, _patch_cylindric, bi_cylindric);
             break;
         case 4:
-            save_patch(_patch_loaded);
+            save_patch(_quilt_loaded, _patch_loaded, bi_loaded);
             break;
         default:
             break;
@@ -1353,7 +2312,7 @@ namespace cagd
 
     void GLWidget::callload(){
         //_patch_index=4;
-        load_patch(_patch_loaded);
+        load_patch();
         updateGL();
     }
 
@@ -4,11 +4,23 @@
 #include <QGLWidget>
 #include <QGLFormat>
 #include <QTimer>
+#include <QElapsedTimer>
+#include <QFileSystemWatcher>
 
 #include "../Parametric/ParametricCurves3.h"
 #include "../Parametric/ParametricSurfaces3.h"
 #include "../Cyclic/CyclicCurve3.h"
 #include "../Core/ShaderPrograms.h"
+#include "../Core/ShaderManagers.h"
+#include "../Core/RenderBatches.h"
+#include "../Core/RenderQueues.h"
+#include "../Core/RenderPassProfilers.h"
+#include "../Core/BoundingVolumeHierarchies3.h"
+#include "../Core/ControlPointIndices3.h"
+#include "../Core/CurvatureAnalyses3.h"
+#include "../Core/SurfaceIntersections3.h"
+#include "../Core/PatchQuilts3.h"
+#include "../Core/TessellationQueues.h"
 #include "../B-spline/BicubicBSplinePatch.h"
 #include "../B-spline/BicubicBSplineArc.h"
 
@@ -38,7 +50,6 @@ namespace cagd
         int         _index, _cc_index, _page_index;
         int         _ps_index, _mo_index, _shader_index;
         int         _patch_index = 0;
-        int         _patch_i=1, _patch_j=1,_dcoord_i=1,_dcoord_j=1;
         double      _modify_x=0, _modify_y=0, _modify_z=0;
 
         // variables needed by parametric curves;
@@ -50,6 +61,28 @@ namespace cagd
         RowMatrix<ParametricSurface3*> _ps;
         RowMatrix<TriangulatedMesh3*> _image_of_ps;
         GLuint _num_of_ps;
+        GLuint _ps_u_div_point_count = 500, _ps_v_div_point_count = 500;
+
+        // picking: the hierarchies are built on the first click, those of the patch quilts are
+        // discarded whenever their images change
+        RowMatrix<BoundingVolumeHierarchy3> _bvh_of_ps;
+        RowMatrix<BoundingVolumeHierarchy3> _bvh_of_mo;
+        BoundingVolumeHierarchy3 _bvh_toroid, _bvh_cylindric, _bvh_loaded;
+
+        const BoundingVolumeHierarchy3 *_picked_hierarchy = nullptr;
+        DCoordinate3 _picked_point;
+
+        BoundingVolumeHierarchy3* _displayed_hierarchy();
+
+        // editing: the control nets of the quilts and arcs are indexed, the clicked control point is
+        // selected and moved by the modify spin boxes
+        ControlPointIndex3 _cp_toroid, _cp_cylindric, _cp_loaded, _cp_arcs;
+
+        const ControlPointIndex3 *_selected_index = nullptr;
+        GLuint _selected_control_point = 0;
+
+        ControlPointIndex3* _displayed_control_points();
+        void _apply_transformations();
 
         // CyclicCurve variables;
         GLuint _n;              // num of cyclic curve points
@@ -67,16 +100,60 @@ namespace cagd
         GLuint _mod;
         GLuint _div;
 
+        // curvature analyses are computed when a quantity is first selected for a surface or model,
+        // the selected quantities (0: none, otherwise CurvatureAnalysis3::Quantity + 1) are shown
+        // as color maps by the fixed-function pipeline
+        RowMatrix<CurvatureAnalysis3> _curvature_of_ps;
+        RowMatrix<CurvatureAnalysis3> _curvature_of_mo;
+        int _ps_curvature = 0, _mo_curvature = 0;
+
+        GLboolean _analyze_parametric_surface(GLuint index, CurvatureAnalysis3 &analysis,
+                                              GLuint u_div_point_count, GLuint v_div_point_count) const;
+        void _update_parametric_surface_curvature();
+        void _update_model_curvature();
+        void _show_curvature(const CurvatureAnalysis3 &analysis, TriangulatedMesh3 &mesh, int quantity);
+        void _render_colored_mesh(const TriangulatedMesh3 &mesh);
+
+        // horizontal plane sections of the models are computed when they are first shown, they
+        // follow neither the breathing animation nor the transformations of the vertex shader
+        RowMatrix<RowMatrix<GenericCurve3*>*> _slices_of_mo;
+        GLboolean _mo_slices = GL_FALSE;
+        GLuint _mo_slice_count = 100;
+
+        void _render_model_slices();
+
         // dynamic vertex buffers;
         QTimer* _timer;
         GLfloat _angle;
 
-        // variables needed by shaders
-        ShaderProgram _shader;
+        // the breathing animation of models is evaluated either by the vertex shader
+        // Shaders/displacement.vert, or, as a fallback, on the CPU via streamed vertex buffers
+        ShaderProgram *_displacement_shader = nullptr;
+        ShaderProgram::Uniform _displacement_time;
+        GLboolean _gpu_animation = GL_TRUE;
+
+        GLboolean _advance_animation();
+        GLdouble _breathing_displacement() const;
+
+        // the light is created once, meshes are rendered through a queue that only emits
+        // the changed shader, material and light states
+        DirectionalLight *_light = nullptr;
+        LightSet _light_set;
+        RenderQueue _render_queue;
+
+        // variables needed by shaders, all programs are owned by the manager, _shader points to
+        // the selected one
+        ShaderManager _shader_manager{"ShaderCache"};
+        ShaderProgram *_shader = nullptr;
+        QFileSystemWatcher *_shader_watcher;
+        QTimer *_shader_reload_timer;
         GLfloat _scale_factor = 1.0f;
         GLfloat _smoothing = 1.0f;
         GLfloat _shading = 1.0f;
 
+        GLvoid _configure_shaders();
+        GLvoid _watch_shader_sources();
+
         // B-spline Patch variables
         //BicubicBSplinePatch _patch;
         //BicubicBSplinePatch _patch2;
@@ -88,6 +165,13 @@ namespace cagd
         Matrix<BicubicBSplinePatch*> _patch_loaded;
         BicubicBSplinePatch _patch;
 
+        // shared control grids of the quilts, these are refreshed from the patches before saving,
+        // since editing only moves the control points of the patches
+        PatchQuilt3 _quilt_toroid, _quilt_cylindric, _quilt_loaded;
+
+        void _quilt_to_patches(const PatchQuilt3 &quilt, Matrix<BicubicBSplinePatch*> &patches);
+        void _patches_to_quilt(const Matrix<BicubicBSplinePatch*> &patches, PatchQuilt3 &quilt);
+
         RowMatrix<GenericCurve3*>* _uLines;
         RowMatrix<GenericCurve3*>* _vLines;
         Matrix<RowMatrix<GenericCurve3*>*> _patch_uLines_toroid;
@@ -103,6 +187,38 @@ namespace cagd
 
         TriangulatedMesh3 *_before_interpolation, *_after_interpolation;
 
+        // the images and isoparametric lines of patch quilts packed into shared buffers,
+        // these have to be refilled whenever the corresponding images change
+        RenderBatch _batch_toroid;
+        RenderBatch _batch_cylindric;
+        RenderBatch _batch_loaded;
+
+        void _update_patch_batch(RenderBatch &batch, BoundingVolumeHierarchy3 &hierarchy,
+                                 const Matrix<TriangulatedMesh3*> &images, GLboolean checkerboard,
+                                 const Matrix<RowMatrix<GenericCurve3*>*> *u_lines = 0,
+                                 const Matrix<RowMatrix<GenericCurve3*>*> *v_lines = 0);
+        void _build_patch_hierarchy(BoundingVolumeHierarchy3 &hierarchy, const Matrix<TriangulatedMesh3*> &images);
+        void _build_control_point_index(ControlPointIndex3 &index, const Matrix<BicubicBSplinePatch*> &patches,
+                                        GLuint row_count);
+        void _move_patch_control_point(const ControlPointIndex3 &index, GLuint point,
+                                       const Matrix<BicubicBSplinePatch*> &patches, GLuint quilt);
+
+        // the images of edited or loaded patches and of edited arcs are generated by worker threads
+        // from copies of their control nets, and uploaded by paintGL(); the key of a job combines the
+        // quilt (the patch index of the side widget, 3 stands for the arcs) with the row-major index
+        // of the patch or the index of the arc; the batch of a quilt is refreshed once its jobs are
+        // finished, but at least four times a second
+        TessellationQueue _tessellation;
+        GLuint _outdated_batches = 0;           // bit q is set if the batch of the quilt q is outdated
+        QElapsedTimer _batch_refresh_timer;
+
+        static GLuint64 _tessellation_key(GLuint quilt, GLuint index);
+        Matrix<TriangulatedMesh3*>* _quilt_images(GLuint quilt);
+        void _submit_patch_image(GLuint quilt, const BicubicBSplinePatch &patch, GLuint index);
+        void _submit_arc_image(GLuint index);
+        void _receive_tessellations();
+        void _refresh_patch_batch(GLuint quilt);
+
         // B-spline Arc variables
         // GLuint _n;              // num of Arc points points, 4 by default
         RowMatrix<BicubicBSplineArc*> _bspa;
@@ -112,6 +228,18 @@ namespace cagd
         ColumnMatrix<GLdouble>      _interp_bspa_nodes;
         ColumnMatrix<DCoordinate3>  _interp_bspa_derivatives;
 
+        // the zones and counters of the last frame are shown over the scene if the application was
+        // started with "--profile" (and built with CAGD_PROFILING, see Core/Profilers.h)
+        GLboolean _profiler_overlay = GL_FALSE;
+
+        // GPU and CPU times of the passes of paintGL(), the rolling window of the frame times is
+        // written on exit into the files given by "--frame-times" and "--frame-histogram"
+        RenderPassProfiler _render_passes;
+        QString _frame_times_file_name, _frame_histogram_file_name;
+
+        void _render_frame();
+        void _render_profiler_overlay();
+
     public:
         // special and default constructor
         // the format specifies the properties of the rendering window
@@ -121,6 +249,7 @@ namespace cagd
         void initializeGL();
         void paintGL();
         void resizeGL(int w, int h);
+        void mousePressEvent(QMouseEvent *event);
 
         virtual ~GLWidget();
 
@@ -140,6 +269,9 @@ namespace cagd
         void set_cyclic_curve_index(int index);
         void set_parametric_surface_index(int index);
         void set_models_index(int index);
+        void set_parametric_surface_curvature(int quantity);
+        void set_models_curvature(int quantity);
+        void set_models_slices(bool value);
 
         void init_parametric_curves();
         void init_cyclic_curves();
@@ -147,7 +279,10 @@ namespace cagd
         void init_models();
         void init_patch();
         void init_bspline_arc();
+        void init_shaders();
         void init_shader(int index);
+        void reload_shaders();
+        void _shader_source_changed(const QString &file_name);
 
         void render_pc();
         void render_cc();
@@ -159,21 +294,22 @@ namespace cagd
         void _animate();
         void start_animate();
         void stop_animate();
+        void set_gpu_animation(bool value);
+        void benchmark_animation();
+        void benchmark_curvature();
+        void benchmark_intersections();
         void set_shader_scale_factor(double value);
         void set_shader_smoothing(double value);
         void set_shader_shading(double value);
         void set_shader_index(int index);
         void set_patch_index(int index);
         void modify();
-        void set_patch_i(double value);
-        void set_patch_j(double value);
-        void set_dcoord_i(double value);
-        void set_dcoord_j(double value);
         void set_modify_x(double value);
         void set_modify_y(double value);
         void set_modify_z(double value);
-        void save_patch( const Matrix<BicubicBSplinePatch*>& _tpatch );
-        void load_patch( Matrix<BicubicBSplinePatch*>& _tpatch );
+        void save_patch(PatchQuilt3 &quilt, const Matrix<BicubicBSplinePatch*> &patches,
+                        const Matrix<TriangulatedMesh3*> &images);
+        void load_patch();
         void callload();
         void callsave();
 
@@ -58,10 +58,14 @@ namespace cagd
 
         // parametric surfaces
         connect(_side_widget->ps_combo, SIGNAL(currentIndexChanged(int)), _gl_widget, SLOT(set_parametric_surface_index(int)));
+        connect(_side_widget->ps_curvature_combo, SIGNAL(currentIndexChanged(int)), _gl_widget, SLOT(set_parametric_surface_curvature(int)));
         // models
         connect(_side_widget->mo_combo, SIGNAL(currentIndexChanged(int)), _gl_widget, SLOT(set_models_index(int)));
         connect(_side_widget->start_animate,SIGNAL(pressed()), _gl_widget, SLOT(start_animate()));
         connect(_side_widget->stop_animate,SIGNAL(pressed()), _gl_widget, SLOT(stop_animate()));
+        connect(_side_widget->gpu_animate,SIGNAL(toggled(bool)), _gl_widget, SLOT(set_gpu_animation(bool)));
+        connect(_side_widget->mo_curvature_combo, SIGNAL(currentIndexChanged(int)), _gl_widget, SLOT(set_models_curvature(int)));
+        connect(_side_widget->mo_slices, SIGNAL(toggled(bool)), _gl_widget, SLOT(set_models_slices(bool)));
 
         // shaders
         connect(_side_widget->SpinBoxScale,SIGNAL(valueChanged(double)),_gl_widget, SLOT(set_shader_scale_factor(double)));
@@ -72,10 +76,6 @@ namespace cagd
         // patches
         connect(_side_widget->patch_comb,SIGNAL(currentIndexChanged(int)),_gl_widget,SLOT(set_patch_index(int)));
 
-        connect(_side_widget->patch_i,SIGNAL(valueChanged(double)),_gl_widget, SLOT(set_patch_i(double)));
-        connect(_side_widget->patch_j,SIGNAL(valueChanged(double)),_gl_widget, SLOT(set_patch_j(double)));
-        connect(_side_widget->dcoord_i,SIGNAL(valueChanged(double)),_gl_widget, SLOT(set_dcoord_i(double)));
-        connect(_side_widget->dcoord_j,SIGNAL(valueChanged(double)),_gl_widget, SLOT(set_dcoord_j(double)));
         connect(_side_widget->modify_x,SIGNAL(valueChanged(double)),_gl_widget, SLOT(set_modify_x(double)));
         connect(_side_widget->modify_y,SIGNAL(valueChanged(double)),_gl_widget, SLOT(set_modify_y(double)));
         connect(_side_widget->modify_z,SIGNAL(valueChanged(double)),_gl_widget, SLOT(set_modify_z(double)));
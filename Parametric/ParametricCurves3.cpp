@@ -1,4 +1,5 @@
 #include "ParametricCurves3.h"
+#include "../Core/Profilers.h"
 
 using namespace cagd;
 using namespace std;
@@ -26,6 +27,9 @@ DCoordinate3 ParametricCurve3::operator ()(GLuint order, GLdouble u) const
 // generate image of the parametric curve
 GenericCurve3* ParametricCurve3::GenerateImage(GLuint div_point_count, GLenum usage_flag) const
 {
+    CAGD_PROFILE_ZONE("ParametricCurve3::GenerateImage");
+    CAGD_PROFILE_COUNT(SAMPLES, div_point_count);
+
     GenericCurve3* result = nullptr;
 
     result = new GenericCurve3(_derivatives.GetColumnCount() - 1, div_point_count, usage_flag);
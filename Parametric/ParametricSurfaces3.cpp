@@ -1,4 +1,5 @@
 #include "ParametricSurfaces3.h"
+#include "../Core/Profilers.h"
 
 #include <cstdlib>
 #include <cmath>
@@ -19,6 +20,68 @@ namespace cagd
     {
     }
 
+    GLvoid ParametricSurface3::GetUInterval(GLdouble &u_min, GLdouble &u_max) const
+    {
+        u_min = _u_min;
+        u_max = _u_max;
+    }
+
+    GLvoid ParametricSurface3::GetVInterval(GLdouble &v_min, GLdouble &v_max) const
+    {
+        v_min = _v_min;
+        v_max = _v_max;
+    }
+
+    GLboolean ParametricSurface3::CalculatePartialDerivatives(
+            GLuint maximum_order, GLdouble u, GLdouble v,
+            TriangularMatrix<DCoordinate3> &pd) const
+    {
+        if (maximum_order > 2 || pd.GetRowCount() < maximum_order + 1 ||
+            _pd.GetRowCount() < min(maximum_order + 1, 2u))
+        {
+            return GL_FALSE;
+        }
+
+        for (GLuint r = 0; r <= min(maximum_order, 1u); ++r)
+        {
+            for (GLuint c = 0; c <= r; ++c)
+            {
+                if (!_pd(r, c))
+                    return GL_FALSE;
+
+                pd(r, c) = _pd(r, c)(u, v);
+            }
+        }
+
+        if (maximum_order < 2)
+            return GL_TRUE;
+
+        if (_pd.GetRowCount() > 2 && _pd(2, 0) && _pd(2, 1) && _pd(2, 2))
+        {
+            pd(2, 0) = _pd(2, 0)(u, v);
+            pd(2, 1) = _pd(2, 1)(u, v);
+            pd(2, 2) = _pd(2, 2)(u, v);
+
+            return GL_TRUE;
+        }
+
+        // the differences are one-sided at the boundary of the domain
+        GLdouble hu = 1.0e-5 * (_u_max - _u_min), hv = 1.0e-5 * (_v_max - _v_min);
+
+        GLdouble u0 = max(_u_min, u - hu), u1 = min(_u_max, u + hu);
+        GLdouble v0 = max(_v_min, v - hv), v1 = min(_v_max, v + hv);
+
+        pd(2, 0) = (_pd(1, 0)(u1, v) - _pd(1, 0)(u0, v)) / (u1 - u0);
+        pd(2, 2) = (_pd(1, 1)(u, v1) - _pd(1, 1)(u, v0)) / (v1 - v0);
+
+        // the mixed derivative is the average of both approximations
+        pd(2, 1)  = (_pd(1, 0)(u, v1) - _pd(1, 0)(u, v0)) / (v1 - v0);
+        pd(2, 1) += (_pd(1, 1)(u1, v) - _pd(1, 1)(u0, v)) / (u1 - u0);
+        pd(2, 1) *= 0.5;
+
+        return GL_TRUE;
+    }
+
     // generates the approximated tesselated image of the parametric surface
     TriangulatedMesh3* ParametricSurface3::GenerateImage(
         GLuint u_div_point_count,
@@ -32,6 +95,9 @@ namespace cagd
             return 0;
         }
 
+        CAGD_PROFILE_ZONE("ParametricSurface3::GenerateImage");
+        CAGD_PROFILE_COUNT(SAMPLES, u_div_point_count * v_div_point_count);
+
         TriangulatedMesh3 *result = 0;
 
         result = new (nothrow) TriangulatedMesh3(
@@ -26,6 +26,18 @@ namespace cagd
                 GLdouble u_min, GLdouble u_max,
                 GLdouble v_min, GLdouble v_max);
 
+        // get the definition domain
+        GLvoid GetUInterval(GLdouble &u_min, GLdouble &u_max) const;
+        GLvoid GetVInterval(GLdouble &v_min, GLdouble &v_max) const;
+
+        // evaluates the surface point and its partial derivatives up to the order 2 at (u, v), pd has
+        // to be a triangular matrix of maximum_order + 1 rows; second order partial derivatives whose
+        // function pointers are not given are approximated by central differences of the first order
+        // ones
+        GLboolean CalculatePartialDerivatives(
+                GLuint maximum_order, GLdouble u, GLdouble v,
+                TriangularMatrix<DCoordinate3> &pd) const;
+
         // generates the approximated tesselated image of the parametric surface
         TriangulatedMesh3* GenerateImage(
                 GLuint u_div_point_count,           // number of subdivision points in direction u
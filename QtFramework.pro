@@ -1,6 +1,9 @@
 QT += core gui widgets opengl
 CONFIG += console
 
+# scoped timers and counters of Core/Profilers.h, remove to compile the instrumentation out
+DEFINES += CAGD_PROFILING
+
 win32 {
     message("Windows platform...")
 
@@ -28,7 +31,7 @@ win32 {
     }
 
     msvc {
-      QMAKE_CXXFLAGS += -openmp -arch:AVX -D "_CRT_SECURE_NO_WARNINGS"
+      QMAKE_CXXFLAGS += -arch:AVX -D "_CRT_SECURE_NO_WARNINGS"
       QMAKE_CXXFLAGS_RELEASE *= -O2
     }
 }
@@ -41,6 +44,17 @@ mac {
 unix {
     # for GLEW installed into /usr/lib/libGLEW.so or /usr/lib/glew.lib
     LIBS += -lGLEW -lGLU
+
+    # the worker threads of Core/TaskSchedulers
+    QMAKE_CXXFLAGS += -pthread
+    QMAKE_LFLAGS   += -pthread
+}
+
+linux {
+    # headless rendering contexts of Core/HeadlessContexts, e.g. for "--headless" on machines
+    # without a GPU (Mesa's llvmpipe)
+    DEFINES += CAGD_HEADLESS_EGL
+    LIBS    += -lEGL
 }
 
 HEADERS += \
@@ -58,6 +72,7 @@ HEADERS += \
     GUI/SideWidget.h \
     Parametric/ParametricCurves3.h \
     Test/TestFunctions.h \
+    Test/HeadlessBenchmarks.h \
     Parametric/ParametricSurfaces3.h \
     Core/HCoordinates3.h \
     Core/TCoordinates4.h \
@@ -68,6 +83,27 @@ HEADERS += \
     Core/Materials.h \
     Core/TensorProductSurfaces3.h \
     Core/ShaderPrograms.h \
+    Core/StreamingBuffers.h \
+    Core/RenderBatches.h \
+    Core/ShaderManagers.h \
+    Core/RenderStates.h \
+    Core/RenderQueues.h \
+    Core/SymmetricBandedMatrices.h \
+    Core/KdTrees3.h \
+    Core/Projectors3.h \
+    Core/BoundingVolumeHierarchies3.h \
+    Core/ControlPointIndices3.h \
+    Core/CurvatureAnalyses3.h \
+    Core/SurfaceIntersections3.h \
+    Core/PatchQuilts3.h \
+    Core/MappedFiles.h \
+    Core/StreamingOFFConverters.h \
+    Core/TaskSchedulers.h \
+    Core/TessellationQueues.h \
+    Core/Profilers.h \
+    Core/RenderPassProfilers.h \
+    Core/HeadlessContexts.h \
+    Core/OffscreenRenderers.h \
     Core/LinearCombination3.h \
     Core/ShaderPrograms.h \
     Core/TCoordinates4.h \
@@ -78,7 +114,10 @@ HEADERS += \
     GUI/SideWidget.h \
     B-spline/BicubicBSplinePatch.h \
     B-spline/BicubicBSplineArc.h \
-    B-spline/BicubicBSplineArc.h
+    B-spline/BicubicBSplineArc.h \
+    B-spline/BSplineBasis.h \
+    B-spline/BSplineCurve3.h \
+    B-spline/BSplineSurface3.h
 
 
 SOURCES += \
@@ -91,6 +130,7 @@ SOURCES += \
     GUI/SideWidget.cpp \
     Parametric/ParametricCurves3.cpp \
     Test/TestFunctions.cpp \
+    Test/HeadlessBenchmarks.cpp \
     main.cpp \
     Parametric/ParametricSurfaces3.cpp \
     Core/TriangulatedMeshes3.cpp \
@@ -98,8 +138,32 @@ SOURCES += \
     Core/Materials.cpp \
     Core/TensorProductSurfaces3.cpp \
     Core/ShaderPrograms.cpp \
+    Core/StreamingBuffers.cpp \
+    Core/RenderBatches.cpp \
+    Core/ShaderManagers.cpp \
+    Core/RenderStates.cpp \
+    Core/RenderQueues.cpp \
+    Core/SymmetricBandedMatrices.cpp \
+    Core/KdTrees3.cpp \
+    Core/Projectors3.cpp \
+    Core/BoundingVolumeHierarchies3.cpp \
+    Core/ControlPointIndices3.cpp \
+    Core/CurvatureAnalyses3.cpp \
+    Core/SurfaceIntersections3.cpp \
+    Core/PatchQuilts3.cpp \
+    Core/MappedFiles.cpp \
+    Core/StreamingOFFConverters.cpp \
+    Core/TaskSchedulers.cpp \
+    Core/TessellationQueues.cpp \
+    Core/Profilers.cpp \
+    Core/RenderPassProfilers.cpp \
+    Core/HeadlessContexts.cpp \
+    Core/OffscreenRenderers.cpp \
     B-spline/BicubicBSplinePatch.cpp \
-    B-spline/BicubicBSplineArc.cpp
+    B-spline/BicubicBSplineArc.cpp \
+    B-spline/BSplineBasis.cpp \
+    B-spline/BSplineCurve3.cpp \
+    B-spline/BSplineSurface3.cpp
 
 FORMS += \
     GUI/MainWindow.ui \
@@ -0,0 +1,39 @@
+/*
+Breathing animation of models evaluated on the GPU. The CPU animation moves every vertex by
+amplitude * sin(k * angle_step) along its normal vector in the kth step, thus after K steps
+the total displacement is
+
+        amplitude * sum_{k=1}^{K} sin(k * angle_step) =
+        amplitude * sin(time / 2) * sin((time + angle_step) / 2) / sin(angle_step / 2),
+
+where time = K * angle_step. Since this is periodic, the application may wrap time into [0, 2pi).
+Only the uniform variable time has to be updated per frame.
+
+The varying variables are consumed by two_sided_lighting.frag.
+*/
+
+uniform float time;
+uniform float angle_step;
+uniform float amplitude;
+
+varying vec3 normal;
+varying vec3 vertex;
+
+void main()
+{
+    float half_step    = 0.5 * angle_step;
+    float displacement = 0.0;
+
+    if (abs(sin(half_step)) > 1.0e-6)
+        displacement = amplitude * sin(0.5 * time) * sin(0.5 * time + half_step) / sin(half_step);
+
+    vec4 position = gl_Vertex + vec4(displacement * gl_Normal, 0.0);
+
+    // calculate and normalize the normal vector
+    normal = normalize(gl_NormalMatrix * gl_Normal);
+
+    // transform the displaced vertex position to eye space
+    vertex = vec3(gl_ModelViewMatrix * position);
+
+    gl_Position = gl_ModelViewProjectionMatrix * position;
+}
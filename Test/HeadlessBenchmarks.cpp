@@ -0,0 +1,475 @@
+#include "HeadlessBenchmarks.h"
+
+#include <GL/glew.h>
+#include <GL/glu.h>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../B-spline/BicubicBSplinePatch.h"
+#include "../Core/Constants.h"
+#include "../Core/HeadlessContexts.h"
+#include "../Core/Lights.h"
+#include "../Core/Materials.h"
+#include "../Core/Matrices.h"
+#include "../Core/OffscreenRenderers.h"
+#include "../Core/PatchQuilts3.h"
+#include "../Core/RenderBatches.h"
+#include "../Core/RenderPassProfilers.h"
+#include "../Core/RenderQueues.h"
+#include "../Core/RenderStates.h"
+#include "../Core/ShaderManagers.h"
+#include "../Core/TaskSchedulers.h"
+#include "../Core/TriangulatedMeshes3.h"
+
+using namespace std;
+
+namespace cagd
+{
+    // the golden images have this size
+    static const GLuint headless_image_width  = 640;
+    static const GLuint headless_image_height = 480;
+
+    class HeadlessBenchmarkOptions
+    {
+    public:
+        GLuint    frame_count;
+        string    golden_directory;
+        GLboolean update_golden;
+        string    output_directory;
+        GLint     tolerance;
+        GLdouble  max_differing_percentage;
+        GLdouble  min_fps;
+        string    results_file_name;
+
+        HeadlessBenchmarkOptions():
+                frame_count(100),
+                golden_directory("Test/Golden"), update_golden(GL_FALSE),
+                output_directory("."),
+                tolerance(8), max_differing_percentage(0.5), min_fps(0.0)
+        {
+        }
+    };
+
+    class HeadlessScene
+    {
+    public:
+        string                          name;
+        string                          file_name;  // of the golden image, without the directory
+        function<GLvoid(GLdouble)>      render;     // renders the scene rotated by the given angle
+    };
+
+    // the toroidal quilt of the patch page of GLWidget: every control point is stored once by the
+    // quilt, both of its directions are closed
+    class HeadlessToroidalQuilt
+    {
+    protected:
+        GLuint                              _row_count, _column_count;
+        Matrix<BicubicBSplinePatch*>        _patch;
+        RenderBatch                         _batch;
+
+    public:
+        HeadlessToroidalQuilt(): _row_count(10), _column_count(12), _patch(_row_count, _column_count)
+        {
+            for (GLuint pi = 0; pi < _row_count; ++pi)
+                for (GLuint pj = 0; pj < _column_count; ++pj)
+                    _patch(pi, pj) = nullptr;
+        }
+
+        GLboolean Create(const ShaderProgram *shader)
+        {
+            const GLuint   iso_line_count = 5, div_point_count = 200;
+            const GLdouble r = 0.75, R = 1.5;
+
+            PatchQuilt3 quilt(_row_count, _column_count, GL_TRUE, GL_TRUE);
+
+            for (GLuint i = 0; i < _row_count; ++i)
+                for (GLuint j = 0; j < _column_count; ++j)
+                {
+                    GLdouble u = TWO_PI * i / _row_count, v = TWO_PI * j / _column_count;
+
+                    quilt(i, j) = DCoordinate3((R + r * sin(u)) * cos(v), (R + r * sin(u)) * sin(v), r * cos(u));
+                }
+
+            Color4 u_line_color(1.0, 0.0, 0.0);
+            Color4 v_line_color(0.0, 0.0, 1.0);
+
+            for (GLuint pi = 0; pi < _row_count; ++pi)
+                for (GLuint pj = 0; pj < _column_count; ++pj)
+                {
+                    BicubicBSplinePatch *patch = _patch(pi, pj) = new BicubicBSplinePatch();
+
+                    for (GLuint i = 0; i < 4; ++i)
+                        for (GLuint j = 0; j < 4; ++j)
+                            patch->SetData(i, j, quilt.ControlPoint(pi, pj, i, j));
+
+                    if (!patch->UpdateVertexBufferObjectsOfData())
+                        return GL_FALSE;
+
+                    // the batch copies the geometry
+                    TriangulatedMesh3 *image = patch->GenerateImage(30, 30);
+
+                    if (!image)
+                        return GL_FALSE;
+
+                    _batch.AddMesh(*image, (pi + pj) % 2 ? MatFBSilver : MatFBRuby, shader);
+                    delete image;
+
+                    RowMatrix<GenericCurve3*> *u_lines = patch->GenerateUIsoparametricLines(iso_line_count, 1, div_point_count);
+                    RowMatrix<GenericCurve3*> *v_lines = patch->GenerateVIsoparametricLines(iso_line_count, 1, div_point_count);
+
+                    for (GLuint i = 0; i < iso_line_count; ++i)
+                    {
+                        if (u_lines && (*u_lines)[i])
+                            _batch.AddCurve(*(*u_lines)[i], u_line_color);
+
+                        if (v_lines && (*v_lines)[i])
+                            _batch.AddCurve(*(*v_lines)[i], v_line_color);
+                    }
+
+                    for (GLuint i = 0; i < iso_line_count; ++i)
+                    {
+                        if (u_lines)
+                            delete (*u_lines)[i];
+
+                        if (v_lines)
+                            delete (*v_lines)[i];
+                    }
+
+                    delete u_lines;
+                    delete v_lines;
+                }
+
+            return _batch.UpdateVertexBufferObjects();
+        }
+
+        GLvoid Render(const LightSet &lights) const
+        {
+            lights.Enable();
+            RenderState::Enable(GL_NORMALIZE);
+
+            _batch.RenderMeshes();
+
+            lights.Disable();
+            RenderState::Disable(GL_NORMALIZE);
+
+            glColor3f(1.0f, 1.0f, 1.0f);
+
+            for (GLuint pi = 0; pi < _row_count; ++pi)
+                for (GLuint pj = 0; pj < _column_count; ++pj)
+                    _patch(pi, pj)->RenderData(GL_LINE_STRIP);
+
+            _batch.RenderCurves();
+
+            glColor3f(1.0f, 1.0f, 1.0f);
+        }
+
+        ~HeadlessToroidalQuilt()
+        {
+            for (GLuint pi = 0; pi < _row_count; ++pi)
+                for (GLuint pj = 0; pj < _column_count; ++pj)
+                    delete _patch(pi, pj);
+        }
+    };
+
+    static GLvoid SetUpHeadlessFrame(GLdouble angle)
+    {
+        glMatrixMode(GL_PROJECTION);
+        glLoadIdentity();
+        gluPerspective(45.0, (GLdouble)headless_image_width / headless_image_height, 1.0, 1000.0);
+
+        glMatrixMode(GL_MODELVIEW);
+        glLoadIdentity();
+        gluLookAt(0.0, 0.0, 6.0, 0.0, 0.0, 0.0, 0.0, 1.0, 0.0);
+
+        // the scenes are tilted towards the viewer, and turned around the vertical axis
+        glRotated(-30.0, 1.0, 0.0, 0.0);
+        glRotated(angle, 0.0, 1.0, 0.0);
+
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    }
+
+    // renders the first frame and compares it to the golden image, then measures a full turn
+    static GLboolean RunHeadlessScene(const HeadlessScene &scene, OffscreenRenderer &renderer,
+                                      const HeadlessBenchmarkOptions &options, ofstream &results)
+    {
+        GLboolean passed = GL_TRUE;
+
+        OffscreenRenderer::Image image;
+
+        if (!renderer.Render([&scene]() { scene.render(0.0); }, &image))
+        {
+            cout << "\t" << scene.name << ": could not be rendered" << endl;
+            return GL_FALSE;
+        }
+
+        string golden_file_name = options.golden_directory + "/" + scene.file_name;
+        string comparison;
+
+        OffscreenRenderer::Difference difference = {0, 0, 0.0};
+
+        if (options.update_golden)
+        {
+            if (image.SaveToPPM(golden_file_name))
+                comparison = "golden image updated";
+            else
+            {
+                comparison = "could not write " + golden_file_name;
+                passed = GL_FALSE;
+            }
+        }
+        else
+        {
+            OffscreenRenderer::Image golden, difference_image;
+
+            if (!golden.LoadFromPPM(golden_file_name))
+            {
+                comparison = "could not read " + golden_file_name;
+                passed = GL_FALSE;
+            }
+            else if (!OffscreenRenderer::Compare(image, golden, options.tolerance, difference, &difference_image))
+            {
+                comparison = "the size of the golden image differs";
+                passed = GL_FALSE;
+            }
+            else
+            {
+                GLdouble percentage = 100.0 * difference.pixel_count / (image.width * image.height);
+
+                comparison = to_string(difference.pixel_count) + " pixels (" + to_string(percentage) +
+                             "%) differ, maximum " + to_string(difference.maximum) +
+                             ", mean " + to_string(difference.mean);
+
+                if (percentage > options.max_differing_percentage)
+                {
+                    passed = GL_FALSE;
+
+                    difference_image.SaveToPPM(options.output_directory + "/difference_" + scene.file_name);
+                }
+            }
+
+            if (!passed)
+                image.SaveToPPM(options.output_directory + "/" + scene.file_name);
+        }
+
+        // every frame is finished before the next one starts, as with a swap of buffers
+        RenderPassProfiler passes;
+        passes.SetEnabled(GL_TRUE);
+
+        renderer.Begin();
+
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+        for (GLuint frame = 0; frame < options.frame_count; ++frame)
+        {
+            passes.BeginFrame();
+            passes.BeginPass(scene.name);
+
+            scene.render(360.0 * frame / options.frame_count);
+
+            passes.EndFrame();
+
+            glFinish();
+        }
+
+        GLdouble total = chrono::duration<GLdouble, milli>(chrono::steady_clock::now() - start).count();
+
+        renderer.End();
+
+        // the results of the last frames are available after glFinish()
+        passes.BeginFrame();
+        passes.EndFrame();
+
+        GLdouble gpu_time = 0.0;
+        GLuint   gpu_frame_count = 0;
+
+        for (deque<RenderPassProfiler::FrameRecord>::const_iterator it = passes.GetFrames().begin();
+             it != passes.GetFrames().end(); ++it)
+            if (it->GPUTime() > 0.0)
+            {
+                gpu_time += it->GPUTime();
+                ++gpu_frame_count;
+            }
+
+        GLdouble frame_time = options.frame_count ? total / options.frame_count : 0.0;
+        GLdouble fps        = total > 0.0 ? 1.0e3 * options.frame_count / total : 0.0;
+
+        if (gpu_frame_count)
+            gpu_time /= gpu_frame_count;
+
+        if (options.frame_count && fps < options.min_fps)
+            passed = GL_FALSE;
+
+        cout << "\t" << scene.name << ": " << frame_time << " ms/frame, " << fps << " frames/s";
+
+        if (gpu_frame_count)
+            cout << ", GPU " << gpu_time << " ms/frame";
+
+        cout << ", " << comparison << (passed ? "" : " - FAILED") << endl;
+
+        if (results.is_open())
+        {
+            results << scene.file_name << "," << options.frame_count << "," << frame_time << "," << fps << ",";
+
+            if (gpu_frame_count)
+                results << gpu_time;
+
+            results << "," << difference.pixel_count << "," << difference.maximum << "," << difference.mean
+                    << "," << (passed ? "passed" : "failed") << "\n";
+        }
+
+        return passed;
+    }
+
+    int RunHeadlessBenchmark(int argc, char **argv)
+    {
+        HeadlessBenchmarkOptions options;
+
+        for (int i = 1; i < argc; ++i)
+        {
+            string argument = argv[i];
+            GLboolean has_value = (i + 1 < argc);
+
+            if (argument == "--update-golden")
+                options.update_golden = GL_TRUE;
+            else if (!has_value)
+                continue;
+            else if (argument == "--frames")
+                options.frame_count = (GLuint)atoi(argv[++i]);
+            else if (argument == "--golden")
+                options.golden_directory = argv[++i];
+            else if (argument == "--output")
+                options.output_directory = argv[++i];
+            else if (argument == "--tolerance")
+                options.tolerance = atoi(argv[++i]);
+            else if (argument == "--max-differing")
+                options.max_differing_percentage = atof(argv[++i]);
+            else if (argument == "--min-fps")
+                options.min_fps = atof(argv[++i]);
+            else if (argument == "--results")
+                options.results_file_name = argv[++i];
+            else if (argument == "--threads")
+                TaskScheduler::Instance().SetThreadCount((GLuint)atoi(argv[++i]));
+        }
+
+        if (!HeadlessContext::IsSupported())
+        {
+            cout << "Headless rendering requires EGL, see CAGD_HEADLESS_EGL in QtFramework.pro" << endl;
+            return 2;
+        }
+
+        HeadlessContext context;
+
+        if (!context.Create())
+        {
+            cout << "Could not create a headless rendering context" << endl;
+            return 2;
+        }
+
+        OffscreenRenderer renderer;
+
+        if (!renderer.Create(headless_image_width, headless_image_height))
+        {
+            cout << "Could not create a framebuffer object of "
+                 << headless_image_width << "x" << headless_image_height << " pixels" << endl;
+            return 2;
+        }
+
+        // the context is new, nothing is known about its fixed-function state
+        RenderState::Invalidate();
+
+        glEnable(GL_DEPTH_TEST);
+        glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+
+        // the default program of GLWidget, the binaries are not cached
+        ShaderManager shader_manager;
+        GLuint shader_index = shader_manager.Register("Shaders/two_sided_lighting.vert", "Shaders/two_sided_lighting.frag");
+
+        if (!shader_manager.Install())
+        {
+            cout << "Could not install the shader programs" << endl;
+            return 2;
+        }
+
+        const ShaderProgram *shader = &shader_manager[shader_index];
+
+        HCoordinate3 direction(0.0, 0.0, 1.0, 0.0);
+        Color4 ambient(0.4, 0.4, 0.4, 1.0);
+        Color4 diffuse(0.8, 0.8, 0.8, 1.0);
+        Color4 specular(1.0, 1.0, 1.0, 1.0);
+
+        DirectionalLight light(GL_LIGHT0, direction, ambient, diffuse, specular);
+        LightSet         lights;
+        lights.Insert(&light);
+
+        HeadlessToroidalQuilt quilt;
+
+        if (!quilt.Create(shader))
+        {
+            cout << "Could not create the toroidal quilt" << endl;
+            return 2;
+        }
+
+        TriangulatedMesh3 elephant;
+
+        if (!elephant.LoadFromOFF("Models/elephant.off", GL_TRUE) || !elephant.UpdateVertexBufferObjects())
+        {
+            cout << "Could not load Models/elephant.off" << endl;
+            return 2;
+        }
+
+        RenderQueue queue;
+
+        vector<HeadlessScene> scenes(2);
+
+        scenes[0].name      = "toroidal quilt";
+        scenes[0].file_name = "toroidal_quilt.ppm";
+        scenes[0].render    = [&quilt, &lights](GLdouble angle)
+                              {
+                                  SetUpHeadlessFrame(angle);
+                                  quilt.Render(lights);
+                              };
+
+        scenes[1].name      = "elephant";
+        scenes[1].file_name = "elephant.ppm";
+        scenes[1].render    = [&elephant, &queue, &lights, shader](GLdouble angle)
+                              {
+                                  SetUpHeadlessFrame(angle);
+
+                                  // the model is scaled into the unit cube by LoadFromOFF()
+                                  glScaled(3.0, 3.0, 3.0);
+
+                                  queue.Submit(elephant, MatFBRuby, shader, &lights);
+                                  queue.Flush();
+                              };
+
+        ofstream results;
+
+        if (!options.results_file_name.empty())
+        {
+            results.open(options.results_file_name.c_str(), ios_base::out);
+
+            if (results.good())
+                results << "scene,frames,frame_time_ms,fps,gpu_time_ms,differing_pixels,maximum_difference,mean_difference,result\n";
+            else
+                cout << "Could not write the results " << options.results_file_name << endl;
+        }
+
+        cout << "Headless benchmark: " << glGetString(GL_RENDERER) << ", "
+             << headless_image_width << "x" << headless_image_height << " pixels, "
+             << options.frame_count << " frames per scene" << endl;
+
+        GLboolean passed = GL_TRUE;
+
+        for (GLuint i = 0; i < scenes.size(); ++i)
+            if (!RunHeadlessScene(scenes[i], renderer, options, results))
+                passed = GL_FALSE;
+
+        return passed ? 0 : 1;
+    }
+}
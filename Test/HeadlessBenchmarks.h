@@ -0,0 +1,29 @@
+#pragma once
+
+namespace cagd
+{
+    // Renders the standard scenes (the toroidal quilt of bicubic B-spline patches together with its
+    // control net and isoparametric lines, and the elephant model) offscreen in a HeadlessContext,
+    // thus neither a window system nor a GPU is needed, e.g. Mesa's llvmpipe suffices.
+    //
+    // For every scene the average frame time and frame rate of a full turn of the scene are listed,
+    // and the first frame is compared to the golden image of the scene, which is a PPM file in the
+    // golden directory. The paths of the models, shaders and golden images are relative to the
+    // working directory, as in the application.
+    //
+    // Options:
+    //      --frames <count>                frames per scene (default: 100)
+    //      --golden <directory>            golden images (default: Test/Golden)
+    //      --update-golden                 overwrites the golden images by the rendered ones
+    //      --output <directory>            the rendered and the difference images of the failed
+    //                                      comparisons are written here (default: .)
+    //      --tolerance <value>             allowed difference of the color channels (default: 8)
+    //      --max-differing <percent>       allowed percentage of differing pixels (default: 0.5)
+    //      --min-fps <value>               minimal frame rate of the scenes (default: 0)
+    //      --results <file>                the measurements are also written into a CSV file
+    //      --threads <count>               worker threads of the TaskScheduler
+    //
+    // Returns 0 if every comparison has passed and every frame rate has reached the minimum,
+    // 1 if some of them have failed, and 2 if the scenes could not be rendered.
+    int RunHeadlessBenchmark(int argc, char **argv);
+}
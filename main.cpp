@@ -2,13 +2,24 @@
 #include "GUI/MainWindow.h"
 
 #include "core/Matrices.h"
+#include "core/Profilers.h"
 #include "core/RealSquareMatrices.h"
+#include "core/TaskSchedulers.h"
+#include "Test/HeadlessBenchmarks.h"
+#include <cstring>
 #include <fstream>
+#include <iostream>
 
 using namespace cagd;
 
 int main(int argc, char **argv)
 {
+    // "--headless" renders the standard scenes offscreen without a window system, measures their
+    // frame rates and compares them to the golden images (see Test/HeadlessBenchmarks.h)
+    for (int i = 1; i < argc; ++i)
+        if (!strcmp(argv[i], "--headless"))
+            return RunHeadlessBenchmark(argc, argv);
+
     QApplication::setAttribute(Qt::AA_EnableHighDpiScaling, true);
 
     // creating an application object and setting one of its attributes
@@ -20,10 +31,41 @@ int main(int argc, char **argv)
     // on Linux or Mac you can uncomment this line
     app.setAttribute(Qt::AA_UseDesktopOpenGL, true);
 
+    // the parallel algorithms share the worker threads of a single scheduler: "--threads <count>"
+    // overrides the hardware concurrency (1 executes every task by the calling thread), while
+    // "--deterministic" makes the parallel reductions independent of the thread count
+    QStringList arguments = app.arguments();
+    int threads_index = arguments.indexOf("--threads");
+
+    if (threads_index >= 0 && threads_index + 1 < arguments.size())
+        TaskScheduler::Instance().SetThreadCount(arguments[threads_index + 1].toUInt());
+
+    if (arguments.contains("--deterministic"))
+        TaskScheduler::Instance().SetDeterministic(GL_TRUE);
+
+    // "--profile" shows the durations of the zones and the counters of the last frame over the
+    // scene, "--trace <file>" records them and writes a Chrome trace (chrome://tracing) on exit
+    int trace_index = arguments.indexOf("--trace");
+    QString trace_file_name;
+
+    if (trace_index >= 0 && trace_index + 1 < arguments.size())
+        trace_file_name = arguments[trace_index + 1];
+
+    if (arguments.contains("--profile") || !trace_file_name.isEmpty())
+        Profiler::Instance().SetEnabled(GL_TRUE);
+
+    if (!trace_file_name.isEmpty())
+        Profiler::Instance().SetTracing(GL_TRUE);
+
     // creating a main window object
     MainWindow mwnd;
     mwnd.showMaximized();
 
     // running the application
-    return app.exec();    
+    int result = app.exec();
+
+    if (!trace_file_name.isEmpty() && !Profiler::Instance().ExportChromeTrace(trace_file_name.toStdString()))
+        std::cerr << "Could not write the trace " << trace_file_name.toStdString() << std::endl;
+
+    return result;
 }